@@ -10,10 +10,29 @@
 #ifndef ABCG_HPP_
 #define ABCG_HPP_
 
+#include "abcg_activitymonitor.hpp"
+#include "abcg_allocationtracker.hpp"
 #include "abcg_application.hpp"
+#include "abcg_framearena.hpp"
+#include "abcg_framepacer.hpp"
+#include "abcg_glstats.hpp"
+#include "abcg_hitchrecorder.hpp"
 #include "abcg_image.hpp"
+#include "abcg_inputrecorder.hpp"
+#include "abcg_jobsystem.hpp"
+#include "abcg_occlusionculler.hpp"
 #include "abcg_openglwindow.hpp"
+#include "abcg_profiler.hpp"
+#include "abcg_random.hpp"
+#include "abcg_renderqueue.hpp"
+#include "abcg_resourcetracker.hpp"
+#include "abcg_spatialhash.hpp"
 #include "abcg_string.hpp"
+#include "abcg_tracer.hpp"
 #include "abcg_trackball.hpp"
+#include "abcg_transformbatch.hpp"
+#include "abcg_trianglebvh.hpp"
+#include "abcg_triplebuffer.hpp"
+#include "abcg_vertexlayout.hpp"
 
 #endif
\ No newline at end of file
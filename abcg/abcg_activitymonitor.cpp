@@ -0,0 +1,77 @@
+/**
+ * @file abcg_activitymonitor.cpp
+ * @brief Definition of abcg::ActivityMonitor class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_activitymonitor.hpp"
+
+#include <fmt/core.h>
+
+/**
+ * @brief Returns the share of the wall time spent working, in [0, 1].
+ */
+double abcg::ActivityMonitor::Statistics::getDutyCycle() const noexcept {
+  return wallTime > 0.0 ? busyTime / wallTime : 0.0;
+}
+
+/**
+ * @brief Returns the number of painted frames per second.
+ */
+double abcg::ActivityMonitor::Statistics::getFrameRate() const noexcept {
+  return wallTime > 0.0 ? static_cast<double>(frames) / wallTime : 0.0;
+}
+
+/**
+ * @brief Accounts an iteration of the main loop.
+ *
+ * The wall time since the previous call goes to the state the window was
+ * in during the iteration.
+ *
+ * @param activity Activity state of the window.
+ * @param busyTime Time spent handling events and painting, in seconds.
+ * @param painted Whether a frame was painted.
+ */
+void abcg::ActivityMonitor::update(WindowActivity activity, double busyTime,
+                                   bool painted) {
+  auto &statistics{m_statistics.at(static_cast<std::size_t>(activity))};
+  statistics.wallTime += m_timer.restart();
+  statistics.busyTime += busyTime;
+  if (painted) ++statistics.frames;
+}
+
+/**
+ * @brief Returns the time and work accounted to an activity state.
+ */
+const abcg::ActivityMonitor::Statistics &
+abcg::ActivityMonitor::getStatistics(WindowActivity activity) const {
+  return m_statistics.at(static_cast<std::size_t>(activity));
+}
+
+/**
+ * @brief Prints the duty cycle and frame rate of each state visited, and
+ * the savings of the background and hidden states relative to the
+ * foreground.
+ */
+void abcg::ActivityMonitor::printSummary() const {
+  const auto &foreground{getStatistics(WindowActivity::Foreground)};
+  const auto saving{[](double value, double reference) {
+    return reference > 0.0 ? (1.0 - value / reference) * 100.0 : 0.0;
+  }};
+
+  const std::array names{"foreground", "background", "hidden"};
+  for (std::size_t index{}; index < m_statistics.size(); ++index) {
+    const auto &statistics{m_statistics.at(index)};
+    if (statistics.wallTime <= 0.0) continue;
+    fmt::print("{:<10}: {:.1f} s, CPU {:.1f}%, {:.1f} frames/s", names.at(index),
+               statistics.wallTime, statistics.getDutyCycle() * 100.0,
+               statistics.getFrameRate());
+    if (index > 0 && foreground.wallTime > 0.0) {
+      fmt::print(" (saves {:.0f}% CPU, {:.0f}% frames)",
+                 saving(statistics.getDutyCycle(), foreground.getDutyCycle()),
+                 saving(statistics.getFrameRate(), foreground.getFrameRate()));
+    }
+    fmt::print("\n");
+  }
+}
@@ -0,0 +1,67 @@
+/**
+ * @file abcg_activitymonitor.hpp
+ * @brief abcg::ActivityMonitor header file.
+ *
+ * Declaration of abcg::WindowActivity and abcg::ActivityMonitor, which
+ * accounts for the work done by the main loop in each activity state of
+ * the window.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_ACTIVITYMONITOR_HPP_
+#define ABCG_ACTIVITYMONITOR_HPP_
+
+#include <array>
+#include <cstdint>
+
+#include "abcg_elapsedtimer.hpp"
+
+namespace abcg {
+enum class WindowActivity;
+class ActivityMonitor;
+}  // namespace abcg
+
+/**
+ * @brief Enumeration of the activity states of a window.
+ *
+ * Foreground: visible and focused. Background: visible, but another window
+ * has the focus. Hidden: minimized or hidden.
+ */
+enum class abcg::WindowActivity { Foreground, Background, Hidden };
+
+/**
+ * @brief abcg::ActivityMonitor class.
+ *
+ * Splits the wall time of the main loop by activity state and measures,
+ * for each state, the CPU duty cycle of the main thread (the share of time
+ * spent handling events and building frames rather than waiting) and the
+ * rate of painted frames. The GPU load of a frame does not depend on the
+ * state, so the frame rate relative to the foreground rate stands for the
+ * GPU duty cycle.
+ */
+class abcg::ActivityMonitor {
+ public:
+  /**
+   * @brief Time and work accounted to an activity state.
+   */
+  struct Statistics {
+    double wallTime{};
+    double busyTime{};
+    std::uint64_t frames{};
+
+    [[nodiscard]] double getDutyCycle() const noexcept;
+    [[nodiscard]] double getFrameRate() const noexcept;
+  };
+
+  void update(WindowActivity activity, double busyTime, bool painted);
+  [[nodiscard]] const Statistics &getStatistics(
+      WindowActivity activity) const;
+  void printSummary() const;
+
+ private:
+  ElapsedTimer m_timer;
+  std::array<Statistics, 3> m_statistics{};
+};
+
+#endif
@@ -0,0 +1,110 @@
+/**
+ * @file abcg_allocationtracker.cpp
+ * @brief Definition of abcg::AllocationTracker class members, and of the
+ * replacements of the global operator new and operator delete.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_allocationtracker.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+// Constant-initialized, so that operator new can use them at any time,
+// including during static initialization
+thread_local abcg::AllocationTracker::Counters threadCounters{};
+std::atomic<std::uint64_t> totalAllocations{};
+std::atomic<std::uint64_t> totalBytes{};
+}  // namespace
+
+/**
+ * @brief Returns the counters of the calling thread since it started.
+ */
+abcg::AllocationTracker::Counters
+abcg::AllocationTracker::getThreadCounters() noexcept {
+  return threadCounters;
+}
+
+/**
+ * @brief Returns the counters of all threads since the program started.
+ */
+abcg::AllocationTracker::Counters
+abcg::AllocationTracker::getTotalCounters() noexcept {
+  return {totalAllocations.load(std::memory_order_relaxed),
+          totalBytes.load(std::memory_order_relaxed)};
+}
+
+/**
+ * @brief Counts an allocation of the calling thread.
+ *
+ * @param size Number of bytes requested.
+ */
+void abcg::AllocationTracker::countAllocation(std::size_t size) noexcept {
+  ++threadCounters.allocations;
+  threadCounters.bytes += size;
+  totalAllocations.fetch_add(1, std::memory_order_relaxed);
+  totalBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+#if !defined(ABCG_DISABLE_ALLOCATION_TRACKING)
+
+namespace {
+// Allocates as the default operator new does: retries through the new
+// handler, and throws if there is none
+template <typename TAllocate>
+void *allocate(std::size_t size, TAllocate &&tryAllocate) {
+  abcg::AllocationTracker::countAllocation(size);
+  // Zero-sized allocations must still return distinct pointers
+  if (size == 0) size = 1;
+  while (true) {
+    if (auto *pointer{tryAllocate(size)}) return pointer;
+    auto *handler{std::get_new_handler()};
+    if (handler == nullptr) throw std::bad_alloc{};
+    handler();
+  }
+}
+}  // namespace
+
+// The array and nothrow forms of the default operators forward to these,
+// so replacing them covers every allocation through operator new
+
+void *operator new(std::size_t size) {
+  return allocate(size, [](std::size_t bytes) { return std::malloc(bytes); });
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  return allocate(size, [alignment](std::size_t bytes) {
+    const auto align{static_cast<std::size_t>(alignment)};
+#if defined(_MSC_VER)
+    return _aligned_malloc(bytes, align);
+#else
+    // The size must be a multiple of the alignment
+    return std::aligned_alloc(align, (bytes + align - 1) / align * align);
+#endif
+  });
+}
+
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+
+void operator delete(void *pointer,
+                     [[maybe_unused]] std::align_val_t alignment) noexcept {
+#if defined(_MSC_VER)
+  _aligned_free(pointer);
+#else
+  std::free(pointer);
+#endif
+}
+
+void operator delete(void *pointer, std::size_t /*size*/) noexcept {
+  ::operator delete(pointer);
+}
+
+void operator delete(void *pointer, std::size_t /*size*/,
+                     std::align_val_t alignment) noexcept {
+  ::operator delete(pointer, alignment);
+}
+
+#endif
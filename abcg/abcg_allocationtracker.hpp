@@ -0,0 +1,69 @@
+/**
+ * @file abcg_allocationtracker.hpp
+ * @brief abcg::AllocationTracker header file.
+ *
+ * Declaration of abcg::AllocationTracker, the counters of the heap
+ * allocations made through the global operator new.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_ALLOCATIONTRACKER_HPP_
+#define ABCG_ALLOCATIONTRACKER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace abcg {
+class AllocationTracker;
+}  // namespace abcg
+
+/**
+ * @brief abcg::AllocationTracker class.
+ *
+ * Counts the allocations made through the global operator new, and the
+ * bytes requested, for the calling thread and for all threads. Counts only
+ * grow: the allocations of an interval are the difference between the
+ * counters read at its ends. abcg::Profiler does so for each frame and
+ * each CPU scope.
+ *
+ * Counting replaces the global operator new and operator delete of the
+ * program, so it is opt-in: it is only compiled with the CMake option
+ * ENABLE_ALLOCATION_TRACKING=ON. Otherwise, ABCG_DISABLE_ALLOCATION_TRACKING
+ * is defined and the counters stay at zero. Allocations that bypass
+ * operator new, such as those of malloc or of the ImGui allocator, are not
+ * counted.
+ */
+class abcg::AllocationTracker {
+ public:
+  /** @brief Allocations and bytes requested. */
+  struct Counters {
+    std::uint64_t allocations{};
+    std::uint64_t bytes{};
+
+    [[nodiscard]] Counters operator-(const Counters &start) const noexcept {
+      return {allocations - start.allocations, bytes - start.bytes};
+    }
+  };
+
+  AllocationTracker() = delete;
+
+  /**
+   * @brief Returns whether operator new counts the allocations.
+   */
+  [[nodiscard]] static constexpr bool isEnabled() noexcept {
+#if defined(ABCG_DISABLE_ALLOCATION_TRACKING)
+    return false;
+#else
+    return true;
+#endif
+  }
+
+  [[nodiscard]] static Counters getThreadCounters() noexcept;
+  [[nodiscard]] static Counters getTotalCounters() noexcept;
+
+  // Hook of operator new
+  static void countAllocation(std::size_t size) noexcept;
+};
+
+#endif
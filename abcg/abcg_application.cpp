@@ -15,8 +15,14 @@
 #include "SDL_image.h"
 #include "abcg_exception.hpp"
 #include "abcg_openglwindow.hpp"
+#include "abcg_tracer.hpp"
 #include "tiny_obj_loader.h"
 
+namespace {
+// Longest wait for events while the window is idle, in milliseconds
+constexpr int idleTimeoutMs{100};
+}  // namespace
+
 #if defined(__EMSCRIPTEN__)
 void abcg::mainLoopCallback(void *userData) {
   abcg::Application &app{*(static_cast<abcg::Application *>(userData))};
@@ -72,6 +78,13 @@ abcg::Application::Application([[maybe_unused]] int argc, char **argv) {
  * subsystems.
  */
 abcg::Application::~Application() {
+  // The simulation and render threads may use members of the derived
+  // window, and terminateGL must run before the derived window is destroyed
+  if (m_window != nullptr) {
+    m_window->stopSimulation();
+    m_window->stopRendering();
+    m_window->terminate();
+  }
 #if !defined(__EMSCRIPTEN__)
   IMG_Quit();
 #endif
@@ -94,20 +107,205 @@ void abcg::Application::run(std::unique_ptr<OpenGLWindow> window) {
   }
 }
 
+/**
+ * @brief Records the input of the session to a log file.
+ *
+ * Must be called before abcg::Application::run. The log stores the events
+ * and delta time of each frame and the seed returned by
+ * abcg::OpenGLWindow::getSessionSeed.
+ *
+ * @param path Path of the log file.
+ *
+ * @throw abcg::Exception if the file cannot be created.
+ */
+void abcg::Application::recordInput(std::string_view path) {
+  m_inputRecorder.record(path);
+}
+
+/**
+ * @brief Replays the input of a recorded session instead of the user input.
+ *
+ * Must be called before abcg::Application::run. The window is created with
+ * the recorded size, each frame sees the recorded events and delta time,
+ * and the application exits at the end of the log. A summary of the frame
+ * times is printed on exit.
+ *
+ * @param path Path of the log file.
+ *
+ * @throw abcg::Exception if the file cannot be read.
+ */
+void abcg::Application::replayInput(std::string_view path) {
+  m_inputRecorder.replay(path);
+}
+
+/**
+ * @brief Writes the time of each frame to a CSV file on exit when
+ * recording or replaying input.
+ *
+ * @param path Path of the CSV file.
+ */
+void abcg::Application::setFrameReport(std::string_view path) {
+  m_inputRecorder.setReportPath(path);
+}
+
+/**
+ * @brief Records the instrumentation events of the session and writes them
+ * to a Chrome trace file on exit.
+ *
+ * @param path Path of the trace file.
+ *
+ * @sa abcg::Tracer
+ */
+void abcg::Application::recordTrace(std::string_view path) {
+  Tracer::start(path);
+}
+
+/**
+ * @brief Captures traces of the frames that take much longer than the
+ * recent ones.
+ *
+ * Keeps recording trace events in memory. When a frame takes longer than
+ * threshold times the median of the recent frames, the events of a window
+ * of a few seconds around it are written to a Chrome trace file in the
+ * directory, with the state of the window at the hitch as metadata.
+ *
+ * @param directory Directory of the trace files, created if needed.
+ * @param threshold Ratio between a hitch and the median frame time.
+ *
+ * @throw abcg::Exception if the threshold is not greater than one or the
+ * directory cannot be created.
+ *
+ * @sa abcg::HitchRecorder
+ */
+void abcg::Application::captureHitches(std::string_view directory,
+                                       double threshold) {
+  m_hitchRecorder.start(directory, threshold);
+}
+
+/**
+ * @brief Exits after painting a number of frames.
+ *
+ * Meant for unattended runs such as tests. The window does not idle in such
+ * runs, so that its frames are painted even if it is hidden. Ignored in
+ * Emscripten builds.
+ *
+ * @param numFrames Number of frames, or zero for no limit.
+ */
+void abcg::Application::setFrameLimit(std::uint64_t numFrames) {
+  m_frameLimit = numFrames;
+}
+
 void abcg::Application::mainLoopIterator([[maybe_unused]] bool &done) {
+  const auto activity{m_window->getActivity()};
+  if (m_window->updateActivity()) {
+    m_window->m_activityMonitor.update(activity, waitEvents(done), false);
+    return;
+  }
+
+  // Replays run as fast as possible: their delta times are recorded
+  const auto replaying{m_inputRecorder.getMode() ==
+                       InputRecorder::Mode::Replay};
+  if (!replaying) m_window->m_framePacer.wait();
+
+  const ElapsedTimer frameTimer;
+  if (replaying) {
+    replayEvents(done);
+    if (done) return;
+  } else {
+    pollEvents(done);
+  }
+  m_window->paint();
+  const auto frameTime{frameTimer.elapsed()};
+  m_inputRecorder.addFrameTime(frameTime);
+  m_window->m_activityMonitor.update(activity, frameTime, true);
+  if (m_frameLimit > 0 && ++m_numFrames >= m_frameLimit) done = true;
+}
+
+// Blocks until an event arrives (or a timeout, so that repaints requested
+// meanwhile are not delayed for long) and handles all pending events.
+// Returns the time spent handling them, in seconds.
+double abcg::Application::waitEvents(bool &done) {
+  SDL_Event event{};
+  if (SDL_WaitEventTimeout(&event, idleTimeoutMs) == 0) return 0.0;
+
+  const ElapsedTimer busyTimer;
+  do {
+    if (event.type == SDL_QUIT) done = true;
+    m_window->handleEvent(event, done);
+  } while (SDL_PollEvent(&event) != 0);
+  return busyTimer.elapsed();
+}
+
+void abcg::Application::pollEvents([[maybe_unused]] bool &done) {
+  const auto recording{m_inputRecorder.getMode() ==
+                       InputRecorder::Mode::Record};
+  if (recording) {
+    m_frameEvents.clear();
+    m_window->m_frameClock += m_window->m_lastDeltaTime;
+  }
+
   SDL_Event event{};
   while (SDL_PollEvent(&event) != 0) {
 #if !defined(__EMSCRIPTEN__)
     if (event.type == SDL_QUIT) done = true;
 #endif
+    if (recording) m_frameEvents.push_back(event);
     m_window->handleEvent(event, done);
   }
-  m_window->paint();
+
+  if (recording) {
+    m_inputRecorder.recordFrame(m_window->m_lastDeltaTime, m_frameEvents);
+  }
+}
+
+// Feeds the events of the next recorded frame to the window. Live events
+// are dropped, except for requests to quit.
+void abcg::Application::replayEvents(bool &done) {
+  SDL_Event event{};
+  while (SDL_PollEvent(&event) != 0) {
+    if (event.type == SDL_QUIT ||
+        (event.type == SDL_WINDOWEVENT &&
+         event.window.event == SDL_WINDOWEVENT_CLOSE)) {
+      done = true;
+    }
+  }
+
+  double deltaTime{};
+  if (done || !m_inputRecorder.replayFrame(deltaTime, m_frameEvents)) {
+    done = true;
+    return;
+  }
+
+  m_window->m_lastDeltaTime = deltaTime;
+  m_window->m_frameClock += deltaTime;
+  for (auto &recorded : m_frameEvents) {
+    recorded.window.windowID = m_window->m_windowID;
+    m_window->handleEvent(recorded, done);
+  }
 }
 
 void abcg::Application::run() {
+  ABCG_TRACE_THREAD_NAME("Main");
+  m_window->m_inputRecorder = nullptr;
+  if (m_inputRecorder.getMode() != InputRecorder::Mode::Off) {
+    m_window->m_inputRecorder = &m_inputRecorder;
+  }
+  m_window->m_hitchRecorder =
+      m_hitchRecorder.isEnabled() ? &m_hitchRecorder : nullptr;
+  m_window->m_frameLimited = m_frameLimit > 0;
+  if (m_inputRecorder.getMode() == InputRecorder::Mode::Replay) {
+    const auto windowSize{m_inputRecorder.getWindowSize()};
+    m_window->m_windowSettings.width = windowSize.width;
+    m_window->m_windowSettings.height = windowSize.height;
+  }
+
   m_window->initialize(m_basePath);
 
+  if (m_inputRecorder.getMode() == InputRecorder::Mode::Record) {
+    m_inputRecorder.setWindowSize(
+        {m_window->m_windowSettings.width, m_window->m_windowSettings.height});
+  }
+
 #if defined(__EMSCRIPTEN__)
   emscripten_set_main_loop_arg(mainLoopCallback, this, 0, true);
 #else
@@ -115,5 +313,11 @@ void abcg::Application::run() {
   while (!done) {
     mainLoopIterator(done);
   };
+  m_window->stopSimulation();
+  m_window->stopRendering();
+  m_inputRecorder.finish();
+  m_window->m_activityMonitor.printSummary();
+  m_hitchRecorder.finish();
+  Tracer::stop();
 #endif
 }
@@ -10,9 +10,14 @@
 #ifndef ABCG_APPLICATION_HPP_
 #define ABCG_APPLICATION_HPP_
 
+#include <cstdint>
 #include <memory>
+#include <string_view>
+#include <vector>
 
 #include "abcg_exception.hpp"
+#include "abcg_hitchrecorder.hpp"
+#include "abcg_inputrecorder.hpp"
 
 namespace abcg {
 class Application;
@@ -40,13 +45,31 @@ class abcg::Application {
 
   void run(std::unique_ptr<OpenGLWindow> window);
 
+  void recordInput(std::string_view path);
+  void replayInput(std::string_view path);
+  void setFrameReport(std::string_view path);
+  void recordTrace(std::string_view path);
+  void captureHitches(std::string_view directory, double threshold = 2.0);
+  void setFrameLimit(std::uint64_t numFrames);
+
  private:
   void mainLoopIterator(bool& done);
+  void pollEvents(bool& done);
+  void replayEvents(bool& done);
+  double waitEvents(bool& done);
   void run();
 
   std::string m_basePath;
   std::unique_ptr<OpenGLWindow> m_window;
 
+  InputRecorder m_inputRecorder;
+  HitchRecorder m_hitchRecorder;
+  std::vector<SDL_Event> m_frameEvents;
+
+  // Frames to paint before exiting (zero for no limit), and frames painted
+  std::uint64_t m_frameLimit{};
+  std::uint64_t m_numFrames{};
+
 #if defined(__EMSCRIPTEN__)
   friend void mainLoopCallback(void* userData);
 #endif
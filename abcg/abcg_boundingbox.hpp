@@ -0,0 +1,59 @@
+/**
+ * @file abcg_boundingbox.hpp
+ * @brief abcg::BoundingBox header file.
+ *
+ * Declaration and definition of abcg::BoundingBox, an axis-aligned bounding
+ * box shared by the culling and collision helpers.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_BOUNDINGBOX_HPP_
+#define ABCG_BOUNDINGBOX_HPP_
+
+#include <glm/common.hpp>
+#include <glm/vec3.hpp>
+
+namespace abcg {
+struct BoundingBox;
+}  // namespace abcg
+
+/**
+ * @brief Axis-aligned bounding box.
+ *
+ */
+struct abcg::BoundingBox {
+  glm::vec3 min{};
+  glm::vec3 max{};
+
+  /**
+   * @brief Creates the bounding box of a sphere.
+   *
+   * @param sphereCenter Center of the sphere.
+   * @param radius Radius of the sphere.
+   * @return Smallest box enclosing the sphere.
+   */
+  [[nodiscard]] static BoundingBox fromSphere(const glm::vec3& sphereCenter,
+                                              float radius) {
+    return {sphereCenter - glm::vec3(radius), sphereCenter + glm::vec3(radius)};
+  }
+
+  [[nodiscard]] glm::vec3 center() const { return (min + max) * 0.5f; }
+
+  [[nodiscard]] glm::vec3 extent() const { return max - min; }
+
+  [[nodiscard]] bool overlaps(const BoundingBox& other) const {
+    return min.x <= other.max.x && max.x >= other.min.x &&
+           min.y <= other.max.y && max.y >= other.min.y &&
+           min.z <= other.max.z && max.z >= other.min.z;
+  }
+
+  [[nodiscard]] bool overlaps(const glm::vec3& sphereCenter,
+                              float radius) const {
+    const auto closest{glm::clamp(sphereCenter, min, max)};
+    const auto d{closest - sphereCenter};
+    return d.x * d.x + d.y * d.y + d.z * d.z <= radius * radius;
+  }
+};
+
+#endif
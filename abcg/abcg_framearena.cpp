@@ -0,0 +1,65 @@
+/**
+ * @file abcg_framearena.cpp
+ * @brief Definition of abcg::FrameArena class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_framearena.hpp"
+
+#include <algorithm>
+#include <bit>
+
+/**
+ * @brief Constructs an arena with a buffer of the given size.
+ *
+ * @param capacity Initial size of the buffer, in bytes. The buffer grows
+ * on reset if a frame needed more.
+ */
+abcg::FrameArena::FrameArena(std::size_t capacity)
+    : m_buffer{std::make_unique<std::byte[]>(capacity)}, m_capacity{capacity} {}
+
+abcg::FrameArena::~FrameArena() { releaseOverflows(); }
+
+/**
+ * @brief Frees everything allocated from the arena.
+ *
+ * If the buffer overflowed since the last reset, it is replaced by one that
+ * holds all the memory handed out, rounded up to a power of two.
+ */
+void abcg::FrameArena::reset() {
+  if (!m_overflows.empty()) {
+    m_capacity = std::bit_ceil(m_offset + m_overflowSpace);
+    m_buffer = std::make_unique<std::byte[]>(m_capacity);
+    releaseOverflows();
+  }
+  m_offset = 0;
+  m_used = 0;
+}
+
+void *abcg::FrameArena::do_allocate(std::size_t bytes, std::size_t alignment) {
+  m_used += bytes;
+  m_peak = std::max(m_peak, m_used);
+
+  auto *pointer{static_cast<void *>(m_buffer.get() + m_offset)};
+  auto space{m_capacity - m_offset};
+  if (std::align(alignment, bytes, pointer, space) != nullptr) {
+    m_offset = m_capacity - space + bytes;
+    return pointer;
+  }
+
+  pointer = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  m_overflows.push_back({pointer, bytes, alignment});
+  m_overflowSpace += bytes + alignment - 1;
+  return pointer;
+}
+
+// Returns the memory taken from the heap
+void abcg::FrameArena::releaseOverflows() noexcept {
+  for (const auto &overflow : m_overflows) {
+    std::pmr::new_delete_resource()->deallocate(
+        overflow.pointer, overflow.bytes, overflow.alignment);
+  }
+  m_overflows.clear();
+  m_overflowSpace = 0;
+}
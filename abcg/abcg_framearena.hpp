@@ -0,0 +1,112 @@
+/**
+ * @file abcg_framearena.hpp
+ * @brief abcg::FrameArena header file.
+ *
+ * Declaration of abcg::FrameArena, a monotonic memory resource for the
+ * transient data of a frame.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_FRAMEARENA_HPP_
+#define ABCG_FRAMEARENA_HPP_
+
+#include <fmt/format.h>
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace abcg {
+class FrameArena;
+}  // namespace abcg
+
+/**
+ * @brief abcg::FrameArena class.
+ *
+ * Memory resource that hands out memory by bumping an offset into a single
+ * buffer, and frees everything at once on abcg::FrameArena::reset. Use it
+ * with the std::pmr containers, e.g. std::pmr::vector<float>{&arena}, for
+ * data that does not outlive the frame.
+ *
+ * When the buffer is exhausted, allocations fall back to the heap until
+ * the next reset, which then grows the buffer to hold the whole frame.
+ * After a few frames, the arena no longer allocates from the heap.
+ * Deallocation does nothing, so containers that grow should reserve first.
+ *
+ * An arena must only be used by one thread at a time. abcg::OpenGLWindow
+ * resets its arena, returned by abcg::OpenGLWindow::getFrameArena, at the
+ * start of each frame, so the data must not be read by the commands given
+ * to abcg::OpenGLWindow::submitGL, which may run after that.
+ */
+class abcg::FrameArena : public std::pmr::memory_resource {
+ public:
+  explicit FrameArena(std::size_t capacity = std::size_t{64} << 10U);
+  ~FrameArena() override;
+
+  FrameArena(const FrameArena &) = delete;
+  FrameArena(FrameArena &&) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+  FrameArena &operator=(FrameArena &&) = delete;
+
+  void reset();
+
+  /** @brief Returns the bytes handed out since the last reset. */
+  [[nodiscard]] std::size_t getUsed() const noexcept { return m_used; }
+  /** @brief Returns the size of the buffer. */
+  [[nodiscard]] std::size_t getCapacity() const noexcept {
+    return m_capacity;
+  }
+  /** @brief Returns the most bytes handed out between two resets. */
+  [[nodiscard]] std::size_t getPeak() const noexcept { return m_peak; }
+
+  /**
+   * @brief Formats a string into the arena.
+   *
+   * @param format Format string, in the syntax of fmt::format.
+   * @param args Arguments of the format string.
+   *
+   * @return String allocated from the arena, e.g. for an ImGui label.
+   */
+  template <typename... TArgs>
+  [[nodiscard]] std::pmr::string format(std::string_view format,
+                                        const TArgs &...args) {
+    std::pmr::string text{this};
+    text.reserve(format.size() + 32);
+    fmt::vformat_to(std::back_inserter(text), format,
+                    fmt::make_format_args(args...));
+    return text;
+  }
+
+ private:
+  // Memory taken from the heap after the buffer was exhausted
+  struct Overflow {
+    void *pointer{};
+    std::size_t bytes{};
+    std::size_t alignment{};
+  };
+
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+  void do_deallocate(void * /*pointer*/, std::size_t /*bytes*/,
+                     std::size_t /*alignment*/) override {}
+  [[nodiscard]] bool do_is_equal(
+      const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+  void releaseOverflows() noexcept;
+
+  std::unique_ptr<std::byte[]> m_buffer;
+  std::size_t m_capacity{};
+  std::size_t m_offset{};
+  std::size_t m_used{};
+  std::size_t m_peak{};
+  std::vector<Overflow> m_overflows;
+  // Buffer size that would have held the overflows, with their alignment
+  std::size_t m_overflowSpace{};
+};
+
+#endif
@@ -0,0 +1,117 @@
+/**
+ * @file abcg_framepacer.cpp
+ * @brief Definition of abcg::FramePacer class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_framepacer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "abcg_exception.hpp"
+
+namespace {
+// Bounds of the spin margin. The lower bound absorbs the jitter of a single
+// wake-up; the upper bound keeps a scheduler hiccup from turning most of
+// the wait into spinning.
+constexpr std::chrono::microseconds minSpinMargin{100};
+constexpr std::chrono::microseconds maxSpinMargin{4000};
+}  // namespace
+
+/**
+ * @brief Sets the frame rate to aim at.
+ *
+ * @param framesPerSecond Target rate, or zero to disable pacing.
+ *
+ * @throw abcg::Exception if the rate is negative.
+ */
+void abcg::FramePacer::setTargetRate(double framesPerSecond) {
+  if (framesPerSecond < 0.0) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Negative target frame rate")};
+  }
+  m_period = framesPerSecond > 0.0
+                 ? std::chrono::duration_cast<clock::duration>(
+                       std::chrono::duration<double>{1.0 / framesPerSecond})
+                 : clock::duration{};
+  m_deadline = clock::now() + m_period;
+}
+
+/**
+ * @brief Returns the frame rate aimed at, or zero if pacing is disabled.
+ */
+double abcg::FramePacer::getTargetRate() const noexcept {
+  if (m_period == clock::duration{}) return 0.0;
+  return 1.0 / std::chrono::duration<double>{m_period}.count();
+}
+
+/**
+ * @brief Waits for the start of the next frame.
+ *
+ * Returns immediately if pacing is disabled or if the frame is already
+ * late. Called once per frame, before handling its events.
+ */
+void abcg::FramePacer::wait() {
+  if (m_period > clock::duration{}) {
+    sleepUntil(m_deadline);
+    m_deadline += m_period;
+    if (const auto now{clock::now()}; m_deadline < now) {
+      m_deadline = now + m_period;
+    }
+  }
+
+  const auto now{clock::now()};
+  if (m_frameStart != clock::time_point{}) {
+    m_frameTimes.at(m_nextFrameTime) =
+        std::chrono::duration<double>{now - m_frameStart}.count();
+    m_nextFrameTime = (m_nextFrameTime + 1) % m_frameTimes.size();
+    m_numFrameTimes = std::min(m_numFrameTimes + 1, m_frameTimes.size());
+  }
+  m_frameStart = now;
+}
+
+/**
+ * @brief Returns the statistics of the time between the starts of the
+ * last frames (up to 240).
+ */
+abcg::FramePacer::Statistics abcg::FramePacer::getStatistics() const {
+  Statistics statistics;
+  if (m_numFrameTimes == 0) return statistics;
+
+  const auto count{static_cast<double>(m_numFrameTimes)};
+  for (std::size_t index{}; index < m_numFrameTimes; ++index) {
+    statistics.mean += m_frameTimes.at(index);
+    statistics.max = std::max(statistics.max, m_frameTimes.at(index));
+  }
+  statistics.mean /= count;
+
+  double variance{};
+  for (std::size_t index{}; index < m_numFrameTimes; ++index) {
+    const auto difference{m_frameTimes.at(index) - statistics.mean};
+    variance += difference * difference;
+  }
+  statistics.deviation = std::sqrt(variance / count);
+  return statistics;
+}
+
+// Sleeps until the spin margin before the deadline, then spins. The margin
+// jumps to a larger oversleep at once and shrinks slowly, so that a single
+// lucky wake-up does not cause a late frame next time.
+void abcg::FramePacer::sleepUntil(clock::time_point deadline) {
+  const auto sleepStart{clock::now()};
+  if (const auto sleepTime{deadline - sleepStart - m_spinMargin};
+      sleepTime > clock::duration{}) {
+    std::this_thread::sleep_for(sleepTime);
+    const auto oversleep{clock::now() - sleepStart - sleepTime};
+    m_spinMargin = std::clamp<clock::duration>(
+        std::max<clock::duration>(oversleep, m_spinMargin - m_spinMargin / 16),
+        minSpinMargin, maxSpinMargin);
+  }
+
+  while (clock::now() < deadline) {
+    std::this_thread::yield();
+  }
+}
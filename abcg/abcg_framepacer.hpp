@@ -0,0 +1,70 @@
+/**
+ * @file abcg_framepacer.hpp
+ * @brief abcg::FramePacer header file.
+ *
+ * Declaration of abcg::FramePacer, a frame rate limiter.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_FRAMEPACER_HPP_
+#define ABCG_FRAMEPACER_HPP_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+namespace abcg {
+class FramePacer;
+}  // namespace abcg
+
+/**
+ * @brief abcg::FramePacer class.
+ *
+ * Starts frames on a fixed grid of the target period. The wait for the next
+ * frame sleeps for most of the remaining time and spins for the rest, since
+ * the operating system may wake a sleeping thread late. The spin margin
+ * follows the oversleep measured on recent frames, so spinning only takes a
+ * small share of each period.
+ *
+ * A frame that starts late shifts the grid instead of being followed by a
+ * burst of short frames.
+ *
+ * The pacer also keeps the duration of recent frames to report the mean
+ * and the variability of the frame time.
+ */
+class abcg::FramePacer {
+ public:
+  /**
+   * @brief Frame time statistics over recent frames, in seconds.
+   */
+  struct Statistics {
+    double mean{};
+    double deviation{};
+    double max{};
+  };
+
+  void setTargetRate(double framesPerSecond);
+  [[nodiscard]] double getTargetRate() const noexcept;
+
+  void wait();
+  [[nodiscard]] Statistics getStatistics() const;
+
+ private:
+  using clock = std::chrono::steady_clock;
+
+  void sleepUntil(clock::time_point deadline);
+
+  clock::duration m_period{};
+  clock::time_point m_deadline{};
+  clock::time_point m_frameStart{};
+  // Time left to spinning at the end of a wait
+  clock::duration m_spinMargin{std::chrono::microseconds{500}};
+
+  // Ring buffer of the last frame times
+  std::array<double, 240> m_frameTimes{};
+  std::size_t m_numFrameTimes{};
+  std::size_t m_nextFrameTime{};
+};
+
+#endif
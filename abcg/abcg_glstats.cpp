@@ -0,0 +1,194 @@
+/**
+ * @file abcg_glstats.cpp
+ * @brief Definition of abcg::GLStats class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_glstats.hpp"
+
+#include <algorithm>
+
+namespace {
+// Index of a texture target in the tracked bindings of a unit
+std::size_t getTargetIndex(GLenum target) {
+  switch (target) {
+    case GL_TEXTURE_2D:
+      return 0;
+    case GL_TEXTURE_CUBE_MAP:
+      return 1;
+    case GL_TEXTURE_3D:
+      return 2;
+    case GL_TEXTURE_2D_ARRAY:
+      return 3;
+    default:
+      return 4;
+  }
+}
+}  // namespace
+
+/**
+ * @brief Returns the size of a pixel of client pixel data.
+ *
+ * @param format Format of the pixels.
+ * @param type Type of the pixels.
+ *
+ * @return Size in bytes, or zero if not known.
+ */
+std::uint64_t abcg::GLStats::getPixelSize(GLenum format, GLenum type) noexcept {
+  switch (type) {
+    case GL_UNSIGNED_SHORT_5_6_5:
+    case GL_UNSIGNED_SHORT_4_4_4_4:
+    case GL_UNSIGNED_SHORT_5_5_5_1:
+      return 2;
+    case GL_UNSIGNED_INT_2_10_10_10_REV:
+    case GL_UNSIGNED_INT_10F_11F_11F_REV:
+    case GL_UNSIGNED_INT_5_9_9_9_REV:
+    case GL_UNSIGNED_INT_24_8:
+      return 4;
+    case GL_FLOAT_32_UNSIGNED_INT_24_8_REV:
+      return 8;
+    default:
+      break;
+  }
+
+  std::uint64_t componentSize{};
+  switch (type) {
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE:
+      componentSize = 1;
+      break;
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+    case GL_HALF_FLOAT:
+      componentSize = 2;
+      break;
+    case GL_INT:
+    case GL_UNSIGNED_INT:
+    case GL_FLOAT:
+      componentSize = 4;
+      break;
+    default:
+      return 0;
+  }
+
+  switch (format) {
+    case GL_RED:
+    case GL_RED_INTEGER:
+    case GL_ALPHA:
+    case GL_LUMINANCE:
+    case GL_DEPTH_COMPONENT:
+      return componentSize;
+    case GL_RG:
+    case GL_RG_INTEGER:
+    case GL_LUMINANCE_ALPHA:
+      return componentSize * 2;
+    case GL_RGB:
+    case GL_RGB_INTEGER:
+      return componentSize * 3;
+    case GL_RGBA:
+    case GL_RGBA_INTEGER:
+      return componentSize * 4;
+    default:
+      return 0;
+  }
+}
+
+/**
+ * @brief Resets the counters at the start of a frame. Bindings are kept.
+ */
+void abcg::GLStats::beginFrame() noexcept { m_counters = {}; }
+
+/**
+ * @brief Forgets the bindings, so that the next bind of each object is not
+ * counted as redundant.
+ *
+ * Must be called when the bindings change without the wrappers, e.g. for a
+ * new OpenGL context.
+ */
+void abcg::GLStats::invalidateBindings() noexcept {
+  m_program = unknown;
+  m_vertexArray = unknown;
+  for (auto &unit : m_textures) unit.fill(unknown);
+}
+
+/**
+ * @brief Counts the bytes of a texture upload from client memory.
+ *
+ * @param pixels Pixels uploaded, or nullptr if the texture is only
+ * allocated, in which case nothing is counted.
+ * @param width Width of the image, in pixels.
+ * @param height Height of the image, in pixels.
+ * @param depth Depth of the image, in pixels.
+ * @param format Format of the pixels.
+ * @param type Type of the pixels.
+ */
+void abcg::GLStats::countTextureUpload(const void *pixels, GLsizei width,
+                                       GLsizei height, GLsizei depth,
+                                       GLenum format, GLenum type) noexcept {
+  if (pixels == nullptr) return;
+  m_counters.textureBytes += static_cast<std::uint64_t>(width) *
+                             static_cast<std::uint64_t>(height) *
+                             static_cast<std::uint64_t>(depth) *
+                             getPixelSize(format, type);
+}
+
+/**
+ * @brief Counts a texture bind to the active texture unit.
+ *
+ * Bindings are tracked per texture unit and target. Binds to units beyond
+ * the first 32 are counted, but never as redundant.
+ *
+ * @param target Texture target.
+ * @param texture Texture bound.
+ */
+void abcg::GLStats::countTextureBind(GLenum target, GLuint texture) noexcept {
+  ++m_counters.textureBinds;
+  if (m_textureUnit >= numTextureUnits) return;
+  auto &bound{m_textures.at(m_textureUnit).at(getTargetIndex(target))};
+  if (texture == bound) ++m_counters.redundantTextureBinds;
+  bound = texture;
+}
+
+/**
+ * @brief Forgets the binding of a deleted program. A deleted program stays
+ * in use until another one is bound, but its name may be reused afterwards.
+ *
+ * @param program Program deleted.
+ */
+void abcg::GLStats::forgetProgram(GLuint program) noexcept {
+  if (program == m_program) m_program = unknown;
+}
+
+/**
+ * @brief Accounts for deleted vertex arrays. Deleting the bound vertex
+ * array binds zero.
+ *
+ * @param count Number of vertex arrays.
+ * @param vertexArrays Vertex arrays deleted.
+ */
+void abcg::GLStats::forgetVertexArrays(GLsizei count,
+                                       const GLuint *vertexArrays) noexcept {
+  if (std::find(vertexArrays, vertexArrays + count, m_vertexArray) !=
+      vertexArrays + count) {
+    m_vertexArray = 0;
+  }
+}
+
+/**
+ * @brief Accounts for deleted textures. Deleting a bound texture binds zero
+ * in its place.
+ *
+ * @param count Number of textures.
+ * @param textures Textures deleted.
+ */
+void abcg::GLStats::forgetTextures(GLsizei count,
+                                   const GLuint *textures) noexcept {
+  for (auto &unit : m_textures) {
+    for (auto &bound : unit) {
+      if (std::find(textures, textures + count, bound) != textures + count) {
+        bound = 0;
+      }
+    }
+  }
+}
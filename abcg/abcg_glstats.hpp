@@ -0,0 +1,162 @@
+/**
+ * @file abcg_glstats.hpp
+ * @brief abcg::GLStats header file.
+ *
+ * Declaration of abcg::GLStats, the per-frame counters of the OpenGL calls
+ * made through the abcg::gl* wrappers, and of the ABCG_GL_STATS macro.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_GLSTATS_HPP_
+#define ABCG_GLSTATS_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "abcg_external.hpp"
+
+namespace abcg {
+class GLStats;
+}  // namespace abcg
+
+/**
+ * @brief abcg::GLStats class.
+ *
+ * Counts the OpenGL calls made through the abcg::gl* wrappers since the
+ * start of the frame: draw calls with the vertices, indices and instances
+ * they submit, bytes uploaded to buffers and textures, program, vertex
+ * array and texture binds, with those that rebind the object already
+ * bound, uniform updates and fixed-function state changes.
+ *
+ * The counters belong to the OpenGL context and must only be used by the
+ * thread that owns it. abcg::Profiler starts them with each GPU frame and
+ * keeps the counts of the recorded frames. Calls that bypass the wrappers,
+ * such as those of the ImGui backend, are not counted. Texture uploads are
+ * sized from the format and type of the pixels, ignoring row alignment.
+ *
+ * Defining ABCG_DISABLE_GL_STATS (CMake option ENABLE_GL_STATS=OFF)
+ * removes the counting from the wrappers altogether.
+ */
+class abcg::GLStats {
+ public:
+  /** @brief Counts of a frame. */
+  struct Counters {
+    std::uint64_t calls{};
+    std::uint64_t drawCalls{};
+    std::uint64_t vertices{};
+    std::uint64_t indices{};
+    std::uint64_t instances{};
+    std::uint64_t bufferBytes{};
+    std::uint64_t textureBytes{};
+    std::uint64_t programBinds{};
+    std::uint64_t redundantProgramBinds{};
+    std::uint64_t vertexArrayBinds{};
+    std::uint64_t redundantVertexArrayBinds{};
+    std::uint64_t textureBinds{};
+    std::uint64_t redundantTextureBinds{};
+    std::uint64_t uniformUpdates{};
+    std::uint64_t stateChanges{};
+  };
+
+  GLStats() = delete;
+
+  /**
+   * @brief Returns whether the wrappers count their calls.
+   */
+  [[nodiscard]] static constexpr bool isEnabled() noexcept {
+#if defined(ABCG_DISABLE_GL_STATS)
+    return false;
+#else
+    return true;
+#endif
+  }
+
+  static void beginFrame() noexcept;
+  [[nodiscard]] static const Counters &getCounters() noexcept {
+    return m_counters;
+  }
+  static void invalidateBindings() noexcept;
+  [[nodiscard]] static std::uint64_t getPixelSize(GLenum format,
+                                                  GLenum type) noexcept;
+
+  // Hooks of the wrappers, through ABCG_GL_STATS
+
+  static void countCall() noexcept { ++m_counters.calls; }
+  static void countDraw(GLsizei count, GLsizei instances,
+                        bool indexed) noexcept {
+    ++m_counters.drawCalls;
+    (indexed ? m_counters.indices : m_counters.vertices) +=
+        static_cast<std::uint64_t>(count);
+    m_counters.instances += static_cast<std::uint64_t>(instances);
+  }
+  static void countBufferUpload(const void *data, GLsizeiptr size) noexcept {
+    if (data != nullptr) {
+      m_counters.bufferBytes += static_cast<std::uint64_t>(size);
+    }
+  }
+  static void countTextureUpload(const void *pixels, GLsizei width,
+                                 GLsizei height, GLsizei depth, GLenum format,
+                                 GLenum type) noexcept;
+  static void countCompressedTextureUpload(const void *data,
+                                           GLsizei size) noexcept {
+    if (data != nullptr) {
+      m_counters.textureBytes += static_cast<std::uint64_t>(size);
+    }
+  }
+  static void countProgramBind(GLuint program) noexcept {
+    ++m_counters.programBinds;
+    if (program == m_program) ++m_counters.redundantProgramBinds;
+    m_program = program;
+  }
+  static void countVertexArrayBind(GLuint vertexArray) noexcept {
+    ++m_counters.vertexArrayBinds;
+    if (vertexArray == m_vertexArray) ++m_counters.redundantVertexArrayBinds;
+    m_vertexArray = vertexArray;
+  }
+  static void countTextureBind(GLenum target, GLuint texture) noexcept;
+  static void setActiveTexture(GLenum texture) noexcept {
+    m_textureUnit = texture - GL_TEXTURE0;
+    ++m_counters.stateChanges;
+  }
+  static void countUniformUpdate() noexcept { ++m_counters.uniformUpdates; }
+  static void countStateChange() noexcept { ++m_counters.stateChanges; }
+  static void forgetProgram(GLuint program) noexcept;
+  static void forgetVertexArrays(GLsizei count,
+                                 const GLuint *vertexArrays) noexcept;
+  static void forgetTextures(GLsizei count, const GLuint *textures) noexcept;
+
+ private:
+  // Binding not known, e.g. before the first bind of a context
+  static constexpr GLuint unknown{std::numeric_limits<GLuint>::max()};
+  // Texture units and targets whose bindings are tracked
+  static constexpr std::size_t numTextureUnits{32};
+  static constexpr std::size_t numTextureTargets{5};
+
+  static Counters m_counters;
+  inline static GLuint m_program{unknown};
+  inline static GLuint m_vertexArray{unknown};
+  inline static GLenum m_textureUnit{};
+  inline static std::array<std::array<GLuint, numTextureTargets>,
+                           numTextureUnits>
+      m_textures{[] {
+        std::array<std::array<GLuint, numTextureTargets>, numTextureUnits>
+            textures{};
+        for (auto &unit : textures) unit.fill(unknown);
+        return textures;
+      }()};
+};
+
+// Defined after the class, which Counters needs to be complete
+inline abcg::GLStats::Counters abcg::GLStats::m_counters{};
+
+#if defined(ABCG_DISABLE_GL_STATS)
+#define ABCG_GL_STATS(hook) static_cast<void>(0)
+#else
+/** @brief Calls the given hook of abcg::GLStats. */
+#define ABCG_GL_STATS(hook) abcg::GLStats::hook
+#endif
+
+#endif
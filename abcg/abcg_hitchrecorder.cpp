@@ -0,0 +1,151 @@
+/**
+ * @file abcg_hitchrecorder.cpp
+ * @brief Definition of abcg::HitchRecorder class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_hitchrecorder.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+#include "abcg_exception.hpp"
+
+namespace {
+// Frames needed before the median is trusted
+constexpr std::size_t minFrames{30};
+
+// Amount by which a hitch must also exceed the median, in seconds, so that
+// jitter at high frame rates does not count
+constexpr double minExcess{0.004};
+
+// Trace window before the start and after the end of a hitch, and shortest
+// time between captures, in nanoseconds
+constexpr std::uint64_t windowBefore{2'000'000'000};
+constexpr std::uint64_t windowAfter{500'000'000};
+constexpr std::uint64_t captureCooldown{5'000'000'000};
+
+// Most captures written in a session
+constexpr int maxCaptures{20};
+}  // namespace
+
+/**
+ * @brief Starts watching the frame times, and starts abcg::Tracer if it is
+ * not recording already.
+ *
+ * @param directory Directory of the capture files, created if needed.
+ * @param threshold Ratio between a hitch and the median frame time.
+ *
+ * @throw abcg::Exception if the threshold is not greater than one or the
+ * directory cannot be created.
+ */
+void abcg::HitchRecorder::start(std::string_view directory, double threshold) {
+  if (threshold <= 1.0) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        "Hitch threshold must be greater than one")};
+  }
+  if (std::error_code error;
+      !std::filesystem::create_directories(directory, error) && error) {
+    throw abcg::Exception{abcg::Exception::Runtime(fmt::format(
+        "Failed to create hitch directory {}: {}", directory, error.message()))};
+  }
+
+  m_directory = directory.empty() ? "." : directory;
+  m_threshold = threshold;
+  restart();
+  if (!Tracer::isEnabled()) Tracer::start();
+}
+
+/**
+ * @brief Accounts a frame. Writes a capture when the window after a hitch
+ * has elapsed.
+ *
+ * @param frameTime Duration of the frame, in seconds.
+ * @param describe Function returning the state of the window, called only
+ * for hitches.
+ */
+void abcg::HitchRecorder::addFrame(double frameTime,
+                                   const Describer &describe) {
+  if (!isEnabled()) return;
+
+  const auto now{Tracer::now()};
+  if (m_skipFrame) {
+    m_skipFrame = false;
+  } else {
+    if (m_numFrameTimes >= minFrames && !m_pending &&
+        m_numCaptures < maxCaptures &&
+        (m_lastCapture == 0 || now - m_lastCapture >= captureCooldown)) {
+      if (const auto median{getMedian()};
+          frameTime > median * m_threshold && frameTime - median > minExcess) {
+        const auto duration{static_cast<std::uint64_t>(frameTime * 1e9)};
+        const auto start{now > duration ? now - duration : 0};
+        ++m_numCaptures;
+        Capture capture{
+            start > windowBefore ? start - windowBefore : 0, now + windowAfter,
+            fmt::format("{}/hitch-{:03d}.json", m_directory, m_numCaptures),
+            describe()};
+        capture.metadata.emplace_back("hitch frame time (ms)",
+                                      fmt::format("{:.3f}", frameTime * 1e3));
+        capture.metadata.emplace_back("median frame time (ms)",
+                                      fmt::format("{:.3f}", median * 1e3));
+        fmt::print("Hitch of {:.1f} ms (median {:.1f} ms), capturing to {}\n",
+                   frameTime * 1e3, median * 1e3, capture.path);
+        m_pending = std::move(capture);
+        m_lastCapture = now;
+      }
+    }
+
+    m_frameTimes.at(m_nextFrameTime) = frameTime;
+    m_nextFrameTime = (m_nextFrameTime + 1) % m_frameTimes.size();
+    m_numFrameTimes = std::min(m_numFrameTimes + 1, m_frameTimes.size());
+  }
+
+  if (m_pending && now >= m_pending->to) {
+    write(*m_pending);
+    m_pending.reset();
+    m_skipFrame = true;
+  }
+}
+
+/**
+ * @brief Forgets the recent frame times, for instance after a change of
+ * the target frame rate, so that the new rate is not taken for hitches.
+ */
+void abcg::HitchRecorder::restart() noexcept {
+  m_numFrameTimes = 0;
+  m_nextFrameTime = 0;
+}
+
+/**
+ * @brief Writes the pending capture, if any, with the events recorded so
+ * far. Called on exit.
+ */
+void abcg::HitchRecorder::finish() {
+  if (m_pending) {
+    write(*m_pending);
+    m_pending.reset();
+  }
+}
+
+double abcg::HitchRecorder::getMedian() const {
+  auto frameTimes{m_frameTimes};
+  const auto end{frameTimes.begin() +
+                 static_cast<std::ptrdiff_t>(m_numFrameTimes)};
+  const auto middle{frameTimes.begin() +
+                    static_cast<std::ptrdiff_t>(m_numFrameTimes / 2)};
+  std::nth_element(frameTimes.begin(), middle, end);
+  return *middle;
+}
+
+// A failed capture is reported, but does not stop the application
+void abcg::HitchRecorder::write(const Capture &capture) {
+  try {
+    Tracer::write(capture.path, capture.from, capture.to, capture.metadata);
+  } catch (const abcg::Exception &exception) {
+    fmt::print("Warning: {}\n", exception.what());
+  }
+}
@@ -0,0 +1,81 @@
+/**
+ * @file abcg_hitchrecorder.hpp
+ * @brief abcg::HitchRecorder header file.
+ *
+ * Declaration of abcg::HitchRecorder, a flight recorder that captures
+ * traces of long frames.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_HITCHRECORDER_HPP_
+#define ABCG_HITCHRECORDER_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "abcg_tracer.hpp"
+
+namespace abcg {
+class HitchRecorder;
+}  // namespace abcg
+
+/**
+ * @brief abcg::HitchRecorder class.
+ *
+ * Keeps abcg::Tracer recording, so that its ring buffers always hold the
+ * last seconds of events, and watches the frame times. A frame longer than
+ * the threshold times the median of the recent frames is a hitch: shortly
+ * after it, so that the GPU results and the frames still in flight are
+ * included, the events of a window around the hitch are written to a
+ * Chrome trace file, together with a description of the state of the
+ * window at the hitch as trace metadata.
+ *
+ * Captures are rate limited, and the frame that writes a capture is left
+ * out of the detection, since the write itself takes time.
+ */
+class abcg::HitchRecorder {
+ public:
+  using Describer = std::function<Tracer::Metadata()>;
+
+  void start(std::string_view directory, double threshold);
+  [[nodiscard]] bool isEnabled() const noexcept {
+    return !m_directory.empty();
+  }
+
+  void addFrame(double frameTime, const Describer &describe);
+  void restart() noexcept;
+  void finish();
+
+ private:
+  // Trace window still waiting for its events after the hitch
+  struct Capture {
+    std::uint64_t from{};
+    std::uint64_t to{};
+    std::string path;
+    Tracer::Metadata metadata;
+  };
+
+  [[nodiscard]] double getMedian() const;
+  void write(const Capture &capture);
+
+  std::string m_directory;
+  double m_threshold{};
+
+  // Ring buffer of the last frame times
+  std::array<double, 120> m_frameTimes{};
+  std::size_t m_numFrameTimes{};
+  std::size_t m_nextFrameTime{};
+
+  std::optional<Capture> m_pending;
+  std::uint64_t m_lastCapture{};
+  int m_numCaptures{};
+  bool m_skipFrame{false};
+};
+
+#endif
@@ -18,6 +18,7 @@
 #include "SDL_image.h"
 #include "abcg_exception.hpp"
 #include "abcg_external.hpp"
+#include "abcg_openglfunctions.hpp"
 
 void flipHorizontally(gsl::not_null<SDL_Surface*> surface) {
   auto width{static_cast<size_t>(surface->w * surface->format->BytesPerPixel)};
@@ -94,36 +95,36 @@ GLuint abcg::opengl::loadTexture(std::string_view path, bool generateMipmaps) {
     flipVertically(formattedSurface);
 
     // Generate the texture
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(format),
-                 formattedSurface->w, formattedSurface->h, 0, format,
-                 GL_UNSIGNED_BYTE, formattedSurface->pixels);
+    abcg::glGenTextures(1, &textureID);
+    abcg::glBindTexture(GL_TEXTURE_2D, textureID);
+    abcg::glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(format),
+                       formattedSurface->w, formattedSurface->h, 0, format,
+                       GL_UNSIGNED_BYTE, formattedSurface->pixels);
 
     SDL_FreeSurface(formattedSurface);
 
     // Set texture filtering
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
     // Generate the mipmap levels
     if (generateMipmaps) {
-      glGenerateMipmap(GL_TEXTURE_2D);
+      abcg::glGenerateMipmap(GL_TEXTURE_2D);
 
       // Override minifying filtering
-      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                      GL_LINEAR_MIPMAP_LINEAR);
+      abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                            GL_LINEAR_MIPMAP_LINEAR);
     }
 
     // Set texture wrapping
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
   } else {
     throw abcg::Exception{abcg::Exception::Runtime(
         fmt::format("Failed to load texture file {}", path))};
   }
 
-  glBindTexture(GL_TEXTURE_2D, 0);
+  abcg::glBindTexture(GL_TEXTURE_2D, 0);
 
   return textureID;
 }
@@ -131,8 +132,8 @@ GLuint abcg::opengl::loadTexture(std::string_view path, bool generateMipmaps) {
 GLuint abcg::opengl::loadCubemap(std::array<std::string_view, 6> paths,
                                  bool generateMipmaps, bool rightHandedSystem) {
   GLuint textureID{};
-  glGenTextures(1, &textureID);
-  glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+  abcg::glGenTextures(1, &textureID);
+  abcg::glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
   for (auto&& [index, path] : iter::enumerate(paths)) {
     // Copy file data into buffer
@@ -171,8 +172,9 @@ GLuint abcg::opengl::loadCubemap(std::array<std::string_view, 6> paths,
       }
 
       // Create texture
-      glTexImage2D(target, 0, GL_RGB, formattedSurface->w, formattedSurface->h,
-                   0, GL_RGB, GL_UNSIGNED_BYTE, formattedSurface->pixels);
+      abcg::glTexImage2D(target, 0, GL_RGB, formattedSurface->w,
+                         formattedSurface->h, 0, GL_RGB, GL_UNSIGNED_BYTE,
+                         formattedSurface->pixels);
 
       SDL_FreeSurface(formattedSurface);
     } else {
@@ -182,21 +184,24 @@ GLuint abcg::opengl::loadCubemap(std::array<std::string_view, 6> paths,
   }
 
   // Set texture wrapping
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+  abcg::glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S,
+                        GL_CLAMP_TO_EDGE);
+  abcg::glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T,
+                        GL_CLAMP_TO_EDGE);
+  abcg::glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R,
+                        GL_CLAMP_TO_EDGE);
 
   // Set texture filtering
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  abcg::glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  abcg::glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 
   // Generate the mipmap levels
   if (generateMipmaps) {
-    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    abcg::glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 
     // Override minifying filtering
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER,
-                    GL_LINEAR_MIPMAP_LINEAR);
+    abcg::glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER,
+                          GL_LINEAR_MIPMAP_LINEAR);
   }
 
   return textureID;
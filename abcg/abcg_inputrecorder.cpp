@@ -0,0 +1,395 @@
+/**
+ * @file abcg_inputrecorder.cpp
+ * @brief Definition of abcg::InputRecorder class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_inputrecorder.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <iterator>
+#include <numeric>
+
+#include "abcg_exception.hpp"
+
+namespace {
+// Log layout:
+//   header: magic, version, seed, window width, window height
+//   frame:  delta time (double), number of events (uint16), events
+//   event:  type (uint32), timestamp (uint32), payload depending on the type
+// Version 1 stored the delta time as a float, which replays did not advance
+// the simulation by as much as the recording session
+constexpr std::array<char, 8> magic{'A', 'B', 'C', 'G', 'I', 'N', 'P', 'T'};
+constexpr std::uint32_t version{2};
+constexpr std::uint32_t floatDeltaVersion{1};
+
+template <typename T>
+void append(std::vector<char> &buffer, const T &value) {
+  const auto bytes{std::bit_cast<std::array<char, sizeof(T)>>(value)};
+  buffer.insert(buffer.end(), bytes.begin(), bytes.end());
+}
+
+// Overwrites the bytes of a value at the given offset
+template <typename T>
+void overwrite(std::vector<char> &buffer, std::size_t offset, const T &value) {
+  const auto bytes{std::bit_cast<std::array<char, sizeof(T)>>(value)};
+  std::ranges::copy(bytes,
+                    buffer.begin() + static_cast<std::ptrdiff_t>(offset));
+}
+
+// Sequential reader of the log; fails once the data is exhausted
+class Reader {
+ public:
+  explicit Reader(std::span<const char> data) : m_data{data} {}
+
+  template <typename T>
+  bool read(T &value) {
+    if (m_data.size() < sizeof(T)) return false;
+    std::array<char, sizeof(T)> bytes{};
+    std::copy_n(m_data.begin(), sizeof(T), bytes.begin());
+    value = std::bit_cast<T>(bytes);
+    m_data = m_data.subspan(sizeof(T));
+    return true;
+  }
+
+  [[nodiscard]] bool empty() const { return m_data.empty(); }
+
+ private:
+  std::span<const char> m_data;
+};
+
+bool isRecorded(Uint32 type) {
+  switch (type) {
+    case SDL_QUIT:
+    case SDL_WINDOWEVENT:
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+    case SDL_TEXTINPUT:
+    case SDL_MOUSEMOTION:
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+    case SDL_MOUSEWHEEL:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void encode(std::vector<char> &buffer, const SDL_Event &event) {
+  append(buffer, event.type);
+  append(buffer, event.common.timestamp);
+  switch (event.type) {
+    case SDL_WINDOWEVENT:
+      append(buffer, event.window.event);
+      append(buffer, event.window.data1);
+      append(buffer, event.window.data2);
+      break;
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+      append(buffer, event.key.state);
+      append(buffer, event.key.repeat);
+      append(buffer, static_cast<std::int32_t>(event.key.keysym.scancode));
+      append(buffer, event.key.keysym.sym);
+      append(buffer, event.key.keysym.mod);
+      break;
+    case SDL_TEXTINPUT:
+      append(buffer, event.text.text);
+      break;
+    case SDL_MOUSEMOTION:
+      append(buffer, event.motion.state);
+      append(buffer, event.motion.x);
+      append(buffer, event.motion.y);
+      append(buffer, event.motion.xrel);
+      append(buffer, event.motion.yrel);
+      break;
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+      append(buffer, event.button.button);
+      append(buffer, event.button.state);
+      append(buffer, event.button.clicks);
+      append(buffer, event.button.x);
+      append(buffer, event.button.y);
+      break;
+    case SDL_MOUSEWHEEL:
+      append(buffer, event.wheel.x);
+      append(buffer, event.wheel.y);
+      append(buffer, event.wheel.direction);
+      break;
+    default:
+      break;
+  }
+}
+
+bool decode(Reader &reader, SDL_Event &event) {
+  event = {};
+  if (!reader.read(event.type) || !reader.read(event.common.timestamp)) {
+    return false;
+  }
+  switch (event.type) {
+    case SDL_QUIT:
+      return true;
+    case SDL_WINDOWEVENT:
+      return reader.read(event.window.event) &&
+             reader.read(event.window.data1) &&
+             reader.read(event.window.data2);
+    case SDL_KEYDOWN:
+    case SDL_KEYUP: {
+      std::int32_t scancode{};
+      const bool valid{reader.read(event.key.state) &&
+                       reader.read(event.key.repeat) && reader.read(scancode) &&
+                       reader.read(event.key.keysym.sym) &&
+                       reader.read(event.key.keysym.mod)};
+      event.key.keysym.scancode =
+          static_cast<decltype(event.key.keysym.scancode)>(scancode);
+      return valid;
+    }
+    case SDL_TEXTINPUT: {
+      std::array<char, sizeof(event.text.text)> text{};
+      if (!reader.read(text)) return false;
+      std::ranges::copy(text, std::begin(event.text.text));
+      return true;
+    }
+    case SDL_MOUSEMOTION:
+      return reader.read(event.motion.state) && reader.read(event.motion.x) &&
+             reader.read(event.motion.y) && reader.read(event.motion.xrel) &&
+             reader.read(event.motion.yrel);
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+      return reader.read(event.button.button) &&
+             reader.read(event.button.state) &&
+             reader.read(event.button.clicks) && reader.read(event.button.x) &&
+             reader.read(event.button.y);
+    case SDL_MOUSEWHEEL:
+      return reader.read(event.wheel.x) && reader.read(event.wheel.y) &&
+             reader.read(event.wheel.direction);
+    default:
+      return false;
+  }
+}
+
+double percentile(const std::vector<double> &sorted, double fraction) {
+  const auto rank{static_cast<std::size_t>(
+      std::ceil(fraction * static_cast<double>(sorted.size())))};
+  return sorted.at(std::clamp<std::size_t>(rank, 1, sorted.size()) - 1);
+}
+}  // namespace
+
+/**
+ * @brief Starts recording to a log file.
+ *
+ * The header is written with the first frame, so that the seed and the
+ * window size set during initialization are stored.
+ *
+ * @param path Path of the log file, which is overwritten.
+ *
+ * @throw abcg::Exception if the file cannot be created.
+ */
+void abcg::InputRecorder::record(std::string_view path) {
+  m_output.open(std::string{path}, std::ios::binary | std::ios::trunc);
+  if (!m_output) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        fmt::format("Failed to create input log {}", path))};
+  }
+  m_mode = Mode::Record;
+  m_headerWritten = false;
+}
+
+/**
+ * @brief Loads a log file for replay.
+ *
+ * A frame left incomplete at the end of the file, as written by a session
+ * that did not exit cleanly, is ignored. Logs of version 1, with delta
+ * times stored as floats, are still read.
+ *
+ * @param path Path of the log file.
+ *
+ * @throw abcg::Exception if the file cannot be read or is not an input log.
+ */
+void abcg::InputRecorder::replay(std::string_view path) {
+  std::ifstream input{std::string{path}, std::ios::binary};
+  if (!input) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        fmt::format("Failed to open input log {}", path))};
+  }
+  const std::vector<char> data{std::istreambuf_iterator<char>{input},
+                               std::istreambuf_iterator<char>{}};
+
+  Reader reader{data};
+  std::array<char, magic.size()> fileMagic{};
+  std::uint32_t fileVersion{};
+  if (!reader.read(fileMagic) || fileMagic != magic ||
+      !reader.read(fileVersion) ||
+      (fileVersion != version && fileVersion != floatDeltaVersion) ||
+      !reader.read(m_seed) || !reader.read(m_windowSize.width) ||
+      !reader.read(m_windowSize.height)) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        fmt::format("Invalid input log {}", path))};
+  }
+
+  m_frames.clear();
+  m_events.clear();
+  while (!reader.empty()) {
+    Frame frame{.firstEvent = m_events.size()};
+    std::uint16_t numEvents{};
+    if (fileVersion == floatDeltaVersion) {
+      float deltaTime{};
+      if (!reader.read(deltaTime)) break;
+      frame.deltaTime = deltaTime;
+    } else if (!reader.read(frame.deltaTime)) {
+      break;
+    }
+    if (!reader.read(numEvents)) break;
+    SDL_Event event{};
+    for (; frame.numEvents < numEvents && decode(reader, event);
+         ++frame.numEvents) {
+      m_events.push_back(event);
+    }
+    if (frame.numEvents < numEvents) {
+      m_events.resize(frame.firstEvent);
+      break;
+    }
+    m_frames.push_back(frame);
+  }
+
+  m_mode = Mode::Replay;
+  m_nextFrame = 0;
+}
+
+/**
+ * @brief Sets the path of the CSV file with the time of each frame, written
+ * by abcg::InputRecorder::finish.
+ */
+void abcg::InputRecorder::setReportPath(std::string_view path) {
+  m_reportPath = path;
+}
+
+/**
+ * @brief Returns the random seed of the session.
+ *
+ * @param seed Seed chosen by the application.
+ *
+ * @return The seed stored in the log when replaying; seed otherwise. When
+ * recording, seed is stored in the log.
+ */
+std::uint64_t abcg::InputRecorder::exchangeSeed(std::uint64_t seed) {
+  if (m_mode == Mode::Replay) return m_seed;
+  m_seed = seed;
+  return seed;
+}
+
+/**
+ * @brief Appends a frame to the log.
+ *
+ * @param deltaTime Delta time seen by the window during the frame, stored
+ * at full precision so that a replay advances the simulation as the
+ * recording session did.
+ * @param events Events handled during the frame. Events of other types
+ * than the recorded ones are skipped.
+ */
+void abcg::InputRecorder::recordFrame(double deltaTime,
+                                      std::span<const SDL_Event> events) {
+  if (m_mode != Mode::Record) return;
+  if (!m_headerWritten) writeHeader();
+
+  // The frame is built in a buffer reused across frames, and its header is
+  // filled in once the events are encoded
+  constexpr auto numEventsOffset{sizeof(deltaTime)};
+  std::uint16_t numEvents{};
+  m_frameBuffer.resize(numEventsOffset + sizeof(numEvents));
+  for (const auto &event : events) {
+    if (!isRecorded(event.type) || numEvents == UINT16_MAX) continue;
+    encode(m_frameBuffer, event);
+    ++numEvents;
+  }
+  overwrite(m_frameBuffer, 0, deltaTime);
+  overwrite(m_frameBuffer, numEventsOffset, numEvents);
+
+  m_output.write(m_frameBuffer.data(),
+                 static_cast<std::streamsize>(m_frameBuffer.size()));
+}
+
+/**
+ * @brief Returns the next frame of the log being replayed.
+ *
+ * @param deltaTime Output delta time of the frame.
+ * @param events Output events of the frame, without window ID.
+ *
+ * @return false if there are no frames left.
+ */
+bool abcg::InputRecorder::replayFrame(double &deltaTime,
+                                      std::vector<SDL_Event> &events) {
+  if (m_mode != Mode::Replay || m_nextFrame >= m_frames.size()) return false;
+  const auto &frame{m_frames.at(m_nextFrame++)};
+  deltaTime = frame.deltaTime;
+  const auto first{m_events.begin() +
+                   static_cast<std::ptrdiff_t>(frame.firstEvent)};
+  events.assign(first, first + static_cast<std::ptrdiff_t>(frame.numEvents));
+  return true;
+}
+
+/**
+ * @brief Stores the wall time of a frame, in seconds.
+ */
+void abcg::InputRecorder::addFrameTime(double frameTime) {
+  if (m_mode != Mode::Off) m_frameTimes.push_back(frameTime);
+}
+
+/**
+ * @brief Closes the log and reports the frame times.
+ *
+ * After a replay, prints a summary of the frame times. Writes the report
+ * file if a path was set.
+ *
+ * @throw abcg::Exception if the report cannot be written.
+ */
+void abcg::InputRecorder::finish() {
+  if (m_mode == Mode::Record) {
+    if (!m_headerWritten) writeHeader();
+    m_output.close();
+  }
+
+  if (m_mode == Mode::Replay && !m_frameTimes.empty()) {
+    auto sorted{m_frameTimes};
+    std::ranges::sort(sorted);
+    const auto mean{std::accumulate(sorted.begin(), sorted.end(), 0.0) /
+                    static_cast<double>(sorted.size())};
+    fmt::print(
+        "Replayed {} frames: mean {:.3f} ms, median {:.3f} ms, 95% {:.3f} "
+        "ms, 99% {:.3f} ms, max {:.3f} ms\n",
+        sorted.size(), mean * 1000.0, percentile(sorted, 0.5) * 1000.0,
+        percentile(sorted, 0.95) * 1000.0, percentile(sorted, 0.99) * 1000.0,
+        sorted.back() * 1000.0);
+  }
+
+  if (!m_reportPath.empty()) writeReport();
+  m_mode = Mode::Off;
+}
+
+void abcg::InputRecorder::writeHeader() {
+  std::vector<char> header;
+  append(header, magic);
+  append(header, version);
+  append(header, m_seed);
+  append(header, m_windowSize.width);
+  append(header, m_windowSize.height);
+  m_output.write(header.data(), static_cast<std::streamsize>(header.size()));
+  m_headerWritten = true;
+}
+
+void abcg::InputRecorder::writeReport() {
+  std::ofstream report{m_reportPath};
+  if (!report) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        fmt::format("Failed to create frame report {}", m_reportPath))};
+  }
+  report << "frame,time_ms\n";
+  for (std::size_t frame{}; frame < m_frameTimes.size(); ++frame) {
+    report << fmt::format("{},{:.4f}\n", frame, m_frameTimes[frame] * 1000.0);
+  }
+}
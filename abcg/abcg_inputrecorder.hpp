@@ -0,0 +1,99 @@
+/**
+ * @file abcg_inputrecorder.hpp
+ * @brief abcg::InputRecorder header file.
+ *
+ * Declaration of abcg::InputRecorder, a recorder of input sessions for
+ * reproducible runs.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_INPUTRECORDER_HPP_
+#define ABCG_INPUTRECORDER_HPP_
+
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "abcg_external.hpp"
+
+namespace abcg {
+class InputRecorder;
+}  // namespace abcg
+
+/**
+ * @brief abcg::InputRecorder class.
+ *
+ * Records the SDL events and the delta time of each frame, together with
+ * the random seed and the window size of the session, to a compact binary
+ * log. Replaying the log feeds the same events with the same delta times,
+ * so that the simulation does not depend on the speed of the machine or of
+ * the build, and measures the wall time of each replayed frame.
+ *
+ * Only keyboard, text input, mouse, window and quit events are recorded.
+ * Numbers are stored in the byte order of the machine.
+ */
+class abcg::InputRecorder {
+ public:
+  enum class Mode { Off, Record, Replay };
+
+  /**
+   * @brief Window size stored in the log.
+   */
+  struct WindowSize {
+    int width{};
+    int height{};
+  };
+
+  void record(std::string_view path);
+  void replay(std::string_view path);
+  void setReportPath(std::string_view path);
+
+  [[nodiscard]] Mode getMode() const noexcept { return m_mode; }
+  [[nodiscard]] std::uint64_t exchangeSeed(std::uint64_t seed);
+  [[nodiscard]] WindowSize getWindowSize() const noexcept {
+    return m_windowSize;
+  }
+  void setWindowSize(WindowSize windowSize) noexcept {
+    m_windowSize = windowSize;
+  }
+
+  void recordFrame(double deltaTime, std::span<const SDL_Event> events);
+  [[nodiscard]] bool replayFrame(double &deltaTime,
+                                 std::vector<SDL_Event> &events);
+  void addFrameTime(double frameTime);
+  void finish();
+
+ private:
+  struct Frame {
+    double deltaTime{};
+    std::size_t firstEvent{};
+    std::size_t numEvents{};
+  };
+
+  Mode m_mode{Mode::Off};
+  std::uint64_t m_seed{};
+  WindowSize m_windowSize{};
+
+  // Recording
+  std::ofstream m_output;
+  bool m_headerWritten{false};
+  std::vector<char> m_frameBuffer;
+
+  // Replay: the whole log is decoded up front
+  std::vector<Frame> m_frames;
+  std::vector<SDL_Event> m_events;
+  std::size_t m_nextFrame{};
+
+  // Wall time of each frame, in seconds
+  std::string m_reportPath;
+  std::vector<double> m_frameTimes;
+
+  void writeHeader();
+  void writeReport();
+};
+
+#endif
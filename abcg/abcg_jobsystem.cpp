@@ -0,0 +1,316 @@
+/**
+ * @file abcg_jobsystem.cpp
+ * @brief Definition of abcg::JobSystem class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_jobsystem.hpp"
+
+#include <fmt/core.h>
+
+#include <chrono>
+
+#include "abcg_tracer.hpp"
+
+namespace {
+// Job system and deque index of the calling thread, if it belongs to one
+thread_local abcg::JobSystem *currentSystem{};
+thread_local std::size_t currentIndex{};
+
+// Upper bound on the time an idle worker sleeps without being notified
+constexpr std::chrono::milliseconds idleTimeout{1};
+}  // namespace
+
+bool abcg::JobSystem::Deque::push(Entry *entry) {
+  const auto bottom{m_bottom.load(std::memory_order_relaxed)};
+  const auto top{m_top.load(std::memory_order_acquire)};
+  if (bottom - top >= capacity) return false;
+  m_buffer[static_cast<std::size_t>(bottom & (capacity - 1))].store(
+      entry, std::memory_order_relaxed);
+  m_bottom.store(bottom + 1, std::memory_order_release);
+  return true;
+}
+
+abcg::JobSystem::Entry *abcg::JobSystem::Deque::pop() {
+  const auto bottom{m_bottom.load(std::memory_order_relaxed) - 1};
+  m_bottom.store(bottom, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  auto top{m_top.load(std::memory_order_relaxed)};
+
+  if (top > bottom) {
+    m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  auto *entry{m_buffer[static_cast<std::size_t>(bottom & (capacity - 1))].load(
+      std::memory_order_relaxed)};
+  if (top == bottom) {
+    // Last element: race against thieves
+    if (!m_top.compare_exchange_strong(top, top + 1,
+                                       std::memory_order_seq_cst,
+                                       std::memory_order_relaxed)) {
+      entry = nullptr;
+    }
+    m_bottom.store(bottom + 1, std::memory_order_relaxed);
+  }
+  return entry;
+}
+
+abcg::JobSystem::Entry *abcg::JobSystem::Deque::steal() {
+  auto top{m_top.load(std::memory_order_acquire)};
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  const auto bottom{m_bottom.load(std::memory_order_acquire)};
+  if (top >= bottom) return nullptr;
+
+  auto *entry{m_buffer[static_cast<std::size_t>(top & (capacity - 1))].load(
+      std::memory_order_relaxed)};
+  if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                     std::memory_order_relaxed)) {
+    return nullptr;
+  }
+  return entry;
+}
+
+/**
+ * @brief Creates the job system and starts its worker threads.
+ *
+ * The calling thread becomes a member of the job system: it can push to its
+ * own deque and executes jobs while waiting on counters.
+ *
+ * @param numWorkers Number of worker threads, not counting the calling
+ * thread. With zero workers, jobs run inline.
+ */
+abcg::JobSystem::JobSystem(std::size_t numWorkers) {
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+  numWorkers = 0;
+#endif
+  currentSystem = this;
+  currentIndex = 0;
+
+  m_deques.resize(numWorkers + 1);
+  for (auto &deque : m_deques) {
+    deque = std::make_unique<Deque>();
+  }
+  m_threads.reserve(numWorkers);
+  for (std::size_t index{1}; index <= numWorkers; ++index) {
+    m_threads.emplace_back([this, index] { workerLoop(index); });
+  }
+}
+
+/**
+ * @brief Stops the workers and runs the jobs that were still queued.
+ */
+abcg::JobSystem::~JobSystem() {
+  m_stop.store(true);
+  m_wake.notify_all();
+  for (auto &thread : m_threads) {
+    thread.join();
+  }
+  m_threads.clear();
+
+  std::size_t victim{};
+  while (auto *entry{findJob(victim)}) {
+    execute(entry);
+  }
+  if (currentSystem == this) currentSystem = nullptr;
+
+  while (m_freeEntries != nullptr) {
+    const std::unique_ptr<Entry> entry{m_freeEntries};
+    m_freeEntries = entry->next;
+  }
+}
+
+/**
+ * @brief Submits a job.
+ *
+ * @param job Function to be executed. If it throws, the exception is
+ * rethrown by abcg::JobSystem::wait on the counter. Without a counter, the
+ * job must not throw.
+ * @param counter Optional counter incremented now and decremented when the
+ * job finishes.
+ */
+void abcg::JobSystem::run(Job job, Counter *counter) {
+  if (counter != nullptr) {
+    counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+  }
+  submit(makeEntry(std::move(job), counter));
+}
+
+/**
+ * @brief Submits a job once all jobs of a counter are finished.
+ *
+ * The job runs even if a job of the dependency threw.
+ *
+ * @param dependency Counter the job depends on.
+ * @param job Function to be executed, under the same rules as in
+ * abcg::JobSystem::run.
+ * @param counter Optional counter incremented now and decremented when the
+ * job finishes.
+ */
+void abcg::JobSystem::runAfter(Counter &dependency, Job job,
+                               Counter *counter) {
+  if (counter != nullptr) {
+    counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+  }
+  {
+    const std::lock_guard lock{dependency.m_mutex};
+    if (!dependency.isDone()) {
+      dependency.m_continuations.emplace_back(std::move(job), counter);
+      return;
+    }
+  }
+  submit(makeEntry(std::move(job), counter));
+}
+
+/**
+ * @brief Blocks until all jobs of a counter are finished, executing queued
+ * jobs in the meantime.
+ *
+ * @param counter Counter to wait on.
+ *
+ * @throw The first exception thrown by a job of the counter since the last
+ * wait on it. The other jobs of the counter are finished by then.
+ */
+void abcg::JobSystem::wait(Counter &counter) {
+  std::size_t victim{currentSystem == this ? currentIndex : 0};
+  while (!counter.isDone()) {
+    if (auto *entry{findJob(victim)}) {
+      execute(entry);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  std::exception_ptr error;
+  {
+    // The last job may still be releasing the counter
+    const std::lock_guard lock{counter.m_mutex};
+    error = std::exchange(counter.m_error, nullptr);
+  }
+  if (error) std::rethrow_exception(error);
+}
+
+/**
+ * @brief Default number of workers: one less than the number of hardware
+ * threads, or zero without thread support.
+ */
+std::size_t abcg::JobSystem::getDefaultNumWorkers() {
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+  return 0;
+#else
+  const auto hardwareThreads{std::thread::hardware_concurrency()};
+  return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+#endif
+}
+
+abcg::JobSystem::Entry *abcg::JobSystem::makeEntry(Job job,
+                                                   Counter *counter) {
+  Entry *entry{};
+  {
+    const std::lock_guard lock{m_entryMutex};
+    entry = m_freeEntries;
+    if (entry != nullptr) m_freeEntries = entry->next;
+  }
+  if (entry == nullptr) entry = new Entry{};
+  entry->job = std::move(job);
+  entry->counter = counter;
+  entry->next = nullptr;
+  return entry;
+}
+
+void abcg::JobSystem::recycle(Entry *entry) noexcept {
+  const std::lock_guard lock{m_entryMutex};
+  entry->next = m_freeEntries;
+  m_freeEntries = entry;
+}
+
+void abcg::JobSystem::submit(Entry *entry) {
+  if (m_threads.empty()) {
+    execute(entry);
+    return;
+  }
+
+  if (currentSystem == this) {
+    if (!m_deques[currentIndex]->push(entry)) {
+      execute(entry);
+      return;
+    }
+  } else {
+    const std::lock_guard lock{m_sharedMutex};
+    m_sharedQueue.push_back(entry);
+  }
+  m_queued.fetch_add(1, std::memory_order_release);
+  m_wake.notify_one();
+}
+
+abcg::JobSystem::Entry *abcg::JobSystem::findJob(std::size_t &victim) {
+  Entry *entry{};
+  if (currentSystem == this) {
+    entry = m_deques[currentIndex]->pop();
+  }
+  if (entry == nullptr) {
+    const std::lock_guard lock{m_sharedMutex};
+    if (!m_sharedQueue.empty()) {
+      entry = m_sharedQueue.front();
+      m_sharedQueue.pop_front();
+    }
+  }
+  for (std::size_t attempt{}; entry == nullptr && attempt < m_deques.size();
+       ++attempt) {
+    victim = (victim + 1) % m_deques.size();
+    entry = m_deques[victim]->steal();
+  }
+  if (entry != nullptr) m_queued.fetch_sub(1, std::memory_order_relaxed);
+  return entry;
+}
+
+void abcg::JobSystem::execute(Entry *entry) {
+  const Job job{std::move(entry->job)};
+  auto *counter{entry->counter};
+  recycle(entry);
+  {
+    ABCG_TRACE_SCOPE("Job");
+    if (counter == nullptr) {
+      job();
+    } else {
+      try {
+        job();
+      } catch (...) {
+        const std::lock_guard lock{counter->m_mutex};
+        if (!counter->m_error) counter->m_error = std::current_exception();
+      }
+    }
+  }
+  if (counter != nullptr) complete(*counter);
+}
+
+void abcg::JobSystem::complete(Counter &counter) {
+  std::vector<std::pair<Job, Counter *>> continuations;
+  {
+    const std::lock_guard lock{counter.m_mutex};
+    if (counter.m_pending.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+      return;
+    }
+    continuations.swap(counter.m_continuations);
+  }
+  for (auto &[job, continuationCounter] : continuations) {
+    submit(makeEntry(std::move(job), continuationCounter));
+  }
+}
+
+void abcg::JobSystem::workerLoop(std::size_t index) {
+  currentSystem = this;
+  currentIndex = index;
+  ABCG_TRACE_THREAD_NAME(fmt::format("Worker {}", index));
+  std::size_t victim{index};
+  while (!m_stop.load(std::memory_order_relaxed)) {
+    if (auto *entry{findJob(victim)}) {
+      execute(entry);
+      continue;
+    }
+    std::unique_lock lock{m_wakeMutex};
+    m_wake.wait_for(lock, idleTimeout, [this] {
+      return m_queued.load(std::memory_order_acquire) > 0 ||
+             m_stop.load(std::memory_order_relaxed);
+    });
+  }
+}
@@ -0,0 +1,169 @@
+/**
+ * @file abcg_jobsystem.hpp
+ * @brief abcg::JobSystem header file.
+ *
+ * Declaration of abcg::JobSystem, a work-stealing thread pool.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_JOBSYSTEM_HPP_
+#define ABCG_JOBSYSTEM_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace abcg {
+class JobSystem;
+}  // namespace abcg
+
+/**
+ * @brief abcg::JobSystem class.
+ *
+ * Each thread of the pool owns a lock-free work-stealing deque (Chase-Lev):
+ * jobs spawned by a worker are pushed to and popped from the bottom of its
+ * own deque, and idle workers steal from the top of the deques of others.
+ * The thread that creates the job system takes part in the execution when
+ * it waits on a counter ("help while waiting"). Jobs submitted from any
+ * other thread go through a shared queue.
+ *
+ * Completion is tracked with abcg::JobSystem::Counter, which can also hold
+ * continuations that are submitted when the counter reaches zero. An
+ * exception thrown by a job is kept by its counter and rethrown by
+ * abcg::JobSystem::wait. Jobs without a counter must not throw.
+ *
+ * With zero workers, or in Emscripten builds without pthreads, the job
+ * system is an inline executor: jobs run immediately on the calling thread.
+ */
+class abcg::JobSystem {
+ public:
+  using Job = std::function<void()>;
+
+  /**
+   * @brief Number of jobs still pending in a group.
+   */
+  class Counter {
+   public:
+    [[nodiscard]] bool isDone() const {
+      return m_pending.load(std::memory_order_acquire) == 0;
+    }
+
+   private:
+    friend class JobSystem;
+    std::atomic<int> m_pending{};
+    std::mutex m_mutex;
+    std::vector<std::pair<Job, Counter *>> m_continuations;
+    // First exception thrown by a job of the group, for wait to rethrow
+    std::exception_ptr m_error;
+  };
+
+  explicit JobSystem(std::size_t numWorkers = getDefaultNumWorkers());
+  ~JobSystem();
+
+  JobSystem(const JobSystem &) = delete;
+  JobSystem(JobSystem &&) = delete;
+  JobSystem &operator=(const JobSystem &) = delete;
+  JobSystem &operator=(JobSystem &&) = delete;
+
+  void run(Job job, Counter *counter = nullptr);
+  void runAfter(Counter &dependency, Job job, Counter *counter = nullptr);
+  void wait(Counter &counter);
+
+  template <typename TFunction>
+  void parallelFor(std::size_t begin, std::size_t end, std::size_t grainSize,
+                   TFunction &&function);
+
+  [[nodiscard]] std::size_t getNumWorkers() const { return m_threads.size(); }
+  [[nodiscard]] static std::size_t getDefaultNumWorkers();
+
+ private:
+  struct Entry {
+    Job job;
+    Counter *counter{};
+    // Next entry of the free list
+    Entry *next{};
+  };
+
+  // Chase-Lev deque of fixed capacity (Le et al., "Correct and Efficient
+  // Work-Stealing for Weak Memory Models", 2013)
+  class Deque {
+   public:
+    bool push(Entry *entry);
+    Entry *pop();
+    Entry *steal();
+
+   private:
+    static constexpr std::int64_t capacity{4096};
+    std::atomic<std::int64_t> m_top{};
+    std::atomic<std::int64_t> m_bottom{};
+    std::unique_ptr<std::atomic<Entry *>[]> m_buffer{
+        new std::atomic<Entry *>[capacity]};
+  };
+
+  std::vector<std::unique_ptr<Deque>> m_deques;
+  std::vector<std::thread> m_threads;
+
+  std::mutex m_sharedMutex;
+  std::deque<Entry *> m_sharedQueue;
+
+  // Entries of finished jobs, reused so that steady-state submission does
+  // not allocate
+  std::mutex m_entryMutex;
+  Entry *m_freeEntries{};
+
+  std::mutex m_wakeMutex;
+  std::condition_variable m_wake;
+  std::atomic<int> m_queued{};
+  std::atomic<bool> m_stop{false};
+
+  Entry *makeEntry(Job job, Counter *counter);
+  void recycle(Entry *entry) noexcept;
+  void submit(Entry *entry);
+  Entry *findJob(std::size_t &victim);
+  void execute(Entry *entry);
+  void complete(Counter &counter);
+  void workerLoop(std::size_t index);
+};
+
+/**
+ * @brief Runs function(first, last) over [begin, end) split into chunks of
+ * at most grainSize elements, and waits for all of them.
+ *
+ * @param begin First index.
+ * @param end One past the last index.
+ * @param grainSize Maximum number of elements per job.
+ * @param function Callable taking the bounds of a chunk.
+ */
+template <typename TFunction>
+void abcg::JobSystem::parallelFor(std::size_t begin, std::size_t end,
+                                  std::size_t grainSize,
+                                  TFunction &&function) {
+  if (begin >= end) return;
+  grainSize = std::max<std::size_t>(grainSize, 1);
+  if (m_threads.empty() || end - begin <= grainSize) {
+    function(begin, end);
+    return;
+  }
+
+  const auto chunk{[&](std::size_t first) {
+    function(first, first + std::min(grainSize, end - first));
+  }};
+  Counter counter;
+  for (auto first{begin}; first < end; first += grainSize) {
+    // Two words, small enough for std::function to store without allocating
+    run([&chunk, first] { chunk(first); }, &counter);
+  }
+  wait(counter);
+}
+
+#endif
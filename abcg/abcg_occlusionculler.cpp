@@ -0,0 +1,295 @@
+/**
+ * @file abcg_occlusionculler.cpp
+ * @brief Definition of abcg::OcclusionCuller class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_occlusionculler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+#include "abcg_elapsedtimer.hpp"
+#include "abcg_exception.hpp"
+#include "abcg_jobsystem.hpp"
+#include "abcg_simd.hpp"
+
+namespace {
+// Smallest view-space distance an occluder or occludee may have to be
+// projected safely
+constexpr float minDepth{1e-3f};
+
+// Number of occludees tested per job
+constexpr std::size_t boxesPerJob{256};
+
+// Half the diagonal of a pixel. Occluder discs are shrunk by this amount so
+// that a pixel is only written when it is fully covered.
+constexpr float halfPixelDiagonal{0.7072f};
+}  // namespace
+
+/**
+ * @brief Constructs an occlusion culler with a depth buffer of given size.
+ *
+ * @param width Depth buffer width in pixels.
+ * @param height Depth buffer height in pixels.
+ *
+ * @throw abcg::Exception if the size is not positive.
+ */
+abcg::OcclusionCuller::OcclusionCuller(int width, int height)
+    : m_width{width}, m_height{height} {
+  if (width <= 0 || height <= 0) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Invalid occlusion buffer size")};
+  }
+  m_depthBuffer.resize(static_cast<std::size_t>(width) *
+                       static_cast<std::size_t>(height));
+}
+
+abcg::OcclusionCuller::~OcclusionCuller() {
+  if (m_jobSystem != nullptr) m_jobSystem->wait(m_pending);
+}
+
+/**
+ * @brief Sets the job system used to test the occludees in parallel.
+ *
+ * @param jobSystem Job system, or nullptr to test on the culling thread only.
+ */
+void abcg::OcclusionCuller::setJobSystem(JobSystem *jobSystem) {
+  wait();
+  m_jobSystem = jobSystem;
+}
+
+/**
+ * @brief Sets the camera used to project occluders and occludees.
+ *
+ * @param viewMatrix World to view space transform.
+ * @param projMatrix View to clip space transform.
+ */
+void abcg::OcclusionCuller::setCamera(const glm::mat4 &viewMatrix,
+                                      const glm::mat4 &projMatrix) {
+  wait();
+  m_viewMatrix = viewMatrix;
+  m_projMatrix = projMatrix;
+}
+
+void abcg::OcclusionCuller::clearOccluders() {
+  wait();
+  m_occluders.clear();
+}
+
+/**
+ * @brief Adds a spherical occluder.
+ *
+ * @param center Center of the sphere in world space.
+ * @param radius Radius of a sphere fully contained in the occluder geometry.
+ */
+void abcg::OcclusionCuller::addOccluder(const glm::vec3 &center,
+                                        float radius) {
+  wait();
+  m_occluders.push_back({center, radius});
+}
+
+/**
+ * @brief Rasterizes the occluders and tests the given boxes synchronously.
+ *
+ * @param boxes World-space bounding boxes of the instances to be tested.
+ */
+void abcg::OcclusionCuller::cull(std::span<const BoundingBox> boxes) {
+  wait();
+  m_boxes = boxes;
+  run();
+}
+
+/**
+ * @brief Rasterizes the occluders and tests the given boxes as a job of the
+ * job system.
+ *
+ * The boxes must stay alive and unchanged until abcg::OcclusionCuller::wait
+ * returns. Without a job system, or when the job system has no workers, the
+ * boxes are tested before this function returns.
+ *
+ * @param boxes World-space bounding boxes of the instances to be tested.
+ */
+void abcg::OcclusionCuller::cullAsync(std::span<const BoundingBox> boxes) {
+  wait();
+  m_boxes = boxes;
+  if (m_jobSystem == nullptr) {
+    run();
+    return;
+  }
+  m_jobSystem->run([this] { run(); }, &m_pending);
+}
+
+/**
+ * @brief Blocks until the pending asynchronous cull, if any, is finished.
+ *
+ * The calling thread executes queued jobs in the meantime.
+ */
+void abcg::OcclusionCuller::wait() {
+  if (m_jobSystem != nullptr) m_jobSystem->wait(m_pending);
+}
+
+bool abcg::OcclusionCuller::isVisible(std::size_t index) const {
+  return index >= m_visibility.size() || m_visibility[index] != 0;
+}
+
+std::span<const std::uint8_t> abcg::OcclusionCuller::getVisibility() const {
+  return m_visibility;
+}
+
+std::span<const float> abcg::OcclusionCuller::getDepthBuffer() const {
+  return m_depthBuffer;
+}
+
+abcg::OcclusionCuller::Statistics abcg::OcclusionCuller::getStatistics()
+    const {
+  return m_statistics;
+}
+
+void abcg::OcclusionCuller::run() {
+  ElapsedTimer timer;
+
+  std::fill(m_depthBuffer.begin(), m_depthBuffer.end(),
+            std::numeric_limits<float>::infinity());
+  for (const auto &occluder : m_occluders) {
+    rasterizeOccluder(occluder);
+  }
+
+  m_visibility.resize(m_boxes.size());
+  std::atomic<std::size_t> occluded{};
+  const auto testRange{[&](std::size_t first, std::size_t last) {
+    std::size_t rangeOccluded{};
+    for (auto index{first}; index < last; ++index) {
+      const bool visible{testBox(m_boxes[index])};
+      m_visibility[index] = visible ? 1 : 0;
+      if (!visible) ++rangeOccluded;
+    }
+    occluded.fetch_add(rangeOccluded, std::memory_order_relaxed);
+  }};
+  if (m_jobSystem != nullptr) {
+    m_jobSystem->parallelFor(0, m_boxes.size(), boxesPerJob, testRange);
+  } else {
+    testRange(0, m_boxes.size());
+  }
+
+  m_statistics.occluders = m_occluders.size();
+  m_statistics.tested = m_boxes.size();
+  m_statistics.occluded = occluded.load();
+  m_statistics.elapsedTime = timer.elapsed();
+}
+
+void abcg::OcclusionCuller::rasterizeOccluder(const Occluder &occluder) {
+  // The disc of the sphere facing the viewing direction is inside the sphere
+  // and projects to an axis-aligned ellipse with constant depth
+  const glm::vec4 center{m_viewMatrix * glm::vec4(occluder.center, 1.0f)};
+  const float depth{-center.z};
+  if (depth - occluder.radius < minDepth) return;
+
+  const auto toWindow{[&](const glm::vec4 &viewPosition) {
+    const glm::vec4 clip{m_projMatrix * viewPosition};
+    return glm::vec2((clip.x / clip.w * 0.5f + 0.5f) *
+                         static_cast<float>(m_width),
+                     (clip.y / clip.w * 0.5f + 0.5f) *
+                         static_cast<float>(m_height));
+  }};
+  const glm::vec2 centerWindow{toWindow(center)};
+  const glm::vec2 edgeX{
+      toWindow(center + glm::vec4(occluder.radius, 0.0f, 0.0f, 0.0f))};
+  const glm::vec2 edgeY{
+      toWindow(center + glm::vec4(0.0f, occluder.radius, 0.0f, 0.0f))};
+  const float radiusX{std::abs(edgeX.x - centerWindow.x) - halfPixelDiagonal};
+  const float radiusY{std::abs(edgeY.y - centerWindow.y) - halfPixelDiagonal};
+  if (radiusX <= 0.0f || radiusY <= 0.0f) return;
+
+  const int firstRow{std::max(
+      0, static_cast<int>(std::ceil(centerWindow.y - radiusY - 0.5f)))};
+  const int lastRow{std::min(
+      m_height - 1,
+      static_cast<int>(std::floor(centerWindow.y + radiusY - 0.5f)))};
+  const auto depth4{simd::broadcast(depth)};
+
+  for (int row{firstRow}; row <= lastRow; ++row) {
+    const float dy{(static_cast<float>(row) + 0.5f - centerWindow.y) /
+                   radiusY};
+    const float squared{1.0f - dy * dy};
+    if (squared <= 0.0f) continue;
+    const float halfWidth{radiusX * std::sqrt(squared)};
+    const int first{std::max(
+        0, static_cast<int>(std::ceil(centerWindow.x - halfWidth - 0.5f)))};
+    const int last{std::min(
+        m_width - 1,
+        static_cast<int>(std::floor(centerWindow.x + halfWidth - 0.5f)))};
+    if (first > last) continue;
+
+    float *pixels{m_depthBuffer.data() +
+                  static_cast<std::ptrdiff_t>(row) * m_width};
+    int column{first};
+    for (; column + simd::width - 1 <= last; column += simd::width) {
+      simd::store(pixels + column,
+                  simd::min(simd::load(pixels + column), depth4));
+    }
+    for (; column <= last; ++column) {
+      pixels[column] = std::min(pixels[column], depth);
+    }
+  }
+}
+
+bool abcg::OcclusionCuller::testBox(const BoundingBox &box) const {
+  const std::array corners{glm::vec4(box.min.x, box.min.y, box.min.z, 1.0f),
+                           glm::vec4(box.max.x, box.min.y, box.min.z, 1.0f),
+                           glm::vec4(box.min.x, box.max.y, box.min.z, 1.0f),
+                           glm::vec4(box.max.x, box.max.y, box.min.z, 1.0f),
+                           glm::vec4(box.min.x, box.min.y, box.max.z, 1.0f),
+                           glm::vec4(box.max.x, box.min.y, box.max.z, 1.0f),
+                           glm::vec4(box.min.x, box.max.y, box.max.z, 1.0f),
+                           glm::vec4(box.max.x, box.max.y, box.max.z, 1.0f)};
+
+  glm::vec2 windowMin{std::numeric_limits<float>::max()};
+  glm::vec2 windowMax{std::numeric_limits<float>::lowest()};
+  float nearestDepth{std::numeric_limits<float>::max()};
+  for (const auto &corner : corners) {
+    const glm::vec4 viewPosition{m_viewMatrix * corner};
+    const float depth{-viewPosition.z};
+    // Boxes crossing the near plane cannot be bounded on screen
+    if (depth < minDepth) return true;
+    const glm::vec4 clip{m_projMatrix * viewPosition};
+    const glm::vec2 window{
+        (clip.x / clip.w * 0.5f + 0.5f) * static_cast<float>(m_width),
+        (clip.y / clip.w * 0.5f + 0.5f) * static_cast<float>(m_height)};
+    windowMin = glm::min(windowMin, window);
+    windowMax = glm::max(windowMax, window);
+    nearestDepth = std::min(nearestDepth, depth);
+  }
+
+  const int firstColumn{
+      std::max(0, static_cast<int>(std::floor(windowMin.x)))};
+  const int lastColumn{
+      std::min(m_width - 1, static_cast<int>(std::floor(windowMax.x)))};
+  const int firstRow{std::max(0, static_cast<int>(std::floor(windowMin.y)))};
+  const int lastRow{
+      std::min(m_height - 1, static_cast<int>(std::floor(windowMax.y)))};
+  // Outside the buffer: leave it to frustum culling
+  if (firstColumn > lastColumn || firstRow > lastRow) return true;
+
+  // Visible as soon as a single pixel of the rectangle is not closer than the
+  // nearest point of the box
+  const auto nearest4{simd::broadcast(nearestDepth)};
+  for (int row{firstRow}; row <= lastRow; ++row) {
+    const float *pixels{m_depthBuffer.data() +
+                        static_cast<std::ptrdiff_t>(row) * m_width};
+    int column{firstColumn};
+    for (; column + simd::width - 1 <= lastColumn; column += simd::width) {
+      const auto mask{
+          simd::greaterEqual(simd::load(pixels + column), nearest4)};
+      if (simd::moveMask(mask) != 0) return true;
+    }
+    for (; column <= lastColumn; ++column) {
+      if (pixels[column] >= nearestDepth) return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file abcg_occlusionculler.hpp
+ * @brief abcg::OcclusionCuller header file.
+ *
+ * Declaration of abcg::OcclusionCuller, a CPU occlusion culling stage based
+ * on a low-resolution software depth buffer.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_OCCLUSIONCULLER_HPP_
+#define ABCG_OCCLUSIONCULLER_HPP_
+
+#include <cstdint>
+#include <glm/mat4x4.hpp>
+#include <span>
+#include <vector>
+
+#include "abcg_boundingbox.hpp"
+#include "abcg_jobsystem.hpp"
+
+namespace abcg {
+class OcclusionCuller;
+}  // namespace abcg
+
+/**
+ * @brief abcg::OcclusionCuller class.
+ *
+ * Occluders are approximated by spheres and rasterized into a small linear
+ * depth buffer (view-space distance along the viewing direction). Each
+ * occluder writes the depth of its center over a disc inscribed in its
+ * silhouette, so the buffer never claims more coverage than the real
+ * geometry. Occludees are axis-aligned bounding boxes whose screen-space
+ * rectangle is tested against the buffer four pixels at a time.
+ *
+ * When a job system is set, abcg::OcclusionCuller::cullAsync runs on one of
+ * its workers and the occludee tests are split among them.
+ *
+ * The class does not issue any OpenGL call and can be used headless.
+ */
+class abcg::OcclusionCuller {
+ public:
+  struct Statistics {
+    std::size_t occluders{};
+    std::size_t tested{};
+    std::size_t occluded{};
+    double elapsedTime{};
+
+    [[nodiscard]] float occludedRatio() const {
+      return tested == 0 ? 0.0f
+                         : static_cast<float>(occluded) /
+                               static_cast<float>(tested);
+    }
+  };
+
+  explicit OcclusionCuller(int width = 128, int height = 64);
+  ~OcclusionCuller();
+
+  OcclusionCuller(const OcclusionCuller&) = delete;
+  OcclusionCuller(OcclusionCuller&&) = delete;
+  OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+  OcclusionCuller& operator=(OcclusionCuller&&) = delete;
+
+  void setJobSystem(JobSystem* jobSystem);
+  void setCamera(const glm::mat4& viewMatrix, const glm::mat4& projMatrix);
+  void clearOccluders();
+  void addOccluder(const glm::vec3& center, float radius);
+
+  void cull(std::span<const BoundingBox> boxes);
+  void cullAsync(std::span<const BoundingBox> boxes);
+  void wait();
+
+  [[nodiscard]] bool isVisible(std::size_t index) const;
+  [[nodiscard]] std::span<const std::uint8_t> getVisibility() const;
+  [[nodiscard]] std::span<const float> getDepthBuffer() const;
+  [[nodiscard]] Statistics getStatistics() const;
+  [[nodiscard]] int getWidth() const { return m_width; }
+  [[nodiscard]] int getHeight() const { return m_height; }
+
+ private:
+  struct Occluder {
+    glm::vec3 center{};
+    float radius{};
+  };
+
+  int m_width{};
+  int m_height{};
+
+  glm::mat4 m_viewMatrix{1.0f};
+  glm::mat4 m_projMatrix{1.0f};
+
+  std::vector<Occluder> m_occluders;
+  std::vector<float> m_depthBuffer;
+  std::vector<std::uint8_t> m_visibility;
+  std::span<const BoundingBox> m_boxes;
+
+  Statistics m_statistics{};
+  JobSystem* m_jobSystem{};
+  // Pending asynchronous cull, see cullAsync
+  JobSystem::Counter m_pending;
+
+  void run();
+  void rasterizeOccluder(const Occluder& occluder);
+  [[nodiscard]] bool testBox(const BoundingBox& box) const;
+};
+
+#endif
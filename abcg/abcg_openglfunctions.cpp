@@ -7,9 +7,66 @@
 
 #include "abcg_openglfunctions.hpp"
 
+#include <fmt/core.h>
+
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
 #include "abcg_exception.hpp"
 
 #if !defined(NDEBUG) && !defined(__EMSCRIPTEN__) && !defined(__APPLE__)
+namespace {
+// First error received by the debug output callback, waiting to be thrown
+std::mutex debugErrorMutex;
+std::string debugErrorMessage;
+abcg::sl debugErrorLocation{};
+
+// Identifiers of the warnings already printed
+std::unordered_set<GLuint> printedWarnings;
+
+std::string_view getDebugTypeString(GLenum type) {
+  switch (type) {
+    case GL_DEBUG_TYPE_ERROR:
+      return "error";
+    case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+      return "deprecated behavior";
+    case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+      return "undefined behavior";
+    case GL_DEBUG_TYPE_PORTABILITY:
+      return "portability";
+    case GL_DEBUG_TYPE_PERFORMANCE:
+      return "performance";
+    default:
+      return "message";
+  }
+}
+
+// Receives the messages of the debug output, possibly on a thread of the
+// driver. Errors are kept for the next wrapped call, which throws them,
+// since the callback must not throw. Warnings of high and medium severity
+// are printed once per message.
+void GLAPIENTRY debugMessageCallback(GLenum /*source*/, GLenum type, GLuint id,
+                                     GLenum severity, GLsizei length,
+                                     const GLchar *message,
+                                     const void * /*userParam*/) {
+  const std::string_view text{
+      message, length < 0 ? std::string_view{message}.size()
+                          : static_cast<std::size_t>(length)};
+  const std::scoped_lock lock{debugErrorMutex};
+  if (type == GL_DEBUG_TYPE_ERROR) {
+    if (abcg::pendingGLDebugError.load(std::memory_order_relaxed)) return;
+    debugErrorMessage = text;
+    debugErrorLocation = abcg::lastGLCall;
+    abcg::pendingGLDebugError.store(true, std::memory_order_release);
+  } else if ((severity == GL_DEBUG_SEVERITY_HIGH ||
+              severity == GL_DEBUG_SEVERITY_MEDIUM) &&
+             printedWarnings.insert(id).second) {
+    fmt::print("Warning: OpenGL {}: {}\n", getDebugTypeString(type), text);
+  }
+}
+}  // namespace
+
 /**
  * @brief Checks OpenGL error status and throws on error with a log message.
  *
@@ -27,4 +84,63 @@ void abcg::checkGLError(
         abcg::Exception::OpenGL(prefix, status, sourceLocation)};
   }
 }
-#endif
\ No newline at end of file
+
+/**
+ * @brief Reports OpenGL errors through the KHR_debug output of the current
+ * context instead of glGetError, unless synchronous checks are requested.
+ *
+ * Messages are delivered asynchronously, so callGL no longer synchronizes
+ * with the GPU, but an error is thrown by a wrapped call made after the
+ * failing one. The context should be created with the debug flag, without
+ * which drivers may report less.
+ *
+ * @return Whether the debug output is supported and was enabled. If not,
+ * errors are still checked synchronously.
+ */
+bool abcg::enableGLDebugOutput() {
+  if (!GLEW_VERSION_4_3 && !GLEW_KHR_debug) return false;
+
+  // Called directly, since the wrappers are still checking synchronously
+  ::glEnable(GL_DEBUG_OUTPUT);
+  ::glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+  ::glDebugMessageCallback(debugMessageCallback, nullptr);
+  ::glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE,
+                          GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+  synchronousGLErrors = false;
+  return true;
+}
+
+/**
+ * @brief Throws the error received by the debug output.
+ *
+ * The error is located at the last call made before the callback on the
+ * thread that received it, if any: drivers that report errors during the
+ * failing call run the callback on the calling thread. Otherwise, it is
+ * located near the given call.
+ *
+ * @param sourceLocation Call that noticed the error.
+ *
+ * @throw abcg::Exception with a log message.
+ */
+void abcg::throwGLDebugError(const sl &sourceLocation) {
+  std::string message;
+  sl location{};
+  {
+    const std::scoped_lock lock{debugErrorMutex};
+    message = std::move(debugErrorMessage);
+    location = debugErrorLocation;
+    pendingGLDebugError.store(false, std::memory_order_relaxed);
+  }
+  // Clear the error flags, which the debug output leaves set
+  while (glGetError() != GL_NO_ERROR) {
+  }
+
+  if (location.line() == 0) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        fmt::format("OpenGL error ({}) near this call", message),
+        sourceLocation)};
+  }
+  throw abcg::Exception{abcg::Exception::Runtime(
+      fmt::format("OpenGL error ({})", message), location)};
+}
+#endif
@@ -3,7 +3,8 @@
  * @brief Declaration of OpenGL-related error checking functions.
  *
  * Error checking wrappers for OpenGL functions are defined here as inline
- * functions.
+ * functions. In debug builds, errors come from the KHR_debug output when
+ * available, and from glGetError around every call otherwise.
  *
  * This project is released under the MIT License.
  */
@@ -15,18 +16,37 @@
 #include <experimental/source_location>
 #endif
 
+#include <atomic>
 #include <string_view>
 
 #include "abcg_external.hpp"
+#include "abcg_glstats.hpp"
+#include "abcg_resourcetracker.hpp"
 
 namespace abcg {
 #if !defined(NDEBUG) && !defined(__EMSCRIPTEN__) && !defined(__APPLE__)
 using sl = std::experimental::source_location;
 
 void checkGLError(const sl& sourceLocation, std::string_view prefix);
+bool enableGLDebugOutput();
+[[noreturn]] void throwGLDebugError(const sl& sourceLocation);
+
+// Whether callGL calls glGetError before and after every call. Stays on
+// until abcg::enableGLDebugOutput succeeds.
+inline bool synchronousGLErrors{true};
+// Set by the debug output callback when it receives an error
+inline std::atomic<bool> pendingGLDebugError{false};
+// Last call made by callGL on this thread, blamed for the errors of the
+// debug output callback when it runs on the same thread
+inline thread_local sl lastGLCall{};
 
 /**
- * @brief Check for OpenGL errors before and after a function call.
+ * @brief Check for OpenGL errors around a function call.
+ *
+ * With the debug output of abcg::enableGLDebugOutput, errors arrive
+ * asynchronously and are thrown by the next call, which costs no
+ * synchronization with the GPU. Otherwise, glGetError is checked before
+ * and after the call.
  *
  * @tparam TFun Function typename.
  * @tparam TArgs Variadic arguments typename.
@@ -37,17 +57,27 @@ void checkGLError(const sl& sourceLocation, std::string_view prefix);
  */
 template <typename TFun, typename... TArgs>
 auto callGL(const sl& sourceLocation, TFun&& function, TArgs&&... args) {
-  checkGLError(sourceLocation, "BEFORE function call");
+  ABCG_GL_STATS(countCall());
+  const auto check{[&](std::string_view prefix) {
+    if (synchronousGLErrors) {
+      checkGLError(sourceLocation, prefix);
+    } else if (pendingGLDebugError.load(std::memory_order_acquire)) {
+      throwGLDebugError(sourceLocation);
+    }
+  }};
+  check("BEFORE function call");
+  lastGLCall = sourceLocation;
   if constexpr (!std::is_void<
                     typename std::result_of<TFun(TArgs...)>::type>::value) {
     // Specialization for functions that do not return void
     auto&& res = std::forward<TFun>(function)(std::forward<TArgs>(args)...);
-    checkGLError(sourceLocation, "AFTER function call");
+    check("AFTER function call");
     return res;
+  } else {
+    // Specialization for functions that return void
+    std::forward<TFun>(function)(std::forward<TArgs>(args)...);
+    check("AFTER function call");
   }
-  // Specialization for functions that return void
-  std::forward<TFun>(function)(std::forward<TArgs>(args)...);
-  checkGLError(sourceLocation, "AFTER function call");
 }
 
 #else
@@ -67,14 +97,16 @@ struct sl {
  */
 template <typename TFun, typename... TArgs>
 auto callGL([[maybe_unused]] sl /*unused*/, TFun&& function, TArgs&&... args) {
+  ABCG_GL_STATS(countCall());
   if constexpr (!std::is_void<
                     typename std::result_of<TFun(TArgs...)>::type>::value) {
     // Specialization for functions that do not return void
     auto&& res = std::forward<TFun>(function)(std::forward<TArgs>(args)...);
     return res;
+  } else {
+    // Specialization for functions that return void
+    std::forward<TFun>(function)(std::forward<TArgs>(args)...);
   }
-  // Specialization for functions that return void
-  std::forward<TFun>(function)(std::forward<TArgs>(args)...);
 }
 #endif
 
@@ -82,6 +114,7 @@ auto callGL([[maybe_unused]] sl /*unused*/, TFun&& function, TArgs&&... args) {
 
 inline void glActiveTexture(GLenum texture,
                             const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(setActiveTexture(texture));
   callGL(sourceLocation, ::glActiveTexture, texture);
 }
 inline void glAttachShader(GLuint program, GLuint shader,
@@ -96,6 +129,7 @@ inline void glBindAttribLocation(GLuint program, GLuint index,
 inline void glBindBuffer(GLenum target, GLuint buffer,
                          const sl& sourceLocation = sl::current()) {
   callGL(sourceLocation, ::glBindBuffer, target, buffer);
+  ABCG_TRACK_GL(bindBuffer(target, buffer));
 }
 inline void glBindFramebuffer(GLenum target, GLuint framebuffer,
                               const sl& sourceLocation = sl::current()) {
@@ -107,39 +141,48 @@ inline void glBindRenderbuffer(GLenum target, GLuint renderbuffer,
 }
 inline void glBindTexture(GLenum target, GLuint texture,
                           const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countTextureBind(target, texture));
   callGL(sourceLocation, ::glBindTexture, target, texture);
 }
 inline void glBlendColor(GLfloat red, GLfloat green, GLfloat blue,
                          GLfloat alpha,
                          const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glBlendColor, red, green, blue, alpha);
 }
 inline void glBlendEquation(GLenum mode,
                             const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glBlendEquation, mode);
 }
 inline void glBlendEquationSeparate(GLenum modeRGB, GLenum modeAlpha,
                                     const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glBlendEquationSeparate, modeRGB, modeAlpha);
 }
 inline void glBlendFunc(GLenum sfactor, GLenum dfactor,
                         const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glBlendFunc, sfactor, dfactor);
 }
 inline void glBlendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha,
                                 GLenum dstAlpha,
                                 const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glBlendFuncSeparate, srcRGB, dstRGB, srcAlpha,
          dstAlpha);
 }
 inline void glBufferData(GLenum target, GLsizeiptr size, const void* data,
                          GLenum usage,
                          const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countBufferUpload(data, size));
   callGL(sourceLocation, ::glBufferData, target, size, data, usage);
+  ABCG_TRACK_GL(bufferData(target, size, usage));
 }
 inline void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size,
                             const void* data,
                             const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countBufferUpload(data, size));
   callGL(sourceLocation, ::glBufferSubData, target, offset, size, data);
 }
 inline GLenum glCheckFramebufferStatus(
@@ -152,17 +195,21 @@ inline void glClear(GLbitfield mask, const sl& sourceLocation = sl::current()) {
 inline void glClearColor(GLclampf red, GLclampf green, GLclampf blue,
                          GLclampf alpha,
                          const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glClearColor, red, green, blue, alpha);
 }
 inline void glClearDepthf(GLfloat d, const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glClearDepthf, d);
 }
 inline void glClearStencil(GLint s, const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glClearStencil, s);
 }
 inline void glColorMask(GLboolean red, GLboolean green, GLboolean blue,
                         GLboolean alpha,
                         const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glColorMask, red, green, blue, alpha);
 }
 inline void glCompileShader(GLuint shader,
@@ -174,13 +221,17 @@ inline void glCompressedTexImage2D(GLenum target, GLint level,
                                    GLsizei height, GLint border,
                                    GLsizei imageSize, const void* data,
                                    const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countCompressedTextureUpload(data, imageSize));
   callGL(sourceLocation, ::glCompressedTexImage2D, target, level,
          internalformat, width, height, border, imageSize, data);
+  ABCG_TRACK_GL(compressedTextureImage(target, level, internalformat,
+                                       width, height, 1, imageSize));
 }
 inline void glCompressedTexSubImage2D(
     GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width,
     GLsizei height, GLenum format, GLsizei imageSize, const void* data,
     const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countCompressedTextureUpload(data, imageSize));
   callGL(sourceLocation, ::glCompressedTexSubImage2D, target, level, xoffset,
          yoffset, width, height, format, imageSize, data);
 }
@@ -199,18 +250,23 @@ inline void glCopyTexSubImage2D(GLenum target, GLint level, GLint xoffset,
          x, y, width, height);
 }
 inline GLuint glCreateProgram(const sl& sourceLocation = sl::current()) {
-  return callGL(sourceLocation, ::glCreateProgram);
+  const auto program{callGL(sourceLocation, ::glCreateProgram)};
+  ABCG_TRACK_GL(created(abcg::ResourceTracker::Kind::Program, 1, &program,
+                        sourceLocation));
+  return program;
 }
 inline GLuint glCreateShader(GLenum shaderType,
                              const sl& sourceLocation = sl::current()) {
   return callGL(sourceLocation, ::glCreateShader, shaderType);
 }
 inline void glCullFace(GLenum mode, const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   return callGL(sourceLocation, ::glCullFace, mode);
 }
 inline void glDeleteBuffers(GLsizei n, const GLuint* buffers,
                             const sl& sourceLocation = sl::current()) {
   if (buffers == nullptr || *buffers == 0) return;
+  ABCG_TRACK_GL(deleted(abcg::ResourceTracker::Kind::Buffer, n, buffers));
   callGL(sourceLocation, ::glDeleteBuffers, n, buffers);
 }
 inline void glDeleteFramebuffers(GLsizei n, const GLuint* framebuffers,
@@ -221,6 +277,8 @@ inline void glDeleteFramebuffers(GLsizei n, const GLuint* framebuffers,
 inline void glDeleteProgram(GLuint program,
                             const sl& sourceLocation = sl::current()) {
   if (program == 0) return;
+  ABCG_GL_STATS(forgetProgram(program));
+  ABCG_TRACK_GL(deleted(abcg::ResourceTracker::Kind::Program, 1, &program));
   callGL(sourceLocation, ::glDeleteProgram, program);
 }
 inline void glDeleteRenderbuffers(GLsizei n, GLuint* renderbuffers,
@@ -236,17 +294,22 @@ inline void glDeleteShader(GLuint shader,
 inline void glDeleteTextures(GLsizei n, const GLuint* textures,
                              const sl& sourceLocation = sl::current()) {
   if (textures == nullptr || *textures == 0) return;
+  ABCG_GL_STATS(forgetTextures(n, textures));
+  ABCG_TRACK_GL(deleted(abcg::ResourceTracker::Kind::Texture, n, textures));
   callGL(sourceLocation, ::glDeleteTextures, n, textures);
 }
 inline void glDepthFunc(GLenum func, const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glDepthFunc, func);
 }
 inline void glDepthMask(GLboolean flag,
                         const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glDepthMask, flag);
 }
 inline void glDepthRangef(GLfloat n, GLfloat f,
                           const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glDepthRangef, n, f);
 }
 inline void glDetachShader(GLuint program, GLuint shader,
@@ -254,6 +317,7 @@ inline void glDetachShader(GLuint program, GLuint shader,
   callGL(sourceLocation, ::glDetachShader, program, shader);
 }
 inline void glDisable(GLenum cap, const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glDisable, cap);
 }
 inline void glDisableVertexAttribArray(
@@ -262,14 +326,17 @@ inline void glDisableVertexAttribArray(
 }
 inline void glDrawArrays(GLenum mode, GLint first, GLsizei count,
                          const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countDraw(count, 1, false));
   callGL(sourceLocation, ::glDrawArrays, mode, first, count);
 }
 inline void glDrawElements(GLenum mode, GLsizei count, GLenum type,
                            const void* indices,
                            const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countDraw(count, 1, true));
   callGL(sourceLocation, ::glDrawElements, mode, count, type, indices);
 }
 inline void glEnable(GLenum cap, const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glEnable, cap);
 }
 inline void glEnableVertexAttribArray(
@@ -296,15 +363,19 @@ inline void glFramebufferTexture2D(GLenum target, GLenum attachment,
          textarget, texture, level);
 }
 inline void glFrontFace(GLenum mode, const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glFrontFace, mode);
 }
 inline void glGenBuffers(GLsizei n, GLuint* buffers,
                          const sl& sourceLocation = sl::current()) {
   callGL(sourceLocation, ::glGenBuffers, n, buffers);
+  ABCG_TRACK_GL(created(abcg::ResourceTracker::Kind::Buffer, n, buffers,
+                        sourceLocation));
 }
 inline void glGenerateMipmap(GLenum target,
                              const sl& sourceLocation = sl::current()) {
   callGL(sourceLocation, ::glGenerateMipmap, target);
+  ABCG_TRACK_GL(generateMipmap(target));
 }
 inline void glGenFramebuffers(GLsizei n, GLuint* ids,
                               const sl& sourceLocation = sl::current()) {
@@ -317,6 +388,8 @@ inline void glGenRenderbuffers(GLsizei n, GLuint* renderbuffers,
 inline void glGenTextures(GLsizei n, GLuint* textures,
                           const sl& sourceLocation = sl::current()) {
   callGL(sourceLocation, ::glGenTextures, n, textures);
+  ABCG_TRACK_GL(created(abcg::ResourceTracker::Kind::Texture, n, textures,
+                        sourceLocation));
 }
 inline void glGetActiveAttrib(GLuint program, GLuint index, GLsizei bufSize,
                               GLsizei* length, GLint* size, GLenum* type,
@@ -439,6 +512,7 @@ inline void glGetVertexAttribPointerv(
 }
 inline void glHint(GLenum target, GLenum mode,
                    const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glHint, target, mode);
 }
 inline GLboolean glIsBuffer(GLuint buffer,
@@ -471,6 +545,7 @@ inline GLboolean glIsTexture(GLuint texture,
 }
 inline void glLineWidth(GLfloat width,
                         const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glLineWidth, width);
 }
 inline void glLinkProgram(GLuint program,
@@ -479,10 +554,12 @@ inline void glLinkProgram(GLuint program,
 }
 inline void glPixelStorei(GLenum pname, GLint param,
                           const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glPixelStorei, pname, param);
 }
 inline void glPolygonOffset(GLfloat factor, GLfloat units,
                             const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glPolygonOffset, factor, units);
 }
 inline void glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height,
@@ -502,10 +579,12 @@ inline void glRenderbufferStorage(GLenum target, GLenum internalformat,
 }
 inline void glSampleCoverage(GLfloat value, GLboolean invert,
                              const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glSampleCoverage, value, invert);
 }
 inline void glScissor(GLint x, GLint y, GLsizei width, GLsizei height,
                       const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glScissor, x, y, width, height);
 }
 inline void glShaderBinary(GLsizei count, const GLuint* shaders,
@@ -522,36 +601,45 @@ inline void glShaderSource(GLuint shader, GLsizei count, const GLchar** string,
 }
 inline void glStencilFunc(GLenum func, GLint ref, GLuint mask,
                           const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glStencilFunc, func, ref, mask);
 }
 inline void glStencilFuncSeparate(GLenum face, GLenum func, GLint ref,
                                   GLuint mask,
                                   const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glStencilFuncSeparate, face, func, ref, mask);
 }
 inline void glStencilMask(GLuint mask,
                           const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glStencilMask, mask);
 }
 inline void glStencilMaskSeparate(GLenum face, GLuint mask,
                                   const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glStencilMaskSeparate, face, mask);
 }
 inline void glStencilOp(GLenum fail, GLenum zfail, GLenum zpass,
                         const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glStencilOp, fail, zfail, zpass);
 }
 inline void glStencilOpSeparate(GLenum face, GLenum sfail, GLenum dpfail,
                                 GLenum dppass,
                                 const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glStencilOpSeparate, face, sfail, dpfail, dppass);
 }
 inline void glTexImage2D(GLenum target, GLint level, GLint internalformat,
                          GLsizei width, GLsizei height, GLint border,
                          GLenum format, GLenum type, const void* data,
                          const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countTextureUpload(data, width, height, 1, format, type));
   callGL(sourceLocation, ::glTexImage2D, target, level, internalformat, width,
          height, border, format, type, data);
+  ABCG_TRACK_GL(textureImage(target, level, static_cast<GLenum>(internalformat),
+                             width, height, 1, format, type));
 }
 
 inline void glTexParameterf(GLenum target, GLenum pname, GLfloat param,
@@ -574,93 +662,114 @@ inline void glTexSubImage2D(GLenum target, GLint level, GLint xoffset,
                             GLint yoffset, GLsizei width, GLsizei height,
                             GLenum format, GLenum type, const void* pixels,
                             const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countTextureUpload(pixels, width, height, 1, format, type));
   callGL(sourceLocation, ::glTexSubImage2D, target, level, xoffset, yoffset,
          width, height, format, type, pixels);
 }
 inline void glUniform1f(GLint location, GLfloat v0,
                         const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniform1f, location, v0);
 }
 inline void glUniform1fv(GLint location, GLsizei count, const GLfloat* value,
                          const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniform1fv, location, count, value);
 }
 inline void glUniform1i(GLint location, GLint v0,
                         const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniform1i, location, v0);
 }
 inline void glUniform1iv(GLint location, GLsizei count, const GLint* value,
                          const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniform1iv, location, count, value);
 }
 inline void glUniform2f(GLint location, GLfloat v0, GLfloat v1,
                         const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniform2f, location, v0, v1);
 }
 inline void glUniform2fv(GLint location, GLsizei count, const GLfloat* value,
                          const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniform2fv, location, count, value);
 }
 inline void glUniform2i(GLint location, GLint v0, GLint v1,
                         const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniform2i, location, v0, v1);
 }
 inline void glUniform2iv(GLint location, GLsizei count, const GLint* value,
                          const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniform2iv, location, count, value);
 }
 inline void glUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2,
                         const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniform3f, location, v0, v1, v2);
 }
 inline void glUniform3fv(GLint location, GLsizei count, const GLfloat* value,
                          const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniform3fv, location, count, value);
 }
 inline void glUniform3i(GLint location, GLint v0, GLint v1, GLint v2,
                         const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniform3i, location, v0, v1, v2);
 }
 inline void glUniform3iv(GLint location, GLsizei count, const GLint* value,
                          const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniform3iv, location, count, value);
 }
 inline void glUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2,
                         GLfloat v3, const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniform4f, location, v0, v1, v2, v3);
 }
 inline void glUniform4fv(GLint location, GLsizei count, const GLfloat* value,
                          const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniform4fv, location, count, value);
 }
 inline void glUniform4i(GLint location, GLint v0, GLint v1, GLint v2, GLint v3,
                         const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniform4i, location, v0, v1, v2, v3);
 }
 inline void glUniform4iv(GLint location, GLsizei count, const GLint* value,
                          const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniform4iv, location, count, value);
 }
 inline void glUniformMatrix2fv(GLint location, GLsizei count,
                                GLboolean transpose, const GLfloat* value,
                                const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniformMatrix2fv, location, count, transpose,
          value);
 }
 inline void glUniformMatrix3fv(GLint location, GLsizei count,
                                GLboolean transpose, const GLfloat* value,
                                const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniformMatrix3fv, location, count, transpose,
          value);
 }
 inline void glUniformMatrix4fv(GLint location, GLsizei count,
                                GLboolean transpose, const GLfloat* value,
                                const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniformMatrix4fv, location, count, transpose,
          value);
 }
 inline void glUseProgram(GLuint program,
                          const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countProgramBind(program));
   callGL(sourceLocation, ::glUseProgram, program);
 }
 inline void glValidateProgram(GLuint program,
@@ -709,6 +818,7 @@ inline void glVertexAttribPointer(GLuint index, GLint size, GLenum type,
 }
 inline void glViewport(GLint x, GLint y, GLsizei width, GLsizei height,
                        const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countStateChange());
   callGL(sourceLocation, ::glViewport, x, y, width, height);
 }
 
@@ -720,6 +830,7 @@ inline void glReadBuffer(GLenum src, const sl& sourceLocation = sl::current()) {
 inline void glDrawRangeElements(GLenum mode, GLuint start, GLuint end,
                                 GLsizei count, GLenum type, const void* indices,
                                 const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countDraw(count, 1, true));
   callGL(sourceLocation, ::glDrawRangeElements, mode, start, end, count, type,
          indices);
 }
@@ -728,14 +839,18 @@ inline void glTexImage3D(GLenum target, GLint level, GLint internalformat,
                          GLint border, GLenum format, GLenum type,
                          const void* pixels,
                          const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countTextureUpload(pixels, width, height, depth, format, type));
   callGL(sourceLocation, ::glTexImage3D, target, level, internalformat, width,
          height, depth, border, format, type, pixels);
+  ABCG_TRACK_GL(textureImage(target, level, static_cast<GLenum>(internalformat),
+                             width, height, depth, format, type));
 }
 inline void glTexSubImage3D(GLenum target, GLint level, GLint xoffset,
                             GLint yoffset, GLint zoffset, GLsizei width,
                             GLsizei height, GLsizei depth, GLenum format,
                             GLenum type, const void* pixels,
                             const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countTextureUpload(pixels, width, height, depth, format, type));
   callGL(sourceLocation, ::glTexSubImage3D, target, level, xoffset, yoffset,
          zoffset, width, height, depth, format, type, pixels);
 }
@@ -751,14 +866,18 @@ inline void glCompressedTexImage3D(GLenum target, GLint level,
                                    GLsizei height, GLsizei depth, GLint border,
                                    GLsizei imageSize, const void* data,
                                    const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countCompressedTextureUpload(data, imageSize));
   callGL(sourceLocation, ::glCompressedTexImage3D, target, level,
          internalformat, width, height, depth, border, imageSize, data);
+  ABCG_TRACK_GL(compressedTextureImage(target, level, internalformat,
+                                       width, height, depth, imageSize));
 }
 inline void glCompressedTexSubImage3D(
     GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
     GLsizei width, GLsizei height, GLsizei depth, GLenum format,
     GLsizei imageSize, const void* data,
     const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countCompressedTextureUpload(data, imageSize));
   callGL(sourceLocation, ::glCompressedTexSubImage3D, target, level, xoffset,
          yoffset, zoffset, width, height, depth, format, imageSize, data);
 }
@@ -805,36 +924,42 @@ inline void glDrawBuffers(GLsizei n, const GLenum* bufs,
 inline void glUniformMatrix2x3fv(GLint location, GLsizei count,
                                  GLboolean transpose, const GLfloat* value,
                                  const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniformMatrix2x3fv, location, count, transpose,
          value);
 }
 inline void glUniformMatrix3x2fv(GLint location, GLsizei count,
                                  GLboolean transpose, const GLfloat* value,
                                  const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniformMatrix3x2fv, location, count, transpose,
          value);
 }
 inline void glUniformMatrix2x4fv(GLint location, GLsizei count,
                                  GLboolean transpose, const GLfloat* value,
                                  const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniformMatrix2x4fv, location, count, transpose,
          value);
 }
 inline void glUniformMatrix4x2fv(GLint location, GLsizei count,
                                  GLboolean transpose, const GLfloat* value,
                                  const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniformMatrix4x2fv, location, count, transpose,
          value);
 }
 inline void glUniformMatrix3x4fv(GLint location, GLsizei count,
                                  GLboolean transpose, const GLfloat* value,
                                  const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniformMatrix3x4fv, location, count, transpose,
          value);
 }
 inline void glUniformMatrix4x3fv(GLint location, GLsizei count,
                                  GLboolean transpose, const GLfloat* value,
                                  const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniformMatrix4x3fv, location, count, transpose,
          value);
 }
@@ -871,15 +996,21 @@ inline void glFlushMappedBufferRange(GLenum target, GLintptr offset,
 }
 inline void glBindVertexArray(GLuint array,
                               const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countVertexArrayBind(array));
   callGL(sourceLocation, ::glBindVertexArray, array);
+  ABCG_TRACK_GL(bindVertexArray(array));
 }
 inline void glDeleteVertexArrays(GLsizei n, const GLuint* arrays,
                                  const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(forgetVertexArrays(n, arrays));
+  ABCG_TRACK_GL(deleted(abcg::ResourceTracker::Kind::VertexArray, n, arrays));
   callGL(sourceLocation, ::glDeleteVertexArrays, n, arrays);
 }
 inline void glGenVertexArrays(GLsizei n, GLuint* arrays,
                               const sl& sourceLocation = sl::current()) {
   callGL(sourceLocation, ::glGenVertexArrays, n, arrays);
+  ABCG_TRACK_GL(created(abcg::ResourceTracker::Kind::VertexArray, n, arrays,
+                        sourceLocation));
 }
 inline GLboolean glIsVertexArray(GLuint array,
                                  const sl& sourceLocation = sl::current()) {
@@ -901,10 +1032,12 @@ inline void glBindBufferRange(GLenum target, GLuint index, GLuint buffer,
                               const sl& sourceLocation = sl::current()) {
   callGL(sourceLocation, ::glBindBufferRange, target, index, buffer, offset,
          size);
+  ABCG_TRACK_GL(bindBuffer(target, buffer));
 }
 inline void glBindBufferBase(GLenum target, GLuint index, GLuint buffer,
                              const sl& sourceLocation = sl::current()) {
   callGL(sourceLocation, ::glBindBufferBase, target, index, buffer);
+  ABCG_TRACK_GL(bindBuffer(target, buffer));
 }
 inline void glTransformFeedbackVaryings(
     GLuint program, GLsizei count, const GLchar* const* varyings,
@@ -960,34 +1093,42 @@ inline GLint glGetFragDataLocation(GLuint program, const GLchar* name,
 }
 inline void glUniform1ui(GLint location, GLuint v0,
                          const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniform1ui, location, v0);
 }
 inline void glUniform2ui(GLint location, GLuint v0, GLuint v1,
                          const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniform2ui, location, v0, v1);
 }
 inline void glUniform3ui(GLint location, GLuint v0, GLuint v1, GLuint v2,
                          const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniform3ui, location, v0, v1, v2);
 }
 inline void glUniform4ui(GLint location, GLuint v0, GLuint v1, GLuint v2,
                          GLuint v3, const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniform4ui, location, v0, v1, v2, v3);
 }
 inline void glUniform1uiv(GLint location, GLsizei count, const GLuint* value,
                           const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniform1uiv, location, count, value);
 }
 inline void glUniform2uiv(GLint location, GLsizei count, const GLuint* value,
                           const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniform2uiv, location, count, value);
 }
 inline void glUniform3uiv(GLint location, GLsizei count, const GLuint* value,
                           const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniform3uiv, location, count, value);
 }
 inline void glUniform4uiv(GLint location, GLsizei count, const GLuint* value,
                           const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countUniformUpdate());
   callGL(sourceLocation, ::glUniform4uiv, location, count, value);
 }
 inline void glClearBufferiv(GLenum buffer, GLint drawbuffer, const GLint* value,
@@ -1062,12 +1203,14 @@ inline void glUniformBlockBinding(GLuint program, GLuint uniformBlockIndex,
 inline void glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count,
                                   GLsizei instancecount,
                                   const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countDraw(count, instancecount, false));
   callGL(sourceLocation, ::glDrawArraysInstanced, mode, first, count,
          instancecount);
 }
 inline void glDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type,
                                     const void* indices, GLsizei instancecount,
                                     const sl& sourceLocation = sl::current()) {
+  ABCG_GL_STATS(countDraw(count, instancecount, true));
   callGL(sourceLocation, ::glDrawElementsInstanced, mode, count, type, indices,
          instancecount);
 }
@@ -1213,12 +1356,16 @@ inline void glTexStorage2D(GLenum target, GLsizei levels, GLenum internalformat,
                            const sl& sourceLocation = sl::current()) {
   callGL(sourceLocation, ::glTexStorage2D, target, levels, internalformat,
          width, height);
+  ABCG_TRACK_GL(textureStorage(target, levels, internalformat, width,
+                               height, 1));
 }
 inline void glTexStorage3D(GLenum target, GLsizei levels, GLenum internalformat,
                            GLsizei width, GLsizei height, GLsizei depth,
                            const sl& sourceLocation = sl::current()) {
   callGL(sourceLocation, ::glTexStorage3D, target, levels, internalformat,
          width, height, depth);
+  ABCG_TRACK_GL(textureStorage(target, levels, internalformat, width,
+                               height, depth));
 }
 inline void glGetInternalformativ(GLenum target, GLenum internalformat,
                                   GLenum pname, GLsizei count, GLint* params,
@@ -1265,6 +1412,21 @@ inline void glGetDoublev(GLenum pname, GLdouble* params,
 
 #endif
 
+#if !defined(__EMSCRIPTEN__)
+
+// OpenGL 3.3+ function definitions
+
+inline void glQueryCounter(GLuint id, GLenum target,
+                           const sl& sourceLocation = sl::current()) {
+  callGL(sourceLocation, ::glQueryCounter, id, target);
+}
+inline void glGetQueryObjectui64v(GLuint id, GLenum pname, GLuint64* params,
+                                  const sl& sourceLocation = sl::current()) {
+  callGL(sourceLocation, ::glGetQueryObjectui64v, id, pname, params);
+}
+
+#endif
+
 }  // namespace abcg
 
 #endif
\ No newline at end of file
@@ -17,13 +17,42 @@
 #include <regex>
 #include <sstream>
 #include <string_view>
+#include <utility>
 
 #include "SDL_events.h"
 #include "SDL_video.h"
 #include "abcg_application.hpp"
 #include "abcg_embeddedfonts.hpp"
+#include "abcg_hitchrecorder.hpp"
+#include "abcg_inputrecorder.hpp"
+#include "abcg_resourcetracker.hpp"
 #include "abcg_string.hpp"
 
+namespace {
+// Longest time simulated before a frame; the rest of a longer stall is
+// dropped
+constexpr double maxSimulationLag{0.25};
+// Period of the measurement of the frame and tick rates, in seconds
+constexpr double loopRateInterval{0.5};
+
+// Frames painted after an input event in render-on-demand mode. ImGui
+// reacts to some input (hover, focus) a frame late.
+constexpr int repaintsPerEvent{3};
+
+#if !defined(__EMSCRIPTEN__)
+// Refresh rate of the display showing the window, or 60 Hz if unknown
+double getRefreshRate(SDL_Window *window) {
+  SDL_DisplayMode mode{};
+  if (const auto display{SDL_GetWindowDisplayIndex(window)};
+      display >= 0 && SDL_GetCurrentDisplayMode(display, &mode) == 0 &&
+      mode.refresh_rate > 0) {
+    return mode.refresh_rate;
+  }
+  return 60.0;
+}
+#endif
+}  // namespace
+
 void printShaderInfoLog(GLuint shader, std::string_view prefix) {
   GLint infoLogLength{};
   glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &infoLogLength);
@@ -162,9 +191,25 @@ EM_BOOL abcg::fullscreenchangeCallback(
 #endif
 
 abcg::OpenGLWindow::~OpenGLWindow() {
+  // Normally already stopped and terminated by abcg::Application
+  stopSimulation();
+  stopRendering();
+  terminate();
+}
+
+// Releases the OpenGL resources, the GUI and the window. Called by
+// abcg::Application while the derived window still exists, so that its
+// terminateGL runs.
+void abcg::OpenGLWindow::terminate() {
   if (m_window != nullptr) {
     if (ImGui::GetCurrentContext() != nullptr) {
       terminateGL();
+      m_profiler.terminateGL();
+      // Whatever the application and the profiler left is a leak
+      if constexpr (ResourceTracker::isEnabled()) {
+        ResourceTracker::reportLeaks();
+        ResourceTracker::reset();
+      }
       ImGui_ImplOpenGL3_Shutdown();
       ImGui_ImplSDL2_Shutdown();
       ImGui::DestroyContext();
@@ -172,8 +217,10 @@ abcg::OpenGLWindow::~OpenGLWindow() {
 
     if (m_GLContext != nullptr) {
       SDL_GL_DeleteContext(m_GLContext);
+      m_GLContext = nullptr;
     }
     SDL_DestroyWindow(m_window);
+    m_window = nullptr;
   }
 }
 
@@ -208,34 +255,29 @@ void abcg::OpenGLWindow::handleEvent([[maybe_unused]] SDL_Event &event) {}
 
 void abcg::OpenGLWindow::initializeGL() { glClearColor(0, 0, 0, 1); }
 
-void abcg::OpenGLWindow::paintGL() { glClear(GL_COLOR_BUFFER_BIT); }
+void abcg::OpenGLWindow::paintGL() {
+  submitGL([] { glClear(GL_COLOR_BUFFER_BIT); });
+}
 
 void abcg::OpenGLWindow::paintUI() {
-  // FPS counter
+  // Profiler overlay
   if (m_windowSettings.showFPS) {
-    float fps = ImGui::GetIO().Framerate;
-
-    static size_t offset{0};
-    static double refreshTime = ImGui::GetTime();
-    static std::array<float, 150> frames{};
-
-    while (refreshTime < ImGui::GetTime()) {
-      const auto refreshFrequency{60.0};
-      frames.at(offset) = fps;
-      offset = (offset + 1) % frames.size();
-      refreshTime += (1.0 / refreshFrequency);
-    }
-
-    ImGui::SetNextWindowPos(ImVec2(5, 5));
-    ImGui::Begin("FPS", nullptr,
-                 ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoInputs |
+    ImGui::SetNextWindowPos(ImVec2(5, 5), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Profiler", nullptr,
+                 ImGuiWindowFlags_AlwaysAutoResize |
                      ImGuiWindowFlags_NoBringToFrontOnFocus |
                      ImGuiWindowFlags_NoFocusOnAppearing);
-    std::string label{fmt::format("avg {:.1f} FPS", fps)};
-    ImGui::PlotLines("", &frames[0], static_cast<int>(frames.size()),
-                     static_cast<int>(offset), label.c_str(), 0.0f,
-                     *std::max_element(frames.begin(), frames.end()) * 2,
-                     ImVec2(static_cast<float>(frames.size()), 50));
+    m_profiler.paintUI();
+    const auto frameTime{m_framePacer.getStatistics()};
+    ImGui::Text("%.2f ms (sd %.2f, max %.2f)", frameTime.mean * 1000.0,
+                frameTime.deviation * 1000.0, frameTime.max * 1000.0);
+    if (m_simulationStep > 0.0) {
+      ImGui::Text("%.0f ticks/s%s", m_tickRate,
+                  m_simulationThread.joinable() ? " (thread)" : "");
+    }
+    if (ResourceTracker::isEnabled() && ImGui::CollapsingHeader("Resources")) {
+      ResourceTracker::paintUI();
+    }
     ImGui::End();
   }
 
@@ -276,9 +318,19 @@ void abcg::OpenGLWindow::paintUI() {
 }
 
 void abcg::OpenGLWindow::resizeGL(int width, int height) {
-  glViewport(0, 0, width, height);
+  submitGL([=] { glViewport(0, 0, width, height); });
 }
 
+/**
+ * @brief Advances the simulation by one tick.
+ *
+ * Called before each frame as many times as needed to keep up with the
+ * elapsed time, once abcg::OpenGLWindow::setSimulationRate has set a rate.
+ *
+ * @param timeStep Duration of the tick, in seconds.
+ */
+void abcg::OpenGLWindow::simulate([[maybe_unused]] double timeStep) {}
+
 void abcg::OpenGLWindow::terminateGL() {}
 
 GLuint abcg::OpenGLWindow::createProgramFromFile(
@@ -398,9 +450,325 @@ std::string abcg::OpenGLWindow::getAssetsPath() { return m_assetsPath; }
 double abcg::OpenGLWindow::getDeltaTime() const { return m_lastDeltaTime; }
 
 double abcg::OpenGLWindow::getElapsedTime() const {
+  if (m_inputRecorder != nullptr) return m_frameClock;
   return m_windowStartTime.elapsed();
 }
 
+/**
+ * @brief Returns the duration of a simulation tick, in seconds, or zero if
+ * the fixed-rate simulation is disabled.
+ */
+double abcg::OpenGLWindow::getSimulationStep() const noexcept {
+  return m_simulationStep;
+}
+
+/**
+ * @brief Returns the fraction of a tick elapsed since the last simulation
+ * tick.
+ *
+ * Rendering the state interpolated between the last two ticks by this
+ * factor gives smooth motion when the frame rate and the tick rate differ.
+ * Not valid in threaded mode; see abcg::OpenGLWindow::getPresentationTime.
+ *
+ * @return Factor in [0, 1), or 1 if the fixed-rate simulation is disabled.
+ */
+double abcg::OpenGLWindow::getSimulationAlpha() const noexcept {
+  if (m_simulationStep <= 0.0) return 1.0;
+  return m_simulationAccumulator / m_simulationStep;
+}
+
+/**
+ * @brief Returns the time spent in abcg::OpenGLWindow::simulate during the
+ * last frame, in seconds.
+ */
+double abcg::OpenGLWindow::getSimulationCost() const noexcept {
+  return m_simulationCost.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the simulation time at the end of the tick being run.
+ *
+ * Only meaningful within abcg::OpenGLWindow::simulate, on the thread that
+ * runs it.
+ */
+double abcg::OpenGLWindow::getSimulationTime() const noexcept {
+  return m_simulationTime;
+}
+
+/**
+ * @brief Returns the simulation time to be shown by the frame being
+ * rendered.
+ *
+ * The presentation time runs one tick behind the latest tick, so that the
+ * frame can be interpolated between the states of the last two ticks with
+ * the factor (presentation time - time of the previous tick) / time step.
+ * Unlike abcg::OpenGLWindow::getSimulationAlpha, it is also valid in
+ * threaded mode.
+ */
+double abcg::OpenGLWindow::getPresentationTime() const {
+  if (m_simulationThread.joinable()) {
+    const std::chrono::duration<double> sinceEpoch{
+        std::chrono::steady_clock::now() - m_simulationEpoch};
+    return sinceEpoch.count() +
+           m_presentationOffset.load(std::memory_order_acquire) -
+           m_simulationStep;
+  }
+  return m_simulationTime + m_simulationAccumulator - m_simulationStep;
+}
+
+/**
+ * @brief Returns the time spent in paintUI, paintGL and the GUI rendering
+ * during the last frame, in seconds. Buffer swaps are not included.
+ *
+ * With the render thread, this is the time spent building the frame on the
+ * main thread; see abcg::OpenGLWindow::getSubmitCost for the other half.
+ */
+double abcg::OpenGLWindow::getRenderCost() const noexcept {
+  return m_renderCost;
+}
+
+/**
+ * @brief Returns the time the render thread spent executing the commands
+ * of the last frame and rendering its GUI, in seconds. Buffer swaps are not
+ * included.
+ *
+ * @return Submission time, or zero without the render thread.
+ */
+double abcg::OpenGLWindow::getSubmitCost() const noexcept {
+  return m_renderThread.joinable()
+             ? m_submitCost.load(std::memory_order_relaxed)
+             : 0.0;
+}
+
+/**
+ * @brief Returns the number of frames per second, measured over the last
+ * half second.
+ */
+double abcg::OpenGLWindow::getFrameRate() const noexcept {
+  return m_frameRate;
+}
+
+/**
+ * @brief Returns the mean, standard deviation and maximum of the time
+ * between the starts of the last frames (up to 240), in seconds.
+ *
+ * With steady pacing, the deviation is small compared to the mean.
+ */
+abcg::FramePacer::Statistics abcg::OpenGLWindow::getFrameTimeStatistics()
+    const {
+  return m_framePacer.getStatistics();
+}
+
+/**
+ * @brief Returns the activity state of the window, from its visibility and
+ * focus.
+ */
+abcg::WindowActivity abcg::OpenGLWindow::getActivity() const noexcept {
+  if (!m_visible) return WindowActivity::Hidden;
+  return m_focused ? WindowActivity::Foreground : WindowActivity::Background;
+}
+
+/**
+ * @brief Returns the time, CPU duty cycle and frame rate measured so far in
+ * an activity state.
+ */
+const abcg::ActivityMonitor::Statistics &
+abcg::OpenGLWindow::getActivityStatistics(WindowActivity activity) const {
+  return m_activityMonitor.getStatistics(activity);
+}
+
+/**
+ * @brief Requests a new frame in render-on-demand mode, for instance when
+ * data shown by the window changed. Must be called on the main thread.
+ */
+void abcg::OpenGLWindow::requestRepaint() noexcept {
+  m_pendingRepaints = std::max(m_pendingRepaints, 1);
+}
+
+/**
+ * @brief Returns the profiler of the window, which records the scopes of
+ * abcg::ProfilerScope.
+ */
+abcg::Profiler &abcg::OpenGLWindow::getProfiler() noexcept {
+  return m_profiler;
+}
+
+/**
+ * @brief Returns the arena of the frame being built, reset at the start of
+ * each frame. Main thread only.
+ *
+ * Memory from the arena must not be read by the commands given to
+ * abcg::OpenGLWindow::submitGL, which may run on the render thread after
+ * the next frame has started.
+ */
+abcg::FrameArena &abcg::OpenGLWindow::getFrameArena() noexcept {
+  return m_frameArena;
+}
+
+/**
+ * @brief Returns the number of simulation ticks per second, measured over
+ * the last half second.
+ */
+double abcg::OpenGLWindow::getTickRate() const noexcept { return m_tickRate; }
+
+/**
+ * @brief Returns whether simulation ticks run on their own thread.
+ *
+ * Threaded mode is never used while input is recorded or replayed, since
+ * the ticks would no longer be tied to the frames.
+ */
+bool abcg::OpenGLWindow::isSimulationThreaded() const noexcept {
+  return m_simulationThreaded && m_inputRecorder == nullptr;
+}
+
+/**
+ * @brief Returns whether OpenGL commands run on their own thread.
+ */
+bool abcg::OpenGLWindow::isRenderThreaded() const noexcept {
+  return m_renderThreaded;
+}
+
+/**
+ * @brief Enables the fixed-rate simulation.
+ *
+ * Before each frame, the elapsed time is accumulated and consumed in ticks
+ * of fixed duration, each one calling abcg::OpenGLWindow::simulate. After a
+ * long stall, ticks are dropped rather than making the next frame slower.
+ *
+ * @param ticksPerSecond Tick rate, or zero to disable the fixed-rate
+ * simulation.
+ *
+ * @throw abcg::Exception if the rate is negative.
+ */
+void abcg::OpenGLWindow::setSimulationRate(double ticksPerSecond) {
+  if (ticksPerSecond < 0.0) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Negative simulation rate")};
+  }
+  stopSimulation();
+  m_simulationStep = ticksPerSecond > 0.0 ? 1.0 / ticksPerSecond : 0.0;
+  m_simulationAccumulator = 0.0;
+}
+
+/**
+ * @brief Runs the simulation ticks on a dedicated thread.
+ *
+ * In threaded mode, abcg::OpenGLWindow::simulate is called on the
+ * simulation thread at the rate set by abcg::OpenGLWindow::setSimulationRate,
+ * independently of the frames, so that a slow frame does not delay the
+ * simulation and a slow tick does not delay the frames. The window must
+ * then hand the state over to paintGL without sharing it, for instance
+ * through an abcg::TripleBuffer of snapshots, and must pass input and UI
+ * changes to simulate in a thread-safe way.
+ *
+ * The thread starts with the next frame and stops when threaded mode is
+ * disabled or when the application leaves its main loop. An exception
+ * thrown by simulate is rethrown by the next frame.
+ *
+ * Without thread support (Emscripten builds without pthreads), ticks keep
+ * running on the main thread.
+ *
+ * @param threaded Whether to use the simulation thread.
+ */
+void abcg::OpenGLWindow::setSimulationThreaded(bool threaded) {
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+  threaded = false;
+#endif
+  if (!threaded) stopSimulation();
+  m_simulationThreaded = threaded;
+}
+
+/**
+ * @brief Moves the OpenGL context to a dedicated render thread.
+ *
+ * With the render thread, the main thread keeps handling events and
+ * building frames (simulation, paintUI, paintGL), while the render thread
+ * executes the OpenGL commands of previous frames, renders their GUI and
+ * swaps the buffers, so that driver stalls do not delay input handling.
+ * paintGL and resizeGL must then issue all OpenGL calls through
+ * abcg::OpenGLWindow::submitGL, and the commands must only read data that
+ * the main thread does not modify until the frame is executed, for
+ * instance data kept per abcg::OpenGLWindow::getFrameSlot. initializeGL
+ * and terminateGL still run on the main thread with the context current.
+ *
+ * The thread starts with the next frame and stops when it is disabled or
+ * when the application leaves its main loop. An exception thrown by a
+ * command is rethrown by the next frame.
+ *
+ * In Emscripten builds, the WebGL context cannot leave the main thread, so
+ * commands keep running on the main thread.
+ *
+ * @param threaded Whether to use the render thread.
+ * @param queueDepth Number of frames submitted to the render thread that
+ * the main thread can get ahead by, from 1 to 3.
+ */
+void abcg::OpenGLWindow::setRenderThreaded(bool threaded,
+                                           std::size_t queueDepth) {
+  if (queueDepth < 1 || queueDepth > 3) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Render queue depth out of range")};
+  }
+#if defined(__EMSCRIPTEN__)
+  threaded = false;
+#endif
+  if (!threaded || queueDepth != m_renderQueueDepth) stopRendering();
+  m_renderThreaded = threaded;
+  m_renderQueueDepth = queueDepth;
+}
+
+/**
+ * @brief Issues OpenGL commands for the frame being built.
+ *
+ * Without the render thread, the command runs immediately. Otherwise, it is
+ * recorded and runs on the render thread, after the commands submitted
+ * before it in the same frame.
+ *
+ * @param command Function making OpenGL calls.
+ */
+void abcg::OpenGLWindow::submitGL(RenderQueue::Command command) {
+  if (!m_renderThread.joinable()) {
+    command();
+    return;
+  }
+  getRecordingFrame().commands.push_back(std::move(command));
+}
+
+/**
+ * @brief Returns the slot of the frame being built.
+ *
+ * Data read by submitted commands can be kept per slot: a slot is not
+ * reused before the commands of its previous frame have run.
+ *
+ * @return Slot index, in [0, abcg::OpenGLWindow::getNumFrameSlots).
+ */
+std::size_t abcg::OpenGLWindow::getFrameSlot() {
+  return m_renderThread.joinable() ? getRecordingFrame().slot : 0;
+}
+
+/**
+ * @brief Returns the number of frame slots: the render queue depth plus
+ * one with the render thread, or one without it.
+ */
+std::size_t abcg::OpenGLWindow::getNumFrameSlots() const noexcept {
+  return m_renderThread.joinable() ? m_renderQueue->getNumSlots() : 1;
+}
+
+/**
+ * @brief Returns the random seed to be used by the window.
+ *
+ * Windows that randomize their content should call this function during
+ * initializeGL, so that replayed input sessions see the same content.
+ *
+ * @param seed Seed chosen by the window.
+ *
+ * @return The seed of the recorded session when replaying input; seed
+ * otherwise.
+ */
+std::uint64_t abcg::OpenGLWindow::getSessionSeed(std::uint64_t seed) {
+  if (m_inputRecorder == nullptr) return seed;
+  return m_inputRecorder->exchangeSeed(seed);
+}
+
 void abcg::OpenGLWindow::toggleFullscreen() {
 #if defined(__EMSCRIPTEN__)
   EM_ASM(toggleFullscreen(););
@@ -434,8 +802,26 @@ void abcg::OpenGLWindow::handleEvent(SDL_Event &event, bool &done) {
 
   if (event.window.windowID != m_windowID) return;
 
+  m_pendingRepaints = repaintsPerEvent;
+
   if (event.type == SDL_WINDOWEVENT) {
     switch (event.window.event) {
+      case SDL_WINDOWEVENT_HIDDEN:
+      case SDL_WINDOWEVENT_MINIMIZED:
+        m_visible = false;
+        break;
+      case SDL_WINDOWEVENT_SHOWN:
+      case SDL_WINDOWEVENT_EXPOSED:
+      case SDL_WINDOWEVENT_RESTORED:
+      case SDL_WINDOWEVENT_MAXIMIZED:
+        m_visible = true;
+        break;
+      case SDL_WINDOWEVENT_FOCUS_GAINED:
+        m_focused = true;
+        break;
+      case SDL_WINDOWEVENT_FOCUS_LOST:
+        m_focused = false;
+        break;
       case SDL_WINDOWEVENT_CLOSE:
         done = true;
         break;
@@ -566,6 +952,16 @@ void abcg::OpenGLWindow::initialize(std::string_view basePath) {
   SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, majorVersion);
   SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, minorVersion);
 
+#if !defined(NDEBUG) && !defined(__EMSCRIPTEN__) && !defined(__APPLE__)
+  // Debug context for the debug output of abcg::enableGLDebugOutput
+  if (!m_openGLSettings.synchronousGLErrors) {
+    int contextFlags{};
+    SDL_GL_GetAttribute(SDL_GL_CONTEXT_FLAGS, &contextFlags);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS,
+                        contextFlags | SDL_GL_CONTEXT_DEBUG_FLAG);
+  }
+#endif
+
   if (m_openGLSettings.preserveWebGLDrawingBuffer) {
     SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 0);
   } else {
@@ -584,11 +980,13 @@ void abcg::OpenGLWindow::initialize(std::string_view basePath) {
   }
 
   // Create window with graphics context
+  Uint32 windowFlags{SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE};
+  if (m_windowSettings.hidden) windowFlags |= SDL_WINDOW_HIDDEN;
   while (true) {
     m_window = SDL_CreateWindow(m_windowSettings.title.c_str(),
                                 SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
                                 m_windowSettings.width, m_windowSettings.height,
-                                SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE);
+                                windowFlags);
     if (m_window == nullptr && m_openGLSettings.samples > 0) {
       // Try again, but this time with multisampling disabled
       m_openGLSettings.samples = 0;
@@ -616,11 +1014,26 @@ void abcg::OpenGLWindow::initialize(std::string_view basePath) {
   if (m_GLContext == nullptr) {
     throw abcg::Exception{abcg::Exception::SDL("SDL_GL_CreateContext failed")};
   }
+  GLStats::invalidateBindings();
 
 #if !defined(__EMSCRIPTEN__)
-  SDL_GL_SetSwapInterval(m_openGLSettings.vsync ? 1 : 0);  // Disable vsync
+  if (m_openGLSettings.vsync) {
+    // Adaptive vsync (late swaps tear) if supported, regular vsync otherwise
+    if (SDL_GL_SetSwapInterval(-1) != 0) SDL_GL_SetSwapInterval(1);
+  } else {
+    SDL_GL_SetSwapInterval(0);
+  }
+
+  auto frameRate{m_openGLSettings.targetFrameRate};
+  if (frameRate == 0.0 && !m_openGLSettings.vsync) {
+    frameRate = getRefreshRate(m_window);
+  }
+  m_foregroundFrameRate = std::max(frameRate, 0.0);
+  m_framePacer.setTargetRate(m_foregroundFrameRate);
 #endif
 
+  m_visible = !m_windowSettings.hidden;
+
 #if !defined(__EMSCRIPTEN__)
   if (GLenum err{glewInit()}; GLEW_OK != err) {
     std::string header{"Failed to initialize OpenGL loader: "};
@@ -636,6 +1049,14 @@ void abcg::OpenGLWindow::initialize(std::string_view basePath) {
   fmt::print("OpenGL version.: {}\n", glGetString(GL_VERSION));
   fmt::print("GLSL version...: {}\n", glGetString(GL_SHADING_LANGUAGE_VERSION));
 
+#if !defined(NDEBUG) && !defined(__EMSCRIPTEN__) && !defined(__APPLE__)
+  if (!m_openGLSettings.synchronousGLErrors && !enableGLDebugOutput()) {
+    fmt::print(
+        "Warning: KHR_debug not supported, OpenGL errors are checked "
+        "synchronously\n");
+  }
+#endif
+
   // Setup Dear ImGui context
   IMGUI_CHECKVERSION();
   ImGui::CreateContext();
@@ -668,6 +1089,9 @@ void abcg::OpenGLWindow::initialize(std::string_view basePath) {
     throw abcg::Exception{abcg::Exception::Runtime("Failed to load font file")};
   }
 
+  Profiler::setActive(&m_profiler);
+  m_profiler.initializeGL();
+
   initializeGL();
 
   if (io.DisplaySize.x >= 0 && io.DisplaySize.y >= 0) {
@@ -682,7 +1106,14 @@ void abcg::OpenGLWindow::initialize(std::string_view basePath) {
 }
 
 void abcg::OpenGLWindow::paint() {
-  SDL_GL_MakeCurrent(m_window, m_GLContext);
+  if (m_renderFailed.load(std::memory_order_acquire)) {
+    stopRendering();
+    m_renderFailed.store(false);
+    std::rethrow_exception(m_renderError);
+  }
+  if (isRenderThreaded() && !m_renderThread.joinable()) startRendering();
+  const bool renderThread{m_renderThread.joinable()};
+  if (!renderThread) SDL_GL_MakeCurrent(m_window, m_GLContext);
 
 #if defined(__EMSCRIPTEN__)
   // Force window size in windowed mode
@@ -694,23 +1125,345 @@ void abcg::OpenGLWindow::paint() {
   }
 #endif
 
-  ImGui_ImplOpenGL3_NewFrame();
-  ImGui_ImplSDL2_NewFrame();
-  ImGui::NewFrame();
-  paintUI();
-  ImGui::Render();
-  paintGL();
-  ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+  m_profiler.beginFrame();
+  m_frameArena.reset();
+  ABCG_TRACE_FRAME(m_profiler.getFrameNumber());
+  runSimulation();
+
+  const ElapsedTimer renderTimer;
+  {
+    const ProfilerScope scope{"paintUI"};
+    if (!renderThread) ImGui_ImplOpenGL3_NewFrame();
+    ImGui_ImplSDL2_NewFrame();
+    ImGui::NewFrame();
+    paintUI();
+    ImGui::Render();
+  }
+  {
+    const ProfilerScope scope{"paintGL"};
+    submitGL([this, frameNumber{m_profiler.getFrameNumber()}] {
+      m_profiler.beginGpuFrame(frameNumber);
+      m_profiler.beginGpuScope("paintGL");
+    });
+    paintGL();
+    submitGL([this] { m_profiler.endGpuScope(); });
+  }
 
-  if (m_openGLSettings.preserveWebGLDrawingBuffer) {
-    glFinish();
+  // paintUI or paintGL may have stopped the render thread
+  if (m_renderThread.joinable()) {
+    const ProfilerScope scope{"submit"};
+    auto &frame{getRecordingFrame()};
+    frame.copyDrawData(*ImGui::GetDrawData());
+    m_recordingFrame = nullptr;
+    m_renderQueue->submit(frame);
+    m_renderCost = renderTimer.elapsed();
   } else {
-    SDL_GL_SwapWindow(m_window);
+    {
+      const ProfilerScope scope{"ImGui", true};
+      ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    }
+    m_profiler.endGpuFrame();
+    m_renderCost = renderTimer.elapsed();
+
+    const ProfilerScope scope{"swap"};
+    if (m_openGLSettings.preserveWebGLDrawingBuffer) {
+      glFinish();
+    } else {
+      SDL_GL_SwapWindow(m_window);
+    }
+  }
+  m_profiler.endFrame();
+
+  // abcg::Application paces the frames unless targetFrameRate is negative;
+  // unpaced frames can be shorter than the resolution of the clock, so the
+  // delta time may be zero and must not be divided by
+  m_lastDeltaTime = m_deltaTime.restart();
+  ABCG_TRACE_COUNTER("Frame time (ms)", m_lastDeltaTime * 1000.0);
+  if (m_pendingRepaints > 0) --m_pendingRepaints;
+  if (m_hitchRecorder != nullptr) {
+    m_hitchRecorder->addFrame(m_lastDeltaTime,
+                              [this] { return describeFrame(); });
+  }
+
+  measureLoopRates();
+}
+
+// Runs the simulation ticks due before this frame, or starts the simulation
+// thread in threaded mode
+void abcg::OpenGLWindow::runSimulation() {
+  if (m_simulationStep <= 0.0) return;
+
+  if (isSimulationThreaded()) {
+    if (m_simulationFailed.load(std::memory_order_acquire)) {
+      stopSimulation();
+      m_simulationFailed.store(false);
+      std::rethrow_exception(m_simulationError);
+    }
+    if (!m_simulationThread.joinable()) {
+      m_stopSimulation.store(false);
+      m_simulationEpoch = std::chrono::steady_clock::now();
+      m_presentationOffset.store(m_simulationTime);
+      m_simulationThread = std::thread{[this] { simulationLoop(); }};
+    }
+    return;
+  }
+
+  const ProfilerScope scope{"simulate"};
+  const ElapsedTimer simulationTimer;
+  m_simulationAccumulator =
+      std::min(m_simulationAccumulator + m_lastDeltaTime, maxSimulationLag);
+  while (m_simulationAccumulator >= m_simulationStep) {
+    m_simulationTime += m_simulationStep;
+    simulate(m_simulationStep);
+    m_simulationAccumulator -= m_simulationStep;
+    m_numTicks.fetch_add(1, std::memory_order_relaxed);
+  }
+  m_simulationCost.store(simulationTimer.elapsed(), std::memory_order_relaxed);
+}
+
+// Body of the simulation thread. Ticks are scheduled on a fixed grid; after
+// a stall longer than maxSimulationLag, the missed ticks are dropped.
+void abcg::OpenGLWindow::simulationLoop() {
+  using clock = std::chrono::steady_clock;
+  const auto step{std::chrono::duration_cast<clock::duration>(
+      std::chrono::duration<double>{m_simulationStep})};
+  const auto maxLag{std::chrono::duration_cast<clock::duration>(
+      std::chrono::duration<double>{maxSimulationLag})};
+
+  ABCG_TRACE_THREAD_NAME("Simulation");
+  auto nextTick{m_simulationEpoch + step};
+  while (!m_stopSimulation.load(std::memory_order_acquire)) {
+    std::this_thread::sleep_until(nextTick);
+
+    const ProfilerScope scope{"simulate"};
+    const ElapsedTimer simulationTimer;
+    m_simulationTime += m_simulationStep;
+    try {
+      simulate(m_simulationStep);
+    } catch (...) {
+      // Rethrown on the main thread by the next frame
+      m_simulationError = std::current_exception();
+      m_simulationFailed.store(true, std::memory_order_release);
+      return;
+    }
+    m_simulationCost.store(simulationTimer.elapsed(),
+                           std::memory_order_relaxed);
+    m_numTicks.fetch_add(1, std::memory_order_relaxed);
+
+    if (const auto now{clock::now()}; now - nextTick > maxLag) nextTick = now;
+    const std::chrono::duration<double> sinceEpoch{nextTick -
+                                                   m_simulationEpoch};
+    m_presentationOffset.store(m_simulationTime - sinceEpoch.count(),
+                               std::memory_order_release);
+    nextTick += step;
   }
+}
+
+// Joins the simulation thread; the next frames simulate on the main thread
+// unless threaded mode is still enabled
+void abcg::OpenGLWindow::stopSimulation() {
+  if (!m_simulationThread.joinable()) return;
+  m_stopSimulation.store(true, std::memory_order_release);
+  m_simulationThread.join();
+  m_simulationAccumulator = 0.0;
+}
+
+// Hands the OpenGL context over to a new render thread
+void abcg::OpenGLWindow::startRendering() {
+  // Creates the device objects of the GUI renderer while the context is
+  // still current here
+  SDL_GL_MakeCurrent(m_window, m_GLContext);
+  ImGui_ImplOpenGL3_NewFrame();
+
+  m_renderQueue = std::make_unique<RenderQueue>(m_renderQueueDepth);
+  SDL_GL_MakeCurrent(m_window, nullptr);
+  m_renderThread = std::thread{[this] { renderLoop(); }};
+}
+
+// Body of the render thread. After a failure, frames are still released,
+// but no longer executed, so that the main thread never waits for a slot.
+void abcg::OpenGLWindow::renderLoop() {
+  ABCG_TRACE_THREAD_NAME("Render");
+  SDL_GL_MakeCurrent(m_window, m_GLContext);
+  while (auto *frame{m_renderQueue->pop()}) {
+    if (!m_renderFailed.load(std::memory_order_relaxed)) {
+      const ProfilerScope frameScope{"execute"};
+      try {
+        const ElapsedTimer submitTimer;
+        for (auto &command : frame->commands) command();
+        {
+          const ProfilerScope scope{"ImGui", true};
+          ImGui_ImplOpenGL3_RenderDrawData(&frame->drawData);
+        }
+        m_profiler.endGpuFrame();
+        m_submitCost.store(submitTimer.elapsed(), std::memory_order_relaxed);
+
+        if (m_openGLSettings.preserveWebGLDrawingBuffer) {
+          glFinish();
+        } else {
+          SDL_GL_SwapWindow(m_window);
+        }
+      } catch (...) {
+        // Rethrown on the main thread by the next frame
+        m_renderError = std::current_exception();
+        m_renderFailed.store(true, std::memory_order_release);
+      }
+    }
+    m_renderQueue->release(*frame);
+  }
+  SDL_GL_MakeCurrent(m_window, nullptr);
+}
+
+// Executes the frames already submitted, joins the render thread and takes
+// the context back. Commands recorded for the next frame run here.
+void abcg::OpenGLWindow::stopRendering() {
+  if (!m_renderThread.joinable()) return;
+  m_renderQueue->close();
+  m_renderThread.join();
+  SDL_GL_MakeCurrent(m_window, m_GLContext);
+
+  if (m_recordingFrame != nullptr) {
+    if (!m_renderFailed.load()) {
+      for (auto &command : m_recordingFrame->commands) command();
+    }
+    m_recordingFrame = nullptr;
+  }
+  m_renderQueue.reset();
+}
+
+// Frame receiving the commands submitted with the render thread, acquired
+// on first use
+abcg::RenderQueue::Frame &abcg::OpenGLWindow::getRecordingFrame() {
+  if (m_recordingFrame == nullptr) {
+    m_recordingFrame = &m_renderQueue->acquire();
+  }
+  return *m_recordingFrame;
+}
+
+// Called by abcg::Application before each iteration of the main loop.
+// Adapts the frame rate to the activity state and returns whether the
+// window is idle: hidden, or waiting for input in render-on-demand mode.
+// The simulation pauses while idle, and the idle time is not simulated.
+// Windows never idle while input is recorded or replayed, nor in runs of a
+// fixed number of frames.
+bool abcg::OpenGLWindow::updateActivity() {
+#if defined(__EMSCRIPTEN__)
+  // The browser throttles hidden tabs by itself
+  return false;
+#else
+  const auto activity{getActivity()};
+  const auto idle{m_inputRecorder == nullptr && !m_frameLimited &&
+                  (activity == WindowActivity::Hidden ||
+                   (m_windowSettings.renderOnDemand && m_pendingRepaints == 0))};
+
+  if (activity != m_activity) {
+    auto frameRate{m_foregroundFrameRate};
+    if (activity == WindowActivity::Background &&
+        m_windowSettings.backgroundFrameRate > 0.0) {
+      frameRate = frameRate > 0.0 ? std::min(frameRate,
+                                             m_windowSettings.backgroundFrameRate)
+                                  : m_windowSettings.backgroundFrameRate;
+    }
+    m_framePacer.setTargetRate(frameRate);
+    if (m_hitchRecorder != nullptr) m_hitchRecorder->restart();
+    m_activity = activity;
+  }
+
+  if (idle && !m_idle) stopSimulation();
+  if (!idle && m_idle) m_deltaTime.restart();
+  m_idle = idle;
+  return idle;
+#endif
+}
+
+// State of the window at the end of a frame, stored with hitch captures:
+// timings of the frame and its scopes, GPU time and OpenGL call counts of
+// the last frames measured, and state of the simulation and of the render
+// queue
+abcg::Tracer::Metadata abcg::OpenGLWindow::describeFrame() {
+  Tracer::Metadata metadata;
+  const auto add{[&](std::string key, std::string value) {
+    metadata.emplace_back(std::move(key), std::move(value));
+  }};
+  const auto milliseconds{
+      [](double seconds) { return fmt::format("{:.3f}", seconds * 1e3); }};
+  // Scopes are numbered, since a name may occur several times
+  const auto addScopes{[&](std::string_view processor,
+                           const std::vector<Profiler::Sample> &samples) {
+    for (std::size_t index{}; index < samples.size(); ++index) {
+      const auto &sample{samples.at(index)};
+      add(fmt::format("{} scope {:02d}", processor, index),
+          fmt::format("{:{}}{} {} ms", "", sample.depth * 2, sample.name,
+                      milliseconds(sample.duration)));
+    }
+  }};
+
+  const auto frameNumber{m_profiler.getFrameNumber()};
+  add("frame", std::to_string(frameNumber));
+  if (const auto *frame{m_profiler.getFrame(frameNumber)}) {
+    add("CPU time (ms)", milliseconds(frame->cpuTime));
+    addScopes("CPU", frame->cpuSamples);
+  }
+  for (auto number{frameNumber}; number + 8 > frameNumber && number > 0;
+       --number) {
+    const auto *frame{m_profiler.getFrame(number)};
+    if (frame == nullptr || !frame->hasGpuTime) continue;
+    add("GPU frame", std::to_string(number));
+    add("GPU time (ms)", milliseconds(frame->gpuTime));
+    addScopes("GPU", frame->gpuSamples);
+    break;
+  }
+  for (auto number{frameNumber}; number + 8 > frameNumber && number > 0;
+       --number) {
+    const auto *frame{m_profiler.getFrame(number)};
+    if (frame == nullptr || !frame->hasGLStats) continue;
+    const auto &stats{frame->glStats};
+    const auto binds{[](std::uint64_t count, std::uint64_t redundant) {
+      return fmt::format("{} ({} redundant)", count, redundant);
+    }};
+    add("GL frame", std::to_string(number));
+    add("GL calls", std::to_string(stats.calls));
+    add("draw calls", std::to_string(stats.drawCalls));
+    add("vertices", std::to_string(stats.vertices));
+    add("indices", std::to_string(stats.indices));
+    add("instances", std::to_string(stats.instances));
+    add("buffer bytes", std::to_string(stats.bufferBytes));
+    add("texture bytes", std::to_string(stats.textureBytes));
+    add("program binds",
+        binds(stats.programBinds, stats.redundantProgramBinds));
+    add("VAO binds",
+        binds(stats.vertexArrayBinds, stats.redundantVertexArrayBinds));
+    add("texture binds",
+        binds(stats.textureBinds, stats.redundantTextureBinds));
+    add("uniform updates", std::to_string(stats.uniformUpdates));
+    add("state changes", std::to_string(stats.stateChanges));
+    break;
+  }
+
+  add("render cost (ms)", milliseconds(getRenderCost()));
+  add("simulation cost (ms)", milliseconds(getSimulationCost()));
+  add("simulation thread", isSimulationThreaded() ? "yes" : "no");
+  add("render thread", m_renderThread.joinable() ? "yes" : "no");
+  if (m_renderQueue != nullptr) {
+    add("submit cost (ms)", milliseconds(getSubmitCost()));
+    add("render queue depth", std::to_string(m_renderQueueDepth));
+    add("frames queued", std::to_string(m_renderQueue->getNumSubmitted()));
+    add("free frame slots", std::to_string(m_renderQueue->getNumFree()));
+  }
+  const std::array activities{"foreground", "background", "hidden"};
+  add("activity", activities.at(static_cast<std::size_t>(m_activity)));
+  add("target frame rate", fmt::format("{:.1f}", m_framePacer.getTargetRate()));
+  return metadata;
+}
 
-  // Cap to 480 Hz
-  if (m_deltaTime.elapsed() >= 1.0 / 480.0) {
-    m_lastDeltaTime = m_deltaTime.restart();
-  } else
-    m_lastDeltaTime = 0.0;
+void abcg::OpenGLWindow::measureLoopRates() {
+  ++m_rateFrames;
+  const auto elapsed{m_rateTimer.elapsed()};
+  if (elapsed < loopRateInterval) return;
+  const auto ticks{m_numTicks.load(std::memory_order_relaxed)};
+  m_frameRate = static_cast<double>(m_rateFrames) / elapsed;
+  m_tickRate = static_cast<double>(ticks - m_rateTicks) / elapsed;
+  m_rateFrames = 0;
+  m_rateTicks = ticks;
+  m_rateTimer.restart();
 }
\ No newline at end of file
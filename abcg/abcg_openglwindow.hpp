@@ -10,14 +10,27 @@
 #ifndef ABCG_OPENGLWINDOW_HPP_
 #define ABCG_OPENGLWINDOW_HPP_
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <memory>
 #include <string>
+#include <thread>
 
+#include "abcg_activitymonitor.hpp"
 #include "abcg_elapsedtimer.hpp"
+#include "abcg_framearena.hpp"
+#include "abcg_framepacer.hpp"
 #include "abcg_openglfunctions.hpp"
+#include "abcg_profiler.hpp"
+#include "abcg_renderqueue.hpp"
 
 namespace abcg {
 enum class OpenGLProfile;
 class Application;
+class HitchRecorder;
+class InputRecorder;
 class OpenGLWindow;
 struct OpenGLSettings;
 struct WindowSettings;
@@ -34,6 +47,22 @@ EM_BOOL fullscreenchangeCallback(int eventType,
  */
 enum class abcg::OpenGLProfile { Core, Compatibility, ES };
 
+/**
+ * @brief OpenGL context and presentation settings.
+ *
+ * With vsync, adaptive vsync is used when the driver supports it, so that a
+ * late frame tears instead of waiting for the next refresh.
+ *
+ * targetFrameRate is the rate aimed at by the frame pacer. Zero means the
+ * refresh rate of the display without vsync, and no pacing with vsync
+ * (which paces by itself). A negative rate disables pacing. Ignored in
+ * Emscripten builds, which are paced by the browser.
+ *
+ * In debug builds, the context is created with the debug flag and OpenGL
+ * errors are reported asynchronously through KHR_debug, when supported.
+ * synchronousGLErrors checks glGetError around every call instead, which
+ * pinpoints the failing call but stalls the GPU at each call.
+ */
 struct alignas(32) abcg::OpenGLSettings {
   OpenGLProfile profile{OpenGLProfile::Core};
   int majorVersion{4};
@@ -43,13 +72,27 @@ struct alignas(32) abcg::OpenGLSettings {
   int samples{0};
   bool vsync{false};
   bool preserveWebGLDrawingBuffer{false};
+  double targetFrameRate{0.0};
+  bool synchronousGLErrors{false};
 };
 
+/**
+ * @brief Window settings.
+ *
+ * backgroundFrameRate limits the frame rate while the window is visible but
+ * not focused (zero keeps the foreground rate). With renderOnDemand, frames
+ * are only painted after input events or calls to
+ * abcg::OpenGLWindow::requestRepaint, which suits tools with a static
+ * scene.
+ */
 struct alignas(64) abcg::WindowSettings {
   int width{800};
   int height{600};
   bool showFPS{true};
   bool showFullscreenButton{true};
+  bool hidden{false};
+  bool renderOnDemand{false};
+  double backgroundFrameRate{0.0};
   std::string title{"ABCg Window"};
 };
 
@@ -62,10 +105,10 @@ class abcg::OpenGLWindow {
   OpenGLWindow() = default;
   virtual ~OpenGLWindow();
 
-  OpenGLWindow(const OpenGLWindow&) = default;
-  OpenGLWindow(OpenGLWindow&&) = default;
-  OpenGLWindow& operator=(const OpenGLWindow&) = default;
-  OpenGLWindow& operator=(OpenGLWindow&&) = default;
+  OpenGLWindow(const OpenGLWindow&) = delete;
+  OpenGLWindow(OpenGLWindow&&) = delete;
+  OpenGLWindow& operator=(const OpenGLWindow&) = delete;
+  OpenGLWindow& operator=(OpenGLWindow&&) = delete;
 
   [[nodiscard]] OpenGLSettings getOpenGLSettings() noexcept;
   [[nodiscard]] WindowSettings getWindowSettings() noexcept;
@@ -78,6 +121,7 @@ class abcg::OpenGLWindow {
   virtual void paintGL();
   virtual void paintUI();
   virtual void resizeGL(int width, int height);
+  virtual void simulate(double timeStep);
   virtual void terminateGL();
 
   [[nodiscard]] GLuint createProgramFromFile(
@@ -89,12 +133,48 @@ class abcg::OpenGLWindow {
   std::string getAssetsPath();
   [[nodiscard]] double getDeltaTime() const;
   [[nodiscard]] double getElapsedTime() const;
+  [[nodiscard]] std::uint64_t getSessionSeed(std::uint64_t seed);
+  [[nodiscard]] double getSimulationStep() const noexcept;
+  [[nodiscard]] double getSimulationAlpha() const noexcept;
+  [[nodiscard]] double getSimulationCost() const noexcept;
+  [[nodiscard]] double getSimulationTime() const noexcept;
+  [[nodiscard]] double getPresentationTime() const;
+  [[nodiscard]] double getRenderCost() const noexcept;
+  [[nodiscard]] double getSubmitCost() const noexcept;
+  [[nodiscard]] double getFrameRate() const noexcept;
+  [[nodiscard]] FramePacer::Statistics getFrameTimeStatistics() const;
+  [[nodiscard]] WindowActivity getActivity() const noexcept;
+  [[nodiscard]] const ActivityMonitor::Statistics& getActivityStatistics(
+      WindowActivity activity) const;
+  void requestRepaint() noexcept;
+  [[nodiscard]] Profiler& getProfiler() noexcept;
+  [[nodiscard]] FrameArena& getFrameArena() noexcept;
+  [[nodiscard]] double getTickRate() const noexcept;
+  [[nodiscard]] bool isSimulationThreaded() const noexcept;
+  [[nodiscard]] bool isRenderThreaded() const noexcept;
+  void setSimulationRate(double ticksPerSecond);
+  void setSimulationThreaded(bool threaded);
+  void setRenderThreaded(bool threaded, std::size_t queueDepth = 1);
+  void submitGL(RenderQueue::Command command);
+  [[nodiscard]] std::size_t getFrameSlot();
+  [[nodiscard]] std::size_t getNumFrameSlots() const noexcept;
   void toggleFullscreen();
 
  private:
   void handleEvent(SDL_Event& event, bool& done);
   void initialize(std::string_view basePath);
+  void terminate();
   void paint();
+  void runSimulation();
+  void simulationLoop();
+  void stopSimulation();
+  void startRendering();
+  void renderLoop();
+  void stopRendering();
+  RenderQueue::Frame& getRecordingFrame();
+  void measureLoopRates();
+  bool updateActivity();
+  [[nodiscard]] Tracer::Metadata describeFrame();
 
   WindowSettings m_windowSettings{};
   OpenGLSettings m_openGLSettings{};
@@ -113,6 +193,73 @@ class abcg::OpenGLWindow {
   ElapsedTimer m_windowStartTime;
   double m_lastDeltaTime{0.0};
 
+  // Waited on by abcg::Application before each frame
+  FramePacer m_framePacer;
+  double m_foregroundFrameRate{0.0};
+
+  // Visibility and focus from window events, frames still to be painted in
+  // render-on-demand mode, and state of the last main loop iteration
+  bool m_visible{true};
+  bool m_focused{true};
+  int m_pendingRepaints{1};
+  WindowActivity m_activity{WindowActivity::Foreground};
+  bool m_idle{false};
+  ActivityMonitor m_activityMonitor;
+
+  // CPU and GPU scopes of the frames, shown in the FPS overlay
+  Profiler m_profiler;
+  // Transient data of the frame being built, freed when the next one starts
+  FrameArena m_frameArena;
+
+  // Fixed-rate simulation: time step (zero when disabled), time not yet
+  // simulated, time reached by the ticks, and CPU time spent in simulate and
+  // in rendering
+  double m_simulationStep{0.0};
+  double m_simulationAccumulator{0.0};
+  double m_simulationTime{0.0};
+  std::atomic<double> m_simulationCost{0.0};
+  double m_renderCost{0.0};
+  std::atomic<std::uint64_t> m_numTicks{0};
+
+  // Simulation thread. The presentation offset is the simulation time minus
+  // the time since the epoch at the last tick.
+  bool m_simulationThreaded{false};
+  std::thread m_simulationThread;
+  std::atomic<bool> m_stopSimulation{false};
+  std::atomic<bool> m_simulationFailed{false};
+  std::exception_ptr m_simulationError;
+  std::chrono::steady_clock::time_point m_simulationEpoch{};
+  std::atomic<double> m_presentationOffset{0.0};
+
+  // Render thread. It owns the OpenGL context while running and executes
+  // the frames recorded on the main thread.
+  bool m_renderThreaded{false};
+  std::size_t m_renderQueueDepth{1};
+  std::unique_ptr<RenderQueue> m_renderQueue;
+  RenderQueue::Frame* m_recordingFrame{};
+  std::thread m_renderThread;
+  std::atomic<bool> m_renderFailed{false};
+  std::exception_ptr m_renderError;
+  std::atomic<double> m_submitCost{0.0};
+
+  // Frame and tick rates measured over the last half second or so
+  ElapsedTimer m_rateTimer;
+  std::uint64_t m_rateFrames{};
+  std::uint64_t m_rateTicks{};
+  double m_frameRate{0.0};
+  double m_tickRate{0.0};
+
+  // Set by abcg::Application when recording or replaying input. The elapsed
+  // time is then the sum of the delta times of the frames.
+  InputRecorder* m_inputRecorder{};
+  double m_frameClock{0.0};
+
+  // Set by abcg::Application when capturing hitches
+  HitchRecorder* m_hitchRecorder{};
+
+  // Set by abcg::Application for runs of a fixed number of frames
+  bool m_frameLimited{false};
+
   friend Application;
 
 #if defined(__EMSCRIPTEN__)
@@ -0,0 +1,803 @@
+/**
+ * @file abcg_profiler.cpp
+ * @brief Definition of abcg::Profiler and abcg::ProfilerScope class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_profiler.hpp"
+
+#include <fmt/core.h>
+#include <imgui.h>
+
+#include <algorithm>
+#include <functional>
+#include <span>
+#include <string_view>
+#include <utility>
+
+#include "abcg_openglfunctions.hpp"
+
+namespace {
+std::atomic<abcg::Profiler *> activeProfiler{};
+
+// Width of the panel contents, in pixels
+constexpr float panelWidth{420.0f};
+
+// Returns the value below which the given fraction of the values fall.
+// Sorts the values.
+double getPercentile(std::span<double> values, double fraction) {
+  if (values.empty()) return 0.0;
+  std::sort(values.begin(), values.end());
+  const auto index{static_cast<std::size_t>(
+      fraction * static_cast<double>(values.size() - 1) + 0.5)};
+  return values[index];
+}
+
+// Color of a scope, derived from its name so that it is stable across frames
+ImU32 getScopeColor(std::string_view name) {
+  const auto hash{std::hash<std::string_view>{}(name)};
+  const auto hue{static_cast<float>(hash % 360) / 360.0f};
+  return ImColor::HSV(hue, 0.45f, 0.75f);
+}
+}  // namespace
+
+abcg::Profiler::~Profiler() {
+  auto *expected{this};
+  activeProfiler.compare_exchange_strong(expected, nullptr);
+}
+
+/**
+ * @brief Sets the profiler that receives the scopes of abcg::ProfilerScope.
+ *
+ * @param profiler Profiler to activate, or nullptr to disable profiling.
+ */
+void abcg::Profiler::setActive(Profiler *profiler) noexcept {
+  activeProfiler.store(profiler, std::memory_order_release);
+}
+
+/**
+ * @brief Returns the active profiler, or nullptr if there is none.
+ */
+abcg::Profiler *abcg::Profiler::getActive() noexcept {
+  return activeProfiler.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Starts a frame on the calling thread, which becomes the CPU thread.
+ *
+ * Also completes the frame time and the allocation counts of the previous
+ * frame, and collects the GPU results read back since the previous frame.
+ */
+void abcg::Profiler::beginFrame() {
+  if (m_frameOpen) endFrame();
+  mergeGpuResults();
+
+  const auto now{clock::now()};
+  const auto allocations{AllocationTracker::getThreadCounters()};
+  const auto totalAllocations{AllocationTracker::getTotalCounters()};
+  if (m_frameNumber > 0) {
+    auto &previous{m_history.at(m_frameNumber % historySize)};
+    previous.frameTime =
+        std::chrono::duration<double>{now - m_frameStart}.count();
+    previous.allocations = allocations - m_frameAllocations;
+    previous.totalAllocations = totalAllocations - m_frameTotalAllocations;
+  }
+
+  ++m_frameNumber;
+  auto &frame{m_history.at(m_frameNumber % historySize)};
+  frame.number = m_frameNumber;
+  frame.frameTime = 0.0;
+  frame.cpuTime = 0.0;
+  frame.gpuTime = 0.0;
+  frame.hasGpuTime = false;
+  frame.cpuSamples.clear();
+  frame.gpuSamples.clear();
+  frame.hasGLStats = false;
+  frame.allocations = {};
+  frame.totalAllocations = {};
+
+  m_frameStart = now;
+  m_frameAllocations = allocations;
+  m_frameTotalAllocations = totalAllocations;
+  m_cpuStack.clear();
+  m_cpuThread.store(std::this_thread::get_id(), std::memory_order_relaxed);
+  m_frameOpen = true;
+}
+
+/**
+ * @brief Ends the frame started by abcg::Profiler::beginFrame. Scopes still
+ * open are closed.
+ */
+void abcg::Profiler::endFrame() {
+  if (!m_frameOpen) return;
+  while (!m_cpuStack.empty()) endCpuScope();
+  auto &frame{m_history.at(m_frameNumber % historySize)};
+  frame.cpuTime =
+      std::chrono::duration<double>{clock::now() - m_frameStart}.count();
+  m_frameOpen = false;
+}
+
+/**
+ * @brief Opens a CPU scope nested in the scopes already open.
+ *
+ * @param name Name of the scope. Must outlive the profiler.
+ *
+ * @return Whether the scope is recorded, i.e., whether a frame is open and
+ * the caller is the CPU thread. Only recorded scopes must be closed.
+ */
+bool abcg::Profiler::beginCpuScope(const char *name) {
+  if (!m_frameOpen || !isCpuThread()) return false;
+  auto &samples{m_history.at(m_frameNumber % historySize).cpuSamples};
+  m_cpuStack.push_back(samples.size());
+  // The allocation counters at the start are replaced by the difference
+  // when the scope closes
+  samples.push_back(
+      {name, static_cast<int>(m_cpuStack.size()) - 1,
+       std::chrono::duration<double>{clock::now() - m_frameStart}.count(),
+       0.0, AllocationTracker::getThreadCounters()});
+  return true;
+}
+
+/**
+ * @brief Closes the innermost CPU scope.
+ */
+void abcg::Profiler::endCpuScope() {
+  if (m_cpuStack.empty()) return;
+  auto &sample{
+      m_history.at(m_frameNumber % historySize).cpuSamples.at(m_cpuStack.back())};
+  m_cpuStack.pop_back();
+  sample.duration =
+      std::chrono::duration<double>{clock::now() - m_frameStart}.count() -
+      sample.start;
+  sample.allocations =
+      AllocationTracker::getThreadCounters() - sample.allocations;
+}
+
+/**
+ * @brief Returns whether the calling thread is the one that starts frames.
+ */
+bool abcg::Profiler::isCpuThread() const noexcept {
+  return m_cpuThread.load(std::memory_order_relaxed) ==
+         std::this_thread::get_id();
+}
+
+/**
+ * @brief Returns a recorded frame, or nullptr if it is no longer in the
+ * history. Main thread only.
+ *
+ * @param frameNumber Number of the frame.
+ */
+const abcg::Profiler::Frame *abcg::Profiler::getFrame(
+    std::uint64_t frameNumber) const {
+  const auto &frame{m_history.at(frameNumber % historySize)};
+  return frame.number == frameNumber ? &frame : nullptr;
+}
+
+/**
+ * @brief Checks for timer query support. Must be called with the OpenGL
+ * context current.
+ */
+void abcg::Profiler::initializeGL() {
+#if defined(__EMSCRIPTEN__)
+  m_gpuSupported = false;
+#else
+  m_gpuSupported = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+#endif
+  m_gpuThread.store(std::this_thread::get_id(), std::memory_order_relaxed);
+}
+
+/**
+ * @brief Deletes the query objects. Must be called with the OpenGL context
+ * current.
+ */
+void abcg::Profiler::terminateGL() {
+  for (auto &set : m_querySets) {
+    if (!set.queries.empty()) {
+      glDeleteQueries(static_cast<GLsizei>(set.queries.size()),
+                      set.queries.data());
+    }
+    set = {};
+  }
+  m_gpuFrame = nullptr;
+  m_gpuStack.clear();
+  m_gpuSupported = false;
+  m_gpuFrameOpen = false;
+}
+
+/**
+ * @brief Starts the GPU part of a frame on the calling thread, which must
+ * own the OpenGL context.
+ *
+ * Restarts the counters of abcg::GLStats. Reads back the results of
+ * earlier frames that are available, and drops those of the oldest frame if
+ * they are still pending.
+ *
+ * @param frameNumber Number of the frame, as returned by
+ * abcg::Profiler::getFrameNumber when the frame was recorded.
+ */
+void abcg::Profiler::beginGpuFrame(std::uint64_t frameNumber) {
+  m_gpuThread.store(std::this_thread::get_id(), std::memory_order_relaxed);
+  if (m_gpuFrameOpen) endGpuFrame();
+  m_gpuFrameOpen = true;
+  m_gpuFrameNumber = frameNumber;
+  GLStats::beginFrame();
+  if (!m_gpuSupported) return;
+
+  readGpuResults();
+  calibrateGpuClock();
+
+  auto &set{m_querySets.at(m_nextQuerySet)};
+  m_nextQuerySet = (m_nextQuerySet + 1) % m_querySets.size();
+  if (set.pending) {
+    m_droppedGpuFrames.fetch_add(1, std::memory_order_relaxed);
+  }
+  set.frameNumber = frameNumber;
+  set.pending = false;
+  set.numUsed = 0;
+  set.markers.clear();
+
+  m_gpuFrame = &set;
+  m_gpuStack.clear();
+  writeTimestamp();
+}
+
+/**
+ * @brief Ends the GPU part of the frame. Scopes still open are closed.
+ */
+void abcg::Profiler::endGpuFrame() {
+  if (!m_gpuFrameOpen || !isGpuThread()) return;
+  m_gpuFrameOpen = false;
+  if constexpr (GLStats::isEnabled()) {
+    const std::scoped_lock lock{m_gpuMutex};
+    m_glStatsResults.push_back({m_gpuFrameNumber, GLStats::getCounters()});
+  }
+  if (m_gpuFrame == nullptr) return;
+  while (!m_gpuStack.empty()) endGpuScope();
+  writeTimestamp();
+  m_gpuFrame->pending = true;
+  m_gpuFrame = nullptr;
+}
+
+/**
+ * @brief Opens a GPU scope nested in the GPU scopes already open.
+ *
+ * @param name Name of the scope. Must outlive the profiler.
+ *
+ * @return Whether the scope is recorded, i.e., whether a GPU frame is open
+ * and the caller owns the OpenGL context. Only recorded scopes must be
+ * closed.
+ */
+bool abcg::Profiler::beginGpuScope(const char *name) {
+  if (m_gpuFrame == nullptr || !isGpuThread()) return false;
+  m_gpuStack.push_back(m_gpuFrame->markers.size());
+  m_gpuFrame->markers.push_back(
+      {name, static_cast<int>(m_gpuStack.size()) - 1, writeTimestamp(), 0});
+  return true;
+}
+
+/**
+ * @brief Closes the innermost GPU scope.
+ */
+void abcg::Profiler::endGpuScope() {
+  if (m_gpuFrame == nullptr || m_gpuStack.empty()) return;
+  auto &marker{m_gpuFrame->markers.at(m_gpuStack.back())};
+  m_gpuStack.pop_back();
+  marker.end = writeTimestamp();
+}
+
+/**
+ * @brief Returns whether the calling thread is the one that owns the
+ * OpenGL context.
+ */
+bool abcg::Profiler::isGpuThread() const noexcept {
+  return m_gpuThread.load(std::memory_order_relaxed) ==
+         std::this_thread::get_id();
+}
+
+// Returns the frame with the given number, or nullptr if it is no longer
+// in the history
+abcg::Profiler::Frame *abcg::Profiler::findFrame(std::uint64_t frameNumber) {
+  auto &frame{m_history.at(frameNumber % historySize)};
+  return frame.number == frameNumber ? &frame : nullptr;
+}
+
+// Moves the GPU results read back by the OpenGL thread, and the call
+// counts, into the history. The sample buffers replaced in the history go
+// back to the OpenGL thread.
+void abcg::Profiler::mergeGpuResults() {
+  {
+    const std::scoped_lock lock{m_gpuMutex};
+    m_mergedGpuResults.swap(m_gpuResults);
+    m_mergedGLStatsResults.swap(m_glStatsResults);
+  }
+  for (const auto &result : m_mergedGLStatsResults) {
+    if (auto *frame{findFrame(result.frameNumber)}) {
+      frame->glStats = result.counters;
+      frame->hasGLStats = true;
+    }
+  }
+  for (auto &result : m_mergedGpuResults) {
+    if (auto *frame{findFrame(result.frameNumber)}) {
+      frame->gpuTime = result.gpuTime;
+      frame->hasGpuTime = true;
+      frame->gpuSamples.swap(result.samples);
+    }
+  }
+  if (!m_mergedGpuResults.empty()) {
+    const std::scoped_lock lock{m_gpuMutex};
+    for (auto &result : m_mergedGpuResults) {
+      result.samples.clear();
+      m_freeSampleBuffers.push_back(std::move(result.samples));
+    }
+  }
+  m_mergedGpuResults.clear();
+  m_mergedGLStatsResults.clear();
+}
+
+// Issues a timestamp query in the current set and returns its index. Query
+// objects are created on first use and reused afterwards.
+std::size_t abcg::Profiler::writeTimestamp() {
+  auto &set{*m_gpuFrame};
+  if (set.numUsed == set.queries.size()) {
+    GLuint query{};
+    glGenQueries(1, &query);
+    set.queries.push_back(query);
+  }
+#if !defined(__EMSCRIPTEN__)
+  glQueryCounter(set.queries.at(set.numUsed), GL_TIMESTAMP);
+#endif
+  return set.numUsed++;
+}
+
+// Reads back the sets whose queries are available, without waiting.
+// Timestamps complete in order, so the last query of a set tells for all.
+void abcg::Profiler::readGpuResults() {
+#if !defined(__EMSCRIPTEN__)
+  auto &timestamps{m_timestamps};
+  for (auto &set : m_querySets) {
+    if (!set.pending) continue;
+
+    GLuint available{};
+    glGetQueryObjectuiv(set.queries.at(set.numUsed - 1),
+                        GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available == GL_FALSE) continue;
+
+    timestamps.resize(set.numUsed);
+    for (std::size_t index{}; index < set.numUsed; ++index) {
+      glGetQueryObjectui64v(set.queries.at(index), GL_QUERY_RESULT,
+                            &timestamps.at(index));
+    }
+    set.pending = false;
+
+    const auto seconds{[&](std::size_t begin, std::size_t end) {
+      return static_cast<double>(timestamps.at(end) - timestamps.at(begin)) *
+             1e-9;
+    }};
+    GpuResult result{set.frameNumber, seconds(0, set.numUsed - 1), {}};
+    {
+      const std::scoped_lock lock{m_gpuMutex};
+      if (!m_freeSampleBuffers.empty()) {
+        result.samples.swap(m_freeSampleBuffers.back());
+        m_freeSampleBuffers.pop_back();
+      }
+    }
+    result.samples.reserve(set.markers.size());
+    for (const auto &marker : set.markers) {
+      result.samples.push_back({marker.name, marker.depth,
+                                seconds(0, marker.begin),
+                                seconds(marker.begin, marker.end),
+                                {}});
+    }
+
+    if (Tracer::isEnabled() && m_gpuClockValid) {
+      const auto traceTime{[&](std::size_t index) {
+        return static_cast<std::uint64_t>(
+            static_cast<std::int64_t>(timestamps.at(index)) +
+            m_gpuClockOffset);
+      }};
+      Tracer::gpuScope("GPU frame", traceTime(0),
+                       timestamps.at(set.numUsed - 1) - timestamps.at(0));
+      for (const auto &marker : set.markers) {
+        Tracer::gpuScope(marker.name, traceTime(marker.begin),
+                         timestamps.at(marker.end) -
+                             timestamps.at(marker.begin));
+      }
+    }
+
+    const std::scoped_lock lock{m_gpuMutex};
+    m_gpuResults.push_back(std::move(result));
+  }
+#endif
+}
+
+// Measures the offset between the GPU clock and the trace clock while
+// tracing, once every 60 GPU frames to follow the drift of the clocks. The
+// GPU time read is that of the commands already issued, which is close to
+// the CPU time of the call.
+void abcg::Profiler::calibrateGpuClock() {
+#if !defined(__EMSCRIPTEN__)
+  if (!Tracer::isEnabled()) {
+    m_gpuClockValid = false;
+    return;
+  }
+  if (m_gpuClockValid && ++m_gpuClockFrames < 60) return;
+
+  GLint64 gpuTime{};
+  glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+  m_gpuClockOffset = static_cast<std::int64_t>(Tracer::now()) - gpuTime;
+  m_gpuClockValid = true;
+  m_gpuClockFrames = 0;
+#endif
+}
+
+/**
+ * @brief Draws the profiler panel into the current ImGui window.
+ *
+ * Shows the frame times of the history, their percentiles, the average
+ * time of each scope, the OpenGL call counts and a flame view of the last
+ * frames. Scratch data goes to an arena, so that the panel does not
+ * allocate once warm.
+ */
+void abcg::Profiler::paintUI() {
+  m_arena.reset();
+
+  // Frame times, oldest first. The current frame is still incomplete.
+  std::array<float, historySize> frameTimes{};
+  int numFrameTimes{};
+  double sum{};
+  for (auto number{m_frameNumber > historySize ? m_frameNumber - historySize
+                                               : std::uint64_t{}};
+       number < m_frameNumber; ++number) {
+    if (const auto *frame{findFrame(number)};
+        frame != nullptr && frame->frameTime > 0.0) {
+      frameTimes.at(static_cast<std::size_t>(numFrameTimes++)) =
+          static_cast<float>(frame->frameTime * 1000.0);
+      sum += frame->frameTime;
+    }
+  }
+  const auto maxFrameTime{
+      *std::max_element(frameTimes.begin(), frameTimes.end())};
+  const auto label{numFrameTimes > 0
+                       ? m_arena.format("avg {:.1f} FPS", numFrameTimes / sum)
+                       : std::pmr::string{&m_arena}};
+  ImGui::PlotHistogram("##FrameTimes", frameTimes.data(), numFrameTimes, 0,
+                       label.c_str(), 0.0f, maxFrameTime * 1.5f,
+                       ImVec2(panelWidth, 50.0f));
+
+  paintPercentiles();
+  if (AllocationTracker::isEnabled()) {
+    if (const auto *frame{findFrame(m_frameNumber - 1)}) {
+      ImGui::Text("Allocations: %llu (%llu B), %llu on all threads",
+                  static_cast<unsigned long long>(
+                      frame->allocations.allocations),
+                  static_cast<unsigned long long>(frame->allocations.bytes),
+                  static_cast<unsigned long long>(
+                      frame->totalAllocations.allocations));
+    }
+  }
+  if (ImGui::CollapsingHeader("Scopes")) paintScopeTable();
+  if (GLStats::isEnabled() && ImGui::CollapsingHeader("OpenGL")) {
+    paintGLStats();
+  }
+  if (ImGui::CollapsingHeader("Flame view")) paintFlameView();
+}
+
+// Table of the percentiles of the frame, CPU and GPU times
+void abcg::Profiler::paintPercentiles() {
+  std::pmr::vector<double> frameTimes{&m_arena};
+  std::pmr::vector<double> cpuTimes{&m_arena};
+  std::pmr::vector<double> gpuTimes{&m_arena};
+  for (auto *times : {&frameTimes, &cpuTimes, &gpuTimes}) {
+    times->reserve(historySize);
+  }
+  for (const auto &frame : m_history) {
+    if (frame.number == 0 || frame.number == m_frameNumber) continue;
+    if (frame.frameTime > 0.0) frameTimes.push_back(frame.frameTime * 1000.0);
+    cpuTimes.push_back(frame.cpuTime * 1000.0);
+    if (frame.hasGpuTime) gpuTimes.push_back(frame.gpuTime * 1000.0);
+  }
+
+  if (!ImGui::BeginTable("Percentiles", 5,
+                         ImGuiTableFlags_RowBg |
+                             ImGuiTableFlags_SizingStretchSame,
+                         ImVec2(panelWidth, 0.0f))) {
+    return;
+  }
+  for (const auto *header : {"ms", "p50", "p95", "p99", "max"}) {
+    ImGui::TableSetupColumn(header);
+  }
+  ImGui::TableHeadersRow();
+
+  const auto row{[](const char *name, std::span<double> values) {
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted(name);
+    if (values.empty()) {
+      ImGui::TableNextColumn();
+      ImGui::TextDisabled("n/a");
+      return;
+    }
+    for (const auto fraction : {0.5, 0.95, 0.99, 1.0}) {
+      ImGui::TableNextColumn();
+      ImGui::Text("%.2f", getPercentile(values, fraction));
+    }
+  }};
+  row("Frame", frameTimes);
+  row("CPU", cpuTimes);
+  row("GPU", gpuTimes);
+  ImGui::EndTable();
+
+  if (const auto dropped{m_droppedGpuFrames.load(std::memory_order_relaxed)};
+      dropped > 0) {
+    ImGui::TextDisabled("%llu GPU frames dropped",
+                        static_cast<unsigned long long>(dropped));
+  }
+}
+
+// Table of the average and maximum time per frame of each scope, nested as
+// recorded, and of its average allocations. Scopes are merged by name,
+// depth and processor.
+void abcg::Profiler::paintScopeTable() {
+  struct Aggregate {
+    std::string_view name;
+    int depth{};
+    bool gpu{};
+    double total{};
+    double max{};
+    std::uint64_t allocations{};
+  };
+  std::pmr::vector<Aggregate> aggregates{&m_arena};
+  aggregates.reserve(64);
+  int numCpuFrames{};
+  int numGpuFrames{};
+
+  const auto accumulate{[&](const std::vector<Sample> &samples, bool gpu) {
+    for (const auto &sample : samples) {
+      auto iter{std::find_if(
+          aggregates.begin(), aggregates.end(), [&](const auto &aggregate) {
+            return aggregate.gpu == gpu && aggregate.depth == sample.depth &&
+                   aggregate.name == sample.name;
+          })};
+      if (iter == aggregates.end()) {
+        iter = aggregates.insert(
+            aggregates.end(), {sample.name, sample.depth, gpu, 0.0, 0.0, 0});
+      }
+      iter->total += sample.duration;
+      iter->max = std::max(iter->max, sample.duration);
+      iter->allocations += sample.allocations.allocations;
+    }
+  }};
+  for (auto number{m_frameNumber > historySize ? m_frameNumber - historySize
+                                               : std::uint64_t{}};
+       number < m_frameNumber; ++number) {
+    const auto *frame{findFrame(number)};
+    if (frame == nullptr) continue;
+    accumulate(frame->cpuSamples, false);
+    ++numCpuFrames;
+    if (frame->hasGpuTime) {
+      accumulate(frame->gpuSamples, true);
+      ++numGpuFrames;
+    }
+  }
+
+  const auto numColumns{AllocationTracker::isEnabled() ? 4 : 3};
+  if (!ImGui::BeginTable("Scopes", numColumns,
+                         ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit,
+                         ImVec2(panelWidth, 0.0f))) {
+    return;
+  }
+  ImGui::TableSetupColumn("Scope", ImGuiTableColumnFlags_WidthStretch);
+  ImGui::TableSetupColumn("avg ms");
+  ImGui::TableSetupColumn("max ms");
+  if (AllocationTracker::isEnabled()) ImGui::TableSetupColumn("allocs");
+  ImGui::TableHeadersRow();
+  for (const auto gpu : {false, true}) {
+    const auto numFrames{gpu ? numGpuFrames : numCpuFrames};
+    if (numFrames == 0) continue;
+    for (const auto &aggregate : aggregates) {
+      if (aggregate.gpu != gpu) continue;
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::Indent(static_cast<float>(aggregate.depth) * 8.0f + 1.0f);
+      ImGui::Text("%s %.*s", gpu ? "GPU" : "CPU",
+                  static_cast<int>(aggregate.name.size()),
+                  aggregate.name.data());
+      ImGui::Unindent(static_cast<float>(aggregate.depth) * 8.0f + 1.0f);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f", aggregate.total / numFrames * 1000.0);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f", aggregate.max * 1000.0);
+      if (AllocationTracker::isEnabled()) {
+        ImGui::TableNextColumn();
+        if (!gpu) {
+          ImGui::Text("%.1f", static_cast<double>(aggregate.allocations) /
+                                  numFrames);
+        }
+      }
+    }
+  }
+  ImGui::EndTable();
+}
+
+// Table of the OpenGL call counts of the last frame counted, with their
+// average and maximum over the history
+void abcg::Profiler::paintGLStats() {
+  using Counter = std::uint64_t GLStats::Counters::*;
+  const std::array<std::pair<const char *, Counter>, 15> counters{{
+      {"Calls", &GLStats::Counters::calls},
+      {"Draw calls", &GLStats::Counters::drawCalls},
+      {"Vertices", &GLStats::Counters::vertices},
+      {"Indices", &GLStats::Counters::indices},
+      {"Instances", &GLStats::Counters::instances},
+      {"Buffer bytes", &GLStats::Counters::bufferBytes},
+      {"Texture bytes", &GLStats::Counters::textureBytes},
+      {"Program binds", &GLStats::Counters::programBinds},
+      {"  redundant", &GLStats::Counters::redundantProgramBinds},
+      {"VAO binds", &GLStats::Counters::vertexArrayBinds},
+      {"  redundant", &GLStats::Counters::redundantVertexArrayBinds},
+      {"Texture binds", &GLStats::Counters::textureBinds},
+      {"  redundant", &GLStats::Counters::redundantTextureBinds},
+      {"Uniform updates", &GLStats::Counters::uniformUpdates},
+      {"State changes", &GLStats::Counters::stateChanges},
+  }};
+
+  const Frame *last{};
+  std::array<std::uint64_t, counters.size()> totals{};
+  std::array<std::uint64_t, counters.size()> maxima{};
+  std::uint64_t numFrames{};
+  for (auto number{m_frameNumber > historySize ? m_frameNumber - historySize
+                                               : std::uint64_t{}};
+       number <= m_frameNumber; ++number) {
+    const auto *frame{findFrame(number)};
+    if (frame == nullptr || !frame->hasGLStats) continue;
+    for (std::size_t index{}; index < counters.size(); ++index) {
+      const auto value{frame->glStats.*counters.at(index).second};
+      totals.at(index) += value;
+      maxima.at(index) = std::max(maxima.at(index), value);
+    }
+    ++numFrames;
+    last = frame;
+  }
+  if (last == nullptr) {
+    ImGui::TextDisabled("No frame counted yet");
+    return;
+  }
+
+  if (!ImGui::BeginTable("OpenGL", 4,
+                         ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit,
+                         ImVec2(panelWidth, 0.0f))) {
+    return;
+  }
+  ImGui::TableSetupColumn("Per frame", ImGuiTableColumnFlags_WidthStretch);
+  ImGui::TableSetupColumn("last");
+  ImGui::TableSetupColumn("avg");
+  ImGui::TableSetupColumn("max");
+  ImGui::TableHeadersRow();
+  for (std::size_t index{}; index < counters.size(); ++index) {
+    const auto &[name, counter]{counters.at(index)};
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted(name);
+    ImGui::TableNextColumn();
+    ImGui::Text("%llu", static_cast<unsigned long long>(last->glStats.*counter));
+    ImGui::TableNextColumn();
+    ImGui::Text("%llu",
+                static_cast<unsigned long long>(totals.at(index) / numFrames));
+    ImGui::TableNextColumn();
+    ImGui::Text("%llu", static_cast<unsigned long long>(maxima.at(index)));
+  }
+  ImGui::EndTable();
+}
+
+// Timeline of the scopes of the last frames: CPU scopes on top, GPU scopes
+// below. GPU scopes are placed relative to the start of their frame, since
+// CPU and GPU clocks are not related.
+void abcg::Profiler::paintFlameView() {
+  ImGui::SetNextItemWidth(panelWidth / 2.0f);
+  ImGui::SliderInt("Frames", &m_flameFrames, 1, 16);
+
+  // Last complete frames, oldest first
+  std::pmr::vector<const Frame *> frames{&m_arena};
+  frames.reserve(static_cast<std::size_t>(m_flameFrames));
+  for (auto number{m_frameNumber};
+       number > 0 && frames.size() < static_cast<std::size_t>(m_flameFrames);
+       --number) {
+    const auto *frame{findFrame(number)};
+    if (frame == nullptr) break;
+    if (frame->frameTime > 0.0) frames.push_back(frame);
+  }
+  std::reverse(frames.begin(), frames.end());
+
+  double span{};
+  int cpuRows{1};
+  int gpuRows{1};
+  for (const auto *frame : frames) {
+    span += frame->frameTime;
+    for (const auto &sample : frame->cpuSamples) {
+      cpuRows = std::max(cpuRows, sample.depth + 1);
+    }
+    for (const auto &sample : frame->gpuSamples) {
+      gpuRows = std::max(gpuRows, sample.depth + 2);
+    }
+  }
+  if (span <= 0.0) return;
+
+  const auto rowHeight{ImGui::GetTextLineHeight() + 2.0f};
+  const auto laneGap{rowHeight / 2.0f};
+  const auto origin{ImGui::GetCursorScreenPos()};
+  const auto height{static_cast<float>(cpuRows + gpuRows) * rowHeight +
+                    laneGap};
+  ImGui::InvisibleButton("##FlameView", ImVec2(panelWidth, height));
+  const auto hovered{ImGui::IsItemHovered()};
+  const auto mouse{ImGui::GetIO().MousePos};
+  auto *drawList{ImGui::GetWindowDrawList()};
+  const auto scale{static_cast<double>(panelWidth) / span};
+
+  const auto drawSample{[&](const Sample &sample, float top, double offset,
+                            std::string_view lane) {
+    const auto x0{origin.x +
+                  static_cast<float>((offset + sample.start) * scale)};
+    const auto x1{std::max(
+        x0 + 1.0f, x0 + static_cast<float>(sample.duration * scale))};
+    const auto y0{top + static_cast<float>(sample.depth) * rowHeight};
+    const ImVec2 min{x0, y0};
+    const ImVec2 max{x1, y0 + rowHeight - 1.0f};
+    drawList->AddRectFilled(min, max, getScopeColor(sample.name));
+    if (x1 - x0 > ImGui::CalcTextSize(sample.name).x / 2.0f) {
+      drawList->PushClipRect(min, max, true);
+      drawList->AddText(ImVec2(x0 + 2.0f, y0 + 1.0f), IM_COL32_BLACK,
+                        sample.name);
+      drawList->PopClipRect();
+    }
+    if (hovered && mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y &&
+        mouse.y < max.y) {
+      ImGui::SetTooltip("%.*s %s: %.3f ms", static_cast<int>(lane.size()),
+                        lane.data(), sample.name, sample.duration * 1000.0);
+    }
+  }};
+
+  const auto gpuTop{origin.y + static_cast<float>(cpuRows) * rowHeight +
+                    laneGap};
+  double offset{};
+  for (const auto *frame : frames) {
+    // The whole GPU frame forms the bottom row of its lane
+    if (frame->hasGpuTime) {
+      drawSample({"GPU frame", 0, 0.0, frame->gpuTime, {}}, gpuTop, offset,
+                 "GPU");
+      for (const auto &sample : frame->gpuSamples) {
+        drawSample({sample.name, sample.depth + 1, sample.start,
+                    sample.duration, {}},
+                   gpuTop, offset, "GPU");
+      }
+    }
+    for (const auto &sample : frame->cpuSamples) {
+      drawSample(sample, origin.y, offset, "CPU");
+    }
+
+    const auto x{origin.x + static_cast<float>(offset * scale)};
+    drawList->AddLine(ImVec2(x, origin.y), ImVec2(x, origin.y + height),
+                      IM_COL32(255, 255, 255, 96));
+    offset += frame->frameTime;
+  }
+}
+
+/**
+ * @brief Opens a scope in the active profiler.
+ *
+ * @param name Name of the scope. Must outlive the profiler.
+ * @param gpu Whether to also time the GPU commands issued in the scope.
+ */
+abcg::ProfilerScope::ProfilerScope(const char *name, bool gpu)
+    : m_profiler{Profiler::getActive()}, m_traced{Tracer::isEnabled()} {
+  if (m_traced) Tracer::beginScope(name);
+  if (m_profiler == nullptr) return;
+  m_cpu = m_profiler->beginCpuScope(name);
+  if (gpu) m_gpu = m_profiler->beginGpuScope(name);
+}
+
+abcg::ProfilerScope::~ProfilerScope() {
+  if (m_gpu) m_profiler->endGpuScope();
+  if (m_cpu) m_profiler->endCpuScope();
+  if (m_traced) Tracer::endScope();
+}
@@ -0,0 +1,241 @@
+/**
+ * @file abcg_profiler.hpp
+ * @brief abcg::Profiler header file.
+ *
+ * Declaration of abcg::Profiler, a CPU and GPU frame profiler, and of
+ * abcg::ProfilerScope, its RAII marker.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_PROFILER_HPP_
+#define ABCG_PROFILER_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "abcg_allocationtracker.hpp"
+#include "abcg_external.hpp"
+#include "abcg_framearena.hpp"
+#include "abcg_glstats.hpp"
+#include "abcg_tracer.hpp"
+
+namespace abcg {
+class Profiler;
+class ProfilerScope;
+}  // namespace abcg
+
+/**
+ * @brief abcg::Profiler class.
+ *
+ * Records nested scopes of each frame: CPU scopes on the main thread and
+ * GPU scopes on the thread that owns the OpenGL context (the main thread,
+ * or the render thread of abcg::OpenGLWindow). Scopes are usually opened
+ * with abcg::ProfilerScope, which reports to the active profiler.
+ *
+ * GPU scopes are timed with timestamp queries, which unlike
+ * GL_TIME_ELAPSED queries can nest. The queries of a frame are read back
+ * a few frames later from a ring of query sets, and only once the GPU has
+ * made them available, so profiling never stalls the pipeline. If the
+ * results of a set are still not available when the set comes around
+ * again, they are dropped. GPU timing needs OpenGL 3.3 or
+ * GL_ARB_timer_query, so it is not available with OpenGL ES or WebGL.
+ *
+ * The counts of abcg::GLStats are kept with the GPU part of each frame,
+ * including when GPU timing is not available. With abcg::AllocationTracker
+ * enabled, the heap allocations of the main thread are kept with each
+ * frame and each CPU scope.
+ *
+ * While abcg::Tracer is enabled, scopes are also recorded in the trace,
+ * on every thread, and GPU scopes are mapped to the trace clock.
+ *
+ * The last historySize frames are kept for the panel drawn by
+ * abcg::Profiler::paintUI: frame time histogram and percentiles, average
+ * time per scope and a flame view of the last frames.
+ */
+class abcg::Profiler {
+ public:
+  /**
+   * @brief Scope recorded in a frame. Times are in seconds from the start
+   * of the frame (CPU) or of its command stream (GPU).
+   */
+  struct Sample {
+    const char *name{};
+    int depth{};
+    double start{};
+    double duration{};
+    // Heap allocations of a CPU scope, see abcg::AllocationTracker
+    AllocationTracker::Counters allocations;
+  };
+
+  /**
+   * @brief Recorded frame. The GPU part arrives a few frames after the
+   * CPU part.
+   */
+  struct Frame {
+    std::uint64_t number{};
+    double frameTime{};
+    double cpuTime{};
+    double gpuTime{};
+    bool hasGpuTime{false};
+    std::vector<Sample> cpuSamples;
+    std::vector<Sample> gpuSamples;
+    GLStats::Counters glStats;
+    bool hasGLStats{false};
+    // Heap allocations from the start of the frame to the start of the
+    // next, of the main thread and of all threads
+    AllocationTracker::Counters allocations;
+    AllocationTracker::Counters totalAllocations;
+  };
+
+  static constexpr std::size_t historySize{240};
+
+  Profiler() = default;
+  ~Profiler();
+
+  Profiler(const Profiler &) = delete;
+  Profiler(Profiler &&) = delete;
+  Profiler &operator=(const Profiler &) = delete;
+  Profiler &operator=(Profiler &&) = delete;
+
+  static void setActive(Profiler *profiler) noexcept;
+  [[nodiscard]] static Profiler *getActive() noexcept;
+
+  void beginFrame();
+  void endFrame();
+  bool beginCpuScope(const char *name);
+  void endCpuScope();
+  [[nodiscard]] bool isCpuThread() const noexcept;
+  [[nodiscard]] std::uint64_t getFrameNumber() const noexcept {
+    return m_frameNumber;
+  }
+  [[nodiscard]] const Frame *getFrame(std::uint64_t frameNumber) const;
+
+  void initializeGL();
+  void terminateGL();
+  void beginGpuFrame(std::uint64_t frameNumber);
+  void endGpuFrame();
+  bool beginGpuScope(const char *name);
+  void endGpuScope();
+  [[nodiscard]] bool isGpuThread() const noexcept;
+
+  void paintUI();
+
+ private:
+  using clock = std::chrono::steady_clock;
+
+  struct GpuMarker {
+    const char *name{};
+    int depth{};
+    std::size_t begin{};
+    std::size_t end{};
+  };
+
+  // Timestamp queries of a frame, in issue order
+  struct QuerySet {
+    std::uint64_t frameNumber{};
+    bool pending{false};
+    std::vector<GLuint> queries;
+    std::size_t numUsed{};
+    std::vector<GpuMarker> markers;
+  };
+
+  // GPU part of a frame, handed from the OpenGL thread to the main thread
+  struct GpuResult {
+    std::uint64_t frameNumber{};
+    double gpuTime{};
+    std::vector<Sample> samples;
+  };
+
+  // OpenGL call counts of a frame, handed over like GpuResult
+  struct GLStatsResult {
+    std::uint64_t frameNumber{};
+    GLStats::Counters counters;
+  };
+
+  [[nodiscard]] Frame *findFrame(std::uint64_t frameNumber);
+  void mergeGpuResults();
+  std::size_t writeTimestamp();
+  void calibrateGpuClock();
+  void readGpuResults();
+  void paintPercentiles();
+  void paintScopeTable();
+  void paintGLStats();
+  void paintFlameView();
+
+  // Main thread
+  clock::time_point m_frameStart{};
+  AllocationTracker::Counters m_frameAllocations;
+  AllocationTracker::Counters m_frameTotalAllocations;
+  std::uint64_t m_frameNumber{};
+  bool m_frameOpen{false};
+  std::vector<std::size_t> m_cpuStack;
+  std::vector<Frame> m_history{historySize};
+  std::atomic<std::thread::id> m_cpuThread{};
+
+  // Thread owning the OpenGL context
+  bool m_gpuSupported{false};
+  bool m_gpuFrameOpen{false};
+  std::uint64_t m_gpuFrameNumber{};
+  std::array<QuerySet, 4> m_querySets{};
+  std::size_t m_nextQuerySet{};
+  QuerySet *m_gpuFrame{};
+  std::vector<std::size_t> m_gpuStack;
+  std::atomic<std::thread::id> m_gpuThread{};
+  // Trace clock minus GPU clock, in nanoseconds, and GPU frames since the
+  // last measurement
+  std::int64_t m_gpuClockOffset{};
+  bool m_gpuClockValid{false};
+  std::uint64_t m_gpuClockFrames{};
+
+  // Query results, reused by readGpuResults
+  std::vector<GLuint64> m_timestamps;
+
+  // Results are swapped with the main thread, and sample buffers are
+  // recycled, so that the hand-off does not allocate once warm
+  std::mutex m_gpuMutex;
+  std::vector<GpuResult> m_gpuResults;
+  std::vector<GLStatsResult> m_glStatsResults;
+  std::vector<std::vector<Sample>> m_freeSampleBuffers;
+  std::vector<GpuResult> m_mergedGpuResults;
+  std::vector<GLStatsResult> m_mergedGLStatsResults;
+  std::atomic<std::uint64_t> m_droppedGpuFrames{};
+
+  // Panel settings, and scratch memory of the panel
+  int m_flameFrames{4};
+  FrameArena m_arena{std::size_t{16} << 10U};
+};
+
+/**
+ * @brief abcg::ProfilerScope class.
+ *
+ * Times the enclosing block on the CPU (on the main thread) and, if
+ * requested, on the GPU (on the thread that owns the OpenGL context). Does
+ * nothing without an active profiler or on other threads, except recording
+ * the block in the trace if abcg::Tracer is enabled. The name must outlive
+ * the profiler and the trace, e.g. a string literal.
+ */
+class abcg::ProfilerScope {
+ public:
+  explicit ProfilerScope(const char *name, bool gpu = false);
+  ~ProfilerScope();
+
+  ProfilerScope(const ProfilerScope &) = delete;
+  ProfilerScope(ProfilerScope &&) = delete;
+  ProfilerScope &operator=(const ProfilerScope &) = delete;
+  ProfilerScope &operator=(ProfilerScope &&) = delete;
+
+ private:
+  Profiler *m_profiler{};
+  bool m_cpu{false};
+  bool m_gpu{false};
+  bool m_traced{false};
+};
+
+#endif
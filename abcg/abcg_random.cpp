@@ -0,0 +1,225 @@
+/**
+ * @file abcg_random.cpp
+ * @brief Definition of keyed random functions.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_random.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+
+#include "abcg_exception.hpp"
+#include "abcg_simd.hpp"
+
+namespace {
+std::uint64_t splitMix64(std::uint64_t &state) {
+  auto z{state += 0x9E3779B97F4A7C15ULL};
+  z = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27U)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31U);
+}
+
+// 32-bit integer hash with low bias (C. Wellons, "Prospecting for Hash
+// Functions", 2018)
+constexpr std::uint32_t hash32(std::uint32_t x) {
+  x ^= x >> 16U;
+  x *= 0x7FEB352DU;
+  x ^= x >> 15U;
+  x *= 0x846CA68BU;
+  x ^= x >> 16U;
+  return x;
+}
+
+// Maps the upper 24 bits to [0, 1)
+constexpr float toUnitFloat(std::uint32_t x) {
+  return static_cast<float>(x >> 8U) * 0x1.0p-24f;
+}
+
+struct SeedWords {
+  std::uint32_t low{};
+  std::uint32_t high{};
+};
+
+SeedWords mixSeed(std::uint64_t seed) {
+  const auto mixed{splitMix64(seed)};
+  return {static_cast<std::uint32_t>(mixed),
+          static_cast<std::uint32_t>(mixed >> 32U)};
+}
+
+constexpr std::uint32_t hashKey(const SeedWords &seed, std::uint64_t key,
+                                std::uint32_t dimension) {
+  auto x{hash32(static_cast<std::uint32_t>(key) ^ seed.low)};
+  x = hash32(x ^ static_cast<std::uint32_t>(key >> 32U) ^ seed.high);
+  return hash32(x + dimension * 0x9E3779B9U);
+}
+
+// hash32 and hashKey on four keys at a time, with the same results
+abcg::simd::UInt4 hash32(abcg::simd::UInt4 x) {
+  using namespace abcg::simd;
+  x = bitXor(x, shiftRight(x, 16));
+  x = x * broadcastUInt(0x7FEB352DU);
+  x = bitXor(x, shiftRight(x, 15));
+  x = x * broadcastUInt(0x846CA68BU);
+  return bitXor(x, shiftRight(x, 16));
+}
+
+abcg::simd::UInt4 hashKeys(const SeedWords &seed, const std::uint64_t *keys,
+                           std::uint32_t dimension) {
+  using namespace abcg::simd;
+  auto x{hash32(bitXor(loadLowWords(keys), broadcastUInt(seed.low)))};
+  x = hash32(
+      bitXor(bitXor(x, loadHighWords(keys)), broadcastUInt(seed.high)));
+  return hash32(x + broadcastUInt(dimension * 0x9E3779B9U));
+}
+
+// sin(pi * t) for t in [-1, 1]: reduction to [-1/2, 1/2] and Taylor
+// polynomial of degree 11 (absolute error below 1e-7)
+abcg::simd::Float4 sinPi(abcg::simd::Float4 t) {
+  using namespace abcg::simd;
+  const auto half{broadcast(0.5f)};
+  const auto one{broadcast(1.0f)};
+  auto reduced{select(greaterThan(t, half), one - t, t)};
+  reduced = select(lessThan(reduced, broadcast(-0.5f)),
+                   broadcast(-1.0f) - reduced, reduced);
+  const auto x{broadcast(std::numbers::pi_v<float>) * reduced};
+  const auto x2{x * x};
+  auto polynomial{broadcast(-1.0f / 39916800.0f)};
+  for (const float coefficient :
+       {1.0f / 362880.0f, -1.0f / 5040.0f, 1.0f / 120.0f, -1.0f / 6.0f,
+        1.0f}) {
+    polynomial = polynomial * x2 + broadcast(coefficient);
+  }
+  return x * polynomial;
+}
+
+// Points on the unit sphere from two uniform values in [0, 1), four at a
+// time. The inputs are read before the outputs are written, so they may
+// alias.
+void toUnitVectors(const float *u, const float *v, float *x, float *y,
+                   float *z) {
+  using namespace abcg::simd;
+  const auto one{broadcast(1.0f)};
+  const auto cosTheta{one - broadcast(2.0f) * load(u)};
+  const auto sinTheta{
+      sqrt(max(broadcast(0.0f), one - cosTheta * cosTheta))};
+  // Azimuth pi * t with t in [-1, 1)
+  const auto t{broadcast(2.0f) * load(v) - one};
+  const auto tCos{t + broadcast(0.5f)};
+  const auto tCosWrapped{
+      select(greaterThan(tCos, one), tCos - broadcast(2.0f), tCos)};
+  store(x, sinTheta * sinPi(tCosWrapped));
+  store(y, sinTheta * sinPi(t));
+  store(z, cosTheta);
+}
+
+// Converts uniform values staged in x and y to unit vectors
+void stagedToUnitVectors(std::span<float> x, std::span<float> y,
+                         std::span<float> z) {
+  constexpr auto width{static_cast<std::size_t>(abcg::simd::width)};
+  const auto count{x.size()};
+  std::size_t index{};
+  for (; index + width <= count; index += width) {
+    toUnitVectors(x.data() + index, y.data() + index, x.data() + index,
+                  y.data() + index, z.data() + index);
+  }
+  if (index < count) {
+    const auto tail{count - index};
+    std::array<float, width> u{};
+    std::array<float, width> v{};
+    std::array<float, width> outX{};
+    std::array<float, width> outY{};
+    std::array<float, width> outZ{};
+    std::copy_n(x.data() + index, tail, u.data());
+    std::copy_n(y.data() + index, tail, v.data());
+    toUnitVectors(u.data(), v.data(), outX.data(), outY.data(), outZ.data());
+    std::copy_n(outX.data(), tail, x.data() + index);
+    std::copy_n(outY.data(), tail, y.data() + index);
+    std::copy_n(outZ.data(), tail, z.data() + index);
+  }
+}
+
+void checkSizes(std::span<float> x, std::span<float> y, std::span<float> z) {
+  if (x.size() != y.size() || x.size() != z.size()) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Unit vector components differ in size")};
+  }
+}
+}  // namespace
+
+/**
+ * @brief Fills an array with uniform values that depend only on the seed,
+ * the key of each element and the dimension.
+ *
+ * The result for a given key does not depend on the order of the calls or
+ * on the other keys of the batch. Using the same keys
+ * with different dimensions gives independent values.
+ *
+ * @param seed Seed shared by all keys.
+ * @param keys One key per value, usually made by abcg::makeRandomKey.
+ * @param dimension Index of the sampled quantity.
+ * @param values Output array, with the size of keys.
+ * @param min Lower bound (inclusive).
+ * @param max Upper bound (exclusive).
+ *
+ * @throw abcg::Exception if the sizes differ.
+ */
+void abcg::fillUniform(std::uint64_t seed, std::span<const std::uint64_t> keys,
+                       std::uint32_t dimension, std::span<float> values,
+                       float min, float max) {
+  if (keys.size() != values.size()) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Random keys and values differ in size")};
+  }
+  using namespace abcg::simd;
+  constexpr auto lanes{static_cast<std::size_t>(width)};
+  const auto seedWords{mixSeed(seed)};
+  const float range{max - min};
+  const auto min4{broadcast(min)};
+  const auto range4{broadcast(range)};
+  // toUnitFloat, four values at a time
+  const auto unit4{broadcast(0x1.0p-24f)};
+  std::size_t index{};
+  for (; index + lanes <= keys.size(); index += lanes) {
+    const auto hashes{hashKeys(seedWords, keys.data() + index, dimension)};
+    store(values.data() + index,
+          min4 + range4 * (convertToFloat(shiftRight(hashes, 8)) * unit4));
+  }
+  for (; index < keys.size(); ++index) {
+    values[index] =
+        min + range * toUnitFloat(hashKey(seedWords, keys[index], dimension));
+  }
+}
+
+/**
+ * @brief Fills arrays with keyed unit vectors uniformly distributed on the
+ * sphere.
+ *
+ * Each vector uses dimensions dimension and dimension + 1.
+ *
+ * @param seed Seed shared by all keys.
+ * @param keys One key per vector.
+ * @param dimension Index of the first sampled quantity.
+ * @param x Output x components, with the size of keys.
+ * @param y Output y components, with the size of keys.
+ * @param z Output z components, with the size of keys.
+ *
+ * @throw abcg::Exception if the sizes differ.
+ */
+void abcg::fillUnitVectors(std::uint64_t seed,
+                           std::span<const std::uint64_t> keys,
+                           std::uint32_t dimension, std::span<float> x,
+                           std::span<float> y, std::span<float> z) {
+  checkSizes(x, y, z);
+  if (keys.size() != x.size()) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Random keys and values differ in size")};
+  }
+  // Uniform values are staged in the output arrays
+  fillUniform(seed, keys, dimension, x, 0.0f, 1.0f);
+  fillUniform(seed, keys, dimension + 1, y, 0.0f, 1.0f);
+  stagedToUnitVectors(x, y, z);
+}
@@ -0,0 +1,31 @@
+/**
+ * @file abcg_random.hpp
+ * @brief Declaration of keyed random functions.
+ *
+ * The random values depend only on a seed, a key per element and a
+ * dimension, for reproducible per-slot sampling.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_RANDOM_HPP_
+#define ABCG_RANDOM_HPP_
+
+#include <cstdint>
+#include <span>
+
+namespace abcg {
+[[nodiscard]] constexpr std::uint64_t makeRandomKey(std::uint32_t slot,
+                                                    std::uint32_t generation) {
+  return (static_cast<std::uint64_t>(generation) << 32U) | slot;
+}
+
+void fillUniform(std::uint64_t seed, std::span<const std::uint64_t> keys,
+                 std::uint32_t dimension, std::span<float> values, float min,
+                 float max);
+void fillUnitVectors(std::uint64_t seed, std::span<const std::uint64_t> keys,
+                     std::uint32_t dimension, std::span<float> x,
+                     std::span<float> y, std::span<float> z);
+}  // namespace abcg
+
+#endif
@@ -0,0 +1,146 @@
+/**
+ * @file abcg_renderqueue.cpp
+ * @brief Definition of abcg::RenderQueue class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_renderqueue.hpp"
+
+#include <algorithm>
+
+#include "abcg_exception.hpp"
+
+namespace {
+template <typename T>
+void copyVector(const ImVector<T> &source, ImVector<T> &destination) {
+  destination.resize(source.Size);
+  std::copy_n(source.Data, source.Size, destination.Data);
+}
+}  // namespace
+
+/**
+ * @brief Copies the draw lists of the ImGui draw data.
+ *
+ * ImGui reuses its draw lists on the next frame, so the frame keeps its own
+ * copies. The copies keep their capacity from frame to frame.
+ *
+ * @param source Draw data returned by ImGui::GetDrawData after
+ * ImGui::Render.
+ */
+void abcg::RenderQueue::Frame::copyDrawData(const ImDrawData &source) {
+  const auto numLists{static_cast<std::size_t>(source.CmdListsCount)};
+  while (m_drawLists.size() < numLists) {
+    m_drawLists.push_back(
+        std::make_unique<ImDrawList>(ImGui::GetDrawListSharedData()));
+  }
+
+  m_drawListPointers.clear();
+  for (std::size_t index{}; index < numLists; ++index) {
+    const auto &sourceList{*source.CmdLists[index]};
+    auto &list{*m_drawLists[index]};
+    copyVector(sourceList.CmdBuffer, list.CmdBuffer);
+    copyVector(sourceList.IdxBuffer, list.IdxBuffer);
+    copyVector(sourceList.VtxBuffer, list.VtxBuffer);
+    list.Flags = sourceList.Flags;
+    m_drawListPointers.push_back(&list);
+  }
+
+  drawData = source;
+  drawData.CmdLists = m_drawListPointers.data();
+}
+
+/**
+ * @brief Constructs a queue of the given depth.
+ *
+ * @param depth Number of frames that can be submitted and not yet released
+ * while the next frame is recorded. Must be at least 1.
+ */
+abcg::RenderQueue::RenderQueue(std::size_t depth) : m_frames(depth + 1) {
+  if (depth == 0) {
+    throw abcg::Exception{abcg::Exception::Runtime("Empty render queue")};
+  }
+  for (std::size_t slot{}; slot < m_frames.size(); ++slot) {
+    m_frames[slot].slot = slot;
+    m_free.push_back(&m_frames[slot]);
+  }
+}
+
+/**
+ * @brief Returns a free frame to be recorded, waiting for the consumer to
+ * release one if needed. Producer only.
+ */
+abcg::RenderQueue::Frame &abcg::RenderQueue::acquire() {
+  std::unique_lock lock{m_mutex};
+  m_condition.wait(lock, [this] { return !m_free.empty(); });
+  auto *frame{m_free.front()};
+  m_free.pop_front();
+  return *frame;
+}
+
+/**
+ * @brief Queues a recorded frame for the consumer. Producer only.
+ */
+void abcg::RenderQueue::submit(Frame &frame) {
+  {
+    const std::lock_guard lock{m_mutex};
+    m_submitted.push_back(&frame);
+  }
+  m_condition.notify_all();
+}
+
+/**
+ * @brief Waits for the next submitted frame. Consumer only.
+ *
+ * @return Oldest submitted frame, or nullptr once the queue is closed and
+ * all submitted frames have been popped.
+ */
+abcg::RenderQueue::Frame *abcg::RenderQueue::pop() {
+  std::unique_lock lock{m_mutex};
+  m_condition.wait(lock, [this] { return !m_submitted.empty() || m_closed; });
+  if (m_submitted.empty()) return nullptr;
+  auto *frame{m_submitted.front()};
+  m_submitted.pop_front();
+  return frame;
+}
+
+/**
+ * @brief Clears an executed frame and makes it available to the producer.
+ * Consumer only.
+ */
+void abcg::RenderQueue::release(Frame &frame) {
+  // Destroys the captures outside of the lock
+  frame.commands.clear();
+  {
+    const std::lock_guard lock{m_mutex};
+    m_free.push_back(&frame);
+  }
+  m_condition.notify_all();
+}
+
+/**
+ * @brief Wakes up the consumer once the submitted frames are exhausted.
+ */
+void abcg::RenderQueue::close() {
+  {
+    const std::lock_guard lock{m_mutex};
+    m_closed = true;
+  }
+  m_condition.notify_all();
+}
+
+/**
+ * @brief Returns the number of frames submitted and not yet popped.
+ */
+std::size_t abcg::RenderQueue::getNumSubmitted() {
+  const std::lock_guard lock{m_mutex};
+  return m_submitted.size();
+}
+
+/**
+ * @brief Returns the number of slots available to the producer.
+ */
+std::size_t abcg::RenderQueue::getNumFree() {
+  const std::lock_guard lock{m_mutex};
+  return m_free.size();
+}
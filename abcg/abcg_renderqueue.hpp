@@ -0,0 +1,88 @@
+/**
+ * @file abcg_renderqueue.hpp
+ * @brief abcg::RenderQueue header file.
+ *
+ * Declaration of abcg::RenderQueue, a bounded queue of frames handed from
+ * the thread that builds them to the thread that owns the OpenGL context.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_RENDERQUEUE_HPP_
+#define ABCG_RENDERQUEUE_HPP_
+
+#include <imgui.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace abcg {
+class RenderQueue;
+}  // namespace abcg
+
+/**
+ * @brief abcg::RenderQueue class.
+ *
+ * Holds a fixed number of frame slots. The producer acquires a free slot,
+ * records the OpenGL commands of the frame and a copy of the ImGui draw
+ * data into it, and submits it; the consumer pops the submitted frames in
+ * order, executes them and releases their slots. With a queue depth of n,
+ * there are n + 1 slots: up to n frames wait or are being executed while
+ * the producer records the next one. The producer blocks when no slot is
+ * free, so it never gets more than n frames ahead.
+ *
+ * Slots keep their buffers across frames, so a steady state does not
+ * allocate except for the captures of the commands.
+ */
+class abcg::RenderQueue {
+ public:
+  using Command = std::function<void()>;
+
+  /**
+   * @brief Commands and UI draw data of a frame.
+   */
+  class Frame {
+   public:
+    void copyDrawData(const ImDrawData &drawData);
+
+    /** @brief Index of the slot, in [0, abcg::RenderQueue::getNumSlots). */
+    std::size_t slot{};
+    /** @brief OpenGL commands, executed in order. */
+    std::vector<Command> commands;
+    /** @brief Copy of the ImGui draw data, rendered after the commands. */
+    ImDrawData drawData{};
+
+   private:
+    std::vector<std::unique_ptr<ImDrawList>> m_drawLists;
+    std::vector<ImDrawList *> m_drawListPointers;
+  };
+
+  explicit RenderQueue(std::size_t depth);
+
+  [[nodiscard]] std::size_t getNumSlots() const noexcept {
+    return m_frames.size();
+  }
+
+  [[nodiscard]] Frame &acquire();
+  void submit(Frame &frame);
+  [[nodiscard]] Frame *pop();
+  void release(Frame &frame);
+  void close();
+  [[nodiscard]] std::size_t getNumSubmitted();
+  [[nodiscard]] std::size_t getNumFree();
+
+ private:
+  std::vector<Frame> m_frames;
+
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::deque<Frame *> m_free;
+  std::deque<Frame *> m_submitted;
+  bool m_closed{false};
+};
+
+#endif
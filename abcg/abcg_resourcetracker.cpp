@@ -0,0 +1,591 @@
+/**
+ * @file abcg_resourcetracker.cpp
+ * @brief Definition of abcg::ResourceTracker class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_resourcetracker.hpp"
+
+#include <fmt/core.h>
+#include <imgui.h>
+
+#include <algorithm>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <tuple>
+#include <unordered_map>
+
+#include "abcg_glstats.hpp"
+
+namespace {
+using Kind = abcg::ResourceTracker::Kind;
+using Resource = abcg::ResourceTracker::Resource;
+
+// Registry, shared by all threads
+std::mutex registryMutex;
+std::unordered_map<std::uint64_t, Resource> resources;
+std::vector<abcg::ResourceTracker::HostMemory> hostMemory;
+abcg::ResourceTracker::Totals totals;
+
+constexpr std::array<const char *, abcg::ResourceTracker::numKinds>
+    kindNames{"buffer", "texture", "program", "vertex array"};
+
+std::uint64_t getKey(Kind kind, GLuint name) {
+  return (static_cast<std::uint64_t>(kind) << 32U) | name;
+}
+
+std::size_t getIndex(Kind kind) { return static_cast<std::size_t>(kind); }
+
+// Index of a buffer target in the tracked bindings, other than the element
+// array
+std::optional<std::size_t> getBufferTargetIndex(GLenum target) {
+  switch (target) {
+    case GL_ARRAY_BUFFER:
+      return 0;
+    case GL_COPY_READ_BUFFER:
+      return 1;
+    case GL_COPY_WRITE_BUFFER:
+      return 2;
+    case GL_PIXEL_PACK_BUFFER:
+      return 3;
+    case GL_PIXEL_UNPACK_BUFFER:
+      return 4;
+    case GL_TRANSFORM_FEEDBACK_BUFFER:
+      return 5;
+    case GL_UNIFORM_BUFFER:
+      return 6;
+    default:
+      return std::nullopt;
+  }
+}
+
+// Texture bound to a target of the active unit. Queried from OpenGL, since
+// textures are only sized when loaded.
+GLuint getBoundTexture(GLenum target) {
+  GLenum binding{};
+  switch (target) {
+    case GL_TEXTURE_2D:
+      binding = GL_TEXTURE_BINDING_2D;
+      break;
+    case GL_TEXTURE_3D:
+      binding = GL_TEXTURE_BINDING_3D;
+      break;
+    case GL_TEXTURE_2D_ARRAY:
+      binding = GL_TEXTURE_BINDING_2D_ARRAY;
+      break;
+    case GL_TEXTURE_CUBE_MAP:
+    case GL_TEXTURE_CUBE_MAP_POSITIVE_X:
+    case GL_TEXTURE_CUBE_MAP_NEGATIVE_X:
+    case GL_TEXTURE_CUBE_MAP_POSITIVE_Y:
+    case GL_TEXTURE_CUBE_MAP_NEGATIVE_Y:
+    case GL_TEXTURE_CUBE_MAP_POSITIVE_Z:
+    case GL_TEXTURE_CUBE_MAP_NEGATIVE_Z:
+      binding = GL_TEXTURE_BINDING_CUBE_MAP;
+      break;
+    default:
+      return 0;
+  }
+  GLint texture{};
+  ::glGetIntegerv(binding, &texture);
+  return static_cast<GLuint>(texture);
+}
+
+// Number of images of a level: six for a cube map, whose faces all have
+// the same size
+std::uint64_t getNumFaces(GLenum target) {
+  return target == GL_TEXTURE_2D || target == GL_TEXTURE_3D ||
+                 target == GL_TEXTURE_2D_ARRAY
+             ? 1
+             : 6;
+}
+
+// Size of a texel of a sized internal format, or of the pixels given for
+// an unsized one
+std::uint64_t getTexelSize(GLenum internalFormat, GLenum format,
+                           GLenum type) {
+  switch (internalFormat) {
+    case GL_R8:
+    case GL_R8I:
+    case GL_R8UI:
+      return 1;
+    case GL_RG8:
+    case GL_R16F:
+    case GL_RGB565:
+    case GL_RGBA4:
+    case GL_RGB5_A1:
+    case GL_DEPTH_COMPONENT16:
+      return 2;
+    case GL_RGB8:
+    case GL_SRGB8:
+      return 3;
+    case GL_RGBA8:
+    case GL_SRGB8_ALPHA8:
+    case GL_RG16F:
+    case GL_R32F:
+    case GL_R11F_G11F_B10F:
+    case GL_RGB10_A2:
+    case GL_DEPTH_COMPONENT24:
+    case GL_DEPTH_COMPONENT32F:
+    case GL_DEPTH24_STENCIL8:
+      return 4;
+    case GL_RGB16F:
+      return 6;
+    case GL_RGBA16F:
+    case GL_RG32F:
+    case GL_DEPTH32F_STENCIL8:
+      return 8;
+    case GL_RGB32F:
+      return 12;
+    case GL_RGBA32F:
+      return 16;
+    default:
+      return abcg::GLStats::getPixelSize(format, type);
+  }
+}
+
+std::string_view getFormatName(GLenum format) {
+  switch (format) {
+    case GL_STATIC_DRAW:
+      return "static";
+    case GL_DYNAMIC_DRAW:
+      return "dynamic";
+    case GL_STREAM_DRAW:
+      return "stream";
+    case GL_RGB:
+      return "RGB";
+    case GL_RGBA:
+      return "RGBA";
+    case GL_RGB8:
+      return "RGB8";
+    case GL_RGBA8:
+      return "RGBA8";
+    case GL_SRGB8_ALPHA8:
+      return "SRGB8_A8";
+    case GL_RGBA16F:
+      return "RGBA16F";
+    case GL_DEPTH_COMPONENT24:
+      return "DEPTH24";
+    case GL_DEPTH24_STENCIL8:
+      return "DEPTH24_S8";
+    default:
+      return {};
+  }
+}
+
+std::string formatBytes(std::uint64_t bytes) {
+  if (bytes >= (1U << 20U)) {
+    return fmt::format("{:.1f} MiB", static_cast<double>(bytes) / (1U << 20U));
+  }
+  if (bytes >= (1U << 10U)) {
+    return fmt::format("{:.1f} KiB", static_cast<double>(bytes) / (1U << 10U));
+  }
+  return fmt::format("{} B", bytes);
+}
+
+std::string describe(const Resource &resource) {
+  std::string description{fmt::format("{} {}", kindNames.at(getIndex(
+                                                   resource.kind)),
+                                      resource.name)};
+  if (resource.format != 0) {
+    const auto name{getFormatName(resource.format)};
+    description += name.empty() ? fmt::format(" 0x{:04X}", resource.format)
+                                : fmt::format(" {}", name);
+  }
+  if (resource.kind == Kind::Texture && resource.width > 0) {
+    description += fmt::format(" {}x{}", resource.width, resource.height);
+    if (resource.depth > 1) description += fmt::format("x{}", resource.depth);
+    if (resource.mipmapped) description += " mip";
+  }
+  return description;
+}
+
+// Updates the totals after a change of the registry. Registry mutex held.
+void updateTotals() {
+  auto &[count, bytes, hostBytes, peakCount, peakBytes, peakHostBytes]{totals};
+  count = {};
+  bytes = {};
+  for (const auto &[key, resource] : resources) {
+    ++count.at(getIndex(resource.kind));
+    bytes.at(getIndex(resource.kind)) += resource.bytes;
+  }
+  hostBytes = 0;
+  for (const auto &memory : hostMemory) hostBytes += memory.bytes;
+  peakCount = std::max(
+      peakCount, std::accumulate(count.begin(), count.end(), std::uint64_t{}));
+  peakBytes = std::max(
+      peakBytes, std::accumulate(bytes.begin(), bytes.end(), std::uint64_t{}));
+  peakHostBytes = std::max(peakHostBytes, hostBytes);
+}
+
+// Sets the size of a texture from the size of its base level. Images of
+// other levels only mark the texture as mipmapped.
+void setTextureSize(GLenum target, GLint level, GLenum internalFormat,
+                    GLsizei width, GLsizei height, GLsizei depth,
+                    std::uint64_t levelBytes) {
+  const auto texture{getBoundTexture(target)};
+  if (texture == 0) return;
+  const std::scoped_lock lock{registryMutex};
+  const auto iter{resources.find(getKey(Kind::Texture, texture))};
+  if (iter == resources.end()) return;
+  auto &resource{iter->second};
+  if (level > 0) {
+    if (resource.mipmapped) return;
+    resource.mipmapped = true;
+    resource.bytes = resource.bytes * 4 / 3;
+  } else {
+    resource.bytes = levelBytes * getNumFaces(target);
+    // A full mipmap chain adds a third of the base level
+    if (resource.mipmapped) resource.bytes = resource.bytes * 4 / 3;
+    resource.format = internalFormat;
+    resource.width = width;
+    resource.height = height;
+    resource.depth = depth;
+  }
+  updateTotals();
+}
+}  // namespace
+
+/**
+ * @brief Returns the objects alive.
+ */
+std::vector<abcg::ResourceTracker::Resource>
+abcg::ResourceTracker::getResources() {
+  std::vector<Resource> result;
+  const std::scoped_lock lock{registryMutex};
+  result.reserve(resources.size());
+  for (const auto &[key, resource] : resources) result.push_back(resource);
+  return result;
+}
+
+/**
+ * @brief Returns the memory reported by the owners of host copies.
+ */
+std::vector<abcg::ResourceTracker::HostMemory>
+abcg::ResourceTracker::getHostMemory() {
+  const std::scoped_lock lock{registryMutex};
+  return hostMemory;
+}
+
+/**
+ * @brief Returns the live totals per kind and the high-water marks.
+ */
+abcg::ResourceTracker::Totals abcg::ResourceTracker::getTotals() {
+  const std::scoped_lock lock{registryMutex};
+  return totals;
+}
+
+/**
+ * @brief Reports the main memory held by an owner, e.g. copies of vertex
+ * data kept after the upload. Can be called from any thread.
+ *
+ * @param owner Object holding the memory.
+ * @param tag Description of the memory.
+ * @param bytes Size of the memory, or zero to remove the entry.
+ */
+void abcg::ResourceTracker::setHostMemory(const void *owner,
+                                          std::string_view tag,
+                                          std::uint64_t bytes) {
+  const std::scoped_lock lock{registryMutex};
+  auto iter{std::find_if(hostMemory.begin(), hostMemory.end(),
+                         [&](const auto &memory) {
+                           return memory.owner == owner && memory.tag == tag;
+                         })};
+  if (bytes == 0) {
+    if (iter != hostMemory.end()) hostMemory.erase(iter);
+  } else if (iter == hostMemory.end()) {
+    hostMemory.push_back({owner, std::string{tag}, bytes});
+  } else {
+    iter->bytes = bytes;
+  }
+  updateTotals();
+}
+
+/**
+ * @brief Prints the objects still alive, grouped by owner.
+ *
+ * Called by abcg::OpenGLWindow after terminateGL, when every object
+ * created by the application should have been deleted.
+ *
+ * @return Whether any object was still alive.
+ */
+bool abcg::ResourceTracker::reportLeaks() {
+  auto leaks{getResources()};
+  if (leaks.empty()) return false;
+
+  std::sort(leaks.begin(), leaks.end(), [](const auto &a, const auto &b) {
+    return std::tie(a.owner, a.kind, a.name) <
+           std::tie(b.owner, b.kind, b.name);
+  });
+  std::uint64_t bytes{};
+  for (const auto &leak : leaks) bytes += leak.bytes;
+  fmt::print("Warning: {} OpenGL objects not deleted ({}):\n", leaks.size(),
+             formatBytes(bytes));
+  for (const auto &leak : leaks) {
+    fmt::print("  {}: {}{}{}\n", leak.owner.empty() ? "untagged" : leak.owner,
+               describe(leak),
+               leak.bytes > 0 ? fmt::format(", {}", formatBytes(leak.bytes))
+                              : std::string{},
+               leak.location.empty() ? std::string{}
+                                     : fmt::format(", at {}", leak.location));
+  }
+  return true;
+}
+
+/**
+ * @brief Forgets every object and the buffer bindings, e.g. once their
+ * context is destroyed. High-water marks are kept.
+ */
+void abcg::ResourceTracker::reset() {
+  {
+    const std::scoped_lock lock{registryMutex};
+    resources.clear();
+    updateTotals();
+  }
+  m_buffers = {};
+  m_vertexArray = 0;
+  m_elementBuffers.clear();
+}
+
+/**
+ * @brief Draws the registry into the current ImGui window: totals per
+ * kind, high-water marks and memory per owner.
+ */
+void abcg::ResourceTracker::paintUI() {
+  const auto current{getTotals()};
+  const auto objects{getResources()};
+  const auto host{getHostMemory()};
+
+  const auto flags{ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit};
+  if (ImGui::BeginTable("Totals", 3, flags)) {
+    ImGui::TableSetupColumn("Objects", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableSetupColumn("count");
+    ImGui::TableSetupColumn("size");
+    ImGui::TableHeadersRow();
+    const auto row{[](const char *name, std::uint64_t count,
+                      std::uint64_t bytes) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(name);
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", static_cast<unsigned long long>(count));
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(formatBytes(bytes).c_str());
+    }};
+    for (std::size_t index{}; index < numKinds; ++index) {
+      row(kindNames.at(index), current.count.at(index),
+          current.bytes.at(index));
+    }
+    row("host copies", host.size(), current.hostBytes);
+    row("GPU peak", current.peakCount, current.peakBytes);
+    row("host peak", 0, current.peakHostBytes);
+    ImGui::EndTable();
+  }
+
+  // Objects and host memory merged by owner, largest first
+  struct Owner {
+    std::string_view name;
+    std::uint64_t count{};
+    std::uint64_t gpuBytes{};
+    std::uint64_t hostBytes{};
+  };
+  std::vector<Owner> owners;
+  const auto findOwner{[&](std::string_view name) -> Owner & {
+    auto iter{
+        std::find_if(owners.begin(), owners.end(),
+                     [&](const auto &owner) { return owner.name == name; })};
+    if (iter == owners.end()) iter = owners.insert(owners.end(), Owner{name});
+    return *iter;
+  }};
+  for (const auto &object : objects) {
+    auto &owner{findOwner(object.owner.empty()
+                              ? std::string_view{"untagged"}
+                              : std::string_view{object.owner})};
+    ++owner.count;
+    owner.gpuBytes += object.bytes;
+  }
+  for (const auto &memory : host) {
+    findOwner(memory.tag).hostBytes += memory.bytes;
+  }
+  std::sort(owners.begin(), owners.end(), [](const auto &a, const auto &b) {
+    return a.gpuBytes + a.hostBytes > b.gpuBytes + b.hostBytes;
+  });
+
+  if (ImGui::BeginTable("Owners", 4, flags)) {
+    ImGui::TableSetupColumn("Owner", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableSetupColumn("objects");
+    ImGui::TableSetupColumn("GPU");
+    ImGui::TableSetupColumn("host");
+    ImGui::TableHeadersRow();
+    for (const auto &owner : owners) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::Text("%.*s", static_cast<int>(owner.name.size()),
+                  owner.name.data());
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", static_cast<unsigned long long>(owner.count));
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(formatBytes(owner.gpuBytes).c_str());
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(formatBytes(owner.hostBytes).c_str());
+    }
+    ImGui::EndTable();
+  }
+}
+
+/**
+ * @brief Records deleted objects. Buffers and vertex arrays deleted while
+ * bound are unbound.
+ *
+ * @param kind Kind of the objects.
+ * @param count Number of objects.
+ * @param names Names of the objects. Zero is ignored.
+ */
+void abcg::ResourceTracker::deleted(Kind kind, GLsizei count,
+                                    const GLuint *names) {
+  if (names == nullptr) return;
+  const std::span deletedNames{names, static_cast<std::size_t>(count)};
+  {
+    const std::scoped_lock lock{registryMutex};
+    for (const auto name : deletedNames) resources.erase(getKey(kind, name));
+    updateTotals();
+  }
+
+  const auto isDeleted{[&](GLuint name) {
+    return name != 0 && std::find(deletedNames.begin(), deletedNames.end(),
+                                  name) != deletedNames.end();
+  }};
+  if (kind == Kind::Buffer) {
+    for (auto &buffer : m_buffers) {
+      if (isDeleted(buffer)) buffer = 0;
+    }
+    for (auto &[vertexArray, buffer] : m_elementBuffers) {
+      if (isDeleted(buffer)) buffer = 0;
+    }
+  } else if (kind == Kind::VertexArray) {
+    std::erase_if(m_elementBuffers,
+                  [&](const auto &entry) { return isDeleted(entry.first); });
+    if (isDeleted(m_vertexArray)) m_vertexArray = 0;
+  }
+}
+
+/**
+ * @brief Records a buffer binding, so that glBufferData can size the
+ * buffer without querying OpenGL.
+ *
+ * @param target Buffer target.
+ * @param buffer Buffer bound.
+ */
+void abcg::ResourceTracker::bindBuffer(GLenum target, GLuint buffer) noexcept {
+  if (target == GL_ELEMENT_ARRAY_BUFFER) {
+    auto iter{std::find_if(
+        m_elementBuffers.begin(), m_elementBuffers.end(),
+        [](const auto &entry) { return entry.first == m_vertexArray; })};
+    if (iter == m_elementBuffers.end()) {
+      m_elementBuffers.emplace_back(m_vertexArray, buffer);
+    } else {
+      iter->second = buffer;
+    }
+  } else if (const auto index{getBufferTargetIndex(target)}) {
+    m_buffers.at(*index) = buffer;
+  }
+}
+
+/**
+ * @brief Records the size and usage of the buffer bound to a target.
+ *
+ * @param target Buffer target.
+ * @param size Size of the storage, in bytes.
+ * @param usage Usage hint.
+ */
+void abcg::ResourceTracker::bufferData(GLenum target, GLsizeiptr size,
+                                       GLenum usage) {
+  GLuint buffer{};
+  if (target == GL_ELEMENT_ARRAY_BUFFER) {
+    for (const auto &[vertexArray, elementBuffer] : m_elementBuffers) {
+      if (vertexArray == m_vertexArray) buffer = elementBuffer;
+    }
+  } else if (const auto index{getBufferTargetIndex(target)}) {
+    buffer = m_buffers.at(*index);
+  }
+  if (buffer == 0) return;
+
+  const std::scoped_lock lock{registryMutex};
+  const auto iter{resources.find(getKey(Kind::Buffer, buffer))};
+  if (iter == resources.end()) return;
+  if (iter->second.bytes == static_cast<std::uint64_t>(size) &&
+      iter->second.format == usage) {
+    return;
+  }
+  iter->second.bytes = static_cast<std::uint64_t>(size);
+  iter->second.format = usage;
+  updateTotals();
+}
+
+/**
+ * @brief Records the size of an image of the texture bound to a target,
+ * specified with glTexImage2D or glTexImage3D.
+ */
+void abcg::ResourceTracker::textureImage(GLenum target, GLint level,
+                                         GLenum internalFormat, GLsizei width,
+                                         GLsizei height, GLsizei depth,
+                                         GLenum format, GLenum type) {
+  setTextureSize(target, level, internalFormat, width, height, depth,
+                 static_cast<std::uint64_t>(width) *
+                     static_cast<std::uint64_t>(height) *
+                     static_cast<std::uint64_t>(depth) *
+                     getTexelSize(internalFormat, format, type));
+}
+
+/**
+ * @brief Records the size of a compressed image of the texture bound to a
+ * target.
+ */
+void abcg::ResourceTracker::compressedTextureImage(
+    GLenum target, GLint level, GLenum internalFormat, GLsizei width,
+    GLsizei height, GLsizei depth, GLsizei size) {
+  setTextureSize(target, level, internalFormat, width, height, depth,
+                 static_cast<std::uint64_t>(size));
+}
+
+/**
+ * @brief Records the immutable storage of the texture bound to a target.
+ */
+void abcg::ResourceTracker::textureStorage(GLenum target, GLsizei levels,
+                                           GLenum internalFormat,
+                                           GLsizei width, GLsizei height,
+                                           GLsizei depth) {
+  textureImage(target, 0, internalFormat, width, height, depth, 0, 0);
+  if (levels > 1) generateMipmap(target);
+}
+
+/**
+ * @brief Marks the texture bound to a target as mipmapped.
+ */
+void abcg::ResourceTracker::generateMipmap(GLenum target) {
+  const auto texture{getBoundTexture(target)};
+  if (texture == 0) return;
+  const std::scoped_lock lock{registryMutex};
+  const auto iter{resources.find(getKey(Kind::Texture, texture))};
+  if (iter == resources.end() || iter->second.mipmapped) return;
+  iter->second.mipmapped = true;
+  iter->second.bytes = iter->second.bytes * 4 / 3;
+  updateTotals();
+}
+
+// Registers new objects with the owner tag of the calling thread
+void abcg::ResourceTracker::add(Kind kind, GLsizei count, const GLuint *names,
+                                const char *file, unsigned line) {
+  if (names == nullptr) return;
+  const auto location{file == nullptr ? std::string{}
+                                      : fmt::format("{}:{}", file, line)};
+  const std::scoped_lock lock{registryMutex};
+  for (const auto name : std::span{names, static_cast<std::size_t>(count)}) {
+    if (name == 0) continue;
+    resources[getKey(kind, name)] = {kind,  name,  0, 0, 0, 0, 0, false,
+                                     std::string{m_owner}, location};
+  }
+  updateTotals();
+}
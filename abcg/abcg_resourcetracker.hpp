@@ -0,0 +1,190 @@
+/**
+ * @file abcg_resourcetracker.hpp
+ * @brief abcg::ResourceTracker header file.
+ *
+ * Declaration of abcg::ResourceTracker, a registry of the OpenGL objects
+ * created through the abcg::gl* wrappers, of abcg::ResourceOwner, its RAII
+ * owner tag, and of the ABCG_TRACK_GL macro.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_RESOURCETRACKER_HPP_
+#define ABCG_RESOURCETRACKER_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "abcg_external.hpp"
+
+namespace abcg {
+class ResourceTracker;
+class ResourceOwner;
+}  // namespace abcg
+
+/**
+ * @brief abcg::ResourceTracker class.
+ *
+ * Records the buffers, textures, programs and vertex arrays created
+ * through the abcg::gl* wrappers until they are deleted, with their size,
+ * format, the tag of the abcg::ResourceOwner active when they were created
+ * and, in debug builds, the call that created them. Copies kept in main
+ * memory are reported by their owners with
+ * abcg::ResourceTracker::setHostMemory.
+ *
+ * Sizes are those of the data specified, without driver padding: buffers
+ * from glBufferData, textures from glTexImage* and glTexStorage*, with a
+ * third more for mipmaps. Objects created or sized without the wrappers,
+ * such as those of the ImGui backend, are not recorded.
+ *
+ * The registry is locked, so it can be read from any thread, but the
+ * wrappers must be called by the thread that owns the OpenGL context.
+ * abcg::OpenGLWindow shows the registry in its profiler overlay and
+ * reports the objects still alive when it destroys its context as leaks.
+ *
+ * Defining ABCG_DISABLE_RESOURCE_TRACKING (CMake option
+ * ENABLE_RESOURCE_TRACKING=OFF) removes the tracking from the wrappers
+ * altogether.
+ */
+class abcg::ResourceTracker {
+ public:
+  /** @brief Kinds of OpenGL objects recorded. */
+  enum class Kind { Buffer, Texture, Program, VertexArray };
+  static constexpr std::size_t numKinds{4};
+
+  /** @brief OpenGL object alive. */
+  struct Resource {
+    Kind kind{};
+    GLuint name{};
+    std::uint64_t bytes{};
+    // Usage of a buffer, internal format of a texture
+    GLenum format{};
+    GLsizei width{};
+    GLsizei height{};
+    GLsizei depth{};
+    bool mipmapped{false};
+    std::string owner;
+    std::string location;
+  };
+
+  /** @brief Memory reported with abcg::ResourceTracker::setHostMemory. */
+  struct HostMemory {
+    const void *owner{};
+    std::string tag;
+    std::uint64_t bytes{};
+  };
+
+  /** @brief Live totals and high-water marks. */
+  struct Totals {
+    std::array<std::uint64_t, numKinds> count{};
+    std::array<std::uint64_t, numKinds> bytes{};
+    std::uint64_t hostBytes{};
+    std::uint64_t peakCount{};
+    std::uint64_t peakBytes{};
+    std::uint64_t peakHostBytes{};
+  };
+
+  ResourceTracker() = delete;
+
+  /**
+   * @brief Returns whether the wrappers record their objects.
+   */
+  [[nodiscard]] static constexpr bool isEnabled() noexcept {
+#if defined(ABCG_DISABLE_RESOURCE_TRACKING)
+    return false;
+#else
+    return true;
+#endif
+  }
+
+  [[nodiscard]] static std::vector<Resource> getResources();
+  [[nodiscard]] static std::vector<HostMemory> getHostMemory();
+  [[nodiscard]] static Totals getTotals();
+  static void setHostMemory(const void *owner, std::string_view tag,
+                            std::uint64_t bytes);
+  static bool reportLeaks();
+  static void reset();
+  static void paintUI();
+
+  // Hooks of the wrappers, through ABCG_TRACK_GL
+
+  template <typename TLocation>
+  static void created(Kind kind, GLsizei count, const GLuint *names,
+                      const TLocation &location) {
+    if constexpr (requires { location.line(); }) {
+      add(kind, count, names, location.file_name(), location.line());
+    } else {
+      add(kind, count, names, nullptr, 0);
+    }
+  }
+  static void deleted(Kind kind, GLsizei count, const GLuint *names);
+  static void bindBuffer(GLenum target, GLuint buffer) noexcept;
+  static void bindVertexArray(GLuint vertexArray) noexcept {
+    m_vertexArray = vertexArray;
+  }
+  static void bufferData(GLenum target, GLsizeiptr size, GLenum usage);
+  static void textureImage(GLenum target, GLint level, GLenum internalFormat,
+                           GLsizei width, GLsizei height, GLsizei depth,
+                           GLenum format, GLenum type);
+  static void compressedTextureImage(GLenum target, GLint level,
+                                     GLenum internalFormat, GLsizei width,
+                                     GLsizei height, GLsizei depth,
+                                     GLsizei size);
+  static void textureStorage(GLenum target, GLsizei levels,
+                             GLenum internalFormat, GLsizei width,
+                             GLsizei height, GLsizei depth);
+  static void generateMipmap(GLenum target);
+
+ private:
+  friend class ResourceOwner;
+
+  static void add(Kind kind, GLsizei count, const GLuint *names,
+                  const char *file, unsigned line);
+
+  // Owner tag of the calling thread, set by abcg::ResourceOwner
+  inline static thread_local std::string_view m_owner{};
+
+  // Buffer bindings, owned by the OpenGL thread. Element array bindings
+  // belong to the vertex array bound.
+  inline static std::array<GLuint, 7> m_buffers{};
+  inline static GLuint m_vertexArray{};
+  inline static std::vector<std::pair<GLuint, GLuint>> m_elementBuffers;
+};
+
+/**
+ * @brief abcg::ResourceOwner class.
+ *
+ * Tags the OpenGL objects created by the calling thread in the enclosing
+ * block, e.g. with the name of the model or effect they belong to. Scopes
+ * nest, and the innermost tag applies. The tag is copied by the registry.
+ */
+class abcg::ResourceOwner {
+ public:
+  explicit ResourceOwner(std::string_view tag) noexcept
+      : m_previous{ResourceTracker::m_owner} {
+    ResourceTracker::m_owner = tag;
+  }
+  ~ResourceOwner() { ResourceTracker::m_owner = m_previous; }
+
+  ResourceOwner(const ResourceOwner &) = delete;
+  ResourceOwner(ResourceOwner &&) = delete;
+  ResourceOwner &operator=(const ResourceOwner &) = delete;
+  ResourceOwner &operator=(ResourceOwner &&) = delete;
+
+ private:
+  std::string_view m_previous;
+};
+
+#if defined(ABCG_DISABLE_RESOURCE_TRACKING)
+#define ABCG_TRACK_GL(hook) static_cast<void>(0)
+#else
+/** @brief Calls the given hook of abcg::ResourceTracker. */
+#define ABCG_TRACK_GL(hook) abcg::ResourceTracker::hook
+#endif
+
+#endif
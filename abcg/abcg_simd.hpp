@@ -0,0 +1,343 @@
+/**
+ * @file abcg_simd.hpp
+ * @brief Portable 4-wide SIMD helpers.
+ *
+ * Thin wrapper over SSE2, WebAssembly SIMD128 or plain scalar code, selected
+ * at compile time. Only the operations needed by ABCg's batch kernels are
+ * provided.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_SIMD_HPP_
+#define ABCG_SIMD_HPP_
+
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ABCG_SIMD_SSE2
+#include <emmintrin.h>
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+#elif defined(__wasm_simd128__)
+#define ABCG_SIMD_WASM
+#include <wasm_simd128.h>
+#else
+#define ABCG_SIMD_SCALAR
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#endif
+
+namespace abcg::simd {
+struct Float4;
+struct UInt4;
+
+/**
+ * @brief Number of lanes of abcg::simd::Float4 and abcg::simd::UInt4.
+ */
+inline constexpr int width{4};
+}  // namespace abcg::simd
+
+/**
+ * @brief Four packed single-precision floats.
+ *
+ * Comparison functions return lane masks (all bits set or cleared) that can
+ * be consumed by abcg::simd::select and abcg::simd::moveMask.
+ */
+struct abcg::simd::Float4 {
+#if defined(ABCG_SIMD_SSE2)
+  __m128 v;
+#elif defined(ABCG_SIMD_WASM)
+  v128_t v;
+#else
+  std::array<float, 4> v;
+#endif
+};
+
+/**
+ * @brief Four packed 32-bit unsigned integers, with wrapping arithmetic.
+ */
+struct abcg::simd::UInt4 {
+#if defined(ABCG_SIMD_SSE2)
+  __m128i v;
+#elif defined(ABCG_SIMD_WASM)
+  v128_t v;
+#else
+  std::array<std::uint32_t, 4> v;
+#endif
+};
+
+namespace abcg::simd {
+
+#if defined(ABCG_SIMD_SSE2)
+
+inline Float4 broadcast(float x) { return {_mm_set1_ps(x)}; }
+inline Float4 load(const float *p) { return {_mm_loadu_ps(p)}; }
+inline void store(float *p, Float4 a) { _mm_storeu_ps(p, a.v); }
+inline Float4 operator+(Float4 a, Float4 b) { return {_mm_add_ps(a.v, b.v)}; }
+inline Float4 operator-(Float4 a, Float4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline Float4 operator*(Float4 a, Float4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline Float4 operator/(Float4 a, Float4 b) { return {_mm_div_ps(a.v, b.v)}; }
+inline Float4 min(Float4 a, Float4 b) { return {_mm_min_ps(a.v, b.v)}; }
+inline Float4 max(Float4 a, Float4 b) { return {_mm_max_ps(a.v, b.v)}; }
+inline Float4 sqrt(Float4 a) { return {_mm_sqrt_ps(a.v)}; }
+inline Float4 lessThan(Float4 a, Float4 b) { return {_mm_cmplt_ps(a.v, b.v)}; }
+inline Float4 greaterThan(Float4 a, Float4 b) {
+  return {_mm_cmpgt_ps(a.v, b.v)};
+}
+inline Float4 greaterEqual(Float4 a, Float4 b) {
+  return {_mm_cmpge_ps(a.v, b.v)};
+}
+inline Float4 bitAnd(Float4 a, Float4 b) { return {_mm_and_ps(a.v, b.v)}; }
+inline Float4 bitOr(Float4 a, Float4 b) { return {_mm_or_ps(a.v, b.v)}; }
+inline Float4 select(Float4 mask, Float4 a, Float4 b) {
+  return {_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))};
+}
+inline int moveMask(Float4 mask) { return _mm_movemask_ps(mask.v); }
+
+inline UInt4 broadcastUInt(std::uint32_t x) {
+  return {_mm_set1_epi32(static_cast<int>(x))};
+}
+// Low and high 32 bits of four 64-bit integers
+inline UInt4 loadLowWords(const std::uint64_t *p) {
+  const auto a{_mm_loadu_ps(reinterpret_cast<const float *>(p))};
+  const auto b{_mm_loadu_ps(reinterpret_cast<const float *>(p + 2))};
+  return {_mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)))};
+}
+inline UInt4 loadHighWords(const std::uint64_t *p) {
+  const auto a{_mm_loadu_ps(reinterpret_cast<const float *>(p))};
+  const auto b{_mm_loadu_ps(reinterpret_cast<const float *>(p + 2))};
+  return {_mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)))};
+}
+inline UInt4 operator+(UInt4 a, UInt4 b) { return {_mm_add_epi32(a.v, b.v)}; }
+// Without SSE4.1, only lanes 0 and 2 multiply (to 64 bits), so the odd
+// lanes are shifted down and multiplied separately
+inline UInt4 operator*(UInt4 a, UInt4 b) {
+#if defined(__SSE4_1__)
+  return {_mm_mullo_epi32(a.v, b.v)};
+#else
+  const auto even{_mm_mul_epu32(a.v, b.v)};
+  const auto odd{
+      _mm_mul_epu32(_mm_srli_epi64(a.v, 32), _mm_srli_epi64(b.v, 32))};
+  return {_mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                             _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)))};
+#endif
+}
+inline UInt4 bitXor(UInt4 a, UInt4 b) { return {_mm_xor_si128(a.v, b.v)}; }
+inline UInt4 shiftRight(UInt4 a, int count) {
+  return {_mm_srli_epi32(a.v, count)};
+}
+// Lanes must be below 2^31
+inline Float4 convertToFloat(UInt4 a) { return {_mm_cvtepi32_ps(a.v)}; }
+
+#elif defined(ABCG_SIMD_WASM)
+
+inline Float4 broadcast(float x) { return {wasm_f32x4_splat(x)}; }
+inline Float4 load(const float *p) { return {wasm_v128_load(p)}; }
+inline void store(float *p, Float4 a) { wasm_v128_store(p, a.v); }
+inline Float4 operator+(Float4 a, Float4 b) {
+  return {wasm_f32x4_add(a.v, b.v)};
+}
+inline Float4 operator-(Float4 a, Float4 b) {
+  return {wasm_f32x4_sub(a.v, b.v)};
+}
+inline Float4 operator*(Float4 a, Float4 b) {
+  return {wasm_f32x4_mul(a.v, b.v)};
+}
+inline Float4 operator/(Float4 a, Float4 b) {
+  return {wasm_f32x4_div(a.v, b.v)};
+}
+inline Float4 min(Float4 a, Float4 b) { return {wasm_f32x4_pmin(a.v, b.v)}; }
+inline Float4 max(Float4 a, Float4 b) { return {wasm_f32x4_pmax(a.v, b.v)}; }
+inline Float4 sqrt(Float4 a) { return {wasm_f32x4_sqrt(a.v)}; }
+inline Float4 lessThan(Float4 a, Float4 b) {
+  return {wasm_f32x4_lt(a.v, b.v)};
+}
+inline Float4 greaterThan(Float4 a, Float4 b) {
+  return {wasm_f32x4_gt(a.v, b.v)};
+}
+inline Float4 greaterEqual(Float4 a, Float4 b) {
+  return {wasm_f32x4_ge(a.v, b.v)};
+}
+inline Float4 bitAnd(Float4 a, Float4 b) { return {wasm_v128_and(a.v, b.v)}; }
+inline Float4 bitOr(Float4 a, Float4 b) { return {wasm_v128_or(a.v, b.v)}; }
+inline Float4 select(Float4 mask, Float4 a, Float4 b) {
+  return {wasm_v128_bitselect(a.v, b.v, mask.v)};
+}
+inline int moveMask(Float4 mask) {
+  return static_cast<int>(wasm_i32x4_bitmask(mask.v));
+}
+
+inline UInt4 broadcastUInt(std::uint32_t x) {
+  return {wasm_i32x4_splat(static_cast<std::int32_t>(x))};
+}
+// Low and high 32 bits of four 64-bit integers
+inline UInt4 loadLowWords(const std::uint64_t *p) {
+  return {wasm_i32x4_shuffle(wasm_v128_load(p), wasm_v128_load(p + 2), 0, 2,
+                             4, 6)};
+}
+inline UInt4 loadHighWords(const std::uint64_t *p) {
+  return {wasm_i32x4_shuffle(wasm_v128_load(p), wasm_v128_load(p + 2), 1, 3,
+                             5, 7)};
+}
+inline UInt4 operator+(UInt4 a, UInt4 b) { return {wasm_i32x4_add(a.v, b.v)}; }
+inline UInt4 operator*(UInt4 a, UInt4 b) { return {wasm_i32x4_mul(a.v, b.v)}; }
+inline UInt4 bitXor(UInt4 a, UInt4 b) { return {wasm_v128_xor(a.v, b.v)}; }
+inline UInt4 shiftRight(UInt4 a, int count) {
+  return {wasm_u32x4_shr(a.v, static_cast<std::uint32_t>(count))};
+}
+// Lanes must be below 2^31
+inline Float4 convertToFloat(UInt4 a) {
+  return {wasm_f32x4_convert_i32x4(a.v)};
+}
+
+#else
+
+namespace detail {
+inline float maskValue(bool condition) {
+  const std::uint32_t bits{condition ? 0xFFFFFFFFu : 0u};
+  float result{};
+  std::memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+inline std::uint32_t bitsOf(float x) {
+  std::uint32_t bits{};
+  std::memcpy(&bits, &x, sizeof(bits));
+  return bits;
+}
+inline float floatOf(std::uint32_t bits) {
+  float result{};
+  std::memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+template <typename TFun>
+inline Float4 map(Float4 a, Float4 b, TFun &&function) {
+  Float4 result{};
+  for (std::size_t i{}; i < result.v.size(); ++i) {
+    result.v.at(i) = function(a.v.at(i), b.v.at(i));
+  }
+  return result;
+}
+template <typename TFun>
+inline UInt4 map(UInt4 a, UInt4 b, TFun &&function) {
+  UInt4 result{};
+  for (std::size_t i{}; i < result.v.size(); ++i) {
+    result.v.at(i) = function(a.v.at(i), b.v.at(i));
+  }
+  return result;
+}
+}  // namespace detail
+
+inline Float4 broadcast(float x) { return {{x, x, x, x}}; }
+inline Float4 load(const float *p) { return {{p[0], p[1], p[2], p[3]}}; }
+inline void store(float *p, Float4 a) {
+  std::copy(a.v.begin(), a.v.end(), p);
+}
+inline Float4 operator+(Float4 a, Float4 b) {
+  return detail::map(a, b, [](float x, float y) { return x + y; });
+}
+inline Float4 operator-(Float4 a, Float4 b) {
+  return detail::map(a, b, [](float x, float y) { return x - y; });
+}
+inline Float4 operator*(Float4 a, Float4 b) {
+  return detail::map(a, b, [](float x, float y) { return x * y; });
+}
+inline Float4 operator/(Float4 a, Float4 b) {
+  return detail::map(a, b, [](float x, float y) { return x / y; });
+}
+inline Float4 min(Float4 a, Float4 b) {
+  return detail::map(a, b, [](float x, float y) { return y < x ? y : x; });
+}
+inline Float4 max(Float4 a, Float4 b) {
+  return detail::map(a, b, [](float x, float y) { return y > x ? y : x; });
+}
+inline Float4 sqrt(Float4 a) {
+  return detail::map(a, a, [](float x, float) { return std::sqrt(x); });
+}
+inline Float4 lessThan(Float4 a, Float4 b) {
+  return detail::map(a, b,
+                     [](float x, float y) { return detail::maskValue(x < y); });
+}
+inline Float4 greaterThan(Float4 a, Float4 b) {
+  return detail::map(a, b,
+                     [](float x, float y) { return detail::maskValue(x > y); });
+}
+inline Float4 greaterEqual(Float4 a, Float4 b) {
+  return detail::map(
+      a, b, [](float x, float y) { return detail::maskValue(x >= y); });
+}
+inline Float4 bitAnd(Float4 a, Float4 b) {
+  return detail::map(a, b, [](float x, float y) {
+    return detail::floatOf(detail::bitsOf(x) & detail::bitsOf(y));
+  });
+}
+inline Float4 bitOr(Float4 a, Float4 b) {
+  return detail::map(a, b, [](float x, float y) {
+    return detail::floatOf(detail::bitsOf(x) | detail::bitsOf(y));
+  });
+}
+inline Float4 select(Float4 mask, Float4 a, Float4 b) {
+  return bitOr(bitAnd(mask, a),
+               detail::map(mask, b, [](float m, float y) {
+                 return detail::floatOf(~detail::bitsOf(m) & detail::bitsOf(y));
+               }));
+}
+inline int moveMask(Float4 mask) {
+  int result{};
+  for (std::size_t i{}; i < mask.v.size(); ++i) {
+    if ((detail::bitsOf(mask.v.at(i)) & 0x80000000u) != 0u) {
+      result |= 1 << static_cast<int>(i);
+    }
+  }
+  return result;
+}
+
+inline UInt4 broadcastUInt(std::uint32_t x) { return {{x, x, x, x}}; }
+// Low and high 32 bits of four 64-bit integers
+inline UInt4 loadLowWords(const std::uint64_t *p) {
+  return {{static_cast<std::uint32_t>(p[0]), static_cast<std::uint32_t>(p[1]),
+           static_cast<std::uint32_t>(p[2]), static_cast<std::uint32_t>(p[3])}};
+}
+inline UInt4 loadHighWords(const std::uint64_t *p) {
+  return {{static_cast<std::uint32_t>(p[0] >> 32U),
+           static_cast<std::uint32_t>(p[1] >> 32U),
+           static_cast<std::uint32_t>(p[2] >> 32U),
+           static_cast<std::uint32_t>(p[3] >> 32U)}};
+}
+inline UInt4 operator+(UInt4 a, UInt4 b) {
+  return detail::map(a, b, [](std::uint32_t x, std::uint32_t y) {
+    return static_cast<std::uint32_t>(x + y);
+  });
+}
+inline UInt4 operator*(UInt4 a, UInt4 b) {
+  return detail::map(a, b, [](std::uint32_t x, std::uint32_t y) {
+    return static_cast<std::uint32_t>(x * y);
+  });
+}
+inline UInt4 bitXor(UInt4 a, UInt4 b) {
+  return detail::map(
+      a, b, [](std::uint32_t x, std::uint32_t y) { return x ^ y; });
+}
+inline UInt4 shiftRight(UInt4 a, int count) {
+  return detail::map(a, a, [count](std::uint32_t x, std::uint32_t) {
+    return x >> static_cast<unsigned>(count);
+  });
+}
+// Lanes must be below 2^31
+inline Float4 convertToFloat(UInt4 a) {
+  Float4 result{};
+  for (std::size_t i{}; i < result.v.size(); ++i) {
+    result.v.at(i) = static_cast<float>(static_cast<std::int32_t>(a.v.at(i)));
+  }
+  return result;
+}
+
+#endif
+
+}  // namespace abcg::simd
+
+#endif
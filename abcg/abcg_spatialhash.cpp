@@ -0,0 +1,172 @@
+/**
+ * @file abcg_spatialhash.cpp
+ * @brief Definition of abcg::SpatialHash class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_spatialhash.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include "abcg_exception.hpp"
+
+/**
+ * @brief Constructs an empty spatial hash.
+ *
+ * @param cellSize Edge length of the grid cells.
+ *
+ * @throw abcg::Exception if the cell size is not positive.
+ */
+abcg::SpatialHash::SpatialHash(float cellSize) { setCellSize(cellSize); }
+
+/**
+ * @brief Sets the edge length of the grid cells.
+ *
+ * Takes effect on the next call to abcg::SpatialHash::build.
+ *
+ * @param cellSize Edge length of the grid cells.
+ *
+ * @throw abcg::Exception if the cell size is not positive.
+ */
+void abcg::SpatialHash::setCellSize(float cellSize) {
+  if (!(cellSize > 0.0f)) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Invalid spatial hash cell size")};
+  }
+  m_cellSize = cellSize;
+  m_inverseCellSize = 1.0f / cellSize;
+}
+
+/**
+ * @brief Replaces the contents of the hash with the given boxes.
+ *
+ * Query results are indices into this span.
+ *
+ * @param boxes Boxes to be stored.
+ */
+void abcg::SpatialHash::build(std::span<const BoundingBox> boxes) {
+  m_boxes.assign(boxes.begin(), boxes.end());
+
+  const auto numBuckets{
+      std::bit_ceil(std::max<std::size_t>(16, boxes.size() * 2))};
+  m_bucketMask = static_cast<std::uint32_t>(numBuckets - 1);
+  m_bucketStart.assign(numBuckets + 1, 0);
+
+  // Counting sort of (bucket, box) pairs: count entries per bucket, then
+  // place them
+  m_pairs.clear();
+  for (std::size_t index{}; index < m_boxes.size(); ++index) {
+    const auto range{getCellRange(m_boxes[index])};
+    for (auto z{range.first.z}; z <= range.last.z; ++z) {
+      for (auto y{range.first.y}; y <= range.last.y; ++y) {
+        for (auto x{range.first.x}; x <= range.last.x; ++x) {
+          const auto bucket{getBucket(x, y, z)};
+          ++m_bucketStart[bucket + 1];
+          m_pairs.push_back({bucket, static_cast<std::uint32_t>(index)});
+        }
+      }
+    }
+  }
+  for (std::size_t bucket{1}; bucket < m_bucketStart.size(); ++bucket) {
+    m_bucketStart[bucket] += m_bucketStart[bucket - 1];
+  }
+  m_entries.resize(m_pairs.size());
+  for (const auto &[bucket, index] : m_pairs) {
+    m_entries[--m_bucketStart[bucket + 1]] = index;
+  }
+  // Placing from the end of each bucket shifted every start back by one
+  // bucket
+  std::copy(m_bucketStart.begin() + 1, m_bucketStart.end(),
+            m_bucketStart.begin());
+  m_bucketStart.back() = static_cast<std::uint32_t>(m_entries.size());
+}
+
+/**
+ * @brief Finds the stored boxes overlapping a box.
+ *
+ * @param box Query box.
+ * @param result Indices of the overlapping boxes, in ascending order.
+ */
+void abcg::SpatialHash::query(const BoundingBox &box,
+                              std::vector<std::size_t> &result) const {
+  gather(
+      box, [&box](const BoundingBox &other) { return other.overlaps(box); },
+      result);
+}
+
+/**
+ * @brief Finds the stored boxes overlapping a sphere.
+ *
+ * @param sphereCenter Center of the query sphere.
+ * @param radius Radius of the query sphere.
+ * @param result Indices of the overlapping boxes, in ascending order.
+ */
+void abcg::SpatialHash::query(const glm::vec3 &sphereCenter, float radius,
+                              std::vector<std::size_t> &result) const {
+  gather(
+      BoundingBox::fromSphere(sphereCenter, radius),
+      [&](const BoundingBox &other) {
+        return other.overlaps(sphereCenter, radius);
+      },
+      result);
+}
+
+// Computed in double precision to avoid overflow with huge ranges
+double abcg::SpatialHash::CellRange::count() const {
+  const auto cells{[this](glm::length_t axis) {
+    return static_cast<double>(last[axis]) -
+           static_cast<double>(first[axis]) + 1.0;
+  }};
+  return cells(0) * cells(1) * cells(2);
+}
+
+abcg::SpatialHash::CellRange
+abcg::SpatialHash::getCellRange(const BoundingBox &box) const {
+  const auto toCell{[this](const glm::vec3 &position) {
+    return glm::ivec3(glm::floor(position * m_inverseCellSize));
+  }};
+  return {toCell(box.min), toCell(box.max)};
+}
+
+std::uint32_t abcg::SpatialHash::getBucket(int x, int y, int z) const {
+  const auto hash{(static_cast<std::uint32_t>(x) * 73856093U) ^
+                  (static_cast<std::uint32_t>(y) * 19349663U) ^
+                  (static_cast<std::uint32_t>(z) * 83492791U)};
+  return hash & m_bucketMask;
+}
+
+template <typename TOverlaps>
+void abcg::SpatialHash::gather(const BoundingBox &bounds, TOverlaps overlaps,
+                               std::vector<std::size_t> &result) const {
+  result.clear();
+  if (m_boxes.empty()) return;
+
+  // Query volumes spanning more cells than there are buckets are cheaper to
+  // test against every box
+  const auto range{getCellRange(bounds)};
+  if (range.count() > static_cast<double>(m_bucketStart.size() - 1)) {
+    for (std::uint32_t index{}; index < m_boxes.size(); ++index) {
+      if (overlaps(m_boxes[index])) result.push_back(index);
+    }
+    return;
+  }
+
+  for (auto z{range.first.z}; z <= range.last.z; ++z) {
+    for (auto y{range.first.y}; y <= range.last.y; ++y) {
+      for (auto x{range.first.x}; x <= range.last.x; ++x) {
+        const auto bucket{getBucket(x, y, z)};
+        for (auto entry{m_bucketStart[bucket]};
+             entry < m_bucketStart[bucket + 1]; ++entry) {
+          const auto index{m_entries[entry]};
+          if (overlaps(m_boxes[index])) result.push_back(index);
+        }
+      }
+    }
+  }
+  // A box spanning several of the visited cells is found once per cell
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+}
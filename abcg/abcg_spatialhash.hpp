@@ -0,0 +1,83 @@
+/**
+ * @file abcg_spatialhash.hpp
+ * @brief abcg::SpatialHash header file.
+ *
+ * Declaration of abcg::SpatialHash, a uniform-grid broadphase for overlap
+ * queries against a set of axis-aligned bounding boxes.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_SPATIALHASH_HPP_
+#define ABCG_SPATIALHASH_HPP_
+
+#include <cstdint>
+#include <glm/vec3.hpp>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "abcg_boundingbox.hpp"
+
+namespace abcg {
+class SpatialHash;
+}  // namespace abcg
+
+/**
+ * @brief abcg::SpatialHash class.
+ *
+ * Space is divided into cubic cells of a fixed size, and each cell is hashed
+ * into one of a power-of-two number of buckets. A box is stored in every
+ * bucket of the cells it overlaps. Buckets are laid out contiguously with a
+ * counting sort, so abcg::SpatialHash::build is O(n) and allocates only when
+ * the number of boxes grows.
+ *
+ * A query visits only the buckets of the cells overlapped by the query
+ * volume, so its cost depends on the local density of boxes rather than
+ * their total number. For best results, the cell size should be about the
+ * size of the largest stored box. Queries do not modify the hash, so they
+ * can run concurrently once it is built.
+ *
+ * The class does not issue any OpenGL call and can be used headless.
+ */
+class abcg::SpatialHash {
+ public:
+  explicit SpatialHash(float cellSize = 1.0f);
+
+  void setCellSize(float cellSize);
+  void build(std::span<const BoundingBox> boxes);
+
+  void query(const BoundingBox &box, std::vector<std::size_t> &result) const;
+  void query(const glm::vec3 &sphereCenter, float radius,
+             std::vector<std::size_t> &result) const;
+
+  [[nodiscard]] float getCellSize() const { return m_cellSize; }
+  [[nodiscard]] std::size_t size() const { return m_boxes.size(); }
+
+ private:
+  struct CellRange {
+    glm::ivec3 first{};
+    glm::ivec3 last{};
+
+    [[nodiscard]] double count() const;
+  };
+
+  float m_cellSize{};
+  float m_inverseCellSize{};
+
+  std::vector<BoundingBox> m_boxes;
+  // Entries of bucket b are m_entries[m_bucketStart[b]..m_bucketStart[b+1])
+  std::vector<std::uint32_t> m_bucketStart;
+  std::vector<std::uint32_t> m_entries;
+  std::uint32_t m_bucketMask{};
+  // (bucket, box index) pairs produced while building
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> m_pairs;
+
+  [[nodiscard]] CellRange getCellRange(const BoundingBox &box) const;
+  [[nodiscard]] std::uint32_t getBucket(int x, int y, int z) const;
+  template <typename TOverlaps>
+  void gather(const BoundingBox &bounds, TOverlaps overlaps,
+              std::vector<std::size_t> &result) const;
+};
+
+#endif
@@ -0,0 +1,405 @@
+/**
+ * @file abcg_tracer.cpp
+ * @brief Definition of abcg::Tracer class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_tracer.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "abcg_exception.hpp"
+
+namespace {
+using clock = std::chrono::steady_clock;
+
+// Origin of the timestamps
+const clock::time_point epoch{clock::now()};
+
+enum class EventType : std::uint8_t { Begin, End, Complete, Counter, Frame };
+
+// Copy of a recorded event. The value is the counter value, the frame
+// number, or the duration in nanoseconds of a complete event.
+struct Event {
+  const char *name{};
+  std::uint64_t timestamp{};
+  double value{};
+  EventType type{};
+};
+
+// Event in a ring buffer. The fields are atomic since a reader may copy
+// the slot while its thread overwrites it.
+struct Slot {
+  std::atomic<const char *> name{};
+  std::atomic<std::uint64_t> timestamp{};
+  std::atomic<double> value{};
+  std::atomic<EventType> type{};
+};
+
+// Ring buffer of the last events of a thread, or of the GPU track. Events
+// are numbered from zero; reserved counts the events whose slot is being or
+// has been written, published those that can be read.
+struct Buffer {
+  std::uint32_t id{};
+  std::string name;
+  std::atomic<std::uint64_t> first{};
+  std::atomic<std::uint64_t> reserved{};
+  std::atomic<std::uint64_t> published{};
+  std::array<Slot, abcg::Tracer::bufferCapacity> slots{};
+
+  // Called by the owning thread only
+  void push(EventType type, const char *eventName, std::uint64_t timestamp,
+            double value) {
+    const auto index{reserved.load(std::memory_order_relaxed)};
+    reserved.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    auto &slot{slots.at(index % slots.size())};
+    slot.name.store(eventName, std::memory_order_relaxed);
+    slot.timestamp.store(timestamp, std::memory_order_relaxed);
+    slot.value.store(value, std::memory_order_relaxed);
+    slot.type.store(type, std::memory_order_relaxed);
+    published.store(index + 1, std::memory_order_release);
+  }
+
+  // Copies the events of the trace still in the buffer. Events reserved
+  // again while they were copied may be torn, so they are discarded.
+  [[nodiscard]] std::vector<Event> read() const {
+    const std::uint64_t capacity{slots.size()};
+    const auto end{published.load(std::memory_order_acquire)};
+    const auto begin{std::max(first.load(std::memory_order_relaxed),
+                              end > capacity ? end - capacity : 0)};
+
+    std::vector<Event> events;
+    events.reserve(end > begin ? end - begin : 0);
+    for (auto index{begin}; index < end; ++index) {
+      const auto &slot{slots.at(index % capacity)};
+      events.push_back({slot.name.load(std::memory_order_relaxed),
+                        slot.timestamp.load(std::memory_order_relaxed),
+                        slot.value.load(std::memory_order_relaxed),
+                        slot.type.load(std::memory_order_relaxed)});
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const auto reservedEnd{reserved.load(std::memory_order_relaxed)};
+    if (const auto valid{reservedEnd > capacity ? reservedEnd - capacity : 0};
+        valid > begin) {
+      const auto torn{std::min<std::uint64_t>(valid - begin, events.size())};
+      events.erase(events.begin(),
+                   events.begin() + static_cast<std::ptrdiff_t>(torn));
+    }
+    return events;
+  }
+};
+
+// Buffers of all threads that recorded events, kept until exit so that the
+// events of finished threads can still be written
+std::mutex registryMutex;
+std::vector<std::unique_ptr<Buffer>> buffers;
+std::string outputPath;
+
+thread_local Buffer *threadBuffer{};
+thread_local std::string threadName;
+
+Buffer &registerBuffer(std::string_view name) {
+  const std::scoped_lock lock{registryMutex};
+  auto &buffer{*buffers.emplace_back(std::make_unique<Buffer>())};
+  buffer.id = static_cast<std::uint32_t>(buffers.size());
+  buffer.name =
+      name.empty() ? fmt::format("Thread {}", buffer.id) : std::string{name};
+  return buffer;
+}
+
+// Buffers are created on the first event, so that threads that never
+// record do not take memory
+Buffer &getThreadBuffer() {
+  if (threadBuffer == nullptr) threadBuffer = &registerBuffer(threadName);
+  return *threadBuffer;
+}
+
+Buffer &getGpuBuffer() {
+  static auto &buffer{registerBuffer("GPU")};
+  return buffer;
+}
+
+std::string escapeJSON(std::string_view text) {
+  std::string escaped;
+  escaped.reserve(text.size());
+  for (const auto character : text) {
+    if (character == '"' || character == '\\') {
+      escaped += '\\';
+      escaped += character;
+    } else if (static_cast<unsigned char>(character) < 0x20) {
+      escaped += fmt::format("\\u{:04x}", static_cast<int>(character));
+    } else {
+      escaped += character;
+    }
+  }
+  return escaped;
+}
+
+// Timestamps are written in microseconds
+double toMicroseconds(double nanoseconds) { return nanoseconds / 1000.0; }
+}  // namespace
+
+/**
+ * @brief Starts recording events.
+ *
+ * Events recorded before are left out of the trace.
+ *
+ * @param path Path of the trace file written by abcg::Tracer::stop, or an
+ * empty string to write traces only with abcg::Tracer::write.
+ */
+void abcg::Tracer::start([[maybe_unused]] std::string_view path) {
+#if defined(ABCG_DISABLE_TRACING)
+  fmt::print("Warning: tracing requested but disabled at build time!\n");
+#else
+  const std::scoped_lock lock{registryMutex};
+  outputPath = path;
+  for (auto &buffer : buffers) {
+    buffer->first.store(buffer->published.load(std::memory_order_acquire),
+                        std::memory_order_relaxed);
+  }
+  m_enabled.store(true, std::memory_order_release);
+#endif
+}
+
+/**
+ * @brief Stops recording events and writes the trace to the path given to
+ * abcg::Tracer::start, if any.
+ *
+ * @throw abcg::Exception if the trace file cannot be created.
+ */
+void abcg::Tracer::stop() {
+  m_enabled.store(false, std::memory_order_release);
+  std::string path;
+  {
+    const std::scoped_lock lock{registryMutex};
+    path.swap(outputPath);
+  }
+  if (!path.empty()) {
+    write(path);
+    fmt::print("Trace written to {}\n", path);
+  }
+}
+
+/**
+ * @brief Writes the events recorded so far as a Chrome trace (JSON).
+ *
+ * May be called while events are recorded. Each thread contributes its
+ * last bufferCapacity events. Scopes become complete events; scopes whose
+ * start was overwritten are left out, and scopes still open are written as
+ * begin events.
+ *
+ * @param path Path of the trace file, which is overwritten.
+ *
+ * @throw abcg::Exception if the trace file cannot be created.
+ */
+void abcg::Tracer::write(std::string_view path) {
+  write(path, 0, std::numeric_limits<std::uint64_t>::max());
+}
+
+/**
+ * @brief Writes the events recorded in a time window as a Chrome trace
+ * (JSON).
+ *
+ * Scopes that overlap the window are written whole.
+ *
+ * @param path Path of the trace file, which is overwritten.
+ * @param from Start of the window on the trace clock, in nanoseconds.
+ * @param to End of the window on the trace clock, in nanoseconds.
+ * @param metadata Key-value pairs written to the otherData section, which
+ * trace viewers show as metadata.
+ *
+ * @throw abcg::Exception if the trace file cannot be created.
+ */
+void abcg::Tracer::write(std::string_view path, std::uint64_t from,
+                         std::uint64_t to, const Metadata &metadata) {
+  std::vector<std::pair<const Buffer *, std::string>> snapshot;
+  {
+    const std::scoped_lock lock{registryMutex};
+    for (const auto &buffer : buffers) {
+      snapshot.emplace_back(buffer.get(), buffer->name);
+    }
+  }
+
+  std::ofstream output{std::string{path}};
+  if (!output) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        fmt::format("Failed to create trace file {}", path))};
+  }
+
+  output << R"({"displayTimeUnit":"ms","otherData":{)";
+  auto separator{""};
+  for (const auto &[key, value] : metadata) {
+    output << fmt::format(R"({}"{}":"{}")", separator, escapeJSON(key),
+                          escapeJSON(value));
+    separator = ",";
+  }
+  output << R"(},"traceEvents":[)";
+
+  separator = "";
+  const auto emit{[&](const std::string &json) {
+    output << separator << '\n' << json;
+    separator = ",";
+  }};
+  const auto overlaps{[&](std::uint64_t start, std::uint64_t end) {
+    return start <= to && end >= from;
+  }};
+
+  for (const auto &[buffer, name] : snapshot) {
+    const auto tid{buffer->id};
+    emit(fmt::format(R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},)"
+                     R"("args":{{"name":"{}"}}}})",
+                     tid, escapeJSON(name)));
+
+    const auto events{buffer->read()};
+    std::vector<const Event *> open;
+    for (const auto &event : events) {
+      const auto eventName{event.name != nullptr ? escapeJSON(event.name)
+                                                 : std::string{}};
+      const auto timestamp{
+          toMicroseconds(static_cast<double>(event.timestamp))};
+      switch (event.type) {
+        case EventType::Begin:
+          open.push_back(&event);
+          break;
+        case EventType::End: {
+          if (open.empty()) break;
+          const auto &begin{*open.back()};
+          open.pop_back();
+          if (!overlaps(begin.timestamp, event.timestamp)) break;
+          emit(fmt::format(
+              R"({{"name":"{}","ph":"X","pid":1,"tid":{},"ts":{:.3f},)"
+              R"("dur":{:.3f}}})",
+              escapeJSON(begin.name), tid,
+              toMicroseconds(static_cast<double>(begin.timestamp)),
+              toMicroseconds(
+                  static_cast<double>(event.timestamp - begin.timestamp))));
+          break;
+        }
+        case EventType::Complete:
+          if (!overlaps(event.timestamp,
+                        event.timestamp +
+                            static_cast<std::uint64_t>(event.value))) {
+            break;
+          }
+          emit(fmt::format(
+              R"({{"name":"{}","ph":"X","pid":1,"tid":{},"ts":{:.3f},)"
+              R"("dur":{:.3f}}})",
+              eventName, tid, timestamp, toMicroseconds(event.value)));
+          break;
+        case EventType::Counter:
+          if (!overlaps(event.timestamp, event.timestamp)) break;
+          emit(fmt::format(
+              R"({{"name":"{}","ph":"C","pid":1,"tid":{},"ts":{:.3f},)"
+              R"("args":{{"value":{}}}}})",
+              eventName, tid, timestamp, event.value));
+          break;
+        case EventType::Frame:
+          if (!overlaps(event.timestamp, event.timestamp)) break;
+          emit(fmt::format(
+              R"({{"name":"{}","ph":"i","s":"g","pid":1,"tid":{},)"
+              R"("ts":{:.3f},"args":{{"frame":{:.0f}}}}})",
+              eventName, tid, timestamp, event.value));
+          break;
+      }
+    }
+    for (const auto *event : open) {
+      if (event->timestamp > to) continue;
+      emit(fmt::format(
+          R"({{"name":"{}","ph":"B","pid":1,"tid":{},"ts":{:.3f}}})",
+          escapeJSON(event->name), tid,
+          toMicroseconds(static_cast<double>(event->timestamp))));
+    }
+  }
+  output << "\n]}\n";
+
+  if (!output) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        fmt::format("Failed to write trace file {}", path))};
+  }
+}
+
+/**
+ * @brief Returns the time of the trace clock, in nanoseconds.
+ */
+std::uint64_t abcg::Tracer::now() noexcept {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() -
+                                                           epoch)
+          .count());
+}
+
+/**
+ * @brief Sets the name of the calling thread in the trace.
+ */
+void abcg::Tracer::setThreadName(std::string_view name) {
+  threadName = name;
+  if (threadBuffer != nullptr) {
+    const std::scoped_lock lock{registryMutex};
+    threadBuffer->name = name;
+  }
+}
+
+/**
+ * @brief Records the start of a scope of the calling thread.
+ *
+ * @param name Name of the scope. Must outlive the trace.
+ */
+void abcg::Tracer::beginScope(const char *name) {
+  getThreadBuffer().push(EventType::Begin, name, now(), 0.0);
+}
+
+/**
+ * @brief Records the end of the innermost scope of the calling thread.
+ */
+void abcg::Tracer::endScope() {
+  getThreadBuffer().push(EventType::End, nullptr, now(), 0.0);
+}
+
+/**
+ * @brief Records a sample of a counter.
+ *
+ * @param name Name of the counter. Must outlive the trace.
+ * @param value Value of the counter.
+ */
+void abcg::Tracer::counter(const char *name, double value) {
+  getThreadBuffer().push(EventType::Counter, name, now(), value);
+}
+
+/**
+ * @brief Records the start of a frame, shown as a marker across threads.
+ *
+ * @param number Number of the frame.
+ */
+void abcg::Tracer::frame(std::uint64_t number) {
+  getThreadBuffer().push(EventType::Frame, "Frame", now(),
+                         static_cast<double>(number));
+}
+
+/**
+ * @brief Records a scope of the GPU track.
+ *
+ * Must not be called by two threads at the same time; it is meant for the
+ * thread that owns the OpenGL context.
+ *
+ * @param name Name of the scope. Must outlive the trace.
+ * @param start Start of the scope on the trace clock, in nanoseconds.
+ * @param duration Duration of the scope, in nanoseconds.
+ */
+void abcg::Tracer::gpuScope(const char *name, std::uint64_t start,
+                            std::uint64_t duration) {
+  getGpuBuffer().push(EventType::Complete, name, start,
+                      static_cast<double>(duration));
+}
@@ -0,0 +1,138 @@
+/**
+ * @file abcg_tracer.hpp
+ * @brief abcg::Tracer header file.
+ *
+ * Declaration of abcg::Tracer, a recorder of instrumentation events that
+ * writes Chrome trace files, of abcg::TraceScope, its RAII marker, and of
+ * the ABCG_TRACE_* macros.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_TRACER_HPP_
+#define ABCG_TRACER_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace abcg {
+class Tracer;
+class TraceScope;
+}  // namespace abcg
+
+/**
+ * @brief abcg::Tracer class.
+ *
+ * Records timestamped events while enabled: nested CPU scopes, GPU scopes
+ * mapped to CPU time, counters and frame markers. The events can be written
+ * at any time, or when tracing stops, as a JSON file in the Chrome Trace
+ * Event format, which chrome://tracing and the Perfetto UI open.
+ *
+ * Each thread records into its own ring buffer of the last bufferCapacity
+ * events, without locks: the owning thread is the only writer, and a
+ * reader discards the events overwritten while it copied them. GPU scopes
+ * go to a buffer of their own, written by the thread that owns the OpenGL
+ * context.
+ *
+ * While tracing is disabled, the ABCG_TRACE_* macros and
+ * abcg::TraceScope cost a relaxed atomic load. Defining
+ * ABCG_DISABLE_TRACING (CMake option ENABLE_TRACING=OFF) removes them
+ * altogether.
+ */
+class abcg::Tracer {
+ public:
+  /** @brief Key-value pairs stored in the trace file. */
+  using Metadata = std::vector<std::pair<std::string, std::string>>;
+
+  static constexpr std::size_t bufferCapacity{std::size_t{1} << 15};
+
+  Tracer() = delete;
+
+  static void start(std::string_view path = {});
+  static void stop();
+  static void write(std::string_view path);
+  static void write(std::string_view path, std::uint64_t from,
+                    std::uint64_t to, const Metadata &metadata = {});
+
+  /**
+   * @brief Returns whether events are being recorded.
+   */
+  [[nodiscard]] static bool isEnabled() noexcept {
+#if defined(ABCG_DISABLE_TRACING)
+    return false;
+#else
+    return m_enabled.load(std::memory_order_relaxed);
+#endif
+  }
+
+  [[nodiscard]] static std::uint64_t now() noexcept;
+  static void setThreadName(std::string_view name);
+  static void beginScope(const char *name);
+  static void endScope();
+  static void counter(const char *name, double value);
+  static void frame(std::uint64_t number);
+  static void gpuScope(const char *name, std::uint64_t start,
+                       std::uint64_t duration);
+
+ private:
+  inline static std::atomic<bool> m_enabled{false};
+};
+
+/**
+ * @brief abcg::TraceScope class.
+ *
+ * Records the enclosing block as a scope of the calling thread if tracing
+ * is enabled when the block starts. The name must outlive the trace, e.g.
+ * a string literal.
+ */
+class abcg::TraceScope {
+ public:
+  explicit TraceScope(const char *name) : m_traced{Tracer::isEnabled()} {
+    if (m_traced) Tracer::beginScope(name);
+  }
+  ~TraceScope() {
+    if (m_traced) Tracer::endScope();
+  }
+
+  TraceScope(const TraceScope &) = delete;
+  TraceScope(TraceScope &&) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+  TraceScope &operator=(TraceScope &&) = delete;
+
+ private:
+  bool m_traced{};
+};
+
+#define ABCG_TRACE_CONCAT_IMPL(a, b) a##b
+#define ABCG_TRACE_CONCAT(a, b) ABCG_TRACE_CONCAT_IMPL(a, b)
+
+#if defined(ABCG_DISABLE_TRACING)
+#define ABCG_TRACE_SCOPE(name) static_cast<void>(0)
+#define ABCG_TRACE_COUNTER(name, value) static_cast<void>(0)
+#define ABCG_TRACE_FRAME(number) static_cast<void>(0)
+#define ABCG_TRACE_THREAD_NAME(name) static_cast<void>(0)
+#else
+/** @brief Records the enclosing block as a scope named name. */
+#define ABCG_TRACE_SCOPE(name) \
+  const abcg::TraceScope ABCG_TRACE_CONCAT(abcgTraceScope, __LINE__) { name }
+/** @brief Records a sample of the counter named name. */
+#define ABCG_TRACE_COUNTER(name, value)                                \
+  do {                                                                 \
+    if (abcg::Tracer::isEnabled()) abcg::Tracer::counter(name, value); \
+  } while (false)
+/** @brief Records the start of a frame. */
+#define ABCG_TRACE_FRAME(number)                                \
+  do {                                                          \
+    if (abcg::Tracer::isEnabled()) abcg::Tracer::frame(number); \
+  } while (false)
+/** @brief Names the calling thread in the trace. */
+#define ABCG_TRACE_THREAD_NAME(name) abcg::Tracer::setThreadName(name)
+#endif
+
+#endif
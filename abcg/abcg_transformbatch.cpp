@@ -0,0 +1,174 @@
+/**
+ * @file abcg_transformbatch.cpp
+ * @brief Definition of the batched model/normal matrix kernel.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_transformbatch.hpp"
+
+#include <array>
+#include <cmath>
+
+#include "abcg_exception.hpp"
+#include "abcg_simd.hpp"
+
+namespace {
+// Entries of the model matrix (16) followed by the normal matrix (9), in
+// column-major order
+constexpr std::size_t numEntries{25};
+
+template <typename T>
+T splat(float x) {
+  if constexpr (std::is_same_v<T, float>) {
+    return x;
+  } else {
+    return abcg::simd::broadcast(x);
+  }
+}
+
+/**
+ * @brief Computes model and normal matrix entries of one instance (T = float)
+ * or of four instances at once (T = abcg::simd::Float4).
+ *
+ * The model matrix is T * S * R, where S is a uniform scale and R is the
+ * rotation about a unit axis given by Rodrigues' formula with the shared
+ * sine and cosine. Since the upper 3x3 of the view matrix (V) and R are
+ * orthonormal, the inverse transpose of V * S * R is simply V * R / s.
+ */
+template <typename T>
+std::array<T, numEntries> computeEntries(T px, T py, T pz, T s, T ax, T ay,
+                                         T az, float sine, float cosine,
+                                         const glm::mat4 &view) {
+  const auto c{splat<T>(cosine)};
+  const auto sn{splat<T>(sine)};
+  const auto t{splat<T>(1.0f - cosine)};
+
+  const auto txy{t * ax * ay};
+  const auto txz{t * ax * az};
+  const auto tyz{t * ay * az};
+  const auto sx{sn * ax};
+  const auto sy{sn * ay};
+  const auto sz{sn * az};
+
+  // Columns of the rotation matrix
+  const std::array<std::array<T, 3>, 3> r{
+      {{c + t * ax * ax, txy + sz, txz - sy},
+       {txy - sz, c + t * ay * ay, tyz + sx},
+       {txz + sy, tyz - sx, c + t * az * az}}};
+
+  const auto zero{splat<T>(0.0f)};
+  const auto one{splat<T>(1.0f)};
+  const auto inverseScale{one / s};
+
+  std::array<T, numEntries> entries{};
+  for (std::size_t column{}; column < 3; ++column) {
+    for (std::size_t row{}; row < 3; ++row) {
+      entries[column * 4 + row] = r[column][row] * s;
+    }
+    entries[column * 4 + 3] = zero;
+  }
+  entries[12] = px;
+  entries[13] = py;
+  entries[14] = pz;
+  entries[15] = one;
+
+  for (std::size_t column{}; column < 3; ++column) {
+    const auto &rc{r[column]};
+    for (std::size_t row{}; row < 3; ++row) {
+      const auto vrow{static_cast<glm::length_t>(row)};
+      const auto value{splat<T>(view[0][vrow]) * rc[0] +
+                       splat<T>(view[1][vrow]) * rc[1] +
+                       splat<T>(view[2][vrow]) * rc[2]};
+      entries[16 + column * 3 + row] = value * inverseScale;
+    }
+  }
+  return entries;
+}
+
+void storeEntries(const std::array<float, numEntries> &entries,
+                  abcg::InstanceMatrices &output) {
+  auto *model{&output.modelMatrix[0][0]};
+  auto *normal{&output.normalMatrix[0][0]};
+  std::copy(entries.begin(), entries.begin() + 16, model);
+  std::copy(entries.begin() + 16, entries.end(), normal);
+}
+}  // namespace
+
+/**
+ * @brief Computes model and normal matrices of a batch of instances.
+ *
+ * For each instance i, writes the model matrix translate(p_i + t) *
+ * scale(s_i) * rotate(angle, axis_i), where t is the translation of the
+ * batch, and the normal matrix inverseTranspose(mat3(view * model)), the
+ * same matrices obtained with glm::translate, glm::scale, glm::rotate and
+ * glm::inverseTranspose. Sine and cosine are evaluated once for the whole
+ * batch and four instances are processed per iteration.
+ *
+ * @param batch Positions, uniform scales, unit rotation axes and
+ * translation.
+ * @param angle Rotation angle shared by all instances, in radians.
+ * @param viewMatrix Rigid (rotation and translation only) view matrix.
+ * @param output Destination, with at least as many elements as the batch.
+ *
+ * @throw abcg::Exception if the sizes of the input and output differ.
+ */
+void abcg::computeInstanceMatrices(const TransformBatch &batch, float angle,
+                                   const glm::mat4 &viewMatrix,
+                                   std::span<InstanceMatrices> output) {
+  const auto count{batch.positionX.size()};
+  if (batch.positionY.size() != count || batch.positionZ.size() != count ||
+      batch.scale.size() != count || batch.axisX.size() != count ||
+      batch.axisY.size() != count || batch.axisZ.size() != count ||
+      output.size() < count) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Mismatched transform batch sizes")};
+  }
+
+  const float sine{std::sin(angle)};
+  const float cosine{std::cos(angle)};
+
+  const auto tx{simd::broadcast(batch.translation.x)};
+  const auto ty{simd::broadcast(batch.translation.y)};
+  const auto tz{simd::broadcast(batch.translation.z)};
+
+  const auto lanes{static_cast<std::size_t>(simd::width)};
+  std::size_t index{};
+  for (; index + lanes <= count; index += lanes) {
+    const auto packed{computeEntries(simd::load(&batch.positionX[index]) + tx,
+                                     simd::load(&batch.positionY[index]) + ty,
+                                     simd::load(&batch.positionZ[index]) + tz,
+                                     simd::load(&batch.scale[index]),
+                                     simd::load(&batch.axisX[index]),
+                                     simd::load(&batch.axisY[index]),
+                                     simd::load(&batch.axisZ[index]), sine,
+                                     cosine, viewMatrix)};
+
+    // Transpose from structure of arrays to one matrix pair per instance
+    std::array<std::array<float, lanes>, numEntries> unpacked{};
+    for (std::size_t entry{}; entry < numEntries; ++entry) {
+      simd::store(unpacked[entry].data(), packed[entry]);
+    }
+    for (std::size_t lane{}; lane < lanes; ++lane) {
+      auto *model{&output[index + lane].modelMatrix[0][0]};
+      auto *normal{&output[index + lane].normalMatrix[0][0]};
+      for (std::size_t entry{}; entry < 16; ++entry) {
+        model[entry] = unpacked[entry][lane];
+      }
+      for (std::size_t entry{16}; entry < numEntries; ++entry) {
+        normal[entry - 16] = unpacked[entry][lane];
+      }
+    }
+  }
+
+  for (; index < count; ++index) {
+    storeEntries(
+        computeEntries(batch.positionX[index] + batch.translation.x,
+                       batch.positionY[index] + batch.translation.y,
+                       batch.positionZ[index] + batch.translation.z,
+                       batch.scale[index],
+                       batch.axisX[index], batch.axisY[index],
+                       batch.axisZ[index], sine, cosine, viewMatrix),
+        output[index]);
+  }
+}
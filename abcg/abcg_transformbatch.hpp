@@ -0,0 +1,54 @@
+/**
+ * @file abcg_transformbatch.hpp
+ * @brief Declaration of the batched model/normal matrix kernel.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_TRANSFORMBATCH_HPP_
+#define ABCG_TRANSFORMBATCH_HPP_
+
+#include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <span>
+
+namespace abcg {
+struct InstanceMatrices;
+struct TransformBatch;
+
+void computeInstanceMatrices(const TransformBatch& batch, float angle,
+                             const glm::mat4& viewMatrix,
+                             std::span<InstanceMatrices> output);
+}  // namespace abcg
+
+/**
+ * @brief Packed per-instance matrices.
+ *
+ * Tightly packed (100 bytes) so that an array of it can be uploaded as is to
+ * a per-instance vertex buffer.
+ */
+struct abcg::InstanceMatrices {
+  glm::mat4 modelMatrix{1.0f};
+  glm::mat3 normalMatrix{1.0f};
+};
+
+/**
+ * @brief Structure-of-arrays input of abcg::computeInstanceMatrices.
+ *
+ * All spans must have the same size. Rotation axes must be unit vectors.
+ * The translation is added to every position, so that a batch stored in a
+ * local space can be placed without being copied.
+ */
+struct abcg::TransformBatch {
+  std::span<const float> positionX;
+  std::span<const float> positionY;
+  std::span<const float> positionZ;
+  std::span<const float> scale;
+  std::span<const float> axisX;
+  std::span<const float> axisY;
+  std::span<const float> axisZ;
+  glm::vec3 translation{};
+};
+
+#endif
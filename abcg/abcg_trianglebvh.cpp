@@ -0,0 +1,493 @@
+/**
+ * @file abcg_trianglebvh.cpp
+ * @brief Definition of abcg::TriangleBVH class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_trianglebvh.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include "abcg_exception.hpp"
+#include "abcg_simd.hpp"
+
+namespace {
+constexpr std::size_t maxLeafTriangles{4};
+constexpr std::size_t numBins{12};
+// Below this depth the split falls back to the median, which bounds the
+// depth of the tree and thus the traversal stacks
+constexpr std::size_t maxSAHDepth{64};
+constexpr std::size_t maxStackSize{256};
+
+namespace simd = abcg::simd;
+
+struct BuildTriangle {
+  abcg::BoundingBox bounds{};
+  glm::vec3 centroid{};
+  std::uint32_t index{};
+};
+
+abcg::BoundingBox makeEmptyBox() {
+  return {glm::vec3(std::numeric_limits<float>::max()),
+          glm::vec3(std::numeric_limits<float>::lowest())};
+}
+
+void grow(abcg::BoundingBox &box, const abcg::BoundingBox &other) {
+  box.min = glm::min(box.min, other.min);
+  box.max = glm::max(box.max, other.max);
+}
+
+float getSurfaceArea(const abcg::BoundingBox &box) {
+  const auto extent{glm::max(box.extent(), glm::vec3(0.0f))};
+  return 2.0f * (extent.x * extent.y + extent.y * extent.z +
+                 extent.z * extent.x);
+}
+
+// Bounding box of a box transformed by an affine matrix
+abcg::BoundingBox transformBox(const abcg::BoundingBox &box,
+                               const glm::mat4 &matrix) {
+  const glm::vec3 center{matrix * glm::vec4(box.center(), 1.0f)};
+  const auto halfExtent{box.extent() * 0.5f};
+  glm::vec3 newHalfExtent{};
+  for (glm::length_t row{}; row < 3; ++row) {
+    for (glm::length_t column{}; column < 3; ++column) {
+      newHalfExtent[row] += std::abs(matrix[column][row]) * halfExtent[column];
+    }
+  }
+  return {center - newHalfExtent, center + newHalfExtent};
+}
+
+// Four 3D vectors, one per lane
+struct Vec3x4 {
+  simd::Float4 x;
+  simd::Float4 y;
+  simd::Float4 z;
+};
+
+Vec3x4 broadcast(const glm::vec3 &v) {
+  return {simd::broadcast(v.x), simd::broadcast(v.y), simd::broadcast(v.z)};
+}
+
+Vec3x4 operator-(const Vec3x4 &a, const Vec3x4 &b) {
+  return {a.x - b.x, a.y - b.y, a.z - b.z};
+}
+
+simd::Float4 dot(const Vec3x4 &a, const Vec3x4 &b) {
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+Vec3x4 cross(const Vec3x4 &a, const Vec3x4 &b) {
+  return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z,
+          a.x * b.y - a.y * b.x};
+}
+
+simd::Float4 lessEqual(simd::Float4 a, simd::Float4 b) {
+  return simd::greaterEqual(b, a);
+}
+
+std::array<Vec3x4, 3> loadPack(const auto &coordinates) {
+  std::array<Vec3x4, 3> vertices{};
+  for (std::size_t vertex{}; vertex < 3; ++vertex) {
+    vertices.at(vertex) = {simd::load(coordinates.at(vertex * 3 + 0).data()),
+                           simd::load(coordinates.at(vertex * 3 + 1).data()),
+                           simd::load(coordinates.at(vertex * 3 + 2).data())};
+  }
+  return vertices;
+}
+
+// Squared distance from p to each triangle of the pack (Ericson, Real-Time
+// Collision Detection, 5.1.5), evaluated for every Voronoi region and then
+// selected per lane
+simd::Float4 squaredDistance(const std::array<Vec3x4, 3> &triangle,
+                             const Vec3x4 &p) {
+  const auto &[a, b, c]{triangle};
+  const auto zero{simd::broadcast(0.0f)};
+  const auto one{simd::broadcast(1.0f)};
+
+  const auto ab{b - a};
+  const auto ac{c - a};
+  const auto ap{p - a};
+  const auto bp{p - b};
+  const auto cp{p - c};
+  const auto d1{dot(ab, ap)};
+  const auto d2{dot(ac, ap)};
+  const auto d3{dot(ab, bp)};
+  const auto d4{dot(ac, bp)};
+  const auto d5{dot(ab, cp)};
+  const auto d6{dot(ac, cp)};
+  const auto va{d3 * d6 - d5 * d4};
+  const auto vb{d5 * d2 - d1 * d6};
+  const auto vc{d1 * d4 - d3 * d2};
+
+  // Interior: barycentric coordinates (v, w) of the closest point
+  const auto denominator{one / (va + vb + vc)};
+  auto v{vb * denominator};
+  auto w{vc * denominator};
+
+  // Regions are applied from the lowest to the highest priority
+  const auto d43{d4 - d3};
+  const auto d56{d5 - d6};
+  const auto inBC{simd::bitAnd(lessEqual(va, zero),
+                               simd::bitAnd(simd::greaterEqual(d43, zero),
+                                            simd::greaterEqual(d56, zero)))};
+  const auto tBC{d43 / (d43 + d56)};
+  v = simd::select(inBC, one - tBC, v);
+  w = simd::select(inBC, tBC, w);
+
+  const auto inAC{simd::bitAnd(lessEqual(vb, zero),
+                               simd::bitAnd(simd::greaterEqual(d2, zero),
+                                            lessEqual(d6, zero)))};
+  v = simd::select(inAC, zero, v);
+  w = simd::select(inAC, d2 / (d2 - d6), w);
+
+  const auto inC{
+      simd::bitAnd(simd::greaterEqual(d6, zero), lessEqual(d5, d6))};
+  v = simd::select(inC, zero, v);
+  w = simd::select(inC, one, w);
+
+  const auto inAB{simd::bitAnd(lessEqual(vc, zero),
+                               simd::bitAnd(simd::greaterEqual(d1, zero),
+                                            lessEqual(d3, zero)))};
+  v = simd::select(inAB, d1 / (d1 - d3), v);
+  w = simd::select(inAB, zero, w);
+
+  const auto inB{
+      simd::bitAnd(simd::greaterEqual(d3, zero), lessEqual(d4, d3))};
+  v = simd::select(inB, one, v);
+  w = simd::select(inB, zero, w);
+
+  const auto inA{simd::bitAnd(lessEqual(d1, zero), lessEqual(d2, zero))};
+  v = simd::select(inA, zero, v);
+  w = simd::select(inA, zero, w);
+
+  const Vec3x4 closest{a.x + ab.x * v + ac.x * w, a.y + ab.y * v + ac.y * w,
+                       a.z + ab.z * v + ac.z * w};
+  const auto d{p - closest};
+  return dot(d, d);
+}
+
+// Separating axis test of one triangle against each triangle of the pack:
+// the two face normals and the nine edge cross products. Returns the mask of
+// separated lanes.
+simd::Float4 separated(const std::array<Vec3x4, 3> &triangle,
+                       const std::array<Vec3x4, 3> &pack) {
+  const auto isSeparatedOn{[&](const Vec3x4 &axis) {
+    const auto t0{dot(axis, triangle[0])};
+    const auto t1{dot(axis, triangle[1])};
+    const auto t2{dot(axis, triangle[2])};
+    const auto p0{dot(axis, pack[0])};
+    const auto p1{dot(axis, pack[1])};
+    const auto p2{dot(axis, pack[2])};
+    const auto triangleMin{simd::min(simd::min(t0, t1), t2)};
+    const auto triangleMax{simd::max(simd::max(t0, t1), t2)};
+    const auto packMin{simd::min(simd::min(p0, p1), p2)};
+    const auto packMax{simd::max(simd::max(p0, p1), p2)};
+    return simd::bitOr(simd::lessThan(triangleMax, packMin),
+                       simd::lessThan(packMax, triangleMin));
+  }};
+
+  const std::array triangleEdges{triangle[1] - triangle[0],
+                                 triangle[2] - triangle[1],
+                                 triangle[0] - triangle[2]};
+  const std::array packEdges{pack[1] - pack[0], pack[2] - pack[1],
+                             pack[0] - pack[2]};
+
+  auto result{isSeparatedOn(cross(triangleEdges[0], triangleEdges[1]))};
+  result = simd::bitOr(result,
+                       isSeparatedOn(cross(packEdges[0], packEdges[1])));
+  for (const auto &triangleEdge : triangleEdges) {
+    for (const auto &packEdge : packEdges) {
+      result = simd::bitOr(result, isSeparatedOn(cross(triangleEdge, packEdge)));
+    }
+  }
+  return result;
+}
+
+class Builder {
+ public:
+  Builder(std::vector<BuildTriangle> &triangles,
+          std::span<const glm::vec3> positions,
+          std::span<const std::uint32_t> indices)
+      : m_triangles{triangles}, m_positions{positions}, m_indices{indices} {}
+
+  template <typename TNode, typename TPack>
+  std::uint32_t build(std::vector<TNode> &nodes, std::vector<TPack> &packs,
+                      std::size_t begin, std::size_t end, std::size_t depth) {
+    const auto nodeIndex{static_cast<std::uint32_t>(nodes.size())};
+    nodes.emplace_back();
+
+    auto bounds{makeEmptyBox()};
+    auto centroidBounds{makeEmptyBox()};
+    for (std::size_t index{begin}; index < end; ++index) {
+      const auto &triangle{m_triangles[index]};
+      grow(bounds, triangle.bounds);
+      grow(centroidBounds, {triangle.centroid, triangle.centroid});
+    }
+    nodes[nodeIndex].bounds = bounds;
+
+    const auto count{end - begin};
+    if (count <= maxLeafTriangles) {
+      nodes[nodeIndex].index = static_cast<std::uint32_t>(packs.size());
+      nodes[nodeIndex].count = static_cast<std::uint32_t>(count);
+      auto &pack{packs.emplace_back()};
+      for (std::size_t lane{}; lane < maxLeafTriangles; ++lane) {
+        const auto &triangle{m_triangles[begin + std::min(lane, count - 1)]};
+        for (std::size_t vertex{}; vertex < 3; ++vertex) {
+          const auto &position{
+              m_positions[m_indices[triangle.index * 3 + vertex]]};
+          for (glm::length_t axis{}; axis < 3; ++axis) {
+            pack.coordinates.at(vertex * 3 + static_cast<std::size_t>(axis))
+                .at(lane) = position[axis];
+          }
+        }
+      }
+      return nodeIndex;
+    }
+
+    const auto middle{
+        split(begin, end, centroidBounds, depth < maxSAHDepth)};
+    build(nodes, packs, begin, middle, depth + 1);
+    const auto right{build(nodes, packs, middle, end, depth + 1)};
+    nodes[nodeIndex].index = right;
+    return nodeIndex;
+  }
+
+ private:
+  std::vector<BuildTriangle> &m_triangles;
+  std::span<const glm::vec3> m_positions;
+  std::span<const std::uint32_t> m_indices;
+
+  // Returns the partition point of [begin, end): binned SAH if useSAH is
+  // true, median of the largest centroid axis otherwise or when the SAH
+  // cannot separate the triangles
+  std::size_t split(std::size_t begin, std::size_t end,
+                    const abcg::BoundingBox &centroidBounds, bool useSAH) {
+    const auto extent{centroidBounds.extent()};
+    auto largestAxis{glm::length_t{0}};
+    if (extent.y > extent[largestAxis]) largestAxis = 1;
+    if (extent.z > extent[largestAxis]) largestAxis = 2;
+
+    if (useSAH) {
+      struct Bin {
+        abcg::BoundingBox bounds{makeEmptyBox()};
+        std::size_t count{};
+      };
+      auto bestCost{std::numeric_limits<float>::max()};
+      auto bestAxis{glm::length_t{-1}};
+      std::size_t bestBin{};
+
+      for (glm::length_t axis{}; axis < 3; ++axis) {
+        if (extent[axis] <= 0.0f) continue;
+        const auto scale{static_cast<float>(numBins) / extent[axis]};
+        std::array<Bin, numBins> bins{};
+        for (std::size_t index{begin}; index < end; ++index) {
+          const auto &triangle{m_triangles[index]};
+          auto &bin{bins.at(getBin(triangle.centroid[axis],
+                                   centroidBounds.min[axis], scale))};
+          grow(bin.bounds, triangle.bounds);
+          ++bin.count;
+        }
+
+        // Sweep from the right to accumulate the cost of the right side
+        std::array<float, numBins> rightCosts{};
+        auto rightBounds{makeEmptyBox()};
+        std::size_t rightCount{};
+        for (auto bin{numBins - 1}; bin > 0; --bin) {
+          grow(rightBounds, bins.at(bin).bounds);
+          rightCount += bins.at(bin).count;
+          rightCosts.at(bin) = rightCount == 0
+                                   ? 0.0f
+                                   : getSurfaceArea(rightBounds) *
+                                         static_cast<float>(rightCount);
+        }
+        auto leftBounds{makeEmptyBox()};
+        std::size_t leftCount{};
+        for (std::size_t bin{}; bin < numBins - 1; ++bin) {
+          grow(leftBounds, bins.at(bin).bounds);
+          leftCount += bins.at(bin).count;
+          if (leftCount == 0 || leftCount == end - begin) continue;
+          const auto cost{getSurfaceArea(leftBounds) *
+                              static_cast<float>(leftCount) +
+                          rightCosts.at(bin + 1)};
+          if (cost < bestCost) {
+            bestCost = cost;
+            bestAxis = axis;
+            bestBin = bin;
+          }
+        }
+      }
+
+      if (bestAxis >= 0) {
+        const auto scale{static_cast<float>(numBins) / extent[bestAxis]};
+        const auto minimum{centroidBounds.min[bestAxis]};
+        const auto middle{std::partition(
+            m_triangles.begin() + static_cast<std::ptrdiff_t>(begin),
+            m_triangles.begin() + static_cast<std::ptrdiff_t>(end),
+            [&](const BuildTriangle &triangle) {
+              return getBin(triangle.centroid[bestAxis], minimum, scale) <=
+                     bestBin;
+            })};
+        return static_cast<std::size_t>(middle - m_triangles.begin());
+      }
+    }
+
+    const auto middle{begin + (end - begin) / 2};
+    std::nth_element(
+        m_triangles.begin() + static_cast<std::ptrdiff_t>(begin),
+        m_triangles.begin() + static_cast<std::ptrdiff_t>(middle),
+        m_triangles.begin() + static_cast<std::ptrdiff_t>(end),
+        [largestAxis](const BuildTriangle &lhs, const BuildTriangle &rhs) {
+          return lhs.centroid[largestAxis] < rhs.centroid[largestAxis];
+        });
+    return middle;
+  }
+
+  static std::size_t getBin(float value, float minimum, float scale) {
+    const auto bin{static_cast<std::size_t>(
+        std::max(0.0f, (value - minimum) * scale))};
+    return std::min(bin, numBins - 1);
+  }
+};
+}  // namespace
+
+/**
+ * @brief Builds the hierarchy over the triangles of an indexed mesh.
+ *
+ * @param positions Vertex positions.
+ * @param indices Vertex indices, three per triangle.
+ *
+ * @throw abcg::Exception if the number of indices is not a multiple of 3 or
+ * an index is out of range.
+ */
+void abcg::TriangleBVH::build(std::span<const glm::vec3> positions,
+                              std::span<const std::uint32_t> indices) {
+  clear();
+  if (indices.size() % 3 != 0 ||
+      std::any_of(indices.begin(), indices.end(), [&](std::uint32_t index) {
+        return index >= positions.size();
+      })) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Invalid triangle mesh for BVH")};
+  }
+  m_numTriangles = indices.size() / 3;
+  if (m_numTriangles == 0) return;
+
+  std::vector<BuildTriangle> triangles(m_numTriangles);
+  for (std::size_t index{}; index < m_numTriangles; ++index) {
+    const auto &a{positions[indices[index * 3 + 0]]};
+    const auto &b{positions[indices[index * 3 + 1]]};
+    const auto &c{positions[indices[index * 3 + 2]]};
+    auto &triangle{triangles[index]};
+    triangle.bounds = {glm::min(a, glm::min(b, c)),
+                       glm::max(a, glm::max(b, c))};
+    triangle.centroid = (a + b + c) / 3.0f;
+    triangle.index = static_cast<std::uint32_t>(index);
+  }
+
+  m_nodes.reserve(m_numTriangles * 2 / maxLeafTriangles + 1);
+  m_packs.reserve(m_numTriangles / maxLeafTriangles + 1);
+  Builder builder{triangles, positions, indices};
+  builder.build(m_nodes, m_packs, 0, m_numTriangles, 0);
+}
+
+void abcg::TriangleBVH::clear() {
+  m_nodes.clear();
+  m_packs.clear();
+  m_numTriangles = 0;
+}
+
+abcg::BoundingBox abcg::TriangleBVH::getBounds() const {
+  return m_nodes.empty() ? BoundingBox{} : m_nodes.front().bounds;
+}
+
+/**
+ * @brief Checks whether the mesh intersects a sphere.
+ *
+ * @param sphereCenter Center of the sphere in the local space of the mesh.
+ * @param radius Radius of the sphere in the local space of the mesh.
+ * @return true if any triangle is within radius of the center.
+ */
+bool abcg::TriangleBVH::intersectsSphere(const glm::vec3 &sphereCenter,
+                                         float radius) const {
+  if (m_nodes.empty()) return false;
+
+  const auto center4{broadcast(sphereCenter)};
+  const auto radius4{simd::broadcast(radius * radius)};
+
+  std::array<std::uint32_t, maxStackSize> stack{};
+  std::size_t stackSize{};
+  stack.at(stackSize++) = 0;
+  while (stackSize > 0) {
+    const auto &node{m_nodes[stack.at(--stackSize)]};
+    if (!node.bounds.overlaps(sphereCenter, radius)) continue;
+    if (node.count > 0) {
+      const auto pack{loadPack(m_packs[node.index].coordinates)};
+      const auto inside{lessEqual(squaredDistance(pack, center4), radius4)};
+      if (simd::moveMask(inside) != 0) return true;
+      continue;
+    }
+    const auto nodeIndex{static_cast<std::uint32_t>(&node - m_nodes.data())};
+    stack.at(stackSize++) = node.index;
+    stack.at(stackSize++) = nodeIndex + 1;
+  }
+  return false;
+}
+
+/**
+ * @brief Checks whether the mesh intersects another mesh.
+ *
+ * Both hierarchies are traversed simultaneously, descending into the node
+ * with the larger surface area. Leaf pairs are tested triangle against four
+ * triangles.
+ *
+ * @param other Hierarchy of the other mesh.
+ * @param otherToThis Affine transform from the local space of the other mesh
+ * to the local space of this mesh.
+ * @return true if any pair of triangles intersects.
+ */
+bool abcg::TriangleBVH::intersects(const TriangleBVH &other,
+                                   const glm::mat4 &otherToThis) const {
+  if (m_nodes.empty() || other.m_nodes.empty()) return false;
+
+  std::array<std::pair<std::uint32_t, std::uint32_t>, maxStackSize> stack{};
+  std::size_t stackSize{};
+  stack.at(stackSize++) = {0, 0};
+  while (stackSize > 0) {
+    const auto [thisIndex, otherIndex]{stack.at(--stackSize)};
+    const auto &thisNode{m_nodes[thisIndex]};
+    const auto &otherNode{other.m_nodes[otherIndex]};
+    const auto otherBounds{transformBox(otherNode.bounds, otherToThis)};
+    if (!thisNode.bounds.overlaps(otherBounds)) continue;
+
+    const bool thisLeaf{thisNode.count > 0};
+    const bool otherLeaf{otherNode.count > 0};
+    if (thisLeaf && otherLeaf) {
+      const auto pack{loadPack(m_packs[thisNode.index].coordinates)};
+      const auto &otherPack{other.m_packs[otherNode.index].coordinates};
+      for (std::size_t lane{}; lane < otherNode.count; ++lane) {
+        std::array<Vec3x4, 3> triangle{};
+        for (std::size_t vertex{}; vertex < 3; ++vertex) {
+          const glm::vec4 position{otherPack.at(vertex * 3 + 0).at(lane),
+                                   otherPack.at(vertex * 3 + 1).at(lane),
+                                   otherPack.at(vertex * 3 + 2).at(lane),
+                                   1.0f};
+          triangle.at(vertex) = broadcast(glm::vec3(otherToThis * position));
+        }
+        if (simd::moveMask(separated(triangle, pack)) != 0xF) return true;
+      }
+      continue;
+    }
+
+    if (otherLeaf || (!thisLeaf && getSurfaceArea(thisNode.bounds) >=
+                                       getSurfaceArea(otherBounds))) {
+      stack.at(stackSize++) = {thisNode.index, otherIndex};
+      stack.at(stackSize++) = {thisIndex + 1, otherIndex};
+    } else {
+      stack.at(stackSize++) = {thisIndex, otherNode.index};
+      stack.at(stackSize++) = {thisIndex, otherIndex + 1};
+    }
+  }
+  return false;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file abcg_trianglebvh.hpp
+ * @brief abcg::TriangleBVH header file.
+ *
+ * Declaration of abcg::TriangleBVH, a bounding volume hierarchy over the
+ * triangles of an indexed mesh for exact collision queries.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_TRIANGLEBVH_HPP_
+#define ABCG_TRIANGLEBVH_HPP_
+
+#include <array>
+#include <cstdint>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <span>
+#include <vector>
+
+#include "abcg_boundingbox.hpp"
+
+namespace abcg {
+class TriangleBVH;
+}  // namespace abcg
+
+/**
+ * @brief abcg::TriangleBVH class.
+ *
+ * The hierarchy is built top-down with the surface area heuristic evaluated
+ * over a fixed number of bins per axis. Each leaf holds up to four
+ * triangles stored as a structure of arrays, so that leaf tests run on four
+ * triangles at once with abcg::simd.
+ *
+ * Queries are expressed in the local space of the mesh. Triangle/triangle
+ * tests use the separating axis theorem; coplanar triangles are
+ * conservatively reported as intersecting when their planes coincide.
+ *
+ * The class does not issue any OpenGL call and can be used headless.
+ */
+class abcg::TriangleBVH {
+ public:
+  void build(std::span<const glm::vec3> positions,
+             std::span<const std::uint32_t> indices);
+  void clear();
+
+  [[nodiscard]] bool intersectsSphere(const glm::vec3 &sphereCenter,
+                                      float radius) const;
+  [[nodiscard]] bool intersects(const TriangleBVH &other,
+                                const glm::mat4 &otherToThis) const;
+
+  [[nodiscard]] bool empty() const { return m_nodes.empty(); }
+  [[nodiscard]] BoundingBox getBounds() const;
+  [[nodiscard]] std::size_t getNumNodes() const { return m_nodes.size(); }
+  [[nodiscard]] std::size_t getNumTriangles() const { return m_numTriangles; }
+
+ private:
+  // Internal nodes have count == 0; their left child follows them and
+  // index is the right child. Leaves have count > 0 and index is the pack.
+  struct Node {
+    BoundingBox bounds{};
+    std::uint32_t index{};
+    std::uint32_t count{};
+  };
+
+  // Up to four triangles, one per lane. Unused lanes repeat the last
+  // triangle.
+  struct TrianglePack {
+    std::array<std::array<float, 4>, 9> coordinates{};
+  };
+
+  std::vector<Node> m_nodes;
+  std::vector<TrianglePack> m_packs;
+  std::size_t m_numTriangles{};
+};
+
+#endif
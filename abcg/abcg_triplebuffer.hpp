@@ -0,0 +1,89 @@
+/**
+ * @file abcg_triplebuffer.hpp
+ * @brief abcg::TripleBuffer header file.
+ *
+ * Declaration and definition of abcg::TripleBuffer, a lock-free handoff of
+ * snapshots from one writer thread to one reader thread.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_TRIPLEBUFFER_HPP_
+#define ABCG_TRIPLEBUFFER_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace abcg {
+template <typename T>
+class TripleBuffer;
+}  // namespace abcg
+
+/**
+ * @brief abcg::TripleBuffer class template.
+ *
+ * The writer fills its own buffer and publishes it; the reader takes the
+ * most recently published buffer. The third buffer sits between them and
+ * is swapped atomically, so neither side ever blocks or sees a partially
+ * written snapshot. Snapshots published while the reader is busy are
+ * overwritten by newer ones.
+ *
+ * The buffer returned by abcg::TripleBuffer::getWriteBuffer holds an older
+ * snapshot and must be fully rewritten before being published. Containers
+ * in T keep their capacity across snapshots.
+ *
+ * A single thread may act as both writer and reader.
+ */
+template <typename T>
+class abcg::TripleBuffer {
+ public:
+  /**
+   * @brief Returns the buffer being written. Writer only.
+   */
+  [[nodiscard]] T &getWriteBuffer() noexcept { return m_buffers[m_writeIndex]; }
+
+  /**
+   * @brief Makes the write buffer the latest snapshot. Writer only.
+   */
+  void publish() noexcept {
+    const auto previous{
+        m_middle.exchange(m_writeIndex | fresh, std::memory_order_acq_rel)};
+    m_writeIndex = previous & indexMask;
+  }
+
+  /**
+   * @brief Takes the latest snapshot, if one was published since the last
+   * call. Reader only.
+   *
+   * @return true if the read buffer changed.
+   */
+  bool update() noexcept {
+    if ((m_middle.load(std::memory_order_relaxed) & fresh) == 0) return false;
+    const auto previous{
+        m_middle.exchange(m_readIndex, std::memory_order_acq_rel)};
+    m_readIndex = previous & indexMask;
+    return true;
+  }
+
+  /**
+   * @brief Returns the snapshot taken by the last update. Reader only.
+   */
+  [[nodiscard]] const T &getReadBuffer() const noexcept {
+    return m_buffers[m_readIndex];
+  }
+
+ private:
+  // The middle index carries a flag set by publish and cleared by update
+  static constexpr std::uint8_t indexMask{0x3};
+  static constexpr std::uint8_t fresh{0x4};
+
+  std::array<T, 3> m_buffers{};
+
+  // Each index is owned by one side; kept apart to avoid false sharing
+  alignas(64) std::uint8_t m_writeIndex{0};
+  alignas(64) std::atomic<std::uint8_t> m_middle{1};
+  alignas(64) std::uint8_t m_readIndex{2};
+};
+
+#endif
@@ -0,0 +1,117 @@
+/**
+ * @file abcg_vertexlayout.cpp
+ * @brief Definition of the run-time vertex layout helpers.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_vertexlayout.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace {
+// Number of consecutive locations taken by an attribute of the given type
+GLint getNumColumns(GLenum type) {
+  switch (type) {
+    case GL_FLOAT_MAT2:
+    case GL_FLOAT_MAT2x3:
+    case GL_FLOAT_MAT2x4:
+      return 2;
+    case GL_FLOAT_MAT3:
+    case GL_FLOAT_MAT3x2:
+    case GL_FLOAT_MAT3x4:
+      return 3;
+    case GL_FLOAT_MAT4:
+    case GL_FLOAT_MAT4x2:
+    case GL_FLOAT_MAT4x3:
+      return 4;
+    default:
+      return 1;
+  }
+}
+
+std::size_t alignUp(std::size_t value, std::size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+}  // namespace
+
+/**
+ * @brief Returns the attribute locations read by a linked program.
+ *
+ * Attributes optimized out by the shader compiler are not active and thus
+ * not reported. Built-in attributes (gl_VertexID, etc.) are ignored.
+ *
+ * @param program Linked program.
+ * @return Bit mask where bit i is set if location i is active.
+ */
+std::uint32_t abcg::getActiveAttributeMask(GLuint program) {
+  GLint numAttributes{};
+  glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &numAttributes);
+  GLint maxLength{};
+  glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+
+  std::string name(static_cast<std::size_t>(std::max(maxLength, 1)), '\0');
+  std::uint32_t mask{};
+  for (GLint index{}; index < numAttributes; ++index) {
+    GLsizei length{};
+    GLint size{};
+    GLenum type{};
+    glGetActiveAttrib(program, static_cast<GLuint>(index), maxLength, &length,
+                      &size, &type, name.data());
+    const auto location{glGetAttribLocation(program, name.c_str())};
+    if (location < 0) continue;
+
+    const auto numLocations{size * getNumColumns(type)};
+    for (GLint offset{}; offset < numLocations; ++offset) {
+      if (location + offset < 32) mask |= 1U << (location + offset);
+    }
+  }
+  return mask;
+}
+
+/**
+ * @brief Copies the active attributes of interleaved vertex data into a
+ * tightly packed, interleaved buffer.
+ *
+ * Attributes keep their relative order and alignment. The packed stride is
+ * rounded up to a multiple of 4 bytes.
+ *
+ * @param vertices Source vertex data.
+ * @param stride Stride of the source vertex data.
+ * @param attributes Layout of a source vertex.
+ * @param activeMask Attribute locations to keep.
+ * @return Packed data and the layout of a packed vertex.
+ */
+abcg::PackedVertexData abcg::packVertexData(
+    std::span<const std::byte> vertices, std::size_t stride,
+    std::span<const VertexAttribute> attributes, std::uint32_t activeMask) {
+  PackedVertexData packed;
+  std::vector<std::size_t> sourceOffsets;
+  std::size_t alignment{4};
+  for (const auto &attribute : attributes) {
+    if (!isAttributeActive(attribute, activeMask)) continue;
+    sourceOffsets.push_back(attribute.offset);
+    auto packedAttribute{attribute};
+    packedAttribute.offset = alignUp(packed.stride, attribute.alignment);
+    packed.stride = packedAttribute.offset + attribute.byteSize;
+    alignment = std::max(alignment, attribute.alignment);
+    packed.attributes.push_back(packedAttribute);
+  }
+  packed.stride = alignUp(packed.stride, alignment);
+  if (packed.attributes.empty() || stride == 0) return packed;
+
+  const auto numVertices{vertices.size() / stride};
+  packed.data.resize(numVertices * packed.stride);
+  for (std::size_t vertex{}; vertex < numVertices; ++vertex) {
+    const auto *source{vertices.data() + vertex * stride};
+    auto *destination{packed.data.data() + vertex * packed.stride};
+    for (std::size_t index{}; index < packed.attributes.size(); ++index) {
+      const auto &attribute{packed.attributes[index]};
+      std::memcpy(destination + attribute.offset,
+                  source + sourceOffsets[index], attribute.byteSize);
+    }
+  }
+  return packed;
+}
@@ -0,0 +1,291 @@
+/**
+ * @file abcg_vertexlayout.hpp
+ * @brief Compile-time vertex layout descriptions.
+ *
+ * A vertex layout is declared once per vertex (or per-instance) structure by
+ * specializing abcg::VertexLayout with a constexpr array of
+ * abcg::VertexAttribute. The layout is validated at compile time and drives
+ * the glVertexAttribPointer calls issued by abcg::setupVertexAttributes.
+ *
+ * At run time, abcg::packVertices uses the attributes actually read by a
+ * program to build a trimmed copy of the vertex data, so that unused streams
+ * are neither uploaded nor fetched.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_VERTEXLAYOUT_HPP_
+#define ABCG_VERTEXLAYOUT_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/gtc/type_precision.hpp>
+#include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "abcg_openglfunctions.hpp"
+
+namespace abcg {
+struct VertexAttribute;
+template <typename T>
+struct VertexAttributeFormat;
+template <typename TVertex>
+struct VertexLayout;
+struct PackedVertexData;
+
+std::uint32_t getActiveAttributeMask(GLuint program);
+PackedVertexData packVertexData(std::span<const std::byte> vertices,
+                                std::size_t stride,
+                                std::span<const VertexAttribute> attributes,
+                                std::uint32_t activeMask);
+}  // namespace abcg
+
+/**
+ * @brief Description of one vertex attribute.
+ *
+ * Matrix attributes span one location per column.
+ */
+struct abcg::VertexAttribute {
+  GLuint location{};
+  GLint size{};
+  GLenum type{};
+  bool normalized{};
+  bool integer{};
+  GLuint columns{1};
+  std::size_t offset{};
+  std::size_t byteSize{};
+  std::size_t alignment{};
+
+  /**
+   * @brief Size in bytes of a single column.
+   */
+  [[nodiscard]] constexpr std::size_t columnSize() const {
+    return byteSize / columns;
+  }
+};
+
+/**
+ * @brief Vertex data trimmed to the attributes read by a program.
+ *
+ * Attribute offsets are relative to the packed vertex.
+ */
+struct abcg::PackedVertexData {
+  std::vector<std::byte> data;
+  std::vector<VertexAttribute> attributes;
+  std::size_t stride{};
+};
+
+namespace abcg::detail {
+template <typename TComponent, GLenum Type, GLint Size, GLuint Columns = 1>
+struct VertexAttributeFormatBase {
+  using Component = TComponent;
+  static constexpr GLenum type{Type};
+  static constexpr GLint size{Size};
+  static constexpr GLuint columns{Columns};
+  static constexpr bool isInteger{!std::is_floating_point_v<TComponent>};
+};
+}  // namespace abcg::detail
+
+// clang-format off
+template <> struct abcg::VertexAttributeFormat<float>
+    : detail::VertexAttributeFormatBase<float, GL_FLOAT, 1> {};
+template <> struct abcg::VertexAttributeFormat<glm::vec2>
+    : detail::VertexAttributeFormatBase<float, GL_FLOAT, 2> {};
+template <> struct abcg::VertexAttributeFormat<glm::vec3>
+    : detail::VertexAttributeFormatBase<float, GL_FLOAT, 3> {};
+template <> struct abcg::VertexAttributeFormat<glm::vec4>
+    : detail::VertexAttributeFormatBase<float, GL_FLOAT, 4> {};
+template <> struct abcg::VertexAttributeFormat<glm::mat3>
+    : detail::VertexAttributeFormatBase<float, GL_FLOAT, 3, 3> {};
+template <> struct abcg::VertexAttributeFormat<glm::mat4>
+    : detail::VertexAttributeFormatBase<float, GL_FLOAT, 4, 4> {};
+template <> struct abcg::VertexAttributeFormat<glm::u8vec4>
+    : detail::VertexAttributeFormatBase<glm::uint8, GL_UNSIGNED_BYTE, 4> {};
+template <> struct abcg::VertexAttributeFormat<glm::i8vec4>
+    : detail::VertexAttributeFormatBase<glm::int8, GL_BYTE, 4> {};
+template <> struct abcg::VertexAttributeFormat<glm::u16vec2>
+    : detail::VertexAttributeFormatBase<glm::uint16, GL_UNSIGNED_SHORT, 2> {};
+template <> struct abcg::VertexAttributeFormat<glm::u16vec4>
+    : detail::VertexAttributeFormatBase<glm::uint16, GL_UNSIGNED_SHORT, 4> {};
+template <> struct abcg::VertexAttributeFormat<glm::i16vec2>
+    : detail::VertexAttributeFormatBase<glm::int16, GL_SHORT, 2> {};
+template <> struct abcg::VertexAttributeFormat<glm::i16vec4>
+    : detail::VertexAttributeFormatBase<glm::int16, GL_SHORT, 4> {};
+template <> struct abcg::VertexAttributeFormat<GLuint>
+    : detail::VertexAttributeFormatBase<GLuint, GL_UNSIGNED_INT, 1> {};
+template <> struct abcg::VertexAttributeFormat<GLint>
+    : detail::VertexAttributeFormatBase<GLint, GL_INT, 1> {};
+// clang-format on
+
+namespace abcg {
+/**
+ * @brief Creates the description of an attribute of type TField.
+ *
+ * Integer fields that are not normalized are fetched as integers
+ * (glVertexAttribIPointer). Normalized integer fields are fetched as floats.
+ *
+ * @tparam TField Type of the field in the vertex structure.
+ * @param location Attribute location (first column for matrices).
+ * @param offset Offset of the field, usually given with offsetof.
+ * @param normalized Whether integer data is normalized to [0,1] or [-1,1].
+ * @return Attribute description.
+ */
+template <typename TField>
+constexpr VertexAttribute makeVertexAttribute(GLuint location,
+                                              std::size_t offset,
+                                              bool normalized = false) {
+  using Format = VertexAttributeFormat<TField>;
+  using Component = typename Format::Component;
+  static_assert(sizeof(TField) == sizeof(Component) *
+                                      static_cast<std::size_t>(Format::size) *
+                                      Format::columns,
+                "Vertex attribute type must be tightly packed");
+  return {.location = location,
+          .size = Format::size,
+          .type = Format::type,
+          .normalized = normalized,
+          .integer = Format::isInteger && !normalized,
+          .columns = Format::columns,
+          .offset = offset,
+          .byteSize = sizeof(TField),
+          .alignment = alignof(Component)};
+}
+
+/**
+ * @brief Checks at compile time the layout of TVertex.
+ *
+ * Attributes must be aligned to their component type, lie within the stride
+ * (sizeof(TVertex)) and must not overlap in memory nor in locations. The
+ * stride must be a multiple of 4 bytes.
+ *
+ * @return true if the layout is valid.
+ */
+template <typename TVertex>
+constexpr bool isValidVertexLayout() {
+  constexpr auto &attributes{VertexLayout<TVertex>::attributes};
+  if (sizeof(TVertex) % 4 != 0) return false;
+  for (std::size_t i{}; i < attributes.size(); ++i) {
+    const auto &a{attributes[i]};
+    if (a.offset % a.alignment != 0) return false;
+    if (a.offset + a.byteSize > sizeof(TVertex)) return false;
+    for (std::size_t j{i + 1}; j < attributes.size(); ++j) {
+      const auto &b{attributes[j]};
+      if (a.offset < b.offset + b.byteSize && b.offset < a.offset + a.byteSize)
+        return false;
+      if (a.location < b.location + b.columns &&
+          b.location < a.location + a.columns)
+        return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Number of bytes of TVertex actually used by attributes.
+ */
+template <typename TVertex>
+constexpr std::size_t getVertexLayoutSize() {
+  std::size_t size{};
+  for (const auto &attribute : VertexLayout<TVertex>::attributes) {
+    size += attribute.byteSize;
+  }
+  return size;
+}
+
+/**
+ * @brief Enables and specifies one attribute for the currently bound
+ * GL_ARRAY_BUFFER and vertex array object.
+ *
+ * @param attribute Attribute description.
+ * @param stride Distance in bytes between consecutive elements.
+ * @param offset Offset of the attribute within the buffer.
+ * @param divisor Instance divisor (0 for per-vertex data).
+ */
+inline void setupVertexAttribute(const VertexAttribute &attribute,
+                                 GLsizei stride, std::size_t offset,
+                                 GLuint divisor = 0) {
+  for (GLuint column{}; column < attribute.columns; ++column) {
+    const auto location{attribute.location + column};
+    // NOLINTNEXTLINE(performance-no-int-to-ptr)
+    const auto *pointer{reinterpret_cast<const void *>(
+        offset + column * attribute.columnSize())};
+    glEnableVertexAttribArray(location);
+    if (attribute.integer) {
+      glVertexAttribIPointer(location, attribute.size, attribute.type, stride,
+                             pointer);
+    } else {
+      glVertexAttribPointer(location, attribute.size, attribute.type,
+                            attribute.normalized ? GL_TRUE : GL_FALSE, stride,
+                            pointer);
+    }
+    glVertexAttribDivisor(location, divisor);
+  }
+}
+
+/**
+ * @brief Enables and specifies all attributes of TVertex for the currently
+ * bound GL_ARRAY_BUFFER and vertex array object.
+ *
+ * @tparam TVertex Vertex type with a specialization of abcg::VertexLayout.
+ * @param divisor Instance divisor (0 for per-vertex data, 1 for per-instance
+ * data).
+ */
+template <typename TVertex>
+void setupVertexAttributes(GLuint divisor = 0) {
+  static_assert(isValidVertexLayout<TVertex>(), "Invalid vertex layout");
+  for (const auto &attribute : VertexLayout<TVertex>::attributes) {
+    setupVertexAttribute(attribute, sizeof(TVertex), attribute.offset,
+                         divisor);
+  }
+}
+
+/**
+ * @brief Enables and specifies the attributes of trimmed vertex data for the
+ * currently bound GL_ARRAY_BUFFER and vertex array object.
+ *
+ * @param packed Vertex data created with abcg::packVertices.
+ * @param divisor Instance divisor (0 for per-vertex data).
+ */
+inline void setupVertexAttributes(const PackedVertexData &packed,
+                                  GLuint divisor = 0) {
+  for (const auto &attribute : packed.attributes) {
+    setupVertexAttribute(attribute, static_cast<GLsizei>(packed.stride),
+                         attribute.offset, divisor);
+  }
+}
+
+/**
+ * @brief Checks whether any location of an attribute is set in a mask
+ * returned by abcg::getActiveAttributeMask.
+ */
+constexpr bool isAttributeActive(const VertexAttribute &attribute,
+                                 std::uint32_t activeMask) {
+  for (GLuint column{}; column < attribute.columns; ++column) {
+    const auto location{attribute.location + column};
+    if (location < 32 && (activeMask & (1U << location)) != 0) return true;
+  }
+  return false;
+}
+
+/**
+ * @brief Copies the attributes of TVertex that are set in activeMask into a
+ * tightly packed, interleaved buffer.
+ *
+ * @param vertices Source vertices.
+ * @param activeMask Attribute locations to keep, usually given by
+ * abcg::getActiveAttributeMask.
+ * @return Packed data and the layout of a packed vertex.
+ */
+template <typename TVertex>
+PackedVertexData packVertices(std::span<const TVertex> vertices,
+                              std::uint32_t activeMask) {
+  static_assert(isValidVertexLayout<TVertex>(), "Invalid vertex layout");
+  return packVertexData(std::as_bytes(vertices), sizeof(TVertex),
+                        VertexLayout<TVertex>::attributes, activeMask);
+}
+}  // namespace abcg
+
+#endif
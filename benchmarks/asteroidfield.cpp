@@ -0,0 +1,128 @@
+/**
+ * @file asteroidfield.cpp
+ * @brief Benchmark of the sphere queries of the asteroid field of the
+ * example.
+ *
+ * Fills an AsteroidField of the avoidasteroids example with 180 to 1M
+ * asteroids at the density of the example (180 asteroids in a 40 x 40 x 100
+ * corridor) and times sphere queries at random points of it, with the
+ * radius of the ship and with a wider radius. AsteroidField::findOverlaps
+ * tests the candidates of its spatial hash against the bounding spheres
+ * four at a time; the reference queries an abcg::SpatialHash of the same
+ * boxes and tests the candidates one at a time. Both must find the same
+ * asteroids.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include <fmt/core.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "abcg_spatialhash.hpp"
+#include "asteroidfield.hpp"
+#include "benchmark.hpp"
+
+namespace {
+// Corridor cross section, and its volume per asteroid
+constexpr float corridorWidth{40.0f};
+constexpr float volumePerAsteroid{corridorWidth * corridorWidth * 100.0f /
+                                  180.0f};
+
+constexpr float asteroidRadius{1.2f};
+
+// Query points, reused by every run
+constexpr std::size_t numQueries{1024};
+
+// Scalar sphere test of the candidates of a box query
+void queryScalar(const abcg::SpatialHash &hash, const AsteroidField &field,
+                 const glm::vec3 &center, float radius,
+                 std::vector<std::size_t> &result) {
+  hash.query(abcg::BoundingBox::fromSphere(center, radius), result);
+  const auto reach{radius + asteroidRadius};
+  std::erase_if(result, [&](std::size_t index) {
+    const auto delta{field.getPosition(index) - center};
+    return glm::dot(delta, delta) > reach * reach;
+  });
+}
+}  // namespace
+
+int main(int /*argc*/, char * /*argv*/[]) {
+  fmt::print("{:>10} {:>8} {:>12} {:>8} {:>16} {:>16}\n", "asteroids",
+             "radius", "candidates", "hits", "SIMD (ns/query)",
+             "scalar (ns/query)");
+  for (const std::size_t count : {180U, 10'000U, 100'000U, 1'000'000U}) {
+    const auto length{static_cast<float>(count) * volumePerAsteroid /
+                      (corridorWidth * corridorWidth)};
+    const abcg::BoundingBox bounds{
+        {-corridorWidth / 2.0f, -corridorWidth / 2.0f, -length},
+        {corridorWidth / 2.0f, corridorWidth / 2.0f, 0.0f}};
+
+    AsteroidField field;
+    field.resize(count, 1.0f);
+    field.randomize(42, 0, bounds);
+    field.buildIndex(asteroidRadius);
+
+    std::vector<abcg::BoundingBox> boxes(count);
+    for (std::size_t index{}; index < count; ++index) {
+      boxes[index] = abcg::BoundingBox::fromSphere(field.getPosition(index),
+                                                   asteroidRadius);
+    }
+    abcg::SpatialHash hash{4.0f * asteroidRadius};
+    hash.build(boxes);
+
+    std::mt19937 engine{42};
+    std::uniform_real_distribution<float> xy{bounds.min.x, bounds.max.x};
+    std::uniform_real_distribution<float> z{bounds.min.z, bounds.max.z};
+    std::vector<glm::vec3> queries(numQueries);
+    for (auto &query : queries) {
+      query = {xy(engine), xy(engine), z(engine)};
+    }
+
+    // The radius of the ship, and a radius reaching a few cells around it
+    for (const auto radius : {0.5f, 8.0f}) {
+      std::vector<std::size_t> result;
+      std::vector<std::size_t> expected;
+      std::size_t candidates{};
+      std::size_t hits{};
+      std::size_t mismatches{};
+      for (const auto &query : queries) {
+        hash.query(abcg::BoundingBox::fromSphere(query, radius), result);
+        candidates += result.size();
+        field.findOverlaps(query, radius, result);
+        queryScalar(hash, field, query, radius, expected);
+        hits += result.size();
+        if (result != expected) ++mismatches;
+      }
+      if (mismatches > 0) {
+        fmt::print("{} queries differ from the scalar test\n", mismatches);
+        return 1;
+      }
+
+      const auto simdTime{benchmark::measure([&] {
+        std::size_t total{};
+        for (const auto &query : queries) {
+          field.findOverlaps(query, radius, result);
+          total += result.size();
+        }
+        benchmark::keep(total);
+      })};
+      const auto scalarTime{benchmark::measure([&] {
+        std::size_t total{};
+        for (const auto &query : queries) {
+          queryScalar(hash, field, query, radius, result);
+          total += result.size();
+        }
+        benchmark::keep(total);
+      })};
+
+      fmt::print("{:>10} {:>8.1f} {:>12} {:>8} {:>16.1f} {:>16.1f}\n", count,
+                 radius, candidates, hits,
+                 simdTime * 1e9 / static_cast<double>(numQueries),
+                 scalarTime * 1e9 / static_cast<double>(numQueries));
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,45 @@
+/**
+ * @file benchmark.hpp
+ * @brief Timing helpers shared by the benchmarks.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef BENCHMARK_HPP_
+#define BENCHMARK_HPP_
+
+#include <algorithm>
+#include <limits>
+
+#include "abcg_elapsedtimer.hpp"
+
+namespace benchmark {
+// Minimum time spent measuring a function, in seconds
+inline constexpr double minTime{0.25};
+
+// Best time of one call of a function, in seconds. The function is called
+// once to warm up, then repeatedly for at least minTime and three times.
+template <typename TFunction>
+double measure(TFunction &&function) {
+  function();
+  auto best{std::numeric_limits<double>::max()};
+  abcg::ElapsedTimer total;
+  for (int runs{}; runs < 3 || total.elapsed() < minTime; ++runs) {
+    abcg::ElapsedTimer timer;
+    function();
+    best = std::min(best, timer.elapsed());
+  }
+  return best;
+}
+
+// Keeps a result alive, so that the computation of it is not optimized
+// away
+template <typename T>
+void keep(const T &value) {
+  static volatile T sink{};
+  sink = value;
+  static_cast<void>(sink);
+}
+}  // namespace benchmark
+
+#endif
@@ -0,0 +1,132 @@
+/**
+ * @file jobsystem.cpp
+ * @brief Scaling benchmark of abcg::JobSystem.
+ *
+ * Runs the same parallelFor workloads with 1 to N threads (the calling
+ * thread plus 0 to N - 1 workers), where N is the first argument or else
+ * the number of hardware threads:
+ *
+ * - compute: a sine series per element, bound by arithmetic;
+ * - matrices: abcg::computeInstanceMatrices over 1M instances in the
+ *   chunks of the example, bound by memory bandwidth;
+ * - empty jobs: the cost of submitting and running a job.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cmath>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "abcg_jobsystem.hpp"
+#include "abcg_transformbatch.hpp"
+#include "benchmark.hpp"
+
+namespace {
+constexpr std::size_t numElements{1 << 20};
+constexpr std::size_t grainSize{4096};
+constexpr std::size_t numEmptyJobs{100'000};
+
+struct Workload {
+  std::vector<float> input;
+  std::vector<float> output;
+  std::vector<float> positionX, positionY, positionZ;
+  std::vector<float> scale;
+  std::vector<float> axisX, axisY, axisZ;
+  std::vector<abcg::InstanceMatrices> matrices;
+
+  Workload()
+      : input(numElements),
+        output(numElements),
+        positionX(numElements),
+        positionY(numElements),
+        positionZ(numElements),
+        scale(numElements, 1.0f),
+        axisX(numElements),
+        axisY(numElements),
+        axisZ(numElements, 1.0f),
+        matrices(numElements) {
+    for (std::size_t index{}; index < numElements; ++index) {
+      input[index] = static_cast<float>(index % 1000) * 1e-3f;
+      positionX[index] = input[index];
+    }
+  }
+};
+
+void compute(Workload &workload, std::size_t first, std::size_t last) {
+  for (auto index{first}; index < last; ++index) {
+    auto value{workload.input[index]};
+    for (int term{}; term < 16; ++term) {
+      value = std::sin(value) + 0.5f;
+    }
+    workload.output[index] = value;
+  }
+}
+
+void computeMatrices(Workload &workload, std::size_t first,
+                     std::size_t last) {
+  const auto count{last - first};
+  const auto slice{[&](const std::vector<float> &array) {
+    return std::span{array}.subspan(first, count);
+  }};
+  abcg::computeInstanceMatrices(
+      {slice(workload.positionX), slice(workload.positionY),
+       slice(workload.positionZ), slice(workload.scale),
+       slice(workload.axisX), slice(workload.axisY), slice(workload.axisZ)},
+      0.5f, glm::mat4{1.0f},
+      std::span{workload.matrices}.subspan(first, count));
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  Workload workload;
+  const auto maxThreads{std::max<std::size_t>(
+      1, argc > 1 ? std::stoul(argv[1])
+                  : std::thread::hardware_concurrency())};
+
+  fmt::print("{:>8} {:>14} {:>8} {:>14} {:>8} {:>18}\n", "threads",
+             "compute (ms)", "speedup", "matrices (ms)", "speedup",
+             "empty job (ns)");
+  double computeBase{};
+  double matricesBase{};
+  for (std::size_t threads{1}; threads <= maxThreads; ++threads) {
+    abcg::JobSystem jobs{threads - 1};
+
+    const auto computeTime{benchmark::measure([&] {
+      jobs.parallelFor(0, numElements, grainSize,
+                       [&](std::size_t first, std::size_t last) {
+                         compute(workload, first, last);
+                       });
+      benchmark::keep(workload.output.back());
+    })};
+    const auto matricesTime{benchmark::measure([&] {
+      jobs.parallelFor(0, numElements, grainSize,
+                       [&](std::size_t first, std::size_t last) {
+                         computeMatrices(workload, first, last);
+                       });
+      benchmark::keep(workload.matrices.back().modelMatrix[3][0]);
+    })};
+    const auto emptyTime{benchmark::measure([&] {
+      abcg::JobSystem::Counter counter;
+      for (std::size_t job{}; job < numEmptyJobs; ++job) {
+        jobs.run([] {}, &counter);
+      }
+      jobs.wait(counter);
+    })};
+
+    if (threads == 1) {
+      computeBase = computeTime;
+      matricesBase = matricesTime;
+    }
+    fmt::print("{:>8} {:>14.2f} {:>7.2f}x {:>14.2f} {:>7.2f}x {:>18.1f}\n",
+               threads, computeTime * 1e3, computeBase / computeTime,
+               matricesTime * 1e3, matricesBase / matricesTime,
+               emptyTime * 1e9 / static_cast<double>(numEmptyJobs));
+  }
+  return 0;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file random.cpp
+ * @brief Benchmark of the keyed random functions against <random>.
+ *
+ * Spawns 1k, 100k and 1M asteroids: a position in a box and a random
+ * rotation axis each, with std::uniform_real_distribution and
+ * glm::normalize one asteroid at a time, and with abcg::fillUniform and
+ * abcg::fillUnitVectors over the whole field.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include <fmt/core.h>
+
+#include <glm/geometric.hpp>
+#include <glm/vec3.hpp>
+#include <random>
+#include <vector>
+
+#include "abcg_random.hpp"
+#include "benchmark.hpp"
+
+namespace {
+struct Field {
+  std::vector<std::uint64_t> keys;
+  std::vector<float> positionX, positionY, positionZ;
+  std::vector<float> axisX, axisY, axisZ;
+
+  explicit Field(std::size_t count)
+      : keys(count),
+        positionX(count),
+        positionY(count),
+        positionZ(count),
+        axisX(count),
+        axisY(count),
+        axisZ(count) {
+    for (std::size_t index{}; index < count; ++index) {
+      keys[index] = abcg::makeRandomKey(static_cast<std::uint32_t>(index), 0);
+    }
+  }
+};
+
+// The per-asteroid path of the example before the keyed functions
+void spawnWithStd(Field &field, std::default_random_engine &engine) {
+  for (std::size_t index{}; index < field.keys.size(); ++index) {
+    std::uniform_real_distribution<float> distPosXY(-20.0f, 20.0f);
+    std::uniform_real_distribution<float> distPosZ(-100.0f, 0.0f);
+    field.positionX[index] = distPosXY(engine);
+    field.positionY[index] = distPosXY(engine);
+    field.positionZ[index] = distPosZ(engine);
+    std::uniform_real_distribution<float> distRotAxis(-1.0f, 1.0f);
+    const auto axis{glm::normalize(glm::vec3(
+        distRotAxis(engine), distRotAxis(engine), distRotAxis(engine)))};
+    field.axisX[index] = axis.x;
+    field.axisY[index] = axis.y;
+    field.axisZ[index] = axis.z;
+  }
+}
+
+void spawnWithKeys(Field &field, std::uint64_t seed) {
+  abcg::fillUniform(seed, field.keys, 0, field.positionX, -20.0f, 20.0f);
+  abcg::fillUniform(seed, field.keys, 1, field.positionY, -20.0f, 20.0f);
+  abcg::fillUniform(seed, field.keys, 2, field.positionZ, -100.0f, 0.0f);
+  abcg::fillUnitVectors(seed, field.keys, 3, field.axisX, field.axisY,
+                        field.axisZ);
+}
+}  // namespace
+
+int main(int /*argc*/, char * /*argv*/[]) {
+  fmt::print("{:>10} {:>16} {:>16} {:>8}\n", "asteroids", "std (ns/spawn)",
+             "keyed (ns/spawn)", "speedup");
+  for (const std::size_t count : {1'000U, 100'000U, 1'000'000U}) {
+    Field field{count};
+
+    std::default_random_engine engine{42};
+    const auto stdTime{benchmark::measure([&] {
+      spawnWithStd(field, engine);
+      benchmark::keep(field.axisZ.back());
+    })};
+    std::uint64_t seed{42};
+    const auto keyedTime{benchmark::measure([&] {
+      spawnWithKeys(field, seed++);
+      benchmark::keep(field.axisZ.back());
+    })};
+
+    const auto perSpawn{1e9 / static_cast<double>(count)};
+    fmt::print("{:>10} {:>16.2f} {:>16.2f} {:>7.2f}x\n", count,
+               stdTime * perSpawn, keyedTime * perSpawn,
+               stdTime / keyedTime);
+  }
+  return 0;
+}
@@ -0,0 +1,69 @@
+/**
+ * @file sectorfield.cpp
+ * @brief Benchmark of the restart of the sector stream of the example.
+ *
+ * Restarts a SectorField of the avoidasteroids example with 180 (the
+ * default) to 1M asteroids in the view distance, as restart() does, and
+ * times the reset itself and the time until every sector in the view is
+ * active. The reset does not wait for the generation of the sectors, so its
+ * time stays flat; the fill time is the time a reset used to block for.
+ * The number of workers of abcg::JobSystem is the first argument, or else
+ * the default one.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <thread>
+
+#include "abcg_elapsedtimer.hpp"
+#include "abcg_jobsystem.hpp"
+#include "sectorfield.hpp"
+
+namespace {
+constexpr int numRuns{5};
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  abcg::JobSystem jobs{argc > 1 ? std::stoul(argv[1])
+                                : abcg::JobSystem::getDefaultNumWorkers()};
+  fmt::print("{} workers\n", jobs.getNumWorkers());
+  fmt::print("{:>10} {:>12} {:>12}\n", "asteroids", "reset (us)",
+             "fill (ms)");
+  for (const std::size_t count : {180U, 10'000U, 100'000U, 1'000'000U}) {
+    // The layout of the example with its default settings
+    SectorField::Layout layout;
+    const auto sectorsInView{static_cast<std::size_t>(
+        std::ceil(layout.viewDistance / layout.sectorLength))};
+    layout.asteroidsPerSector = (count + sectorsInView - 1) / sectorsInView;
+    layout.planetsPerSector = 3;
+
+    SectorField field{jobs};
+    auto bestReset{std::numeric_limits<double>::max()};
+    auto bestFill{std::numeric_limits<double>::max()};
+    for (int run{}; run <= numRuns; ++run) {
+      layout.seed = static_cast<std::uint64_t>(run);
+      abcg::ElapsedTimer timer;
+      field.reset(layout);
+      const auto resetTime{timer.elapsed()};
+      while (field.getSectors().size() < sectorsInView) {
+        std::this_thread::yield();
+        field.advance(0.0f, 0.0f);
+        field.release(field.getVersion());
+      }
+      // The first run warms up the slots of the field
+      if (run == 0) continue;
+      bestReset = std::min(bestReset, resetTime);
+      bestFill = std::min(bestFill, timer.elapsed());
+    }
+
+    fmt::print("{:>10} {:>12.1f} {:>12.3f}\n", count, bestReset * 1e6,
+               bestFill * 1e3);
+  }
+  return 0;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file spatialhash.cpp
+ * @brief Benchmark of abcg::SpatialHash queries against a linear scan.
+ *
+ * Fills a corridor with 180 to 1M asteroid boxes at the density of the
+ * example (180 asteroids in a 40 x 40 x 100 corridor), so that the corridor
+ * gets longer as the count grows, and times ship-sized sphere queries at
+ * random points of it.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include <fmt/core.h>
+
+#include <random>
+#include <vector>
+
+#include "abcg_spatialhash.hpp"
+#include "benchmark.hpp"
+
+namespace {
+// Corridor cross section, and its volume per asteroid
+constexpr float corridorWidth{40.0f};
+constexpr float volumePerAsteroid{corridorWidth * corridorWidth * 100.0f /
+                                  180.0f};
+
+constexpr float asteroidRadius{1.0f};
+constexpr float shipRadius{0.5f};
+
+// Query points, reused by every run
+constexpr std::size_t numQueries{1024};
+
+std::vector<glm::vec3> makePoints(std::size_t count, float length,
+                                  std::mt19937 &engine) {
+  std::uniform_real_distribution<float> xy{-corridorWidth / 2.0f,
+                                           corridorWidth / 2.0f};
+  std::uniform_real_distribution<float> z{-length, 0.0f};
+  std::vector<glm::vec3> points(count);
+  for (auto &point : points) {
+    point = {xy(engine), xy(engine), z(engine)};
+  }
+  return points;
+}
+}  // namespace
+
+int main(int /*argc*/, char * /*argv*/[]) {
+  fmt::print("{:>10} {:>12} {:>16} {:>16} {:>8}\n", "asteroids",
+             "build (ms)", "hash (ns/query)", "scan (ns/query)", "hits");
+  for (const std::size_t count : {180U, 10'000U, 100'000U, 1'000'000U}) {
+    const auto length{static_cast<float>(count) * volumePerAsteroid /
+                      (corridorWidth * corridorWidth)};
+    std::mt19937 engine{42};
+    std::vector<abcg::BoundingBox> boxes;
+    boxes.reserve(count);
+    for (const auto &center : makePoints(count, length, engine)) {
+      boxes.push_back(abcg::BoundingBox::fromSphere(center, asteroidRadius));
+    }
+    const auto queries{makePoints(numQueries, length, engine)};
+
+    // Cells twice the size of a box: boxes and queries span fewer cells,
+    // which more than pays for the extra candidates
+    abcg::SpatialHash hash{4.0f * asteroidRadius};
+    const auto buildTime{benchmark::measure([&] { hash.build(boxes); })};
+
+    std::vector<std::size_t> result;
+    std::size_t hits{};
+    const auto hashTime{benchmark::measure([&] {
+      hits = 0;
+      for (const auto &query : queries) {
+        hash.query(query, shipRadius, result);
+        hits += result.size();
+      }
+      benchmark::keep(hits);
+    })};
+
+    // The scan is much slower on large fields, so it only runs a subset of
+    // the queries
+    const auto scanQueries{std::max<std::size_t>(
+        1, std::min(numQueries, std::size_t{10'000'000} / count))};
+    const auto scanTime{benchmark::measure([&] {
+      std::size_t scanHits{};
+      for (std::size_t query{}; query < scanQueries; ++query) {
+        for (const auto &box : boxes) {
+          if (box.overlaps(queries[query], shipRadius)) ++scanHits;
+        }
+      }
+      benchmark::keep(scanHits);
+    })};
+
+    fmt::print("{:>10} {:>12.3f} {:>16.1f} {:>16.1f} {:>8}\n", count,
+               buildTime * 1e3,
+               hashTime * 1e9 / static_cast<double>(numQueries),
+               scanTime * 1e9 / static_cast<double>(scanQueries), hits);
+  }
+  return 0;
+}
@@ -0,0 +1,126 @@
+/**
+ * @file transformbatch.cpp
+ * @brief Benchmark of abcg::computeInstanceMatrices against glm.
+ *
+ * Computes the model and normal matrices of 200, 10k and 1M instances
+ * with glm::translate, glm::scale, glm::rotate and glm::inverseTranspose,
+ * one instance at a time, and with the batch kernel.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <vector>
+
+#include "abcg_transformbatch.hpp"
+#include "benchmark.hpp"
+
+namespace {
+struct Instances {
+  std::vector<float> positionX, positionY, positionZ;
+  std::vector<float> scale;
+  std::vector<float> axisX, axisY, axisZ;
+
+  explicit Instances(std::size_t count) {
+    std::mt19937 engine{42};
+    std::uniform_real_distribution<float> position{-20.0f, 20.0f};
+    std::uniform_real_distribution<float> size{0.5f, 2.0f};
+    std::uniform_real_distribution<float> axis{-1.0f, 1.0f};
+    for (std::size_t index{}; index < count; ++index) {
+      positionX.push_back(position(engine));
+      positionY.push_back(position(engine));
+      positionZ.push_back(position(engine));
+      scale.push_back(size(engine));
+      const auto unit{glm::normalize(
+          glm::vec3{axis(engine), axis(engine), axis(engine)} +
+          glm::vec3{0.0f, 0.0f, 1e-3f})};
+      axisX.push_back(unit.x);
+      axisY.push_back(unit.y);
+      axisZ.push_back(unit.z);
+    }
+  }
+
+  [[nodiscard]] abcg::TransformBatch getBatch() const {
+    return {positionX, positionY, positionZ, scale, axisX, axisY, axisZ};
+  }
+};
+
+// The per-instance path the kernel replaces
+void computeWithGlm(const Instances &instances, float angle,
+                    const glm::mat4 &viewMatrix,
+                    std::vector<abcg::InstanceMatrices> &output) {
+  for (std::size_t index{}; index < output.size(); ++index) {
+    auto modelMatrix{glm::translate(
+        glm::mat4{1.0f},
+        {instances.positionX[index], instances.positionY[index],
+         instances.positionZ[index]})};
+    modelMatrix = glm::scale(modelMatrix, glm::vec3{instances.scale[index]});
+    modelMatrix = glm::rotate(modelMatrix, angle,
+                              {instances.axisX[index], instances.axisY[index],
+                               instances.axisZ[index]});
+    output[index].modelMatrix = modelMatrix;
+    output[index].normalMatrix =
+        glm::inverseTranspose(glm::mat3{viewMatrix * modelMatrix});
+  }
+}
+
+// Largest difference between the entries of two sets of matrices
+float getMaxError(const std::vector<abcg::InstanceMatrices> &first,
+                  const std::vector<abcg::InstanceMatrices> &second) {
+  float error{};
+  for (std::size_t index{}; index < first.size(); ++index) {
+    for (glm::length_t column{}; column < 4; ++column) {
+      for (glm::length_t row{}; row < 4; ++row) {
+        error =
+            std::max(error, std::abs(first[index].modelMatrix[column][row] -
+                                     second[index].modelMatrix[column][row]));
+      }
+    }
+    for (glm::length_t column{}; column < 3; ++column) {
+      for (glm::length_t row{}; row < 3; ++row) {
+        error =
+            std::max(error, std::abs(first[index].normalMatrix[column][row] -
+                                     second[index].normalMatrix[column][row]));
+      }
+    }
+  }
+  return error;
+}
+}  // namespace
+
+int main(int /*argc*/, char * /*argv*/[]) {
+  const auto viewMatrix{glm::lookAt(glm::vec3{1.0f, 2.0f, 5.0f},
+                                    glm::vec3{0.0f, 0.0f, -1.0f},
+                                    glm::vec3{0.0f, 1.0f, 0.0f})};
+  const float angle{0.7f};
+
+  fmt::print("{:>10} {:>16} {:>16} {:>8} {:>10}\n", "instances",
+             "glm (ns/inst)", "batch (ns/inst)", "speedup", "max error");
+  for (const std::size_t count : {200U, 10'000U, 1'000'000U}) {
+    const Instances instances{count};
+    std::vector<abcg::InstanceMatrices> expected(count);
+    std::vector<abcg::InstanceMatrices> output(count);
+
+    const auto glmTime{benchmark::measure([&] {
+      computeWithGlm(instances, angle, viewMatrix, expected);
+      benchmark::keep(expected.back().normalMatrix[2][2]);
+    })};
+    const auto batchTime{benchmark::measure([&] {
+      abcg::computeInstanceMatrices(instances.getBatch(), angle, viewMatrix,
+                                    output);
+      benchmark::keep(output.back().normalMatrix[2][2]);
+    })};
+
+    const auto perInstance{1e9 / static_cast<double>(count)};
+    fmt::print("{:>10} {:>16.2f} {:>16.2f} {:>7.2f}x {:>10.2g}\n", count,
+               glmTime * perInstance, batchTime * perInstance,
+               glmTime / batchTime, getMaxError(expected, output));
+  }
+  return 0;
+}
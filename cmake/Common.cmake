@@ -66,6 +66,25 @@ if(ENABLE_IPO)
   endif()
 endif()
 
+# Trace events recorded by abcg::Tracer
+option(ENABLE_TRACING "Enable recording of trace events" ON)
+
+# OpenGL call counts of abcg::GLStats
+option(ENABLE_GL_STATS "Enable counting of OpenGL calls" ON)
+
+# OpenGL object registry of abcg::ResourceTracker
+option(ENABLE_RESOURCE_TRACKING "Enable tracking of OpenGL objects" ON)
+
+# Heap allocation counts of abcg::AllocationTracker. Replaces the global
+# operator new, so it is off by default.
+option(ENABLE_ALLOCATION_TRACKING "Enable counting of heap allocations" OFF)
+
+# Benchmarks of abcg, in the benchmarks directory
+option(ENABLE_BENCHMARKS "Build the benchmarks" OFF)
+
+# Tests of abcg, in the tests directory, run with ctest
+option(ENABLE_TESTS "Build the tests" ON)
+
 # Conan
 option(ENABLE_CONAN "Use Conan Package Manager" OFF)
 if(ENABLE_CONAN AND NOT ${CMAKE_SYSTEM_NAME} MATCHES "Emscripten")
@@ -4,10 +4,12 @@ layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inTexCoord;
 
-uniform mat4 modelMatrix;
+// Per-instance attributes
+layout(location = 4) in mat4 inModelMatrix;
+layout(location = 8) in mat3 inNormalMatrix;
+
 uniform mat4 viewMatrix;
 uniform mat4 projMatrix;
-uniform mat3 normalMatrix;
 
 uniform vec4 lightDirWorldSpace;
 
@@ -19,8 +21,8 @@ out vec3 fragPObj;
 out vec3 fragNObj;
 
 void main() {
-  vec3 P = (viewMatrix * modelMatrix * vec4(inPosition, 1.0)).xyz;
-  vec3 N = normalMatrix * inNormal;
+  vec3 P = (viewMatrix * inModelMatrix * vec4(inPosition, 1.0)).xyz;
+  vec3 N = inNormalMatrix * inNormal;
   vec3 L = -(viewMatrix * lightDirWorldSpace).xyz;
 
   fragL = L;
@@ -0,0 +1,113 @@
+#include "asteroidfield.hpp"
+
+#include <array>
+
+#include "abcg_simd.hpp"
+
+namespace {
+const auto lanes{static_cast<std::size_t>(abcg::simd::width)};
+}  // namespace
+
+void AsteroidField::resize(std::size_t count, float scale) {
+  for (auto *array : {&m_positionX, &m_positionY, &m_positionZ, &m_axisX,
+                      &m_axisY, &m_axisZ}) {
+    array->resize(count);
+  }
+  m_scale.assign(count, scale);
+}
+
+glm::vec3 AsteroidField::getPosition(std::size_t index) const {
+  return {m_positionX.at(index), m_positionY.at(index),
+          m_positionZ.at(index)};
+}
+
+glm::vec3 AsteroidField::getAxis(std::size_t index) const {
+  return {m_axisX.at(index), m_axisY.at(index), m_axisZ.at(index)};
+}
+
+void AsteroidField::setAsteroid(std::size_t index, const glm::vec3 &position,
+                                const glm::vec3 &axis) {
+  m_positionX.at(index) = position.x;
+  m_positionY.at(index) = position.y;
+  m_positionZ.at(index) = position.z;
+  m_axisX.at(index) = axis.x;
+  m_axisY.at(index) = axis.y;
+  m_axisZ.at(index) = axis.z;
+}
+
+void AsteroidField::randomize(std::uint64_t seed, std::uint32_t generation,
+                              const abcg::BoundingBox &bounds) {
+  m_keys.resize(size());
+  for (std::size_t index{}; index < m_keys.size(); ++index) {
+    m_keys[index] =
+        abcg::makeRandomKey(static_cast<std::uint32_t>(index), generation);
+  }
+  abcg::fillUniform(seed, m_keys, 0, m_positionX, bounds.min.x, bounds.max.x);
+  abcg::fillUniform(seed, m_keys, 1, m_positionY, bounds.min.y, bounds.max.y);
+  abcg::fillUniform(seed, m_keys, 2, m_positionZ, bounds.min.z, bounds.max.z);
+  abcg::fillUnitVectors(seed, m_keys, 3, m_axisX, m_axisY, m_axisZ);
+}
+
+void AsteroidField::buildIndex(float radius) {
+  m_radius = radius;
+  m_boxes.resize(size());
+  for (std::size_t index{}; index < m_boxes.size(); ++index) {
+    m_boxes[index] = abcg::BoundingBox::fromSphere(getPosition(index), radius);
+  }
+  // Cells twice the size of a box, see the spatial hash benchmark
+  m_index.setCellSize(4.0f * radius);
+  m_index.build(m_boxes);
+}
+
+void AsteroidField::findOverlaps(const glm::vec3 &center, float radius,
+                                 std::vector<std::size_t> &overlaps) const {
+  namespace simd = abcg::simd;
+  // Candidates whose box overlaps the box of the sphere
+  m_index.query(abcg::BoundingBox::fromSphere(center, radius), overlaps);
+
+  // Keeps the candidates within reach of the center, compacting them in
+  // place. Each group of lanes is gathered before it is overwritten.
+  const auto reach{radius + m_radius};
+  const auto centerX4{simd::broadcast(center.x)};
+  const auto centerY4{simd::broadcast(center.y)};
+  const auto centerZ4{simd::broadcast(center.z)};
+  const auto reach4{simd::broadcast(reach * reach)};
+  const auto count{overlaps.size()};
+  std::size_t kept{};
+  std::size_t first{};
+  for (; first + lanes <= count; first += lanes) {
+    std::array<std::size_t, 4> indices{};
+    std::array<float, 4> x{};
+    std::array<float, 4> y{};
+    std::array<float, 4> z{};
+    for (std::size_t lane{}; lane < lanes; ++lane) {
+      indices[lane] = overlaps[first + lane];
+      x[lane] = m_positionX[indices[lane]];
+      y[lane] = m_positionY[indices[lane]];
+      z[lane] = m_positionZ[indices[lane]];
+    }
+    const auto deltaX{simd::load(x.data()) - centerX4};
+    const auto deltaY{simd::load(y.data()) - centerY4};
+    const auto deltaZ{simd::load(z.data()) - centerZ4};
+    const auto distance{deltaX * deltaX + deltaY * deltaY + deltaZ * deltaZ};
+    const auto outside{simd::moveMask(simd::greaterThan(distance, reach4))};
+    for (std::size_t lane{}; lane < lanes; ++lane) {
+      if ((outside & (1 << lane)) == 0) overlaps[kept++] = indices[lane];
+    }
+  }
+  for (; first < count; ++first) {
+    const auto index{overlaps[first]};
+    const auto deltaX{m_positionX[index] - center.x};
+    const auto deltaY{m_positionY[index] - center.y};
+    const auto deltaZ{m_positionZ[index] - center.z};
+    if (deltaX * deltaX + deltaY * deltaY + deltaZ * deltaZ <= reach * reach) {
+      overlaps[kept++] = index;
+    }
+  }
+  overlaps.resize(kept);
+}
+
+abcg::TransformBatch AsteroidField::getTransformBatch() const {
+  return {m_positionX, m_positionY, m_positionZ, m_scale,
+          m_axisX,     m_axisY,     m_axisZ};
+}
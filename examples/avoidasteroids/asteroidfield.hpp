@@ -0,0 +1,54 @@
+#ifndef ASTEROIDFIELD_HPP_
+#define ASTEROIDFIELD_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include "abcg.hpp"
+
+// Asteroid positions and rotation axes stored as structure of arrays so that
+// transforms run four asteroids at a time. Overlap queries go through a
+// spatial hash built once the asteroids are placed, and test the candidates
+// of the hash against the bounding spheres four at a time.
+class AsteroidField {
+ public:
+  void resize(std::size_t count, float scale);
+  [[nodiscard]] std::size_t size() const { return m_positionX.size(); }
+
+  [[nodiscard]] glm::vec3 getPosition(std::size_t index) const;
+  [[nodiscard]] glm::vec3 getAxis(std::size_t index) const;
+  void setAsteroid(std::size_t index, const glm::vec3 &position,
+                   const glm::vec3 &axis);
+
+  // Places the asteroids uniformly in the box with random rotation axes.
+  // The result only depends on the seed, the generation and the index of
+  // each asteroid.
+  void randomize(std::uint64_t seed, std::uint32_t generation,
+                 const abcg::BoundingBox &bounds);
+
+  // Builds the spatial hash of the asteroids, each bounded by a sphere of
+  // given radius
+  void buildIndex(float radius);
+  // Finds the asteroids whose bounding sphere overlaps the sphere and stores
+  // their indices in overlaps, in ascending order. Uses the last buildIndex.
+  void findOverlaps(const glm::vec3 &center, float radius,
+                    std::vector<std::size_t> &overlaps) const;
+
+  [[nodiscard]] abcg::TransformBatch getTransformBatch() const;
+
+ private:
+  std::vector<float> m_positionX;
+  std::vector<float> m_positionY;
+  std::vector<float> m_positionZ;
+  std::vector<float> m_axisX;
+  std::vector<float> m_axisY;
+  std::vector<float> m_axisZ;
+  std::vector<float> m_scale;
+
+  std::vector<std::uint64_t> m_keys;
+  std::vector<abcg::BoundingBox> m_boxes;
+  float m_radius{};
+  abcg::SpatialHash m_index;
+};
+
+#endif
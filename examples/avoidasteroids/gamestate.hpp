@@ -0,0 +1,30 @@
+#ifndef GAMESTATE_HPP_
+#define GAMESTATE_HPP_
+
+#include "abcg.hpp"
+
+// State of one game. A restart assigns a default-constructed GameState and
+// resets the sector field; GPU resources are never touched.
+//
+// The state advances in fixed simulation ticks. The ship position and the
+// spin angle of the previous tick, and the last translation of the field,
+// are kept so that frames can be rendered between two ticks.
+struct GameState {
+  glm::vec3 shipPosition{0.0f, -0.05f, -0.085f};
+  glm::vec3 previousShipPosition{shipPosition};
+  float angle{};
+  float previousAngle{};
+  // Translation (y, z) of the sectors in the last tick
+  glm::vec2 fieldStep{};
+  // Simulated time since the start of the game, in seconds
+  double time{};
+  int hp{3};
+  // Points for the simulated time survived, independent of the frame and
+  // tick rates
+  int score{};
+  bool lost{false};
+  double timeSinceHit{};
+  double timeSinceLost{};
+};
+
+#endif
@@ -2,15 +2,35 @@
 
 #include "abcg.hpp"
 #include "openglwindow.hpp"
+#include "scenesettings.hpp"
 
 int main(int argc, char **argv) {
   try {
     abcg::Application app(argc, argv);
 
-    auto window{std::make_unique<OpenGLWindow>()};
-    window->setOpenGLSettings({.samples = 4});
+    const auto settings{parseSceneSettings(argc, argv)};
+    if (!settings.replayPath.empty()) {
+      app.replayInput(settings.replayPath);
+    } else if (!settings.recordPath.empty()) {
+      app.recordInput(settings.recordPath);
+    }
+    if (!settings.reportPath.empty()) app.setFrameReport(settings.reportPath);
+    if (!settings.tracePath.empty()) app.recordTrace(settings.tracePath);
+    if (!settings.hitchDirectory.empty()) {
+      app.captureHitches(settings.hitchDirectory);
+    }
+
+    auto window{std::make_unique<OpenGLWindow>(settings)};
+    window->setOpenGLSettings({.samples = 4,
+                               .vsync = settings.vsync,
+                               .targetFrameRate = settings.frameRate});
     window->setWindowSettings(
-        {.width = 600, .height = 600, .showFPS = false, .title = "Avoid Asteroids"});
+        {.width = 600,
+         .height = 600,
+         .showFPS = false,
+         .hidden = settings.hidden,
+         .backgroundFrameRate = settings.backgroundFrameRate,
+         .title = "Avoid Asteroids"});
 
     app.run(std::move(window));
   } catch (const abcg::Exception &exception) {
@@ -18,4 +38,4 @@ int main(int argc, char **argv) {
     return -1;
   }
   return 0;
-}
\ No newline at end of file
+}
@@ -4,6 +4,7 @@
 #include <tiny_obj_loader.h>
 
 #include <cppitertools/itertools.hpp>
+#include <algorithm>
 #include <filesystem>
 #include <glm/gtx/hash.hpp>
 #include <unordered_map>
@@ -89,13 +90,13 @@ void Model::computeTangents() {
   }
 }
 
-void Model::createBuffers() {
+void Model::createBuffers(const abcg::PackedVertexData& packed) {
   abcg::glDeleteBuffers(1, &m_EBO);
   abcg::glDeleteBuffers(1, &m_VBO);
   abcg::glGenBuffers(1, &m_VBO);
   abcg::glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-  abcg::glBufferData(GL_ARRAY_BUFFER, sizeof(m_vertices[0]) * m_vertices.size(),
-                     m_vertices.data(), GL_STATIC_DRAW);
+  abcg::glBufferData(GL_ARRAY_BUFFER, packed.data.size(), packed.data.data(),
+                     GL_STATIC_DRAW);
   abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
   abcg::glGenBuffers(1, &m_EBO);
   abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
@@ -126,6 +127,22 @@ void Model::loadNormalTexture(std::string_view path) {
 }
 
 void Model::loadObj(std::string_view path, bool standardize) {
+  parseObj(path, standardize);
+  loadMaterialTextures();
+}
+
+void Model::loadMaterialTextures() {
+  if (!m_materialDiffusePath.empty()) {
+    loadDiffuseTexture(m_materialDiffusePath);
+  }
+  if (!m_materialNormalPath.empty()) {
+    loadNormalTexture(m_materialNormalPath);
+  }
+}
+
+// CPU part of loadObj: it does not issue any OpenGL call and can run on a
+// worker thread
+void Model::parseObj(std::string_view path, bool standardize) {
   const auto basePath{std::filesystem::path{path}.parent_path().string() + "/"};
 
   tinyobj::ObjReaderConfig readerConfig;
@@ -154,6 +171,9 @@ void Model::loadObj(std::string_view path, bool standardize) {
 
   m_hasNormals = false;
   m_hasTexCoords = false;
+  m_hasTangents = false;
+  m_materialDiffusePath.clear();
+  m_materialNormalPath.clear();
 
   std::unordered_map<Vertex, GLuint> hash{};
   for (const auto& shape : shapes) {
@@ -204,11 +224,13 @@ void Model::loadObj(std::string_view path, bool standardize) {
     m_Ks = glm::vec4(mat.specular[0], mat.specular[1], mat.specular[2], 1);
     m_shininess = mat.shininess;
 
-    if (!mat.diffuse_texname.empty()) loadDiffuseTexture(basePath + mat.diffuse_texname);
+    if (!mat.diffuse_texname.empty()) {
+      m_materialDiffusePath = basePath + mat.diffuse_texname;
+    }
     if (!mat.normal_texname.empty()) {
-      loadNormalTexture(basePath + mat.normal_texname);
+      m_materialNormalPath = basePath + mat.normal_texname;
     } else if (!mat.bump_texname.empty()) {
-      loadNormalTexture(basePath + mat.bump_texname);
+      m_materialNormalPath = basePath + mat.bump_texname;
     }
 
   } else {
@@ -223,13 +245,23 @@ void Model::loadObj(std::string_view path, bool standardize) {
   if (!m_hasNormals) {
     computeNormals();
   }
-  if (m_hasTexCoords) {
-    computeTangents();
-  }
-  createBuffers();
+
+  std::vector<glm::vec3> positions(m_vertices.size());
+  std::transform(m_vertices.begin(), m_vertices.end(), positions.begin(),
+                 [](const Vertex& vertex) { return vertex.position; });
+  m_bvh.build(positions, m_indices);
+
+  // Copies kept for the collisions and for setupVAO
+  abcg::ResourceTracker::setHostMemory(
+      this, std::filesystem::path{path}.filename().string(),
+      sizeof(Vertex) * m_vertices.size() + sizeof(GLuint) * m_indices.size());
+
+  // Tangents and GPU buffers depend on the program, see setupVAO
 }
 
 void Model::render(int numTriangles) const {
+  if (m_numInstances == 0) return;
+  const abcg::ProfilerScope scope{"Model::render", true};
   abcg::glBindVertexArray(m_VAO);
   abcg::glActiveTexture(GL_TEXTURE0);
   abcg::glBindTexture(GL_TEXTURE_2D, m_diffuseTexture);
@@ -242,50 +274,53 @@ void Model::render(int numTriangles) const {
   abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
   abcg::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
   const auto numIndices{(numTriangles < 0) ? m_indices.size(): numTriangles * 3};
-  abcg::glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(numIndices), GL_UNSIGNED_INT, nullptr);
+  abcg::glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(numIndices),
+                                GL_UNSIGNED_INT, nullptr, m_numInstances);
   abcg::glBindVertexArray(0);
 }
 
+void Model::setInstances(
+    std::span<const abcg::InstanceMatrices> instances) {
+  m_numInstances = static_cast<GLsizei>(instances.size());
+  abcg::glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+  // Orphan the previous storage so that the upload does not stall on draws
+  // still reading from it
+  abcg::glBufferData(GL_ARRAY_BUFFER, instances.size_bytes(), nullptr,
+                     GL_STREAM_DRAW);
+  abcg::glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size_bytes(),
+                        instances.data());
+  abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Uploads only the vertex attributes read by the program. Tangents are
+// computed the first time a program reading inTangent is used.
 void Model::setupVAO(GLuint program) {
+  const auto activeMask{abcg::getActiveAttributeMask(program)};
+  const auto& tangent{abcg::VertexLayout<Vertex>::attributes.at(3)};
+  if (m_hasTexCoords && !m_hasTangents &&
+      abcg::isAttributeActive(tangent, activeMask)) {
+    computeTangents();
+    m_hasTangents = true;
+  }
+
+  const auto packed{
+      abcg::packVertices(std::span<const Vertex>{m_vertices}, activeMask)};
+  m_vertexBufferSize = packed.data.size();
+  createBuffers(packed);
+
   abcg::glDeleteVertexArrays(1, &m_VAO);
   abcg::glGenVertexArrays(1, &m_VAO);
   abcg::glBindVertexArray(m_VAO);
   abcg::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
   abcg::glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-  const GLint positionAttribute{
-      abcg::glGetAttribLocation(program, "inPosition")};
-  if (positionAttribute >= 0) {
-    abcg::glEnableVertexAttribArray(positionAttribute);
-    abcg::glVertexAttribPointer(positionAttribute, 3, GL_FLOAT, GL_FALSE,
-                                sizeof(Vertex), nullptr);
-  }
-  const GLint normalAttribute{abcg::glGetAttribLocation(program, "inNormal")};
-  if (normalAttribute >= 0) {
-    abcg::glEnableVertexAttribArray(normalAttribute);
-    GLsizei offset{sizeof(glm::vec3)};
-    abcg::glVertexAttribPointer(normalAttribute, 3, GL_FLOAT, GL_FALSE,
-                                sizeof(Vertex),
-                                reinterpret_cast<void*>(offset));
-  }
-  const GLint texCoordAttribute{
-      abcg::glGetAttribLocation(program, "inTexCoord")};
-  if (texCoordAttribute >= 0) {
-    abcg::glEnableVertexAttribArray(texCoordAttribute);
-    GLsizei offset{sizeof(glm::vec3) + sizeof(glm::vec3)};
-    abcg::glVertexAttribPointer(texCoordAttribute, 2, GL_FLOAT, GL_FALSE,
-                                sizeof(Vertex),
-                                reinterpret_cast<void*>(offset));
-  }
+  abcg::setupVertexAttributes(packed);
 
-  const GLint tangentCoordAttribute{
-      abcg::glGetAttribLocation(program, "inTangent")};
-  if (tangentCoordAttribute >= 0) {
-    abcg::glEnableVertexAttribArray(tangentCoordAttribute);
-    GLsizei offset{sizeof(glm::vec3) + sizeof(glm::vec3) + sizeof(glm::vec2)};
-    abcg::glVertexAttribPointer(tangentCoordAttribute, 4, GL_FLOAT, GL_FALSE,
-                                sizeof(Vertex),
-                                reinterpret_cast<void*>(offset));
+  if (m_instanceVBO == 0) {
+    abcg::glGenBuffers(1, &m_instanceVBO);
+    m_numInstances = 0;
   }
+  abcg::glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+  abcg::setupVertexAttributes<abcg::InstanceMatrices>(1);
 
   abcg::glBindBuffer(GL_ARRAY_BUFFER, 0);
   abcg::glBindVertexArray(0);
@@ -315,5 +350,8 @@ void Model::terminateGL() {
   abcg::glDeleteTextures(1, &m_diffuseTexture);
   abcg::glDeleteBuffers(1, &m_EBO);
   abcg::glDeleteBuffers(1, &m_VBO);
+  abcg::glDeleteBuffers(1, &m_instanceVBO);
   abcg::glDeleteVertexArrays(1, &m_VAO);
+  m_instanceVBO = 0;
+  m_numInstances = 0;
 }
\ No newline at end of file
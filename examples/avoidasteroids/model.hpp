@@ -1,6 +1,9 @@
 #ifndef MODEL_HPP_
 #define MODEL_HPP_
 
+#include <cstddef>
+#include <span>
+#include <string>
 #include <vector>
 
 #include "abcg.hpp"
@@ -19,6 +22,29 @@ struct Vertex {
   }
 };
 
+template <>
+struct abcg::VertexLayout<Vertex> {
+  static constexpr std::array attributes{
+      abcg::makeVertexAttribute<glm::vec3>(0, offsetof(Vertex, position)),
+      abcg::makeVertexAttribute<glm::vec3>(1, offsetof(Vertex, normal)),
+      abcg::makeVertexAttribute<glm::vec2>(2, offsetof(Vertex, texCoord)),
+      abcg::makeVertexAttribute<glm::vec4>(3, offsetof(Vertex, tangent))};
+};
+static_assert(abcg::isValidVertexLayout<Vertex>());
+static_assert(abcg::getVertexLayoutSize<Vertex>() == sizeof(Vertex));
+
+// Per-instance attributes: model matrix at locations 4-7, normal matrix at
+// locations 8-10
+template <>
+struct abcg::VertexLayout<abcg::InstanceMatrices> {
+  static constexpr std::array attributes{
+      abcg::makeVertexAttribute<glm::mat4>(
+          4, offsetof(abcg::InstanceMatrices, modelMatrix)),
+      abcg::makeVertexAttribute<glm::mat3>(
+          8, offsetof(abcg::InstanceMatrices, normalMatrix))};
+};
+static_assert(abcg::isValidVertexLayout<abcg::InstanceMatrices>());
+
 class Model {
  public:
   glm::vec4 m_Ka;
@@ -30,7 +56,10 @@ class Model {
   void loadDiffuseTexture(std::string_view path);
   void loadNormalTexture(std::string_view path);
   void loadObj(std::string_view path, bool standardize = true);
+  void parseObj(std::string_view path, bool standardize = true);
+  void loadMaterialTextures();
   void render(int numTriangles = -1) const;
+  void setInstances(std::span<const abcg::InstanceMatrices> instances);
   void setupVAO(GLuint program);
   void terminateGL();
 
@@ -44,6 +73,13 @@ class Model {
   [[nodiscard]] float getShininess() const { return m_shininess; }
 
   [[nodiscard]] bool isUVMapped() const { return m_hasTexCoords; }
+  [[nodiscard]] const abcg::TriangleBVH& getBVH() const { return m_bvh; }
+  [[nodiscard]] std::size_t getVertexBufferSize() const {
+    return m_vertexBufferSize;
+  }
+  [[nodiscard]] std::size_t getVertexBytesSaved() const {
+    return sizeof(Vertex) * m_vertices.size() - m_vertexBufferSize;
+  }
   [[nodiscard]] GLuint getCubeTexture() const { return m_cubeTexture; }
 
   glm::vec4 m_lightDir{-1.0f, -1.0f, -1.0f, 0.0f};
@@ -55,20 +91,33 @@ class Model {
   GLuint m_VAO{};
   GLuint m_VBO{};
   GLuint m_EBO{};
+  GLuint m_instanceVBO{};
+  GLsizei m_numInstances{};
 
   GLuint m_diffuseTexture{};
   GLuint m_normalTexture{};
   GLuint m_cubeTexture{};
 
+  // Textures referenced by the material, loaded by loadMaterialTextures
+  std::string m_materialDiffusePath;
+  std::string m_materialNormalPath;
+
   std::vector<Vertex> m_vertices;
   std::vector<GLuint> m_indices;
 
+  // Hierarchy over the triangles, in model space, for exact collisions
+  abcg::TriangleBVH m_bvh;
+
   bool m_hasNormals{false};
   bool m_hasTexCoords{false};
+  bool m_hasTangents{false};
+
+  // Size of the vertex buffer trimmed to the attributes read by the program
+  std::size_t m_vertexBufferSize{};
 
   void computeNormals();
   void computeTangents();
-  void createBuffers();
+  void createBuffers(const abcg::PackedVertexData& packed);
   void standardize();
 };
 
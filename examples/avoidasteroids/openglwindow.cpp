@@ -1,26 +1,94 @@
 #include "openglwindow.hpp"
 
+#include <fmt/core.h>
 #include <imgui.h>
 
+#include <algorithm>
+#include <cmath>
 #include <cppitertools/itertools.hpp>
-#include <glm/gtx/fast_trigonometry.hpp>
+#include <glm/gtc/constants.hpp>
 #include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtx/fast_trigonometry.hpp>
+#include <utility>
+
+namespace {
+// Radius of the sphere centered at the origin enclosing a mesh
+float getBoundingRadius(const abcg::TriangleBVH &bvh) {
+  const auto bounds{bvh.getBounds()};
+  return glm::length(glm::max(glm::abs(bounds.min), glm::abs(bounds.max)));
+}
+
+// Subrange [first, first + count) of a transform batch
+abcg::TransformBatch getSubBatch(const abcg::TransformBatch &batch,
+                                 std::size_t first, std::size_t count) {
+  return {batch.positionX.subspan(first, count),
+          batch.positionY.subspan(first, count),
+          batch.positionZ.subspan(first, count),
+          batch.scale.subspan(first, count),
+          batch.axisX.subspan(first, count),
+          batch.axisY.subspan(first, count),
+          batch.axisZ.subspan(first, count),
+          batch.translation};
+}
+
+// Number of instance matrices computed per job
+const std::size_t matricesPerJob{4096};
+
+// Bits of the held keys in m_controls
+const std::uint8_t controlUp{0x1};
+const std::uint8_t controlDown{0x2};
+const std::uint8_t controlLeft{0x4};
+const std::uint8_t controlRight{0x8};
+
+// Ship speed in the xy plane and half size of the region it can reach
+const float shipSpeed{1.0f};
+const float shipRange{0.2f};
+// Spin of asteroids and planets, in radians per second
+const float spinSpeed{glm::radians(90.0f)};
+// Points scored per second survived
+const double scorePerSecond{60.0};
+// Invulnerability after a hit and delay before a restart, in seconds
+const double hitCooldown{1.0};
+const double restartDelay{4.0};
+
+// Frames skipped after each change of the stress test level
+const int stressWarmupFrames{10};
+// Duration of the measurement at each stress test level, in seconds
+const double stressWindow{2.0};
+}  // namespace
 
 void OpenGLWindow::handleEvent(SDL_Event& handleEvent) {
-  const float deltaTime{static_cast<float>(getDeltaTime())};
+  // The ship moves in simulate while a key is held, so key repeats are
+  // irrelevant
+  if (handleEvent.type != SDL_KEYDOWN && handleEvent.type != SDL_KEYUP) {
+    return;
+  }
+  std::uint8_t control{};
+  switch (handleEvent.key.keysym.sym) {
+    case SDLK_UP:
+    case SDLK_w:
+      control = controlUp;
+      break;
+    case SDLK_DOWN:
+    case SDLK_s:
+      control = controlDown;
+      break;
+    case SDLK_LEFT:
+    case SDLK_a:
+      control = controlLeft;
+      break;
+    case SDLK_RIGHT:
+    case SDLK_d:
+      control = controlRight;
+      break;
+    default:
+      return;
+  }
   if (handleEvent.type == SDL_KEYDOWN) {
-    if (handleEvent.key.keysym.sym == SDLK_UP || handleEvent.key.keysym.sym == SDLK_w){
-      if(m_shipPosition.y <= 0.2f) m_shipPosition.y += deltaTime * 2.0f;
-    }
-    if (handleEvent.key.keysym.sym == SDLK_LEFT || handleEvent.key.keysym.sym == SDLK_a){
-      if(m_shipPosition.x >= -0.2f) m_shipPosition.x -= deltaTime * 2.0f;
-    }
-    if (handleEvent.key.keysym.sym == SDLK_DOWN || handleEvent.key.keysym.sym == SDLK_s){
-      if(m_shipPosition.y >= -0.2f) m_shipPosition.y -= deltaTime * 2.0f;
-    }
-    if (handleEvent.key.keysym.sym == SDLK_RIGHT || handleEvent.key.keysym.sym == SDLK_d){
-      if(m_shipPosition.x <= 0.2f) m_shipPosition.x += deltaTime * 2.0f;
-    }
+    m_controls.fetch_or(control, std::memory_order_relaxed);
+  } else {
+    m_controls.fetch_and(static_cast<std::uint8_t>(~control),
+                         std::memory_order_relaxed);
   }
 }
 
@@ -28,6 +96,7 @@ void OpenGLWindow::initializeGL() {
   abcg::glClearColor(0, 0, 0, 1);
   abcg::glEnable(GL_DEPTH_TEST);
   for (const auto& name : m_shaderNames) {
+    const abcg::ResourceOwner owner{name};
     const auto path{getAssetsPath() + "shaders/" + name};
     const auto program{createProgramFromFile(path + ".vert", path + ".frag")};
     m_programs.push_back(program);
@@ -35,31 +104,45 @@ void OpenGLWindow::initializeGL() {
   m_mappingMode = 3;
   m_viewMatrix = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
   
+  m_occlusionCuller.setJobSystem(&m_jobs);
+
   //sky
+  const abcg::ResourceOwner skyOwner{m_skyShaderName};
   m_skybox.loadCubeTexture(getAssetsPath() + "maps/cube/");
   initializeSkybox();
-  
-  //asteroids
-  loadModel("asteroid.obj", "asteroid.jpg", m_asteroid);
-  for (const auto index : iter::range(m_numAsteroids)) {
-    auto &position{m_asteroidPositions.at(index)};
-    auto &rotation{m_asteroidRotations.at(index)};
-    randomizeAsteroid(position, rotation);
-  }
 
-  //planets
-  loadModel("planetRound.obj", "planetRound.jpg", m_planetRound);
-  loadModel("planetRing.obj", "planetRing.jpg", m_planetRing);
-  for (const auto index : iter::range(m_numPlanets)) {
-    auto &position{m_planetPositions.at(index)};
-    auto &rotation{m_planetRotations.at(index)};
-    randomizePlanet(position, rotation);
-  }
+  loadModels();
+
+  setSimulationRate(m_settings.tickRate);
+  setSimulationThreaded(m_settings.threaded);
+  setRenderThreaded(m_settings.renderThread);
+
+  // A replayed session brings its own seed
+  m_settings.seed = static_cast<std::uint32_t>(getSessionSeed(m_settings.seed));
+  m_simulationSettings = m_settings;
+  resizeScene();
+  publishSnapshot();
   
-  //ship
-  loadModel("ship.obj", "ship.jpg", m_ship);
-  m_shipPosition = glm::vec3(0.0f, -0.05f, -0.085f);
-  hp_qtt = 3;
+}
+
+// Restarts the sector stream at the current distance with the density and
+// view distance in m_simulationSettings. Simulation side only.
+void OpenGLWindow::resizeScene() {
+  const auto sectorsInView{m_simulationSettings.corridorLength /
+                           m_simulationSettings.sectorLength};
+  SectorField::Layout layout;
+  layout.sectorLength = m_simulationSettings.sectorLength;
+  layout.viewDistance = m_simulationSettings.corridorLength;
+  layout.corridorWidth = m_simulationSettings.corridorWidth;
+  layout.asteroidRadius =
+      layout.asteroidScale * getBoundingRadius(m_asteroid.getBVH());
+  layout.asteroidsPerSector = static_cast<std::size_t>(std::ceil(
+      static_cast<float>(m_simulationSettings.numAsteroids) / sectorsInView));
+  layout.planetsPerSector = static_cast<std::size_t>(std::ceil(
+      static_cast<float>(m_simulationSettings.numPlanets) / sectorsInView));
+  layout.seed =
+      m_simulationSettings.seed + static_cast<std::uint64_t>(m_round);
+  m_sectors.reset(layout, m_sectors.getDistance());
 }
 
 void OpenGLWindow::initializeSkybox() {	
@@ -80,69 +163,129 @@ void OpenGLWindow::initializeSkybox() {
   abcg::glBindVertexArray(0);	
 }
 
-void OpenGLWindow::loadModel(std::string path_obj, std::string path_text, Model &model) {
+// Parses the OBJ files in parallel, then creates the GL resources on this
+// thread
+void OpenGLWindow::loadModels() {
+  const std::array<std::pair<const char *, Model *>, 4> models{
+      {{"asteroid.obj", &m_asteroid},
+       {"planetRound.obj", &m_planetRound},
+       {"planetRing.obj", &m_planetRing},
+       {"ship.obj", &m_ship}}};
+
+  const auto assetsPath{getAssetsPath()};
+  abcg::JobSystem::Counter counter;
+  for (const auto &[name, model] : models) {
+    m_jobs.run(
+        [&, name = name, model = model] {
+          model->parseObj(assetsPath + name);
+        },
+        &counter);
+  }
+  // Rethrows the first parsing error
+  m_jobs.wait(counter);
+
+  setupModel("asteroid.obj", "asteroid.jpg", m_asteroid);
+  setupModel("planetRound.obj", "planetRound.jpg", m_planetRound);
+  setupModel("planetRing.obj", "planetRing.jpg", m_planetRing);
+  setupModel("ship.obj", "ship.jpg", m_ship);
+}
+
+void OpenGLWindow::setupModel(std::string path_obj, std::string path_text, Model &model) {
+  const abcg::ResourceOwner owner{path_obj};
   model.terminateGL();
   model.loadDiffuseTexture(getAssetsPath() + "maps/" + path_text);
   model.loadNormalTexture(getAssetsPath() + "maps/pattern_normal.png");
-  model.loadObj(getAssetsPath() + path_obj);
+  model.loadMaterialTextures();
   model.setupVAO(m_programs.at(m_currentProgramIndex));
+  fmt::print("{}: {} bytes of vertex data ({} bytes saved)\n", path_obj,
+             model.getVertexBufferSize(), model.getVertexBytesSaved());
   model.m_Ka = model.getKa();
   model.m_Kd = model.getKd();
   model.m_Ks = model.getKs();
   model.m_shininess = model.getShininess();
 }
 
-void OpenGLWindow::randomizeAsteroid(glm::vec3 &position, glm::vec3 &rotation) {
-  std::uniform_real_distribution<float> distPosXY(-20.0f, 20.0f);
-  std::uniform_real_distribution<float> distPosZ(-100.0f, 0.0f);
-  position = glm::vec3(distPosXY(m_randomEngine), distPosXY(m_randomEngine),
-                       distPosZ(m_randomEngine));
-  std::uniform_real_distribution<float> distRotAxis(-1.0f, 1.0f);
-  rotation = glm::normalize(glm::vec3(distRotAxis(m_randomEngine),
-                                      distRotAxis(m_randomEngine),
-                                      distRotAxis(m_randomEngine)));
-}
-
-void OpenGLWindow::randomizePlanet(glm::vec3 &position, glm::vec3 &rotation) {
-  std::uniform_real_distribution<float> distPosXY(-10.0f, 10.0f);
-  std::uniform_real_distribution<float> distPosZ(-100.0f, 0.0f);
-  float X = distPosXY(m_randomEngine); 
-  float Y = distPosXY(m_randomEngine);
-  if(Y <= 0 && X <= 0){
-    if(abs(X)>=5 && abs(Y)>=5) position = glm::vec3(X-10.0f, Y-10.0f, distPosZ(m_randomEngine));
-    else if(abs(X) > abs(Y)) position = glm::vec3(X-10.0f, Y, distPosZ(m_randomEngine));
-    else if(abs(X) < abs(Y)) position = glm::vec3(X, Y-10.0f, distPosZ(m_randomEngine));
+void OpenGLWindow::paintGL() {
+  if (m_settings.stress) updateStress();
+  interpolate();
+  gatherPlanets();
+  cullAsteroids();
+  // Asteroid matrices of all sectors, nearest sector first
+  const auto &sectors{m_snapshots.getReadBuffer().sectors};
+  std::size_t numAsteroids{};
+  for (const auto &placed : sectors) {
+    numAsteroids += placed.sector->asteroids.size();
   }
-  if(Y <= 0 && X > 0){
-    if(X>=5 && abs(Y)>=5) position = glm::vec3(X+10.0f, Y-10.0f, distPosZ(m_randomEngine));
-    else if(X>abs(Y)) position = glm::vec3(X+10.0f, Y, distPosZ(m_randomEngine));
-    else if(X<abs(Y)) position = glm::vec3(X, Y-10.0f, distPosZ(m_randomEngine));
+  m_asteroidMatrices.resize(numAsteroids);
+  std::size_t offset{};
+  for (const auto &placed : sectors) {
+    const auto &asteroids{placed.sector->asteroids};
+    auto batch{asteroids.getTransformBatch()};
+    batch.translation = placed.offset + m_render.fieldLag;
+    const auto output{
+        std::span{m_asteroidMatrices}.subspan(offset, asteroids.size())};
+    m_jobs.parallelFor(
+        0, output.size(), matricesPerJob,
+        [&](std::size_t first, std::size_t last) {
+          abcg::computeInstanceMatrices(
+              getSubBatch(batch, first, last - first), m_render.angle,
+              m_viewMatrix, output.subspan(first, last - first));
+        });
+    offset += output.size();
   }
-  if(Y > 0 && X < 0){
-    if(abs(X)>=5 && Y>=5) position = glm::vec3(X-10.0f, Y+10.0f, distPosZ(m_randomEngine));
-    else if(abs(X) > Y) position = glm::vec3(X-10.0f, Y, distPosZ(m_randomEngine));
-    else if(abs(X) < Y) position = glm::vec3(X, Y+10.0f, distPosZ(m_randomEngine));
+  computeMatrices(m_planetPositions, m_planetRotations, 2.0f,
+                  m_planetMatrices);
+
+  if (m_frames.size() != getNumFrameSlots()) {
+    m_frames.resize(getNumFrameSlots());
   }
-  if(Y > 0 && X > 0){
-    if(X>=5 && Y>=5) position = glm::vec3(X+10.0f, Y+10.0f, distPosZ(m_randomEngine));
-    else if(X>Y) position = glm::vec3(X+10.0f, Y, distPosZ(m_randomEngine));
-    else if(X<Y) position = glm::vec3(X, Y+10.0f, distPosZ(m_randomEngine));
+  auto &frame{m_frames.at(getFrameSlot())};
+  frame.viewMatrix = m_viewMatrix;
+  frame.projMatrix = m_projMatrix;
+  frame.program = m_programs.at(m_currentProgramIndex);
+  frame.mappingMode = m_mappingMode;
+  frame.viewportWidth = m_viewportWidth;
+  frame.viewportHeight = m_viewportHeight;
+
+  frame.ship.modelMatrix =
+      glm::translate(glm::mat4{1.0f}, m_render.shipPosition);
+  frame.ship.modelMatrix = glm::scale(frame.ship.modelMatrix, glm::vec3(0.07f));
+  frame.ship.normalMatrix = glm::inverseTranspose(
+      glm::mat3(m_viewMatrix * frame.ship.modelMatrix));
+
+  frame.planetRing.clear();
+  frame.planetRound.clear();
+  for (const auto index : iter::range(m_planetMatrices.size())) {
+    auto &instances{m_planetIsRound.at(index) != 0 ? frame.planetRound
+                                                   : frame.planetRing};
+    instances.push_back(m_planetMatrices.at(index));
   }
-  std::uniform_real_distribution<float> distRotAxis(-0.0005f, 0.0005f);
-  rotation = glm::normalize(glm::vec3(distRotAxis(m_randomEngine), distRotAxis(m_randomEngine), 0.0f));
+
+  submitGL([this, &frame] { renderFrame(frame); });
+
+  // Asteroids are drawn last so that culling overlaps with the submission of
+  // the ship and planets. Visible instances are compacted into a single draw.
+  m_occlusionCuller.wait();
+  frame.asteroids.clear();
+  for (const auto index : iter::range(m_asteroidMatrices.size())) {
+    if (m_occlusionCuller.isVisible(index)) {
+      frame.asteroids.push_back(m_asteroidMatrices.at(index));
+    }
+  }
+  submitGL([this, &frame] { renderAsteroids(frame); });
 }
 
-void OpenGLWindow::paintGL() {
-  update();
+// OpenGL commands of a frame, up to the planets. Runs on the render thread
+// when it is enabled, so it only reads the frame data and the objects
+// created by initializeGL.
+void OpenGLWindow::renderFrame(const FrameData &frame) {
   abcg::glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-  abcg::glViewport(0, 0, m_viewportWidth, m_viewportHeight);
-  const auto program{m_programs.at(m_currentProgramIndex)};
+  abcg::glViewport(0, 0, frame.viewportWidth, frame.viewportHeight);
+  const auto program{frame.program};
   abcg::glUseProgram(program);
   const GLint viewMatrixLoc{abcg::glGetUniformLocation(program, "viewMatrix")};
   const GLint projMatrixLoc{abcg::glGetUniformLocation(program, "projMatrix")};
-  const GLint modelMatrixLoc{abcg::glGetUniformLocation(program, "modelMatrix")};
   const GLint colorLoc{abcg::glGetUniformLocation(program, "color")};
-  const GLint normalMatrixLoc{abcg::glGetUniformLocation(program, "normalMatrix")};
   const GLint lightDirLoc{abcg::glGetUniformLocation(program, "lightDirWorldSpace")};
   const GLint shininessLoc{abcg::glGetUniformLocation(program, "shininess")};
   const GLint IaLoc{abcg::glGetUniformLocation(program, "Ia")};
@@ -157,13 +300,13 @@ void OpenGLWindow::paintGL() {
   const GLint cubeTexLoc{abcg::glGetUniformLocation(program, "cubeTex")};
   const GLint texMatrixLoc{abcg::glGetUniformLocation(program, "texMatrix")};
 
-  abcg::glUniformMatrix4fv(viewMatrixLoc, 1, GL_FALSE, &m_viewMatrix[0][0]);
-  abcg::glUniformMatrix4fv(projMatrixLoc, 1, GL_FALSE, &m_projMatrix[0][0]);
+  abcg::glUniformMatrix4fv(viewMatrixLoc, 1, GL_FALSE, &frame.viewMatrix[0][0]);
+  abcg::glUniformMatrix4fv(projMatrixLoc, 1, GL_FALSE, &frame.projMatrix[0][0]);
   abcg::glUniform4f(colorLoc, 0.6f, 0.2f, 0.0f, 1.0f);
   abcg::glUniform1i(diffuseTexLoc, 0);
   abcg::glUniform1i(normalTexLoc, 1);	
   abcg::glUniform1i(cubeTexLoc, 2);
-  abcg::glUniform1i(mappingModeLoc, m_mappingMode);
+  abcg::glUniform1i(mappingModeLoc, frame.mappingMode);
   const glm::mat3 texMatrix{glm::rotate(glm::mat4(1.0f), glm::radians(0.0f), glm::vec3{1.0f})};
   abcg::glUniformMatrix3fv(texMatrixLoc, 1, GL_TRUE, &texMatrix[0][0]);
   abcg::glUniform4fv(lightDirLoc, 1, &m_asteroid.m_lightDir.x);
@@ -171,73 +314,40 @@ void OpenGLWindow::paintGL() {
   abcg::glUniform4fv(IdLoc, 1, &m_asteroid.m_Id.x);
   abcg::glUniform4fv(IsLoc, 1, &m_asteroid.m_Is.x);
 
-  for (const auto index : iter::range(m_numAsteroids)) {
-    abcg::glFrontFace(GL_CCW);
-    const auto &position{m_asteroidPositions.at(index)};
-    const auto &rotation{m_asteroidRotations.at(index)};
-    glm::mat4 modelMatrix{1.0f};
-    modelMatrix = glm::translate(modelMatrix, position);
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(1.2f));
-    modelMatrix = glm::rotate(modelMatrix, m_angle, rotation);
-    abcg::glUniformMatrix4fv(modelMatrixLoc, 1, GL_FALSE, &modelMatrix[0][0]);
-    const auto modelViewMatrix{glm::mat3(m_viewMatrix * modelMatrix)};
-    glm::mat3 normalMatrix{glm::inverseTranspose(modelViewMatrix)};
-    abcg::glUniformMatrix3fv(normalMatrixLoc, 1, GL_FALSE, &normalMatrix[0][0]);
-    abcg::glUniform1f(shininessLoc, m_asteroid.m_shininess);
-    abcg::glUniform4fv(KaLoc, 1, &m_asteroid.m_Ka.x);
-    abcg::glUniform4fv(KdLoc, 1, &m_asteroid.m_Kd.x);
-    abcg::glUniform4fv(KsLoc, 1, &m_asteroid.m_Ks.x);
-    m_asteroid.render();
-    
-  }
-  
-  glm::mat4 modelShipMatrix{1.0f};
   abcg::glFrontFace(GL_CCW);
-  modelShipMatrix = glm::translate(modelShipMatrix, m_shipPosition);
-  modelShipMatrix = glm::scale(modelShipMatrix, glm::vec3(0.07f));
-  abcg::glUniformMatrix4fv(modelMatrixLoc, 1, GL_FALSE, &modelShipMatrix[0][0]);
-  const auto modelViewMatrix{glm::mat3(m_viewMatrix * modelShipMatrix)};
-  glm::mat3 normalMatrix{glm::inverseTranspose(modelViewMatrix)};
-  abcg::glUniformMatrix3fv(normalMatrixLoc, 1, GL_FALSE, &normalMatrix[0][0]);
+
+  m_ship.setInstances(std::span{&frame.ship, 1});
   abcg::glUniform1f(shininessLoc, m_ship.m_shininess);
   abcg::glUniform4fv(KaLoc, 1, &m_ship.m_Ka.x);
   abcg::glUniform4fv(KdLoc, 1, &m_ship.m_Kd.x);
   abcg::glUniform4fv(KsLoc, 1, &m_ship.m_Ks.x);
   m_ship.render();
 
-  for (const auto index : iter::range(m_numPlanets)) {
-    abcg::glFrontFace(GL_CCW);
-    const auto &position{m_planetPositions.at(index)};
-    const auto &rotation{m_planetRotations.at(index)};
-    glm::mat4 modelMatrix{1.0f};
-    modelMatrix = glm::translate(modelMatrix, position);
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(2.0f));
-    modelMatrix = glm::rotate(modelMatrix, m_angle, rotation);
-    abcg::glUniformMatrix4fv(modelMatrixLoc, 1, GL_FALSE, &modelMatrix[0][0]);
-	  const auto modelViewMatrix{glm::mat3(m_viewMatrix * modelMatrix)};
-    glm::mat3 normalMatrix{glm::inverseTranspose(modelViewMatrix)};
-    abcg::glUniformMatrix3fv(normalMatrixLoc, 1, GL_FALSE, &normalMatrix[0][0]);
-    abcg::glUniform1f(shininessLoc, m_planetRing.m_shininess);
-	  abcg::glUniform4fv(KaLoc, 1, &m_planetRing.m_Ka.x);
-    abcg::glUniform4fv(KdLoc, 1, &m_planetRing.m_Kd.x);
-    abcg::glUniform4fv(KsLoc, 1, &m_planetRing.m_Ks.x);
-	  abcg::glUniform1f(shininessLoc, m_planetRound.m_shininess);
-    abcg::glUniform4fv(KaLoc, 1, &m_planetRound.m_Ka.x);
-    abcg::glUniform4fv(KdLoc, 1, &m_planetRound.m_Kd.x);
-    abcg::glUniform4fv(KsLoc, 1, &m_planetRound.m_Ks.x);
-    if(index < 3){
-      m_planetRing.render();
-    }
-    if(index >= 3 && index < 6){
-      m_planetRound.render();
-    }
-    if(index >= 6 && index < 9){
-      m_planetRound.render();
-    }
-    if(index >= 9 && index < 12){
-      m_planetRing.render();
-    }
-  }
+  m_planetRing.setInstances(frame.planetRing);
+  m_planetRound.setInstances(frame.planetRound);
+  abcg::glUniform1f(shininessLoc, m_planetRound.m_shininess);
+  abcg::glUniform4fv(KaLoc, 1, &m_planetRound.m_Ka.x);
+  abcg::glUniform4fv(KdLoc, 1, &m_planetRound.m_Kd.x);
+  abcg::glUniform4fv(KsLoc, 1, &m_planetRound.m_Ks.x);
+  m_planetRing.render();
+  m_planetRound.render();
+}
+
+// OpenGL commands of a frame after culling: asteroids and skybox
+void OpenGLWindow::renderAsteroids(const FrameData &frame) {
+  const auto program{frame.program};
+  const GLint shininessLoc{abcg::glGetUniformLocation(program, "shininess")};
+  const GLint KaLoc{abcg::glGetUniformLocation(program, "Ka")};
+  const GLint KdLoc{abcg::glGetUniformLocation(program, "Kd")};
+  const GLint KsLoc{abcg::glGetUniformLocation(program, "Ks")};
+
+  m_asteroid.setInstances(frame.asteroids);
+  abcg::glUniform1f(shininessLoc, m_asteroid.m_shininess);
+  abcg::glUniform4fv(KaLoc, 1, &m_asteroid.m_Ka.x);
+  abcg::glUniform4fv(KdLoc, 1, &m_asteroid.m_Kd.x);
+  abcg::glUniform4fv(KsLoc, 1, &m_asteroid.m_Ks.x);
+  m_asteroid.render();
+
   abcg::glUseProgram(0);
 
   abcg::glUseProgram(m_skyProgram);
@@ -246,7 +356,7 @@ void OpenGLWindow::paintGL() {
   const GLint skyTexLoc{abcg::glGetUniformLocation(m_skyProgram, "skyTex")};	
   const auto viewMatrixSky{glm::rotate(glm::mat4(1.0f), glm::radians(0.0f), glm::vec3{1.0f})};	
   abcg::glUniformMatrix4fv(viewMatrixLocSky, 1, GL_FALSE, &viewMatrixSky[0][0]);	
-  abcg::glUniformMatrix4fv(projMatrixLocSky, 1, GL_FALSE, &m_projMatrix[0][0]);	
+  abcg::glUniformMatrix4fv(projMatrixLocSky, 1, GL_FALSE, &frame.projMatrix[0][0]);	
   abcg::glUniform1i(skyTexLoc, 0);	
   abcg::glBindVertexArray(m_skyVAO);	
   abcg::glActiveTexture(GL_TEXTURE0);	
@@ -261,10 +371,102 @@ void OpenGLWindow::paintGL() {
   
 }
 
+void OpenGLWindow::computeMatrices(
+    std::span<const glm::vec3> positions, std::span<const glm::vec3> rotations,
+    float scale, std::vector<abcg::InstanceMatrices> &matrices) {
+  auto &scratch{m_transformScratch};
+  const auto count{positions.size()};
+  for (auto *array : {&scratch.positionX, &scratch.positionY,
+                      &scratch.positionZ, &scratch.scale, &scratch.axisX,
+                      &scratch.axisY, &scratch.axisZ}) {
+    array->resize(count);
+  }
+  for (const auto index : iter::range(count)) {
+    scratch.positionX[index] = positions[index].x;
+    scratch.positionY[index] = positions[index].y;
+    scratch.positionZ[index] = positions[index].z;
+    scratch.scale[index] = scale;
+    scratch.axisX[index] = rotations[index].x;
+    scratch.axisY[index] = rotations[index].y;
+    scratch.axisZ[index] = rotations[index].z;
+  }
+
+  matrices.resize(count);
+  abcg::computeInstanceMatrices(
+      {scratch.positionX, scratch.positionY, scratch.positionZ, scratch.scale,
+       scratch.axisX, scratch.axisY, scratch.axisZ},
+      m_render.angle, m_viewMatrix, matrices);
+}
+
+// Exact test of the ship mesh against the rotated asteroid mesh, in the
+// model space of the asteroid
+bool OpenGLWindow::collidesWithShip(const PlacedSector &placed,
+                                    std::size_t asteroidIndex) const {
+  const auto &asteroids{placed.sector->asteroids};
+  auto asteroidMatrix{glm::translate(
+      glm::mat4{1.0f}, asteroids.getPosition(asteroidIndex) + placed.offset)};
+  asteroidMatrix = glm::scale(asteroidMatrix, glm::vec3(1.2f));
+  asteroidMatrix = glm::rotate(asteroidMatrix, m_game.angle,
+                               asteroids.getAxis(asteroidIndex));
+  auto shipMatrix{glm::translate(glm::mat4{1.0f}, m_game.shipPosition)};
+  shipMatrix = glm::scale(shipMatrix, glm::vec3(0.07f));
+  return m_asteroid.getBVH().intersects(
+      m_ship.getBVH(), glm::inverse(asteroidMatrix) * shipMatrix);
+}
+
+// Planets of the snapshot at their interpolated position
+void OpenGLWindow::gatherPlanets() {
+  m_planetPositions.clear();
+  m_planetRotations.clear();
+  m_planetIsRound.clear();
+  for (const auto &placed : m_snapshots.getReadBuffer().sectors) {
+    const auto &sector{*placed.sector};
+    const auto translation{placed.offset + m_render.fieldLag};
+    for (const auto &position : sector.planetPositions) {
+      m_planetPositions.push_back(position + translation);
+    }
+    m_planetRotations.insert(m_planetRotations.end(),
+                             sector.planetAxes.begin(),
+                             sector.planetAxes.end());
+    m_planetIsRound.insert(m_planetIsRound.end(),
+                           sector.planetIsRound.begin(),
+                           sector.planetIsRound.end());
+  }
+}
+
+void OpenGLWindow::cullAsteroids() {
+  m_occlusionCuller.setCamera(m_viewMatrix, m_projMatrix);
+  m_occlusionCuller.clearOccluders();
+
+  // Round planets: radius of the sphere inscribed in the standardized mesh
+  for (const auto index : iter::range(m_planetPositions.size())) {
+    if (m_planetIsRound.at(index) != 0) {
+      m_occlusionCuller.addOccluder(m_planetPositions.at(index), 2.0f * 0.52f);
+    }
+  }
+
+  // Near asteroids: conservative inner radius of the rock
+  m_asteroidBoxes.clear();
+  for (const auto &placed : m_snapshots.getReadBuffer().sectors) {
+    const auto &asteroids{placed.sector->asteroids};
+    const auto translation{placed.offset + m_render.fieldLag};
+    for (const auto index : iter::range(asteroids.size())) {
+      const auto position{asteroids.getPosition(index) + translation};
+      if (position.z > -30.0f) {
+        m_occlusionCuller.addOccluder(position, 1.2f * 0.35f);
+      }
+      m_asteroidBoxes.push_back(
+          abcg::BoundingBox::fromSphere(position, 1.2f * 0.68f));
+    }
+  }
+
+  m_occlusionCuller.cullAsync(m_asteroidBoxes);
+}
+
 void OpenGLWindow::paintUI() {
   abcg::OpenGLWindow::paintUI();
   {
-    const auto widgetSize{ImVec2(222, 85)};
+    const auto widgetSize{ImVec2(222, 105)};
     ImGui::SetNextWindowPos(ImVec2(m_viewportWidth - widgetSize.x - 5, 5));
     ImGui::SetNextWindowSize(widgetSize);
     ImGui::Begin("Widget window", nullptr, ImGuiWindowFlags_NoDecoration);
@@ -276,20 +478,66 @@ void OpenGLWindow::paintUI() {
       const auto aspect{static_cast<float>(m_viewportWidth) /
                         static_cast<float>(m_viewportHeight)};
       if (currentIndex == 0) {
+        const auto farPlane{std::max(100.0f, m_settings.corridorLength)};
         m_projMatrix =
-            glm::perspective(glm::radians(m_FOV), aspect, 0.01f, 100.0f);
+            glm::perspective(glm::radians(m_FOV), aspect, 0.01f, farPlane);
         ImGui::SliderFloat("FOV", &m_FOV, 5.0f, 179.0f, "%.0f degrees");
       } else {
         m_projMatrix = glm::ortho(-20.0f * aspect, 20.0f * aspect, -20.0f,
                                   20.0f, 0.01f, 100.0f);
       }
-      ImGui::Text("HEALTH POINTS: %d", hp_qtt);
-      ImGui::Text("SCORE: %d", score);
+      const auto &game{m_snapshots.getReadBuffer().game};
+      ImGui::Text("HEALTH POINTS: %d", game.hp);
+      ImGui::Text("SCORE: %d", game.score);
+      ImGui::Text("OCCLUDED: %.1f%%",
+                  m_occlusionCuller.getStatistics().occludedRatio() * 100.0f);
       ImGui::PopItemWidth();
     }
     ImGui::End();
   }
 
+  {
+    ImGui::SetNextWindowPos(ImVec2(5, 5), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowCollapsed(true, ImGuiCond_FirstUseEver);
+    ImGui::Begin("Scene");
+    bool resized{};
+    resized |= ImGui::SliderInt("Asteroids", &m_settings.numAsteroids, 0,
+                                1000000, "%d", ImGuiSliderFlags_Logarithmic);
+    resized |= ImGui::SliderInt("Planets", &m_settings.numPlanets, 0, 120);
+    resized |= ImGui::SliderFloat("Corridor", &m_settings.corridorWidth, 1.0f,
+                                  100.0f);
+    resized |= ImGui::SliderFloat("Length", &m_settings.corridorLength, 10.0f,
+                                  1000.0f);
+    const bool speedChanged{
+        ImGui::SliderFloat("Speed", &m_settings.speed, 0.0f, 100.0f)};
+    if (resized || speedChanged) requestSceneChange(resized);
+    if (ImGui::Checkbox("Simulation thread", &m_settings.threaded)) {
+      setSimulationThreaded(m_settings.threaded);
+    }
+    if (ImGui::Checkbox("Render thread", &m_settings.renderThread)) {
+      setRenderThreaded(m_settings.renderThread);
+    }
+    const auto &snapshot{m_snapshots.getReadBuffer()};
+    ImGui::Text("Sectors: %zu active, %zu allocated", snapshot.sectors.size(),
+                snapshot.numAllocatedSectors);
+    ImGui::Text("Simulation: %.2f ms, render: %.2f ms",
+                getSimulationCost() * 1000.0, getRenderCost() * 1000.0);
+    if (isRenderThreaded()) {
+      ImGui::Text("Submission: %.2f ms", getSubmitCost() * 1000.0);
+    }
+    ImGui::Text("Loops: %.0f frames/s, %.0f ticks/s", getFrameRate(),
+                getTickRate());
+    const auto frameTime{getFrameTimeStatistics()};
+    ImGui::Text("Frame time: %.2f ms, sd %.2f ms, max %.2f ms",
+                frameTime.mean * 1000.0, frameTime.deviation * 1000.0,
+                frameTime.max * 1000.0);
+    if (m_settings.stress) {
+      ImGui::Text("Stress: %d sustainable%s", m_stress.sustainable,
+                  m_stress.done ? "" : " (ramping)");
+    }
+    ImGui::End();
+  }
+
   {
     const auto size{ImVec2(150, 150)};
     const auto position{ImVec2((m_viewportWidth - size.x) / 2.0f,
@@ -300,7 +548,7 @@ void OpenGLWindow::paintUI() {
                            ImGuiWindowFlags_NoTitleBar |
                            ImGuiWindowFlags_NoInputs};
     ImGui::Begin(" ", nullptr, flags);
-    if(lost) ImGui::Text(" *GAME OVER!* ");
+    if (m_snapshots.getReadBuffer().game.lost) ImGui::Text(" *GAME OVER!* ");
     ImGui::End();
   }
 }
@@ -319,6 +567,7 @@ void OpenGLWindow::terminateGL() {
   for (const auto& program : m_programs) {
     abcg::glDeleteProgram(program);
   }
+  m_programs.clear();
   terminateSkybox();
 }
 
@@ -328,53 +577,173 @@ void OpenGLWindow::terminateSkybox() {
   abcg::glDeleteVertexArrays(1, &m_skyVAO);	
 }
 
-void OpenGLWindow::update() {
-  score++;
-  float rndAst = sin(getElapsedTime())*3.0f;
-  const float deltaTime{static_cast<float>(getDeltaTime())};
-  m_angle = glm::wrapAngle(m_angle + glm::radians(90.0f) * deltaTime);
-  for (const auto index : iter::range(m_numPlanets)) {
-    auto &position{m_planetPositions.at(index)};
-    auto &rotation{m_planetRotations.at(index)};
-    position.z += deltaTime * 10.0f;
-    if (position.z > 0.1f) {
-      randomizePlanet(position, rotation);
-      position.z = -100.0f;
-    }
-    if(lost) position.z = 20.0f;
-  } 
-
-   for (const auto index : iter::range(m_numAsteroids)) {
-    auto &position{m_asteroidPositions.at(index)};
-    auto &rotation{m_asteroidRotations.at(index)};
-    position.z += deltaTime * 10.0f;
-    position.y += deltaTime* rndAst;
-    if(!lost){
-      if (position.z > 0.1f) {
-        randomizeAsteroid(position, rotation);
-        position.z = -100.0f;
-      }
-      if ((m_shipPosition.x <= position.x + 1.0f && m_shipPosition.x >= position.x - 1.0f) && (m_shipPosition.y <= position.y + 1.0f && m_shipPosition.y >= position.y - 1.0f) && (m_shipPosition.z <= position.z + 1.0f && m_shipPosition.z >= position.z - 1.0f)){
-        if(m_hitTimer.elapsed() >= 1){
-          hp_qtt--;
-          if(hp_qtt == 0){
-            m_restartWaitTimer.restart();
-            m_shipPosition.z = 20.0f;
-            lost = true;            
-          }
-          m_hitTimer.restart();
-        }
-      }
-    } else {
-      score = 0;
-      position.z = 20.0f;
+// Advances the game by one tick of the fixed-rate simulation
+void OpenGLWindow::simulate(double timeStep) {
+  applySceneChanges();
+
+  const float deltaTime{static_cast<float>(timeStep)};
+  m_game.previousShipPosition = m_game.shipPosition;
+  m_game.previousAngle = m_game.angle;
+  m_game.time += timeStep;
+  m_game.timeSinceHit += timeStep;
+
+  moveShip(deltaTime);
+  m_game.angle = glm::wrapAngle(m_game.angle + spinSpeed * deltaTime);
+
+  // Motion, retirement and generation of the sectors
+  const auto drift{std::sin(static_cast<float>(m_game.time)) * 3.0f};
+  m_game.fieldStep = deltaTime * glm::vec2{drift, m_simulationSettings.speed};
+  m_sectors.advance(m_game.fieldStep.x, m_game.fieldStep.y);
+
+  if (m_game.lost) {
+    m_game.timeSinceLost += timeStep;
+    if (m_game.timeSinceLost > restartDelay) restart();
+  } else {
+    m_game.score = static_cast<int>(m_game.time * scorePerSecond);
+    // The stress test runs without damage so that it never restarts
+    if (!m_simulationSettings.stress) checkCollisions();
+  }
+  publishSnapshot();
+}
+
+// Takes a hit from the asteroids overlapping the ship
+void OpenGLWindow::checkCollisions() {
+  // Broadphase on bounding spheres, then mesh against mesh for the
+  // candidates only
+  const auto shipRadius{0.07f * getBoundingRadius(m_ship.getBVH())};
+  bool hit{};
+  for (const auto &placed : m_sectors.getSectors()) {
+    // Query the spatial hash of the sector in its local space
+    placed.sector->asteroids.findOverlaps(m_game.shipPosition - placed.offset,
+                                          shipRadius, m_overlaps);
+    hit = hit || std::any_of(m_overlaps.begin(), m_overlaps.end(),
+                             [&](std::size_t index) {
+                               return collidesWithShip(placed, index);
+                             });
+  }
+  if (hit && m_game.timeSinceHit >= hitCooldown) {
+    m_game.hp--;
+    if (m_game.hp == 0) {
+      m_game.shipPosition.z = 20.0f;
+      m_game.previousShipPosition = m_game.shipPosition;
+      m_game.score = 0;
+      m_game.lost = true;
+      m_sectors.clear();
     }
+    m_game.timeSinceHit = 0.0;
   }
+}
+
+// Moves the ship with the held keys, within the corridor of the camera
+void OpenGLWindow::moveShip(float deltaTime) {
+  const auto controls{m_controls.load(std::memory_order_relaxed)};
+  glm::vec2 direction{};
+  if ((controls & controlUp) != 0) direction.y += 1.0f;
+  if ((controls & controlDown) != 0) direction.y -= 1.0f;
+  if ((controls & controlLeft) != 0) direction.x -= 1.0f;
+  if ((controls & controlRight) != 0) direction.x += 1.0f;
+  const glm::vec2 position{
+      glm::clamp(glm::vec2{m_game.shipPosition} +
+                     shipSpeed * deltaTime * direction,
+                 -shipRange, shipRange)};
+  m_game.shipPosition.x = position.x;
+  m_game.shipPosition.y = position.y;
+}
+
+// Hands the state of the tick over to rendering
+void OpenGLWindow::publishSnapshot() {
+  auto &snapshot{m_snapshots.getWriteBuffer()};
+  snapshot.time = getSimulationTime();
+  snapshot.game = m_game;
+  const auto sectors{m_sectors.getSectors()};
+  snapshot.sectors.assign(sectors.begin(), sectors.end());
+  snapshot.sectorVersion = m_sectors.getVersion();
+  snapshot.numAllocatedSectors = m_sectors.getNumAllocated();
+  m_snapshots.publish();
+}
+
+// Takes the latest snapshot and blends its last two ticks for the frame
+// being rendered. The asteroids and planets all move by the same step in a
+// tick, so they only need a common translation.
+void OpenGLWindow::interpolate() {
+  m_snapshots.update();
+  const auto &snapshot{m_snapshots.getReadBuffer()};
+  // Older snapshots are no longer read, so the sectors they alone showed
+  // can be reused
+  m_sectors.release(snapshot.sectorVersion);
+  const auto &game{snapshot.game};
+  const auto step{getSimulationStep()};
+  const auto alpha{static_cast<float>(std::clamp(
+      (getPresentationTime() - snapshot.time) / step + 1.0, 0.0, 1.0))};
 
-  if(lost && m_restartWaitTimer.elapsed() > 4) restart();   
+  m_render.shipPosition =
+      glm::mix(game.previousShipPosition, game.shipPosition, alpha);
+
+  auto spin{game.angle - game.previousAngle};
+  if (spin < 0.0f) spin += glm::two_pi<float>();
+  m_render.angle = glm::wrapAngle(game.previousAngle + alpha * spin);
+
+  const auto lag{(alpha - 1.0f) * game.fieldStep};
+  m_render.fieldLag = {0.0f, lag.x, lag.y};
+}
+
+// Passes the scene settings edited on the UI to the simulation
+void OpenGLWindow::requestSceneChange(bool resize) {
+  const std::lock_guard lock{m_sceneMutex};
+  m_pendingSettings = m_settings;
+  m_pendingResize = m_pendingResize || resize;
+  m_sceneChanged.store(true, std::memory_order_release);
+}
+
+void OpenGLWindow::applySceneChanges() {
+  if (!m_sceneChanged.exchange(false, std::memory_order_acquire)) return;
+  bool resize{};
+  {
+    const std::lock_guard lock{m_sceneMutex};
+    m_simulationSettings = m_pendingSettings;
+    resize = std::exchange(m_pendingResize, false);
+  }
+  if (resize) resizeScene();
+}
+
+void OpenGLWindow::updateStress() {
+  auto &stress{m_stress};
+  if (stress.done) return;
+
+  if (++stress.frames <= stressWarmupFrames) {
+    stress.frameTimeSum = 0.0;
+    stress.timer.restart();
+    return;
+  }
+  stress.frameTimeSum += getDeltaTime();
+  if (stress.timer.elapsed() < stressWindow) return;
+
+  const auto average{stress.frameTimeSum * 1000.0 /
+                     (stress.frames - stressWarmupFrames)};
+  if (average <= m_settings.stressBudget) {
+    fmt::print("Stress: {} asteroids, {:.2f} ms/frame\n",
+               m_settings.numAsteroids, average);
+    stress.sustainable = m_settings.numAsteroids;
+    m_settings.numAsteroids = std::min(
+        10'000'000, std::max(m_settings.numAsteroids + 1,
+                             m_settings.numAsteroids / 2 * 3));
+  } else {
+    fmt::print(
+        "Stress: {} asteroids, {:.2f} ms/frame exceeds the {:.2f} ms "
+        "budget\nSustainable: {} asteroids\n",
+        m_settings.numAsteroids, average, m_settings.stressBudget,
+        stress.sustainable);
+    m_settings.numAsteroids = stress.sustainable;
+    stress.done = true;
+  }
+  requestSceneChange(true);
+  stress.frames = 0;
 }
 
+// Starts a new game. Only game state is reset: programs, models and
+// textures created by initializeGL are kept.
 void OpenGLWindow::restart() {
-    lost = false;
-    initializeGL();
+  m_game = GameState{};
+  ++m_round;
+  resizeScene();
 }
\ No newline at end of file
@@ -1,30 +1,58 @@
 #ifndef OPENGLWINDOW_HPP_
 #define OPENGLWINDOW_HPP_
 
-#include <random>
+#include <atomic>
+#include <mutex>
 
 #include "abcg.hpp"
+#include "asteroidfield.hpp"
+#include "gamestate.hpp"
 #include "model.hpp"
+#include "scenesettings.hpp"
+#include "sectorfield.hpp"
 
 class OpenGLWindow : public abcg::OpenGLWindow {
+ public:
+  explicit OpenGLWindow(const SceneSettings &settings = {})
+      : m_settings{settings} {}
+
  protected:
   void handleEvent(SDL_Event& handleEvent) override;
   void initializeGL() override;
   void paintGL() override;
   void paintUI() override;
   void resizeGL(int width, int height) override;
+  void simulate(double timeStep) override;
   void terminateGL() override;
 
+  // Simulation side; protected so that the tests can restart games
+  void restart();
+
  private:
-  static const int m_numAsteroids{180};
-  static const int m_numPlanets{24};
+  // Settings edited on the UI. The simulation works on its own copy, which
+  // takes the changes at the start of a tick.
+  SceneSettings m_settings;
+  SceneSettings m_simulationSettings;
+  std::mutex m_sceneMutex;
+  SceneSettings m_pendingSettings;
+  bool m_pendingResize{};
+  std::atomic<bool> m_sceneChanged{};
+
+  // Stress mode: the number of asteroids grows while the average frame time
+  // over a measurement window stays within budget
+  struct StressState {
+    abcg::ElapsedTimer timer;
+    double frameTimeSum{};
+    int frames{};
+    int sustainable{};
+    bool done{false};
+  } m_stress;
 
   std::vector<GLuint> m_programs;
 
   int m_viewportWidth{};
   int m_viewportHeight{};
 
-  std::default_random_engine m_randomEngine;
 
   Model m_asteroid;
   Model m_ship;
@@ -32,30 +60,98 @@ class OpenGLWindow : public abcg::OpenGLWindow {
   Model m_planetRound;
   Model m_skybox;
 
-  std::array<glm::vec3, m_numAsteroids> m_asteroidPositions;
-  std::array<glm::vec3, m_numAsteroids> m_asteroidRotations;
-  std::array<glm::vec3, m_numPlanets> m_planetPositions;
-  std::array<glm::vec3, m_numPlanets> m_planetRotations;
+  // Workers for model loading, sector generation, culling and instance
+  // matrices. Declared before the users so that it is destroyed after them.
+  abcg::JobSystem m_jobs;
+
+  SectorField m_sectors{m_jobs};
+  // Number of restarts, mixed into the seed so that each game differs
+  int m_round{};
+  // Planets of the active sectors, gathered for each frame
+  std::vector<glm::vec3> m_planetPositions;
+  std::vector<glm::vec3> m_planetRotations;
+  std::vector<std::uint8_t> m_planetIsRound;
+
+  // Occlusion culling of asteroids hidden behind planets and near asteroids
+  abcg::OcclusionCuller m_occlusionCuller{128, 128};
+  std::vector<abcg::BoundingBox> m_asteroidBoxes;
+
+  // Model and normal matrices computed in batch for each frame
+  struct TransformScratch {
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> scale;
+    std::vector<float> axisX, axisY, axisZ;
+  } m_transformScratch;
+  std::vector<abcg::InstanceMatrices> m_asteroidMatrices;
+  std::vector<abcg::InstanceMatrices> m_planetMatrices;
+
+  // Everything the draw commands of a frame read, one per frame slot so
+  // that the render thread can execute a frame while the next is built
+  struct FrameData {
+    glm::mat4 viewMatrix{1.0f};
+    glm::mat4 projMatrix{1.0f};
+    GLuint program{};
+    int mappingMode{};
+    int viewportWidth{};
+    int viewportHeight{};
+    abcg::InstanceMatrices ship{};
+    std::vector<abcg::InstanceMatrices> planetRing;
+    std::vector<abcg::InstanceMatrices> planetRound;
+    std::vector<abcg::InstanceMatrices> asteroids;
+  };
+  std::vector<FrameData> m_frames;
   
-  float m_angle{};
-  int score = 0;
-  int finalScore;
+  // Simulation side: game state, sector stream and collision scratch
+  GameState m_game;
+  std::vector<std::size_t> m_overlaps;
+
+  // Arrow or WASD keys held down, set by the event handler and read by the
+  // simulation
+  std::atomic<std::uint8_t> m_controls{};
+
+  // State of a simulation tick, handed over to rendering without locks. The
+  // sectors belong to the sector field, which does not reuse them until
+  // rendering releases their version.
+  struct Snapshot {
+    GameState game;
+    double time{};
+    std::vector<PlacedSector> sectors;
+    std::uint64_t sectorVersion{};
+    std::size_t numAllocatedSectors{};
+  };
+  abcg::TripleBuffer<Snapshot> m_snapshots;
+
+  // Snapshot interpolated between its last two ticks
+  struct RenderState {
+    glm::vec3 shipPosition{};
+    float angle{};
+    // Translation of the asteroids and planets back to the previous tick
+    glm::vec3 fieldLag{};
+  } m_render;
 
   glm::mat4 m_viewMatrix{1.0f};
   glm::mat4 m_projMatrix{1.0f};
   float m_FOV{140.0f};
 
-  int hp_qtt{2};
-  abcg::ElapsedTimer m_hitTimer;
-  bool lost{false};
-  abcg::ElapsedTimer m_restartWaitTimer;
 
-  void randomizeAsteroid(glm::vec3 &position, glm::vec3 &rotation);
-  void randomizePlanet(glm::vec3 &position, glm::vec3 &rotation);
 
-  void update();
-  void restart();
-  glm::vec3 m_shipPosition = glm::vec3(0.0f, 0.0f, 0.0f);
+  void moveShip(float deltaTime);
+  void checkCollisions();
+  void publishSnapshot();
+  void interpolate();
+  void requestSceneChange(bool resize);
+  void applySceneChanges();
+  void updateStress();
+  void resizeScene();
+  bool collidesWithShip(const PlacedSector &placed,
+                        std::size_t asteroidIndex) const;
+  void gatherPlanets();
+  void renderFrame(const FrameData &frame);
+  void renderAsteroids(const FrameData &frame);
+  void cullAsteroids();
+  void computeMatrices(std::span<const glm::vec3> positions,
+                       std::span<const glm::vec3> rotations, float scale,
+                       std::vector<abcg::InstanceMatrices> &matrices);
   std::vector<const char*> m_shaderNames{"texture"};
   int m_currentProgramIndex{};
   int m_mappingMode{};
@@ -82,7 +178,8 @@ class OpenGLWindow : public abcg::OpenGLWindow {
   void initializeSkybox();
   void renderSkybox();
   void terminateSkybox();
-  void loadModel(std::string path_obj, std::string path_text, Model &model);
+  void loadModels();
+  void setupModel(std::string path_obj, std::string path_text, Model &model);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include "scenesettings.hpp"
+
+#include <fmt/core.h>
+
+#include <cstdlib>
+#include <span>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "abcg.hpp"
+
+namespace {
+template <typename T>
+T parseValue(const std::string &option, const std::string &text, T min,
+             T max) {
+  const char *begin{text.c_str()};
+  char *end{};
+  const auto value{std::strtod(begin, &end)};
+  if (end == begin || *end != '\0' || value < static_cast<double>(min) ||
+      value > static_cast<double>(max)) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        fmt::format("Invalid value for {}: {}", option, text))};
+  }
+  return static_cast<T>(value);
+}
+
+void parseOptions(const std::vector<std::string> &options,
+                  SceneSettings &settings) {
+  for (std::size_t index{}; index < options.size(); ++index) {
+    const auto &option{options.at(index)};
+    if (option == "--stress") {
+      settings.stress = true;
+      continue;
+    }
+    if (option == "--hidden") {
+      settings.hidden = true;
+      continue;
+    }
+    if (option == "--vsync") {
+      settings.vsync = true;
+      continue;
+    }
+    if (option == "--threaded") {
+      settings.threaded = true;
+      continue;
+    }
+    if (option == "--render-thread") {
+      settings.renderThread = true;
+      continue;
+    }
+
+    if (index + 1 >= options.size()) {
+      throw abcg::Exception{abcg::Exception::Runtime(
+          fmt::format("Missing value for {}", option))};
+    }
+    const auto &value{options.at(++index)};
+    if (option == "--asteroids") {
+      settings.numAsteroids = parseValue(option, value, 0, 10'000'000);
+    } else if (option == "--planets") {
+      settings.numPlanets = parseValue(option, value, 0, 10'000);
+    } else if (option == "--corridor") {
+      settings.corridorWidth = parseValue(option, value, 1.0f, 1000.0f);
+    } else if (option == "--length") {
+      settings.corridorLength = parseValue(option, value, 10.0f, 10000.0f);
+    } else if (option == "--sector") {
+      settings.sectorLength = parseValue(option, value, 1.0f, 1000.0f);
+    } else if (option == "--speed") {
+      settings.speed = parseValue(option, value, 0.0f, 1000.0f);
+    } else if (option == "--tick") {
+      settings.tickRate = parseValue(option, value, 1.0f, 10000.0f);
+    } else if (option == "--fps") {
+      settings.frameRate = parseValue(option, value, -1.0, 10000.0);
+    } else if (option == "--background-fps") {
+      settings.backgroundFrameRate = parseValue(option, value, 0.0, 10000.0);
+    } else if (option == "--budget") {
+      settings.stressBudget = parseValue(option, value, 1.0f, 1000.0f);
+    } else if (option == "--seed") {
+      settings.seed = parseValue(option, value, 0U, 0xFFFFFFFFU);
+    } else if (option == "--record") {
+      settings.recordPath = value;
+    } else if (option == "--replay") {
+      settings.replayPath = value;
+    } else if (option == "--report") {
+      settings.reportPath = value;
+    } else if (option == "--trace") {
+      settings.tracePath = value;
+    } else if (option == "--hitches") {
+      settings.hitchDirectory = value;
+    } else {
+      throw abcg::Exception{abcg::Exception::Runtime(
+          fmt::format("Unknown option {}", option))};
+    }
+  }
+}
+}  // namespace
+
+SceneSettings parseSceneSettings(int argc, char **argv) {
+  SceneSettings settings;
+
+  // NOLINTNEXTLINE(concurrency-mt-unsafe)
+  if (const auto *environment{std::getenv("AVOIDASTEROIDS_OPTIONS")}) {
+    std::istringstream stream{environment};
+    std::vector<std::string> options;
+    for (std::string option; stream >> option;) {
+      options.push_back(option);
+    }
+    parseOptions(options, settings);
+  }
+
+  const std::span arguments{argv, static_cast<std::size_t>(argc)};
+  if (arguments.size() > 1) {
+    parseOptions({arguments.begin() + 1, arguments.end()}, settings);
+  }
+  return settings;
+}
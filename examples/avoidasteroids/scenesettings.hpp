@@ -0,0 +1,66 @@
+#ifndef SCENESETTINGS_HPP_
+#define SCENESETTINGS_HPP_
+
+#include <cstdint>
+#include <string>
+
+// Scene scale and speed, read from the AVOIDASTEROIDS_OPTIONS environment
+// variable and then from the command line (which takes precedence):
+//
+//   --asteroids N    number of asteroids within the view distance
+//                    (default 180)
+//   --planets N      number of planets within the view distance (default 12)
+//   --corridor W     half width of the asteroid corridor (default 20)
+//   --length L       view distance along -z (default 100)
+//   --sector L       length of the streamed sectors (default 25)
+//   --speed S        speed of asteroids and planets (default 10)
+//   --tick HZ        simulation tick rate (default 120)
+//   --fps HZ         frame rate limit; 0 for the display refresh rate
+//                    (default), -1 for no limit
+//   --vsync          synchronize buffer swaps with the display
+//   --background-fps HZ
+//                    frame rate limit while the window is not focused; 0 for
+//                    no reduction (default 15)
+//   --threaded       run the simulation on its own thread (ignored while
+//                    recording or replaying)
+//   --render-thread  issue the OpenGL commands from a render thread
+//   --stress         ramp the number of asteroids up to the frame budget
+//   --budget MS      stress mode frame time budget in milliseconds
+//                    (default 20)
+//   --seed N         seed of the asteroid and planet placement (default 0)
+//   --record FILE    record the input and the seed of the session to FILE
+//   --replay FILE    replay a recorded session and print its frame times
+//   --report FILE    write the frame times of a recorded or replayed session
+//                    to a CSV file
+//   --trace FILE     record a Chrome trace (chrome://tracing, Perfetto) of
+//                    the session to FILE
+//   --hitches DIR    write a trace of each frame longer than twice the
+//                    median frame time to DIR
+//   --hidden         create a hidden window (for replays)
+struct SceneSettings {
+  int numAsteroids{180};
+  int numPlanets{12};
+  float corridorWidth{20.0f};
+  float corridorLength{100.0f};
+  float sectorLength{25.0f};
+  float speed{10.0f};
+  float tickRate{120.0f};
+  double frameRate{0.0};
+  bool vsync{false};
+  double backgroundFrameRate{15.0};
+  bool threaded{false};
+  bool renderThread{false};
+  bool stress{false};
+  float stressBudget{20.0f};
+  std::uint32_t seed{};
+  std::string recordPath;
+  std::string replayPath;
+  std::string reportPath;
+  std::string tracePath;
+  std::string hitchDirectory;
+  bool hidden{false};
+};
+
+SceneSettings parseSceneSettings(int argc, char **argv);
+
+#endif
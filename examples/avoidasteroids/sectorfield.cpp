@@ -0,0 +1,219 @@
+#include "sectorfield.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Distance behind the camera at which the far edge of a sector is retired
+const float retireMargin{2.0f};
+
+// Random dimensions of the planets; asteroids use dimensions 0-4
+const std::uint32_t planetDimension{8};
+
+// Planets follow a pattern of 12: 0-2 and 9-11 with rings, 3-8 round
+bool isRoundPlanet(std::size_t index) {
+  const auto slot{index % 12};
+  return slot >= 3 && slot < 9;
+}
+
+// Moves a point of [-10, 10]^2 out of the corridor: diagonally if it is near
+// a corner, along its dominant axis otherwise
+glm::vec2 moveOutOfCorridor(glm::vec2 point) {
+  const glm::vec2 direction{point.x > 0.0f ? 1.0f : -1.0f,
+                            point.y > 0.0f ? 1.0f : -1.0f};
+  const auto distance{glm::abs(point)};
+  if (distance.x >= 5.0f && distance.y >= 5.0f) {
+    return point + 10.0f * direction;
+  }
+  if (distance.x > distance.y) return {point.x + 10.0f * direction.x, point.y};
+  return {point.x, point.y + 10.0f * direction.y};
+}
+}  // namespace
+
+SectorField::~SectorField() {
+  releaseAll();
+  for (auto *slot : m_discarded) {
+    m_jobs.wait(slot->ready);
+  }
+}
+
+// Drops every sector and restarts the stream at the given distance with a
+// new layout
+void SectorField::reset(const Layout &layout, double distance) {
+  releaseAll();
+  m_layout = layout;
+  m_distance = distance;
+  m_nextIndex = std::max<std::int64_t>(
+      0, static_cast<std::int64_t>(
+             std::floor(distance / static_cast<double>(layout.sectorLength))));
+  m_enabled = true;
+  advance(0.0f, 0.0f);
+}
+
+// Drops every sector, rewinds to the start and stops streaming until the
+// next reset
+void SectorField::clear() {
+  releaseAll();
+  m_enabled = false;
+  m_distance = 0.0;
+}
+
+// Moves the field by (0, deltaY, deltaZ), retires the sectors behind the
+// camera and activates the ones entering the view distance whose generation
+// is done. Sectors are activated in order, so a sector still being generated
+// holds back the ones behind it; it is requested one sector early, so this
+// only happens after a reset. A sector starts drifting along y when it is
+// activated.
+void SectorField::advance(float deltaY, float deltaZ) {
+  if (!m_enabled) return;
+  m_distance += deltaZ;
+  ++m_version;
+
+  for (auto *slot : m_active) {
+    slot->offsetY += deltaY;
+  }
+
+  m_sectors.clear();
+  while (!m_active.empty() &&
+         getNearZ(m_active.front()->sector.index) - m_layout.sectorLength >
+             retireMargin) {
+    m_active.front()->retiredVersion = m_version;
+    m_free.push_back(m_active.front());
+    m_active.erase(m_active.begin());
+  }
+
+  const auto requestDistance{m_distance + m_layout.viewDistance +
+                             m_layout.sectorLength};
+  while (static_cast<double>(m_nextIndex) * m_layout.sectorLength <
+         requestDistance) {
+    request(m_nextIndex++);
+  }
+
+  while (!m_pending.empty() && m_pending.front()->ready.isDone() &&
+         getNearZ(m_pending.front()->sector.index) > -m_layout.viewDistance) {
+    auto *slot{m_pending.front()};
+    m_pending.erase(m_pending.begin());
+    // Rethrows the exception of a failed generation
+    m_jobs.wait(slot->ready);
+    slot->offsetY = 0.0f;
+    m_active.push_back(slot);
+  }
+
+  for (auto *slot : m_active) {
+    m_sectors.push_back(
+        {&slot->sector, {0.0f, slot->offsetY, getNearZ(slot->sector.index)}});
+  }
+}
+
+std::size_t SectorField::getNumAsteroids() const {
+  std::size_t count{};
+  for (const auto &placed : m_sectors) {
+    count += placed.sector->asteroids.size();
+  }
+  return count;
+}
+
+// Called by the reader of the placements, on any thread, once it no longer
+// reads the placements of versions older than the given one. The release
+// store orders those reads before the reuse of the sectors they showed.
+void SectorField::release(std::uint64_t version) {
+  m_releasedVersion.store(version, std::memory_order_release);
+}
+
+// Camera-space z of the near edge of a sector
+float SectorField::getNearZ(std::int64_t index) const {
+  return static_cast<float>(
+      m_distance - static_cast<double>(index) * m_layout.sectorLength);
+}
+
+// Generates a sector in a free slot that the reader has released, or in a
+// new slot if it may still read all of them
+void SectorField::request(std::int64_t index) {
+  // Slots dropped by a reset are free once their generation is done
+  std::erase_if(m_discarded, [&](Slot *slot) {
+    if (!slot->ready.isDone()) return false;
+    m_jobs.wait(slot->ready);
+    m_free.push_back(slot);
+    return true;
+  });
+
+  // Pairs with the store in release: the reads of a released sector happen
+  // before it is regenerated
+  const auto released{m_releasedVersion.load(std::memory_order_acquire)};
+  auto free{std::find_if(m_free.begin(), m_free.end(), [&](const Slot *slot) {
+    return slot->retiredVersion <= released;
+  })};
+  if (free == m_free.end()) {
+    m_slots.push_back(std::make_unique<Slot>());
+    free = m_free.insert(m_free.end(), m_slots.back().get());
+    // Room for every slot, so that a reset does not allocate
+    m_discarded.reserve(m_slots.size());
+  }
+  auto *slot{*free};
+  m_free.erase(free);
+  slot->sector.index = index;
+  slot->layout = m_layout;
+  m_jobs.run([slot] { generate(*slot); }, &slot->ready);
+  m_pending.push_back(slot);
+}
+
+// Fills the sector of a slot in its local space (near edge at z = 0), with
+// the layout of the slot. Runs on a worker thread.
+void SectorField::generate(Slot &slot) {
+  const auto &layout{slot.layout};
+  auto &sector{slot.sector};
+  const auto seed{layout.seed};
+  const auto generation{static_cast<std::uint32_t>(sector.index)};
+  const auto width{layout.corridorWidth};
+  const auto length{layout.sectorLength};
+
+  sector.asteroids.resize(layout.asteroidsPerSector, layout.asteroidScale);
+  sector.asteroids.randomize(seed, generation,
+                             {{-width, -width, -length}, {width, width, 0.0f}});
+  sector.asteroids.buildIndex(layout.asteroidRadius);
+
+  const auto numPlanets{layout.planetsPerSector};
+  auto &[keys, x, y, z, axisX, axisY]{slot.scratch};
+  keys.resize(numPlanets);
+  for (std::size_t index{}; index < numPlanets; ++index) {
+    keys[index] =
+        abcg::makeRandomKey(static_cast<std::uint32_t>(index), generation);
+  }
+  for (auto *values : {&x, &y, &z, &axisX, &axisY}) {
+    values->resize(numPlanets);
+  }
+  abcg::fillUniform(seed, keys, planetDimension + 0, x, -10.0f, 10.0f);
+  abcg::fillUniform(seed, keys, planetDimension + 1, y, -10.0f, 10.0f);
+  abcg::fillUniform(seed, keys, planetDimension + 2, z, -length, 0.0f);
+  abcg::fillUniform(seed, keys, planetDimension + 3, axisX, -1.0f, 1.0f);
+  abcg::fillUniform(seed, keys, planetDimension + 4, axisY, -1.0f, 1.0f);
+
+  sector.planetPositions.resize(numPlanets);
+  sector.planetAxes.resize(numPlanets);
+  sector.planetIsRound.resize(numPlanets);
+  for (std::size_t index{}; index < numPlanets; ++index) {
+    const auto xy{moveOutOfCorridor({x[index], y[index]})};
+    sector.planetPositions[index] = {xy, z[index]};
+    // Planets spin around an axis in the xy plane
+    sector.planetAxes[index] =
+        glm::normalize(glm::vec3(axisX[index], axisY[index], 0.0f));
+    const auto number{static_cast<std::size_t>(sector.index) * numPlanets +
+                      index};
+    sector.planetIsRound[index] = isRoundPlanet(number) ? 1 : 0;
+  }
+}
+
+// Returns every slot to the free list without waiting for the generation
+// jobs still running. Pending sectors were never placed, so they are free as
+// soon as they are generated: until then they are discarded.
+void SectorField::releaseAll() {
+  ++m_version;
+  m_discarded.insert(m_discarded.end(), m_pending.begin(), m_pending.end());
+  m_pending.clear();
+  for (auto *slot : m_active) {
+    slot->retiredVersion = m_version;
+    m_free.push_back(slot);
+  }
+  m_active.clear();
+  m_sectors.clear();
+}
@@ -0,0 +1,123 @@
+#ifndef SECTORFIELD_HPP_
+#define SECTORFIELD_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "abcg.hpp"
+#include "asteroidfield.hpp"
+
+// Slice of the corridor along -z with its own asteroids and planets, in a
+// local space where the near edge of the sector is at z = 0. The content
+// does not change while the sector is active, so it can be shared with the
+// renderer.
+struct Sector {
+  std::int64_t index{};
+  AsteroidField asteroids;
+  std::vector<glm::vec3> planetPositions;
+  std::vector<glm::vec3> planetAxes;
+  std::vector<std::uint8_t> planetIsRound;
+};
+
+// Active sector and its translation from local to camera space
+struct PlacedSector {
+  const Sector *sector{};
+  glm::vec3 offset{};
+};
+
+// Unbounded field streamed in sectors. Sector k covers the distances
+// [k * length, (k + 1) * length) travelled from the start and only depends
+// on (seed, k). Sectors are generated on worker threads one sector ahead of
+// the view distance, activated once their generation is done, and retired
+// once they are behind the camera, so memory depends on the view distance
+// and the density, not on the distance travelled. Moving the field only
+// changes the offsets of the sectors. A reset does not wait for the new
+// sectors either: the stream fills in over the next advances.
+// A retired sector is reused once the reader of the placements has released
+// every version that still showed it (see release), so the field stops
+// allocating after a few sectors.
+class SectorField {
+ public:
+  struct Layout {
+    float sectorLength{25.0f};
+    float viewDistance{100.0f};
+    float corridorWidth{20.0f};
+    float asteroidScale{1.2f};
+    // Radius of the bounding sphere of a scaled asteroid, for collisions
+    float asteroidRadius{1.2f};
+    std::size_t asteroidsPerSector{};
+    std::size_t planetsPerSector{};
+    std::uint64_t seed{};
+  };
+
+  explicit SectorField(abcg::JobSystem &jobs) : m_jobs{jobs} {}
+  ~SectorField();
+
+  SectorField(const SectorField &) = delete;
+  SectorField(SectorField &&) = delete;
+  SectorField &operator=(const SectorField &) = delete;
+  SectorField &operator=(SectorField &&) = delete;
+
+  void reset(const Layout &layout, double distance = 0.0);
+  void clear();
+  void advance(float deltaY, float deltaZ);
+
+  // Active sectors, nearest first
+  [[nodiscard]] std::span<const PlacedSector> getSectors() const {
+    return m_sectors;
+  }
+  [[nodiscard]] std::size_t getNumAsteroids() const;
+  [[nodiscard]] std::size_t getNumAllocated() const { return m_slots.size(); }
+  [[nodiscard]] double getDistance() const { return m_distance; }
+
+  // Version of the placements returned by getSectors
+  [[nodiscard]] std::uint64_t getVersion() const { return m_version; }
+  void release(std::uint64_t version);
+
+ private:
+  struct Slot {
+    Sector sector;
+    float offsetY{};
+    // Layout of the generation, copied so that a reset does not change it
+    // under a running job
+    Layout layout;
+    // First version whose placements do not show the sector
+    std::uint64_t retiredVersion{};
+    abcg::JobSystem::Counter ready;
+    // Planet samples, kept so that generating into a reused slot does not
+    // allocate
+    struct Scratch {
+      std::vector<std::uint64_t> keys;
+      std::vector<float> x, y, z;
+      std::vector<float> axisX, axisY;
+    } scratch;
+  };
+
+  abcg::JobSystem &m_jobs;
+  Layout m_layout{};
+  bool m_enabled{false};
+  double m_distance{};
+  std::int64_t m_nextIndex{};
+
+  std::vector<std::unique_ptr<Slot>> m_slots;
+  std::vector<Slot *> m_free;
+  // Vectors rather than deques, which allocate as they move along
+  std::vector<Slot *> m_pending;
+  std::vector<Slot *> m_active;
+  // Slots dropped by a reset while their generation was running
+  std::vector<Slot *> m_discarded;
+  std::vector<PlacedSector> m_sectors;
+  std::uint64_t m_version{};
+  // Set by the reader of the placements, possibly on another thread
+  std::atomic<std::uint64_t> m_releasedVersion{};
+
+  [[nodiscard]] float getNearZ(std::int64_t index) const;
+  void request(std::int64_t index);
+  static void generate(Slot &slot);
+  void releaseAll();
+};
+
+#endif
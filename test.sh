@@ -0,0 +1,32 @@
+#!/bin/bash
+set -euo pipefail
+
+BUILD_TYPE=Release
+
+if [[ "$OSTYPE" == "darwin"* ]]; then
+  # macOS
+  NUM_PROCESSORS=$(sysctl -n hw.ncpu)
+else
+  NUM_PROCESSORS=$(nproc)
+fi
+
+# The tests run in two builds: one with the default options, and one with
+# the counting of heap allocations, which is off by default and without
+# which the allocation test is skipped
+for ALLOCATION_TRACKING in OFF ON; do
+  BUILD_DIR=build-tests-allocations-$ALLOCATION_TRACKING
+
+  # Reset build directory
+  rm -rf $BUILD_DIR
+  mkdir -p $BUILD_DIR
+
+  # Configure
+  cmake -S . -B $BUILD_DIR -DCMAKE_BUILD_TYPE=$BUILD_TYPE -DENABLE_TESTS=ON \
+    -DENABLE_ALLOCATION_TRACKING=$ALLOCATION_TRACKING
+
+  # Build
+  cmake --build $BUILD_DIR --config $BUILD_TYPE -- -j $NUM_PROCESSORS
+
+  # Test
+  (cd $BUILD_DIR && ctest --build-config $BUILD_TYPE --output-on-failure)
+done
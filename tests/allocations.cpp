@@ -0,0 +1,155 @@
+/**
+ * @file allocations.cpp
+ * @brief Test of the heap allocations of the steady-state frames of the
+ * example.
+ *
+ * Runs the window of the avoidasteroids example, hidden, through
+ * abcg::Application: sector streaming, simulation ticks and interpolation,
+ * the UI, the profiler and paintGL, first on the main thread and then with
+ * the simulation and render threads. The asteroids move at the top speed of
+ * the UI, so that sectors are streamed in and retired quickly. After the
+ * warm-up, in which the containers, the slots of the sector field and the
+ * frame arenas reach their capacity, frames must not allocate on any
+ * thread. The allocations are counted from the start of one paintGL to the
+ * start of the next, so that the whole frame is covered.
+ *
+ * Counting replaces operator new, so the test is skipped (exit code 77)
+ * unless the CMake option ENABLE_ALLOCATION_TRACKING is ON. It is also
+ * skipped if the window cannot be created.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include <fmt/core.h>
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+#include "abcg.hpp"
+#include "openglwindow.hpp"
+
+namespace {
+constexpr int skipped{77};
+// Each phase lasts for at least this many frames and simulated seconds.
+// At the top speed, 2 seconds stream in 8 sectors.
+constexpr int numPhaseFrames{30};
+// The warm-up also fills the history of the profiler
+constexpr int numWarmupFrames{abcg::Profiler::historySize + numPhaseFrames};
+constexpr double phaseTime{2.0};
+// Safety limit; the window quits at the end of the measurement
+constexpr std::uint64_t maxFrames{100'000};
+
+struct Result {
+  bool hasContext{};
+  bool measured{};
+  int numFrames{};
+  abcg::AllocationTracker::Counters allocations{};
+};
+
+// Window of the example that warms up, then counts the allocations of its
+// frames and quits
+class AllocationWindow final : public OpenGLWindow {
+ public:
+  AllocationWindow(const SceneSettings &settings, Result &result)
+      : OpenGLWindow{settings}, m_result{result} {}
+
+ protected:
+  void initializeGL() override {
+    m_result.hasContext = true;
+    OpenGLWindow::initializeGL();
+  }
+
+  // Runs on the simulation thread, if any
+  void simulate(double timeStep) override {
+    OpenGLWindow::simulate(timeStep);
+    m_time += timeStep;
+  }
+
+  void paintGL() override {
+    const auto counters{abcg::AllocationTracker::getTotalCounters()};
+    ++m_frames;
+    const auto phaseFrames{m_measuring ? numPhaseFrames
+                                       : numWarmupFrames};
+    if (!m_result.measured && m_frames > phaseFrames &&
+        m_time.load() - m_phaseStart > phaseTime) {
+      if (m_measuring) {
+        m_result.measured = true;
+        m_result.numFrames = m_frames - 1;
+        m_result.allocations = counters - m_start;
+        SDL_Event quit{};
+        quit.type = SDL_QUIT;
+        SDL_PushEvent(&quit);
+      } else {
+        m_measuring = true;
+        m_frames = 1;
+        m_phaseStart = m_time.load();
+        m_start = counters;
+      }
+    }
+    OpenGLWindow::paintGL();
+  }
+
+ private:
+  Result &m_result;
+  std::atomic<double> m_time{};
+  double m_phaseStart{};
+  int m_frames{};
+  bool m_measuring{false};
+  abcg::AllocationTracker::Counters m_start{};
+};
+
+// Runs the example with the given settings
+void runExample(int argc, char *argv[], SceneSettings settings,
+                Result &result) {
+  settings.speed = 100.0f;
+  settings.numAsteroids = 40;
+  abcg::Application app(argc, argv);
+  app.setFrameLimit(maxFrames);
+
+  auto window{std::make_unique<AllocationWindow>(settings, result)};
+  window->setOpenGLSettings({.targetFrameRate = -1.0});
+  window->setWindowSettings(
+      {.width = 300, .height = 300, .showFPS = false, .hidden = true});
+  app.run(std::move(window));
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if constexpr (!abcg::AllocationTracker::isEnabled()) {
+    fmt::print("Skipped: built with ENABLE_ALLOCATION_TRACKING=OFF\n");
+    return skipped;
+  }
+
+  SceneSettings threaded;
+  threaded.threaded = true;
+  threaded.renderThread = true;
+
+  bool passed{true};
+  for (const auto &[settings, name] :
+       {std::pair{SceneSettings{}, "main thread"},
+        std::pair{threaded, "simulation and render threads"}}) {
+    Result result;
+    try {
+      runExample(argc, argv, settings, result);
+    } catch (const abcg::Exception &exception) {
+      if (!result.hasContext) {
+        fmt::print("Skipped: no OpenGL context ({})\n", exception.what());
+        return skipped;
+      }
+      fmt::print("FAILED: {}\n", exception.what());
+      return 1;
+    }
+    fmt::print("{}: {} frames, {} allocations ({} bytes)\n", name,
+               result.numFrames, result.allocations.allocations,
+               result.allocations.bytes);
+    if (!result.measured) {
+      fmt::print("FAILED: {} ended before the measurement\n", name);
+      passed = false;
+    } else if (result.allocations.allocations != 0) {
+      fmt::print("FAILED: {} frames allocate\n", name);
+      passed = false;
+    }
+  }
+  return passed ? 0 : 1;
+}
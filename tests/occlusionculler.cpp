@@ -0,0 +1,163 @@
+/**
+ * @file occlusionculler.cpp
+ * @brief Test of the visibility results of abcg::OcclusionCuller.
+ *
+ * A camera at the origin looks down the negative z axis at a sphere
+ * occluder. Boxes hidden behind the sphere must be culled; boxes in front
+ * of it, beside it, or crossing the near plane must stay visible, and the
+ * statistics must count them. A larger random scene must then give the
+ * same visibility with abcg::OcclusionCuller::cull, and with cullAsync and
+ * wait with and without a job system.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "abcg_boundingbox.hpp"
+#include "abcg_jobsystem.hpp"
+#include "abcg_occlusionculler.hpp"
+
+namespace {
+// Larger than the number of boxes tested per job, so that the tests are
+// split among the workers
+constexpr std::size_t numRandomBoxes{5000};
+
+// Counts the failed checks
+class Checker {
+ public:
+  void check(bool condition, std::string_view what) {
+    if (condition) return;
+    fmt::print("FAILED: {}\n", what);
+    ++m_failures;
+  }
+
+  [[nodiscard]] int getResult() const { return m_failures == 0 ? 0 : 1; }
+
+ private:
+  int m_failures{};
+};
+
+abcg::BoundingBox makeBox(const glm::vec3 &center, float halfExtent) {
+  return {center - glm::vec3{halfExtent}, center + glm::vec3{halfExtent}};
+}
+
+void setCamera(abcg::OcclusionCuller &culler) {
+  culler.setCamera(glm::lookAt(glm::vec3{0.0f}, glm::vec3{0.0f, 0.0f, -1.0f},
+                               glm::vec3{0.0f, 1.0f, 0.0f}),
+                   glm::perspective(glm::radians(60.0f), 2.0f, 0.1f, 100.0f));
+}
+
+void testSphereOccluder(Checker &checker) {
+  abcg::OcclusionCuller culler;
+  setCamera(culler);
+  culler.addOccluder({0.0f, 0.0f, -10.0f}, 3.0f);
+
+  const std::vector boxes{
+      makeBox({0.0f, 0.0f, -30.0f}, 0.5f),
+      makeBox({0.5f, -0.5f, -20.0f}, 1.0f),
+      makeBox({0.0f, 0.0f, -5.0f}, 0.5f),
+      abcg::BoundingBox{{-0.5f, -0.5f, -30.0f}, {0.5f, 0.5f, 1.0f}},
+      makeBox({15.0f, 0.0f, -30.0f}, 0.5f)};
+  culler.cull(boxes);
+
+  checker.check(!culler.isVisible(0), "a box behind the occluder is culled");
+  checker.check(!culler.isVisible(1),
+                "a wider box behind the occluder is culled");
+  checker.check(culler.isVisible(2),
+                "a box in front of the occluder is visible");
+  checker.check(culler.isVisible(3),
+                "a box crossing the near plane is visible");
+  checker.check(culler.isVisible(4),
+                "a box beside the occluder is visible");
+  checker.check(culler.isVisible(boxes.size()),
+                "indices past the boxes are visible");
+
+  const auto statistics{culler.getStatistics()};
+  checker.check(statistics.occluders == 1, "one occluder counted");
+  checker.check(statistics.tested == boxes.size(), "every box tested");
+  checker.check(statistics.occluded == 2, "two boxes occluded");
+  checker.check(statistics.occludedRatio() == 2.0f / 5.0f,
+                "occluded ratio of two in five");
+
+  // Without occluders, nothing is culled
+  culler.clearOccluders();
+  culler.cull(boxes);
+  checker.check(std::ranges::all_of(culler.getVisibility(),
+                                    [](auto visible) { return visible != 0; }),
+                "every box is visible without occluders");
+  checker.check(culler.getStatistics().occludedRatio() == 0.0f,
+                "occluded ratio of zero without occluders");
+}
+
+void testAsync(Checker &checker) {
+  std::mt19937 engine{42};
+  std::uniform_real_distribution<float> xy{-20.0f, 20.0f};
+  std::uniform_real_distribution<float> z{-60.0f, -2.0f};
+  std::uniform_real_distribution<float> size{0.2f, 2.0f};
+
+  std::vector<glm::vec4> occluders(16);
+  for (auto &occluder : occluders) {
+    occluder = {xy(engine) * 0.5f, xy(engine) * 0.5f, z(engine) * 0.5f,
+                size(engine) * 2.0f};
+  }
+  std::vector<abcg::BoundingBox> boxes(numRandomBoxes);
+  for (auto &box : boxes) {
+    box = makeBox({xy(engine), xy(engine), z(engine)}, size(engine));
+  }
+
+  const auto runCull{[&](abcg::JobSystem *jobSystem, bool async) {
+    abcg::OcclusionCuller culler;
+    culler.setJobSystem(jobSystem);
+    setCamera(culler);
+    for (const auto &occluder : occluders) {
+      culler.addOccluder(glm::vec3{occluder}, occluder.w);
+    }
+    if (async) {
+      culler.cullAsync(boxes);
+      culler.wait();
+    } else {
+      culler.cull(boxes);
+    }
+    const auto visibility{culler.getVisibility()};
+    return std::pair{std::vector(visibility.begin(), visibility.end()),
+                     culler.getStatistics()};
+  }};
+
+  const auto [expected, expectedStatistics]{runCull(nullptr, false)};
+  checker.check(expectedStatistics.occluded > 0 &&
+                    expectedStatistics.occluded < boxes.size(),
+                "the random scene has occluded and visible boxes");
+
+  abcg::JobSystem jobs{3};
+  abcg::JobSystem inlineJobs{0};
+  for (const auto &[jobSystem, async, name] :
+       {std::tuple{static_cast<abcg::JobSystem *>(nullptr), true,
+                   "cullAsync without a job system"},
+        std::tuple{&jobs, false, "cull with a job system"},
+        std::tuple{&jobs, true, "cullAsync with a job system"},
+        std::tuple{&inlineJobs, true, "cullAsync with no workers"}}) {
+    const auto [visibility, statistics]{runCull(jobSystem, async)};
+    checker.check(visibility == expected,
+                  fmt::format("{} gives the same visibility", name));
+    checker.check(statistics.tested == expectedStatistics.tested &&
+                      statistics.occluded == expectedStatistics.occluded,
+                  fmt::format("{} gives the same statistics", name));
+  }
+}
+}  // namespace
+
+int main() {
+  Checker checker;
+  testSphereOccluder(checker);
+  testAsync(checker);
+  return checker.getResult();
+}
@@ -0,0 +1,161 @@
+/**
+ * @file renderqueue.cpp
+ * @brief Test of the ordering and the depth bound of abcg::RenderQueue.
+ *
+ * On a single thread, frames must be popped in the order they were
+ * submitted, the queue must run out of slots after depth + 1 frames, and
+ * close must end the pops once the submitted frames are exhausted. With a
+ * producer and a consumer thread, the consumer must execute the commands of
+ * every frame in the order they were recorded, and the producer must never
+ * hold a slot while depth frames are still unreleased.
+ *
+ * No frame carries UI draw data, so no ImGui context is needed.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include <fmt/core.h>
+
+#include <atomic>
+#include <chrono>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "abcg_exception.hpp"
+#include "abcg_renderqueue.hpp"
+
+namespace {
+constexpr std::size_t depth{2};
+constexpr std::size_t numFrames{2000};
+constexpr std::size_t commandsPerFrame{4};
+
+// Counts the failed checks
+class Checker {
+ public:
+  void check(bool condition, std::string_view what) {
+    if (condition) return;
+    fmt::print("FAILED: {}\n", what);
+    ++m_failures;
+  }
+
+  [[nodiscard]] int getResult() const { return m_failures == 0 ? 0 : 1; }
+
+ private:
+  int m_failures{};
+};
+
+void testSingleThread(Checker &checker) {
+  bool thrown{};
+  try {
+    abcg::RenderQueue empty{0};
+  } catch (const abcg::Exception &) {
+    thrown = true;
+  }
+  checker.check(thrown, "a queue of depth 0 throws");
+
+  abcg::RenderQueue queue{depth};
+  checker.check(queue.getNumSlots() == depth + 1, "depth + 1 slots");
+
+  std::vector<abcg::RenderQueue::Frame *> frames;
+  for (std::size_t index{}; index <= depth; ++index) {
+    frames.push_back(&queue.acquire());
+  }
+  checker.check(queue.getNumFree() == 0, "no slot left after depth + 1");
+
+  std::vector<std::size_t> executed;
+  for (auto *frame : frames) {
+    frame->commands.emplace_back(
+        [&executed, slot = frame->slot] { executed.push_back(slot); });
+    queue.submit(*frame);
+  }
+  checker.check(queue.getNumSubmitted() == depth + 1, "every frame queued");
+
+  for (auto *expected : frames) {
+    auto *frame{queue.pop()};
+    checker.check(frame == expected, "frames popped in submission order");
+    if (frame == nullptr) return;
+    for (const auto &command : frame->commands) command();
+    queue.release(*frame);
+    checker.check(frame->commands.empty(), "release clears the commands");
+  }
+  checker.check(executed.size() == frames.size() &&
+                    executed.front() == frames.front()->slot &&
+                    executed.back() == frames.back()->slot,
+                "commands executed in submission order");
+  checker.check(queue.getNumFree() == depth + 1 &&
+                    queue.getNumSubmitted() == 0,
+                "every slot free after the releases");
+
+  queue.submit(queue.acquire());
+  queue.close();
+  auto *last{queue.pop()};
+  checker.check(last != nullptr, "frames submitted before close are popped");
+  if (last != nullptr) queue.release(*last);
+  checker.check(queue.pop() == nullptr, "pop ends once the queue is closed");
+}
+
+void testThreads(Checker &checker) {
+  abcg::RenderQueue queue{depth};
+  // Written by the commands, on the consumer thread
+  std::vector<std::size_t> executed;
+  executed.reserve(numFrames * commandsPerFrame);
+  // Counted before each release, so that the producer never sees a slot
+  // freed by a release it has not counted
+  std::atomic<std::size_t> numReleased{};
+  std::size_t numAhead{};
+  std::size_t numDirty{};
+
+  std::thread producer{[&] {
+    for (std::size_t index{}; index < numFrames; ++index) {
+      auto &frame{queue.acquire()};
+      // Frames up to index - depth - 1 must have been released
+      if (index > depth + numReleased.load()) ++numAhead;
+      if (!frame.commands.empty()) ++numDirty;
+      for (std::size_t command{}; command < commandsPerFrame; ++command) {
+        frame.commands.emplace_back(
+            [&executed, position = index * commandsPerFrame + command] {
+              executed.push_back(position);
+            });
+      }
+      queue.submit(frame);
+    }
+    queue.close();
+  }};
+
+  std::size_t numPopped{};
+  while (auto *frame{queue.pop()}) {
+    for (const auto &command : frame->commands) command();
+    // Lets the producer fill the queue
+    if (++numPopped % 64 == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    numReleased.fetch_add(1);
+    queue.release(*frame);
+  }
+  producer.join();
+
+  std::size_t numOutOfOrder{};
+  for (std::size_t position{}; position < executed.size(); ++position) {
+    if (executed[position] != position) ++numOutOfOrder;
+  }
+  checker.check(numPopped == numFrames &&
+                    executed.size() == numFrames * commandsPerFrame,
+                "every frame and command executed");
+  checker.check(numOutOfOrder == 0,
+                fmt::format("{} commands out of order", numOutOfOrder));
+  checker.check(numAhead == 0,
+                fmt::format("{} frames recorded more than {} frames ahead",
+                            numAhead, depth));
+  checker.check(numDirty == 0,
+                fmt::format("{} frames acquired with stale commands",
+                            numDirty));
+}
+}  // namespace
+
+int main() {
+  Checker checker;
+  testSingleThread(checker);
+  testThreads(checker);
+  return checker.getResult();
+}
@@ -0,0 +1,149 @@
+/**
+ * @file resourcetracker.cpp
+ * @brief Test of the totals of abcg::ResourceTracker across the restarts of
+ * the example.
+ *
+ * Runs the window of the avoidasteroids example, hidden, for a fixed number
+ * of frames of abcg::Application, and restarts the game every few frames.
+ * The totals of the registry after initializeGL are the baseline: restarts
+ * keep the objects of initializeGL and must not create any, so the live
+ * counts must stay at the baseline in every frame. So must the sizes of the
+ * programs, vertex arrays and textures; those of the buffers follow the
+ * number of instances drawn. terminateGL must then delete every object.
+ *
+ * Needs an OpenGL context, so it is skipped (exit code 77) if the window
+ * cannot be created, or if the tracking is compiled out.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <memory>
+#include <string_view>
+
+#include "abcg.hpp"
+#include "openglwindow.hpp"
+
+namespace {
+constexpr int skipped{77};
+constexpr int numRestarts{8};
+constexpr int framesPerRound{12};
+
+using Kind = abcg::ResourceTracker::Kind;
+
+// Counts the failed checks
+class Checker {
+ public:
+  void check(bool condition, std::string_view what) {
+    if (condition) return;
+    fmt::print("FAILED: {}\n", what);
+    ++m_failures;
+  }
+
+  [[nodiscard]] int getResult() const { return m_failures == 0 ? 0 : 1; }
+
+ private:
+  int m_failures{};
+};
+
+// Window of the example that restarts the game every few frames and checks
+// the totals of the registry
+class RestartWindow final : public OpenGLWindow {
+ public:
+  RestartWindow(Checker &checker, bool &hasContext)
+      : m_checker{checker}, m_hasContext{hasContext} {}
+
+ protected:
+  void initializeGL() override {
+    m_hasContext = true;
+    OpenGLWindow::initializeGL();
+    m_baseline = abcg::ResourceTracker::getTotals();
+    m_checker.check(getCount(m_baseline, Kind::Program) > 0 &&
+                        getCount(m_baseline, Kind::Buffer) > 0 &&
+                        getCount(m_baseline, Kind::VertexArray) > 0 &&
+                        getCount(m_baseline, Kind::Texture) > 0,
+                    "the wrappers record the objects of initializeGL");
+  }
+
+  void paintGL() override {
+    OpenGLWindow::paintGL();
+    ++m_frame;
+
+    const auto totals{abcg::ResourceTracker::getTotals()};
+    m_checker.check(totals.count == m_baseline.count,
+                    fmt::format("object counts unchanged in frame {}, after "
+                                "{} restarts",
+                                m_frame, m_numRestarts));
+    for (const auto kind : {Kind::Program, Kind::VertexArray, Kind::Texture}) {
+      m_checker.check(getBytes(totals, kind) == getBytes(m_baseline, kind),
+                      fmt::format("object sizes unchanged in frame {}, after "
+                                  "{} restarts",
+                                  m_frame, m_numRestarts));
+    }
+
+    // The simulation runs on this thread, so the game can restart between
+    // its ticks
+    if (m_frame % framesPerRound == 0) {
+      restart();
+      ++m_numRestarts;
+    }
+  }
+
+  void terminateGL() override {
+    OpenGLWindow::terminateGL();
+    const auto totals{abcg::ResourceTracker::getTotals()};
+    m_checker.check(m_numRestarts == numRestarts,
+                    fmt::format("{} restarts played", numRestarts));
+    m_checker.check(std::all_of(totals.count.begin(), totals.count.end(),
+                                [](auto count) { return count == 0; }),
+                    "terminateGL deletes every object");
+  }
+
+ private:
+  static std::uint64_t getCount(const abcg::ResourceTracker::Totals &totals,
+                                Kind kind) {
+    return totals.count.at(static_cast<std::size_t>(kind));
+  }
+
+  static std::uint64_t getBytes(const abcg::ResourceTracker::Totals &totals,
+                                Kind kind) {
+    return totals.bytes.at(static_cast<std::size_t>(kind));
+  }
+
+  Checker &m_checker;
+  bool &m_hasContext;
+  abcg::ResourceTracker::Totals m_baseline{};
+  int m_frame{};
+  int m_numRestarts{};
+};
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if constexpr (!abcg::ResourceTracker::isEnabled()) {
+    fmt::print("Skipped: built with ENABLE_RESOURCE_TRACKING=OFF\n");
+    return skipped;
+  }
+
+  Checker checker;
+  bool hasContext{};
+  try {
+    abcg::Application app(argc, argv);
+    app.setFrameLimit((numRestarts + 1) * framesPerRound - 1);
+
+    auto window{std::make_unique<RestartWindow>(checker, hasContext)};
+    window->setOpenGLSettings({.targetFrameRate = -1.0});
+    window->setWindowSettings(
+        {.width = 300, .height = 300, .showFPS = false, .hidden = true});
+    app.run(std::move(window));
+  } catch (const abcg::Exception &exception) {
+    if (!hasContext) {
+      fmt::print("Skipped: no OpenGL context ({})\n", exception.what());
+      return skipped;
+    }
+    fmt::print("FAILED: {}\n", exception.what());
+    return 1;
+  }
+  return checker.getResult();
+}
@@ -0,0 +1,313 @@
+/**
+ * @file trianglebvh.cpp
+ * @brief Test of the queries of abcg::TriangleBVH against a brute-force
+ * loop over the triangles.
+ *
+ * Builds hierarchies over random triangle soups and checks
+ * abcg::TriangleBVH::intersectsSphere at random spheres, and
+ * abcg::TriangleBVH::intersects under random affine transforms, against
+ * tests of every triangle or pair of triangles. The same checks run on a
+ * fan of triangles whose centroids make the surface area heuristic split
+ * off one triangle per level, so that the build goes past 64 levels and
+ * falls back to median splits, and on a fan whose centroids coincide, which
+ * the heuristic cannot split at all.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/vec3.hpp>
+#include <limits>
+#include <random>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "abcg_trianglebvh.hpp"
+
+namespace {
+constexpr int numSphereQueries{2000};
+constexpr int numTransforms{300};
+
+// Spheres whose distance to the mesh is this close to their radius are
+// skipped, as the float and double distances may round differently
+constexpr double distanceTolerance{1e-4};
+
+// Counts the failed checks
+class Checker {
+ public:
+  void check(bool condition, std::string_view what) {
+    if (condition) return;
+    fmt::print("FAILED: {}\n", what);
+    ++m_failures;
+  }
+
+  [[nodiscard]] int getResult() const { return m_failures == 0 ? 0 : 1; }
+
+ private:
+  int m_failures{};
+};
+
+struct Mesh {
+  std::vector<glm::vec3> positions;
+  std::vector<std::uint32_t> indices;
+
+  [[nodiscard]] std::size_t getNumTriangles() const {
+    return indices.size() / 3;
+  }
+
+  [[nodiscard]] std::array<glm::vec3, 3> getTriangle(std::size_t index) const {
+    return {positions[indices[index * 3 + 0]],
+            positions[indices[index * 3 + 1]],
+            positions[indices[index * 3 + 2]]};
+  }
+
+  void addTriangle(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c) {
+    for (const auto &position : {a, b, c}) {
+      indices.push_back(static_cast<std::uint32_t>(positions.size()));
+      positions.push_back(position);
+    }
+  }
+};
+
+// Triangles with random vertices around random centers in [-5, 5]^3
+Mesh makeSoup(std::mt19937 &engine, std::size_t numTriangles) {
+  std::uniform_real_distribution<float> position{-5.0f, 5.0f};
+  std::uniform_real_distribution<float> offset{-0.6f, 0.6f};
+  Mesh mesh;
+  for (std::size_t index{}; index < numTriangles; ++index) {
+    const glm::vec3 center{position(engine), position(engine),
+                           position(engine)};
+    const auto vertex{[&] {
+      return center + glm::vec3{offset(engine), offset(engine), offset(engine)};
+    }};
+    const auto a{vertex()};
+    const auto b{vertex()};
+    mesh.addTriangle(a, b, vertex());
+  }
+  return mesh;
+}
+
+// Triangles sharing the edge from the origin to (1, 1, 1), with the third
+// vertex at x = 1 - 0.9^i. Every triangle has the same bounds, and the gap
+// from the lowest centroid to the next is larger than a bin of the rest, so
+// each SAH split separates a single triangle.
+Mesh makePeelingFan(std::size_t numTriangles) {
+  Mesh mesh;
+  for (std::size_t index{}; index < numTriangles; ++index) {
+    const auto x{1.0f - std::pow(0.9f, static_cast<float>(index))};
+    mesh.addTriangle({0.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}, {x, 0.5f, 0.0f});
+  }
+  return mesh;
+}
+
+// Triangles rotated about their common centroid
+Mesh makeCoincidentFan(std::size_t numTriangles) {
+  Mesh mesh;
+  for (std::size_t index{}; index < numTriangles; ++index) {
+    const auto angle{static_cast<float>(index) * 0.1f};
+    const glm::vec3 a{std::cos(angle), std::sin(angle), 0.2f};
+    const glm::vec3 b{-std::sin(angle), std::cos(angle), -0.2f};
+    mesh.addTriangle(a, b, -a - b);
+  }
+  return mesh;
+}
+
+// Distance from a point to a triangle, in double precision (Ericson,
+// Real-Time Collision Detection, 5.1.5)
+double getDistance(const std::array<glm::vec3, 3> &triangle,
+                   const glm::vec3 &point) {
+  const glm::dvec3 a{triangle[0]};
+  const glm::dvec3 b{triangle[1]};
+  const glm::dvec3 c{triangle[2]};
+  const glm::dvec3 p{point};
+  const auto ab{b - a};
+  const auto ac{c - a};
+  const auto ap{p - a};
+  const auto d1{glm::dot(ab, ap)};
+  const auto d2{glm::dot(ac, ap)};
+  if (d1 <= 0.0 && d2 <= 0.0) return glm::distance(p, a);
+
+  const auto bp{p - b};
+  const auto d3{glm::dot(ab, bp)};
+  const auto d4{glm::dot(ac, bp)};
+  if (d3 >= 0.0 && d4 <= d3) return glm::distance(p, b);
+
+  const auto vc{d1 * d4 - d3 * d2};
+  if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0) {
+    return glm::distance(p, a + ab * (d1 / (d1 - d3)));
+  }
+
+  const auto cp{p - c};
+  const auto d5{glm::dot(ab, cp)};
+  const auto d6{glm::dot(ac, cp)};
+  if (d6 >= 0.0 && d5 <= d6) return glm::distance(p, c);
+
+  const auto vb{d5 * d2 - d1 * d6};
+  if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) {
+    return glm::distance(p, a + ac * (d2 / (d2 - d6)));
+  }
+
+  const auto va{d3 * d6 - d5 * d4};
+  if (va <= 0.0 && d4 - d3 >= 0.0 && d5 - d6 >= 0.0) {
+    const auto t{(d4 - d3) / ((d4 - d3) + (d5 - d6))};
+    return glm::distance(p, b + (c - b) * t);
+  }
+
+  const auto denominator{1.0 / (va + vb + vc)};
+  return glm::distance(p,
+                       a + ab * (vb * denominator) + ac * (vc * denominator));
+}
+
+// Separating axis test of two triangles, on the same axes as the hierarchy
+bool intersects(const std::array<glm::vec3, 3> &lhs,
+                const std::array<glm::vec3, 3> &rhs) {
+  const auto isSeparatedOn{[&](const glm::vec3 &axis) {
+    const std::array lhsProjections{glm::dot(axis, lhs[0]),
+                                    glm::dot(axis, lhs[1]),
+                                    glm::dot(axis, lhs[2])};
+    const std::array rhsProjections{glm::dot(axis, rhs[0]),
+                                    glm::dot(axis, rhs[1]),
+                                    glm::dot(axis, rhs[2])};
+    const auto [lhsMin, lhsMax]{std::ranges::minmax(lhsProjections)};
+    const auto [rhsMin, rhsMax]{std::ranges::minmax(rhsProjections)};
+    return lhsMax < rhsMin || rhsMax < lhsMin;
+  }};
+
+  const std::array lhsEdges{lhs[1] - lhs[0], lhs[2] - lhs[1], lhs[0] - lhs[2]};
+  const std::array rhsEdges{rhs[1] - rhs[0], rhs[2] - rhs[1], rhs[0] - rhs[2]};
+  if (isSeparatedOn(glm::cross(lhsEdges[0], lhsEdges[1])) ||
+      isSeparatedOn(glm::cross(rhsEdges[0], rhsEdges[1]))) {
+    return false;
+  }
+  for (const auto &lhsEdge : lhsEdges) {
+    for (const auto &rhsEdge : rhsEdges) {
+      if (isSeparatedOn(glm::cross(lhsEdge, rhsEdge))) return false;
+    }
+  }
+  return true;
+}
+
+void testSpheres(Checker &checker, std::mt19937 &engine, const Mesh &mesh,
+                 const abcg::TriangleBVH &bvh, std::string_view name) {
+  const auto bounds{bvh.getBounds()};
+  const auto size{glm::length(bounds.extent())};
+  const auto margin{0.1f * size};
+  std::uniform_real_distribution<float> x{bounds.min.x - margin,
+                                          bounds.max.x + margin};
+  std::uniform_real_distribution<float> y{bounds.min.y - margin,
+                                          bounds.max.y + margin};
+  std::uniform_real_distribution<float> z{bounds.min.z - margin,
+                                          bounds.max.z + margin};
+  std::uniform_real_distribution<float> radius{0.001f, 0.1f};
+
+  int hits{};
+  int mismatches{};
+  for (int query{}; query < numSphereQueries; ++query) {
+    const glm::vec3 center{x(engine), y(engine), z(engine)};
+    const auto queryRadius{radius(engine) * size};
+    auto distance{std::numeric_limits<double>::max()};
+    for (std::size_t index{}; index < mesh.getNumTriangles(); ++index) {
+      distance =
+          std::min(distance, getDistance(mesh.getTriangle(index), center));
+    }
+    const auto reach{static_cast<double>(queryRadius)};
+    if (std::abs(distance - reach) <= distanceTolerance * reach) continue;
+
+    const bool expected{distance <= reach};
+    if (expected) ++hits;
+    if (bvh.intersectsSphere(center, queryRadius) != expected) ++mismatches;
+  }
+  checker.check(mismatches == 0,
+                fmt::format("{}: {} sphere queries differ from the brute force",
+                            name, mismatches));
+  checker.check(hits > 0 && hits < numSphereQueries,
+                fmt::format("{}: sphere queries hit and miss", name));
+}
+
+void testMeshes(Checker &checker, std::mt19937 &engine, const Mesh &mesh,
+                const abcg::TriangleBVH &bvh, const Mesh &otherMesh,
+                const abcg::TriangleBVH &otherBVH, std::string_view name) {
+  const auto bounds{bvh.getBounds()};
+  const auto reach{glm::length(bounds.extent()) * 0.6f};
+  std::uniform_real_distribution<float> translation{-reach, reach};
+  std::uniform_real_distribution<float> angle{0.0f, 6.2832f};
+  std::uniform_real_distribution<float> component{-1.0f, 1.0f};
+  std::uniform_real_distribution<float> scale{0.05f, 0.3f};
+
+  int hits{};
+  int mismatches{};
+  for (int transform{}; transform < numTransforms; ++transform) {
+    // Translation, rotation and non-uniform scale
+    auto otherToThis{glm::translate(
+        glm::mat4{1.0f}, bounds.center() + glm::vec3{translation(engine),
+                                                     translation(engine),
+                                                     translation(engine)})};
+    otherToThis = glm::rotate(otherToThis, angle(engine),
+                              glm::normalize(glm::vec3{
+                                  component(engine), component(engine),
+                                  component(engine) + 2.0f}));
+    otherToThis = glm::scale(
+        otherToThis,
+        glm::vec3{scale(engine), scale(engine), scale(engine)} * reach);
+
+    bool expected{};
+    for (std::size_t otherIndex{};
+         !expected && otherIndex < otherMesh.getNumTriangles(); ++otherIndex) {
+      auto otherTriangle{otherMesh.getTriangle(otherIndex)};
+      for (auto &vertex : otherTriangle) {
+        vertex = glm::vec3{otherToThis * glm::vec4{vertex, 1.0f}};
+      }
+      for (std::size_t index{}; !expected && index < mesh.getNumTriangles();
+           ++index) {
+        expected = intersects(otherTriangle, mesh.getTriangle(index));
+      }
+    }
+
+    if (expected) ++hits;
+    if (bvh.intersects(otherBVH, otherToThis) != expected) ++mismatches;
+  }
+  checker.check(mismatches == 0,
+                fmt::format("{}: {} mesh queries differ from the brute force",
+                            name, mismatches));
+  checker.check(hits > 0 && hits < numTransforms,
+                fmt::format("{}: mesh queries hit and miss", name));
+}
+}  // namespace
+
+int main() {
+  Checker checker;
+  std::mt19937 engine{42};
+
+  const auto other{makeSoup(engine, 24)};
+  abcg::TriangleBVH otherBVH;
+  otherBVH.build(other.positions, other.indices);
+
+  for (const auto &[mesh, name] :
+       {std::pair{makeSoup(engine, 500), "random soup"},
+        std::pair{makeSoup(engine, 3), "single leaf"},
+        std::pair{makePeelingFan(100), "peeling fan"},
+        std::pair{makeCoincidentFan(100), "coincident fan"}}) {
+    abcg::TriangleBVH bvh;
+    bvh.build(mesh.positions, mesh.indices);
+    checker.check(bvh.getNumTriangles() == mesh.getNumTriangles(),
+                  fmt::format("{}: every triangle in the hierarchy", name));
+    testSpheres(checker, engine, mesh, bvh, name);
+    testMeshes(checker, engine, mesh, bvh, other, otherBVH, name);
+  }
+
+  // Empty hierarchies intersect nothing
+  abcg::TriangleBVH empty;
+  empty.build({}, {});
+  checker.check(empty.empty() && !empty.intersectsSphere({}, 1.0f) &&
+                    !empty.intersects(otherBVH, glm::mat4{1.0f}) &&
+                    !otherBVH.intersects(empty, glm::mat4{1.0f}),
+                "an empty hierarchy intersects nothing");
+  return checker.getResult();
+}
@@ -0,0 +1,131 @@
+/**
+ * @file triplebuffer.cpp
+ * @brief Test of the handoff of snapshots of abcg::TripleBuffer.
+ *
+ * On a single thread, abcg::TripleBuffer::update must report each publish
+ * once, and take only the latest of several. With a writer and a reader
+ * thread, the writer publishes numbered snapshots whose every element is
+ * derived from the number; each snapshot the reader takes must be whole
+ * (no torn reads), must not change while the reader holds it, and must be
+ * newer than the previous one, and the reader must end with the last one.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <thread>
+
+#include "abcg_triplebuffer.hpp"
+
+namespace {
+constexpr std::uint64_t numSnapshots{200'000};
+
+// Large enough for a copy to be interrupted halfway
+struct Snapshot {
+  std::uint64_t sequence{};
+  std::array<std::uint64_t, 64> values{};
+
+  void write(std::uint64_t newSequence) {
+    sequence = newSequence;
+    for (std::size_t index{}; index < values.size(); ++index) {
+      values.at(index) = newSequence * (index + 1);
+    }
+  }
+
+  [[nodiscard]] bool isWhole() const {
+    for (std::size_t index{}; index < values.size(); ++index) {
+      if (values.at(index) != sequence * (index + 1)) return false;
+    }
+    return true;
+  }
+};
+
+// Counts the failed checks
+class Checker {
+ public:
+  void check(bool condition, std::string_view what) {
+    if (condition) return;
+    fmt::print("FAILED: {}\n", what);
+    ++m_failures;
+  }
+
+  [[nodiscard]] int getResult() const { return m_failures == 0 ? 0 : 1; }
+
+ private:
+  int m_failures{};
+};
+
+void testSingleThread(Checker &checker) {
+  abcg::TripleBuffer<Snapshot> buffer;
+  checker.check(!buffer.update(), "nothing to take before the first publish");
+
+  buffer.getWriteBuffer().write(1);
+  buffer.publish();
+  checker.check(buffer.update(), "a publish is taken");
+  checker.check(buffer.getReadBuffer().sequence == 1,
+                "the read buffer holds the published snapshot");
+  checker.check(!buffer.update(), "a publish is taken once");
+  checker.check(buffer.getReadBuffer().sequence == 1,
+                "the read buffer is kept without a publish");
+
+  for (std::uint64_t sequence{2}; sequence <= 4; ++sequence) {
+    buffer.getWriteBuffer().write(sequence);
+    buffer.publish();
+  }
+  checker.check(buffer.update() && buffer.getReadBuffer().sequence == 4,
+                "only the latest of several publishes is taken");
+  checker.check(!buffer.update(), "older publishes are dropped");
+}
+
+void testThreads(Checker &checker) {
+  abcg::TripleBuffer<Snapshot> buffer;
+  std::thread writer{[&buffer] {
+    for (std::uint64_t sequence{1}; sequence <= numSnapshots; ++sequence) {
+      buffer.getWriteBuffer().write(sequence);
+      buffer.publish();
+      // Lets the reader in often, even on a single core
+      if (sequence % 16 == 0) std::this_thread::yield();
+    }
+  }};
+
+  std::uint64_t last{};
+  std::uint64_t numTaken{};
+  std::uint64_t numTorn{};
+  std::uint64_t numStale{};
+  while (last < numSnapshots) {
+    if (!buffer.update()) {
+      std::this_thread::yield();
+      continue;
+    }
+    const auto &snapshot{buffer.getReadBuffer()};
+    const auto sequence{snapshot.sequence};
+    // The writer runs before the snapshot is checked, so that a buffer
+    // still held by the reader would be overwritten
+    std::this_thread::yield();
+    ++numTaken;
+    if (!snapshot.isWhole() || snapshot.sequence != sequence) ++numTorn;
+    if (snapshot.sequence <= last) ++numStale;
+    last = std::max(last, snapshot.sequence);
+  }
+  writer.join();
+
+  fmt::print("{} snapshots published, {} taken\n", numSnapshots, numTaken);
+  checker.check(numTorn == 0,
+                fmt::format("{} snapshots written while taken", numTorn));
+  checker.check(numStale == 0,
+                fmt::format("{} snapshots taken out of order", numStale));
+  checker.check(!buffer.update(), "nothing left after the last snapshot");
+}
+}  // namespace
+
+int main() {
+  Checker checker;
+  testSingleThread(checker);
+  testThreads(checker);
+  return checker.getResult();
+}